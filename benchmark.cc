@@ -0,0 +1,572 @@
+// tracey micro benchmarks. tracey.cpp is included to reach its internals.
+// g++ benchmark.cc -o benchmark -O2 -g -fno-omit-frame-pointer -std=c++11 -lpthread
+
+#include "tracey.cpp"
+
+#include <chrono>
+
+#include <spawn.h>
+#include <sys/wait.h>
+
+namespace {
+
+    double now() {
+        return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+
+    // unwinders {
+
+    volatile unsigned sink = 0;
+
+    __attribute__((noinline))
+    double capture_at( unsigned depth, unsigned iterations ) {
+        if( depth > 1 ) {
+            double ns = capture_at( depth - 1, iterations );
+            return sink += 1, ns;
+        }
+        void *frames[ kTraceyMaxStacktraces ];
+        double t0 = now();
+        for( unsigned i = 0; i < iterations; ++i ) {
+            sink += tracey::callstack::capture( frames, kTraceyMaxStacktraces );
+        }
+        double t1 = now();
+        return ( t1 - t0 ) * 1e9 / iterations;
+    }
+
+    double unwind_at( unsigned depth, int unwinder, unsigned iterations ) {
+        int previous = tracey::callstack::unwinder;
+        tracey::callstack::unwinder = unwinder;
+        double ns = capture_at( depth, iterations );
+        tracey::callstack::unwinder = previous;
+        return ns;
+    }
+
+    void capture_churn( unsigned depth, unsigned iterations, double *ns ) {
+        *ns = capture_at( depth, iterations );
+    }
+
+    // dwarf-cfi captures from several threads at once; average latency per capture and thread
+    double unwind_threads( unsigned depth, unsigned threads, unsigned iterations ) {
+        int previous = tracey::callstack::unwinder;
+        tracey::callstack::unwinder = tracey::callstack::UNWIND_DWARF;
+        std::vector<double> ns( threads );
+        std::vector<std::thread> pool;
+        for( unsigned t = 0; t < threads; ++t ) {
+            pool.push_back( std::thread( capture_churn, depth, iterations, &ns[t] ) );
+        }
+        double sum = 0;
+        for( unsigned t = 0; t < threads; ++t ) {
+            pool[t].join();
+            sum += ns[t];
+        }
+        tracey::callstack::unwinder = previous;
+        return sum / threads;
+    }
+
+    void bench_unwinders() {
+        std::printf( "%-24s %8s %14s %14s %14s\n", "unwinders", "depth", "platform", "frame-pointers", "dwarf-cfi" );
+        const unsigned depths[] = { 8, 32, 128 };
+        for( unsigned d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d ) {
+            double platform = unwind_at( depths[d], tracey::callstack::UNWIND_PLATFORM, 20000 );
+            double fp = unwind_at( depths[d], tracey::callstack::UNWIND_FRAME_POINTERS, 20000 );
+            double cfi = unwind_at( depths[d], tracey::callstack::UNWIND_DWARF, 20000 );
+            std::printf( "%-24s %8u %11.0f ns %11.0f ns %11.0f ns\n", "capture", depths[d], platform, fp, cfi );
+        }
+        std::printf( "%-24s %8s %14s %14s %14s\n", "dwarf-cfi, depth 32", "threads", "", "", "dwarf-cfi" );
+        for( unsigned threads = 1; threads <= 4; threads *= 4 ) {
+            std::printf( "%-24s %8u %14s %14s %11.0f ns\n", "capture", threads, "", "", unwind_threads( 32, threads, 20000 ) );
+        }
+    }
+
+    // }
+
+    // symbolizer {
+
+    // unique frames spread over this executable, as a report over a big program resolves them
+    void bench_symbolizer() {
+        std::printf( "%-24s %8s %14s %14s %14s\n", "symbolizer", "frames", "first report", "next reports", "addr2line" );
+        const tracey::elf::image *exe;
+        {
+            std::lock_guard<std::mutex> lock( tracey::elf::images_mutex );
+            tracey::elf::refresh();
+            exe = tracey::elf::find_image( (uintptr_t)&bench_symbolizer );
+        }
+        const unsigned n = 50000;
+        tracey::callstack cs;
+        for( unsigned i = 0; i < n; ++i ) {
+            cs.frames.push_back( (void *)( exe->lo + ( exe->hi - exe->lo ) / n * i ) );
+        }
+        tracey::acquired = true; // as while reporting: tracey allocates from its metadata arena
+        double t0 = now();
+        sink += cs.unwind().size();
+        double t1 = now();
+        sink += cs.unwind().size();
+        double t2 = now();
+        // same frames, grouped by module and resolved on every core; then again, from the symbol cache
+        std::remove( tracey::symbol_cache::path( *exe ).c_str() );
+        sink += tracey::symbolize( cs.frames ).size();
+        double t4 = now();
+        sink += tracey::symbolize( cs.frames ).size();
+        double t5 = now();
+        std::remove( tracey::symbol_cache::path( *exe ).c_str() );
+        tracey::acquired = false;
+        // what every frame used to cost: one shell and one addr2line process
+        const unsigned spawns = 20;
+        for( unsigned i = 0; i < spawns; ++i ) {
+            std::string cmd = tracey::string( "addr2line -e /proc/\1/exe \2", getpid(), cs.frames[i] );
+            if( FILE *fp = popen( cmd.c_str(), "r" ) ) {
+                char line[ 1024 ];
+                sink += fgets( line, sizeof(line), fp ) != 0;
+                pclose( fp );
+            }
+        }
+        double t3 = now();
+        std::printf( "%-24s %8u %11.0f ns %11.0f ns %11.0f ns\n", "unwind", n, ( t1 - t0 ) * 1e9 / n, ( t2 - t1 ) * 1e9 / n, ( t3 - t5 ) * 1e9 / spawns );
+        std::printf( "%-24s %8u %14s %11.0f ns\n", "batched", n, "-", ( t4 - t2 ) * 1e9 / n );
+        if( !tracey::symbol_cache::directory().empty() ) { // opt-in: kTraceySymbolCache or TRACEY_SYMBOL_CACHE
+            std::printf( "%-24s %8u %14s %11.0f ns\n", "batched, symbol cache", n, "-", ( t5 - t4 ) * 1e9 / n );
+        }
+    }
+
+    // }
+
+    // sampling {
+
+    double churn( size_t rate, unsigned iterations ) {
+        size_t previous = tracey::sampler::rate;
+        tracey::sampler::rate = rate;
+        double t0 = now();
+        for( unsigned i = 0; i < iterations; ++i ) {
+            char *volatile ptr = new char[ 16 + ( i & 255 ) ];
+            delete [] ptr;
+        }
+        double t1 = now();
+        tracey::sampler::rate = previous;
+        return ( t1 - t0 ) * 1e9 / iterations;
+    }
+
+    void bench_sampling() {
+        std::printf( "%-24s %8s %14s\n", "sampling", "KB", "new+delete" );
+        const size_t rates[] = { 0, 512 * 1024, 4 * 1024 * 1024 };
+        for( unsigned r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r ) {
+            std::printf( "%-24s %8u %11.0f ns\n", rates[r] ? "sampled" : "every allocation", unsigned( rates[r] / 1024 ), churn( rates[r], 200000 ) );
+        }
+    }
+
+    // }
+
+    // aligned allocations {
+
+    // amalloc() as it used to be: retry malloc() until an aligned block shows up
+    void *legacy_amalloc( size_t size, size_t alignment ) {
+        std::vector<void *> invalids( 1, tracey::malloc(size) );
+        while( uintptr_t( invalids.back() ) % alignment )
+            invalids.push_back( tracey::malloc( size ) );
+        std::swap( invalids.front(), invalids.back() );
+        for( unsigned i = 1; i < invalids.size(); ++i ) {
+            tracey::free( invalids[i] );
+        }
+        return invalids[0];
+    }
+
+    template<typename FN>
+    double aligned_churn( FN fn, size_t alignment, unsigned iterations ) {
+        double t0 = now();
+        for( unsigned i = 0; i < iterations; ++i ) {
+            void *volatile ptr = fn( 32 + ( i & 127 ), alignment );
+            tracey::free( ptr );
+        }
+        double t1 = now();
+        return ( t1 - t0 ) * 1e9 / iterations;
+    }
+
+    void bench_aligned() {
+        std::printf( "%-24s %8s %14s %14s\n", "aligned", "align", "retry-loop", "amalloc" );
+        const size_t alignments[] = { 64, 256 };
+        for( unsigned a = 0; a < sizeof(alignments) / sizeof(alignments[0]); ++a ) {
+            unsigned iterations = 20000;
+            double legacy = aligned_churn( legacy_amalloc, alignments[a], iterations );
+            double current = aligned_churn( tracey::amalloc, alignments[a], iterations );
+            std::printf( "%-24s %8u %11.0f ns %11.0f ns\n", "amalloc+free", unsigned( alignments[a] ), legacy, current );
+        }
+    }
+
+    // }
+
+    // zero fills {
+
+    // called through a pointer, so the compiler cannot fold malloc+memset into calloc
+    void *(*volatile memset_fn)( void *, int, size_t ) = std::memset;
+
+    double zero_churn( size_t size, bool memset, unsigned iterations ) {
+        double t0 = now();
+        for( unsigned i = 0; i < iterations; ++i ) {
+            // memset: the way tracey::malloc() used to zero every block
+            void *volatile ptr = memset ? memset_fn( tracey::realloc( 0, size ), 0, size ) : tracey::malloc( size );
+            tracey::free( ptr );
+        }
+        double t1 = now();
+        return ( t1 - t0 ) * 1e9 / iterations;
+    }
+
+    void bench_zero_fills() {
+        std::printf( "%-24s %8s %14s %14s\n", "zero fills", "bytes", "memset", "tracey::malloc" );
+        for( size_t size = 16; size <= 64 * 1024 * 1024; size *= 4 ) {
+            unsigned iterations = unsigned( std::min( std::max( ( size_t(1) << 30 ) / size, size_t(8) ), size_t(200000) ) );
+            double memset = zero_churn( size, true, iterations );
+            double malloc = zero_churn( size, false, iterations );
+            std::printf( "%-24s %8s %11.0f ns %11.0f ns\n", "malloc+free", tracey::human( size ).c_str(), memset, malloc );
+        }
+    }
+
+    // }
+
+    // backends {
+
+    // small blocks in a sliding window, so frees are not always of the last allocation
+    void backend_churn( unsigned iterations, bool tracked ) {
+        char *window[ 64 ] = {};
+        for( unsigned i = 0; i < iterations; ++i ) {
+            unsigned slot = ( i * 7 ) & 63;
+            if( tracked ) {
+                delete [] window[ slot ];
+                window[ slot ] = new char[ 16 + ( i & 511 ) ];
+            } else {
+                tracey::free( window[ slot ] );
+                window[ slot ] = (char *)tracey::realloc( 0, 16 + ( i & 511 ) );
+            }
+        }
+        for( unsigned slot = 0; slot < 64; ++slot ) {
+            if( tracked ) delete [] window[ slot ];
+            else tracey::free( window[ slot ] );
+        }
+    }
+
+    double backend_run( int selected, unsigned threads, unsigned iterations, bool tracked ) {
+        int previous = tracey::backend::selected;
+        tracey::backend::selected = selected;
+        double t0 = now();
+        std::vector<std::thread> pool;
+        for( unsigned t = 0; t < threads; ++t ) {
+            pool.push_back( std::thread( backend_churn, iterations, tracked ) );
+        }
+        for( unsigned t = 0; t < threads; ++t ) {
+            pool[t].join();
+        }
+        double t1 = now();
+        tracey::backend::selected = previous;
+        return ( t1 - t0 ) * 1e9 / iterations;
+    }
+
+    void bench_backends() {
+        std::printf( "%-24s %8s %14s %14s\n", "backends", "threads", "system", "slab" );
+        const unsigned iterations = 200000;
+        for( unsigned threads = 1; threads <= 4; threads *= 4 ) {
+            double system = backend_run( tracey::backend::SYSTEM, threads, iterations, false );
+            double slab = backend_run( tracey::backend::SLAB, threads, iterations, false );
+            std::printf( "%-24s %8u %11.0f ns %11.0f ns\n", "malloc+free", threads, system, slab );
+            system = backend_run( tracey::backend::SYSTEM, threads, iterations, true );
+            slab = backend_run( tracey::backend::SLAB, threads, iterations, true );
+            std::printf( "%-24s %8u %11.0f ns %11.0f ns\n", "new+delete (tracked)", threads, system, slab );
+        }
+    }
+
+    // }
+
+    // realloc tracking {
+
+    // a string builder growing 16 bytes at a time, as C code does
+    double grow_churn( bool rewatch, unsigned blocks, unsigned steps ) {
+        double t0 = now();
+        for( unsigned b = 0; b < blocks; ++b ) {
+            void *ptr = 0;
+            for( unsigned i = 1; i <= steps; ++i ) {
+                ptr = rewatch ? tracey::rewatch( ptr, i * 16 ) : tracey::watch( tracey::realloc( tracey::forget( ptr ), i * 16 ), i * 16 );
+            }
+            tracey::free( tracey::forget( ptr ) );
+        }
+        double t1 = now();
+        return ( t1 - t0 ) * 1e9 / ( blocks * steps );
+    }
+
+    void bench_realloc() {
+        std::printf( "%-24s %8s %14s %14s\n", "realloc tracking", "steps", "forget+watch", "rewatch" );
+        const unsigned steps[] = { 16, 256 };
+        for( unsigned s = 0; s < sizeof(steps) / sizeof(steps[0]); ++s ) {
+            unsigned blocks = 100000 / steps[s];
+            double legacy = grow_churn( false, blocks, steps[s] );
+            double current = grow_churn( true, blocks, steps[s] );
+            std::printf( "%-24s %8u %11.0f ns %11.0f ns\n", "realloc", steps[s], legacy, current );
+        }
+    }
+
+    // }
+
+    // policies {
+
+    // per-allocation work that a policy decides at compile time: budget and fill of a fresh block
+    template<typename P>
+    double policy_churn( unsigned iterations ) {
+        static char block[ 1024 ];
+        double t0 = now();
+        for( unsigned i = 0; i < iterations; ++i ) {
+            size_t size = 16 + ( i & 511 );
+            sink += P::budget( size );
+            sink += *(char *)P::fill( block, size );
+        }
+        double t1 = now();
+        return ( t1 - t0 ) * 1e9 / iterations;
+    }
+
+    // same work as the kTracey* macros used to do it
+    double macro_churn( unsigned iterations ) {
+        static char block[ 1024 ];
+        volatile double overhead = kTraceyBudgetOverhead; // a double the compiler cannot fold away
+        double t0 = now();
+        for( unsigned i = 0; i < iterations; ++i ) {
+            size_t size = 16 + ( i & 511 );
+            sink += (size_t)( size + ( overhead * size ) / 100.0 );
+            sink += *(char *)( kTraceyMemsetAllocations ? kTraceyMemset( block, kTraceyMemsetChar, size ) : block );
+        }
+        double t1 = now();
+        return ( t1 - t0 ) * 1e9 / iterations;
+    }
+
+    void bench_policy() {
+        typedef tracey::policy< 32, -1, -1, 0, false, false, false, false > lean;
+        std::printf( "%-24s %8s %14s %14s %14s\n", "policies", "", "macros", "defaults", "lean" );
+        const unsigned iterations = 1000000;
+        double macros = macro_churn( iterations );
+        double defaults = policy_churn< tracey::defaults >( iterations );
+        double bare = policy_churn< lean >( iterations );
+        std::printf( "%-24s %8s %11.1f ns %11.1f ns %11.1f ns\n", "budget+fill", "", macros, defaults, bare );
+        double t0 = now();
+        for( unsigned i = 0; i < iterations; ++i ) {
+            tracey::free( tracey::forget( tracey::watch( tracey::malloc( 16 + ( i & 511 ) ), 16 + ( i & 511 ) ) ) );
+        }
+        double t1 = now();
+        std::printf( "%-24s %8s %11s    %11.0f ns (kTraceyPolicy)\n", "malloc+watch+free", "", "", ( t1 - t0 ) * 1e9 / iterations );
+    }
+
+    // }
+
+    // free filter {
+
+    // frees of blocks allocated while tracey was disabled: none of them has a record
+    void bench_filter() {
+        std::printf( "%-24s %8s %14s %14s\n", "untracked frees", "blocks", "filtered", "registry" );
+        const unsigned n = 100000;
+        std::vector<char *> blocks( n );
+        tracey::disable();
+        for( unsigned i = 0; i < n; ++i ) blocks[i] = new char[ 16 + ( i & 255 ) ];
+        tracey::enable();
+        tracey::container &map = tracey::init();
+        double t0 = now();
+        for( unsigned i = 0; i < n; ++i ) tracey::forget( blocks[i] );
+        double t1 = now();
+        for( unsigned i = 0; i < n; ++i ) sink += map.untrack( blocks[i] );
+        double t2 = now();
+        tracey::disable();
+        for( unsigned i = 0; i < n; ++i ) delete [] blocks[i];
+        tracey::enable();
+        std::printf( "%-24s %8u %11.0f ns %11.0f ns\n", "forget", n, ( t1 - t0 ) * 1e9 / n, ( t2 - t1 ) * 1e9 / n );
+    }
+
+    // }
+
+    // startup {
+
+    // a short-lived process (like a cli tool or a unit test) that allocates once and leaves
+    int startup_child( bool verbose ) {
+        double t0 = now();
+        char *volatile first = new char[ 16 ];
+        double t1 = now();
+        char *volatile second = new char[ 16 ];
+        double t2 = now();
+        delete [] first;
+        delete [] second;
+        if( verbose ) {
+            std::printf( "%-24s %8s %11.0f ns\n", "first allocation", "", ( t1 - t0 ) * 1e9 );
+            std::printf( "%-24s %8s %11.0f ns\n", "second allocation", "", ( t2 - t1 ) * 1e9 );
+        }
+        tracey::disable();
+        std::fflush( stdout );
+        return 0;
+    }
+
+    void spawn( char *self, bool verbose ) {
+        char arg1[] = "--startup-child", arg2[] = "--verbose";
+        char *argv[] = { self, arg1, verbose ? arg2 : 0, 0 };
+        pid_t pid;
+        int status;
+        if( posix_spawn( &pid, self, 0, 0, argv, environ ) == 0 ) {
+            waitpid( pid, &status, 0 );
+        }
+    }
+
+    void bench_startup( char *self ) {
+        std::printf( "%-24s %8s %14s\n", "startup", "runs", "latency" );
+        std::fflush( stdout );
+        spawn( self, true );
+        const unsigned runs = 10;
+        double t0 = now();
+        for( unsigned i = 0; i < runs; ++i ) {
+            spawn( self, false );
+        }
+        double t1 = now();
+        std::printf( "%-24s %8u %11.2f ms\n", "spawn+exit", runs, ( t1 - t0 ) * 1e3 / runs );
+    }
+
+    // }
+
+    // report trees {
+
+    // leaks with 32-frame stacks that share their outer frames and fan out towards the inner ones
+    const unsigned tree_depth = 32;
+
+    std::vector< void * > tree_stacks( unsigned leaks ) {
+        std::vector< void * > frames;
+        frames.reserve( leaks * tree_depth );
+        for( unsigned i = 0; i < leaks; ++i ) {
+            for( unsigned d = 0; d < tree_depth; ++d ) {
+                unsigned site = ( i * 2654435761u ) >> ( 31 - d ) & 3;
+                frames.push_back( (void *)( uintptr_t( 0x400000 ) + d * 0x1000 + site * 0x10 ) );
+            }
+        }
+        return frames;
+    }
+
+    // as _report() does it: both trees filled, refreshed and printed with symbol names
+    void tree_report( bool flat, const std::vector< void * > &frames, const std::map< void *, std::string > &names, double *build, double *print, size_t *bytes ) {
+        size_t used = tracey::metadata().used();
+        double t0 = now();
+        tracey::tree tree;
+        tracey::calltree cct;
+        uint32_t top = cct.insert( 0, (void *)((~0)-0) ), inv = cct.insert( 0, (void *)((~0)-1) );
+        for( size_t at = 0; at < frames.size(); at += tree_depth ) {
+            if( flat ) {
+                uint32_t _top = top, _inv = inv;
+                for( unsigned i = 0; i < tree_depth; ++i ) {
+                    _top = cct.insert( _top, frames[at + i] );
+                    cct.nodes[_top].value.size += i == tree_depth - 1 ? 16 : 0;
+                    cct.nodes[_top].value.hits += 1;
+                    _inv = cct.insert( _inv, frames[at + tree_depth - 1 - i] );
+                    cct.nodes[_inv].value.size += i == tree_depth - 1 ? 16 : 0;
+                    cct.nodes[_inv].value.hits += 1;
+                }
+            } else {
+                tracey::tree *_tree = &tree[(void *)((~0)-0)], *_tree_inv = &tree[(void *)((~0)-1)];
+                for( unsigned i = 0; i < tree_depth; ++i ) {
+                    _tree = &(*_tree)[ frames[at + i] ];
+                    _tree->get().size += i == tree_depth - 1 ? 16 : 0;
+                    _tree->get().hits += 1;
+                    _tree_inv = &(*_tree_inv)[ frames[at + tree_depth - 1 - i] ];
+                    _tree_inv->get().size += i == tree_depth - 1 ? 16 : 0;
+                    _tree_inv->get().hits += 1;
+                }
+            }
+        }
+        if( flat ) cct.refresh(); else tree.refresh();
+        double t1 = now();
+        *bytes = tracey::metadata().used() - used;
+        std::string out = flat ? tracey::print( cct, frames.size() / tree_depth * 16.0, names, "{tabs}[{size}] ({value}) {key}\n", "{value}", true )
+                               : tracey::print( tree, frames.size() / tree_depth * 16.0, names, "{tabs}[{size}] ({value}) {key}\n", "{value}", true );
+        double t2 = now();
+        sink += out.size();
+        *build = t1 - t0;
+        *print = t2 - t1;
+    }
+
+    void bench_trees() {
+        std::printf( "%-24s %8s %14s %14s %14s\n", "report trees", "leaks", "build", "print", "memory" );
+        tracey::acquired = true; // as while reporting: tracey allocates from its metadata arena
+        const unsigned counts[] = { 2000, 20000 };
+        for( unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c ) {
+            std::vector< void * > frames = tree_stacks( counts[c] );
+            std::map< void *, std::string > names;
+            names[ (void *)((~0)-1) ] = "begin";
+            names[ (void *)((~0)-0) ] = "end";
+            for( size_t i = 0; i < frames.size(); ++i ) {
+                names[ frames[i] ] = tracey::string( "frame \1 (file.cc:\2)", frames[i], unsigned( i % tree_depth ) );
+            }
+            for( int flat = 0; flat < 2; ++flat ) {
+                double build, print;
+                size_t bytes;
+                tree_report( !!flat, frames, names, &build, &print, &bytes );
+                std::printf( "%-24s %8u %11.1f ms %11.1f ms %14s\n", flat ? "calltree" : "oak::tree", counts[c], build * 1e3, print * 1e3, tracey::human( bytes ).c_str() );
+            }
+        }
+        tracey::acquired = false;
+    }
+
+    // many leaks from a few callstacks: one tree walk per leak, against folding them by stack first
+    void bench_folding() {
+        std::printf( "%-24s %8s %14s %14s\n", "leaks into tree", "leaks", "per leak", "folded" );
+        tracey::acquired = true;
+        const unsigned sites = 64, leaks = 500000;
+        std::vector< void * > frames = tree_stacks( sites );
+        double t0 = now();
+        {
+            tracey::calltree cct;
+            for( unsigned l = 0; l < leaks; ++l ) {
+                uint32_t at = 0;
+                for( unsigned i = 0; i < tree_depth; ++i ) {
+                    at = cct.insert( at, frames[ ( l % sites ) * tree_depth + i ] );
+                    cct.nodes[at].value.hits += 1;
+                }
+                cct.nodes[at].value.size += 16;
+            }
+            cct.refresh();
+            sink += unsigned( cct.nodes.size() );
+        }
+        double t1 = now();
+        {
+            tracey::table< tracey::container::stack_total > folded;
+            for( unsigned l = 0; l < leaks; ++l ) {
+                tracey::container::stack_total &S = folded.insert( (const void *)( uintptr_t( 1 + l % sites ) << 4 ) );
+                S.count += 1;
+                S.bytes += 16;
+            }
+            tracey::calltree cct;
+            for( size_t s = 0; s < folded.capacity(); ++s ) {
+                const tracey::container::stack_total &S = folded.at( s );
+                if( !S.addr ) continue;
+                uint32_t at = 0;
+                for( unsigned i = 0; i < tree_depth; ++i ) {
+                    at = cct.insert( at, frames[ ( S.stack() - 1 ) * tree_depth + i ] );
+                    cct.nodes[at].value.hits += S.count;
+                }
+                cct.nodes[at].value.size += S.bytes;
+            }
+            cct.refresh();
+            sink += unsigned( cct.nodes.size() );
+        }
+        double t2 = now();
+        tracey::acquired = false;
+        std::printf( "%-24s %8u %11.1f ms %11.1f ms\n", "64 callstacks", leaks, ( t1 - t0 ) * 1e3, ( t2 - t1 ) * 1e3 );
+    }
+
+    // }
+}
+
+int main( int argc, char **argv ) {
+    if( argc > 1 && std::string( argv[1] ) == "--startup-child" ) {
+        return startup_child( argc > 2 );
+    }
+
+    bench_startup( argv[0] );
+    bench_unwinders();
+    bench_symbolizer();
+    bench_sampling();
+    bench_aligned();
+    bench_filter();
+    bench_zero_fills();
+    bench_backends();
+    bench_realloc();
+    bench_policy();
+    bench_trees();
+    bench_folding();
+
+    tracey::disable(); // do not show final report on exit
+    std::fflush( stdout ); // tracey quick-exits without flushing
+}
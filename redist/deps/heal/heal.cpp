@@ -0,0 +1,2591 @@
+// Heal is a lightweight C++ framework to aid and debug applications.
+// - rlyeh, zlib/libpng licensed // ~listening to Kalas - Monuments to Ruins
+
+// Callstack code is based on code by Magnus Norddahl (See http://goo.gl/LM5JB)
+// Mem/CPU OS code is based on code by David Robert Nadeau (See http://goo.gl/8P5Jqv)
+// Distributed under Creative Commons Attribution 3.0 Unported License
+// http://creativecommons.org/licenses/by/3.0/deed.en_US
+
+// A few tweaks before loading STL on MSVC
+// This improves stack unwinding.
+
+#ifdef _SECURE_SCL
+#undef _SECURE_SCL
+#endif
+#define _SECURE_SCL 0
+#ifdef _ITERATOR_DEBUG_LEVEL
+#undef _ITERATOR_DEBUG_LEVEL
+#define _ITERATOR_DEBUG_LEVEL 1
+#endif
+//#define _HAS_ITERATOR_DEBUGGING 0
+
+// Standard headers
+
+#include <cassert>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// System headers
+
+#ifdef _WIN32
+//#   define UNICODE
+//#   define _UNICODE
+#   include <winsock2.h>
+#   include <ws2tcpip.h>
+#   include <windows.h>
+#   include <commctrl.h>
+#   pragma comment(lib, "comctl32.lib")
+#   if defined _M_IX86
+#       pragma comment(linker, "/manifestdependency:\"type='win32' name='Microsoft.Windows.Common-Controls' version='6.0.0.0' processorArchitecture='x86' publicKeyToken='6595b64144ccf1df' language='*'\"")
+#   elif defined _M_IA64
+#       pragma comment(linker, "/manifestdependency:\"type='win32' name='Microsoft.Windows.Common-Controls' version='6.0.0.0' processorArchitecture='ia64' publicKeyToken='6595b64144ccf1df' language='*'\"")
+#   elif defined _M_X64
+#       pragma comment(linker, "/manifestdependency:\"type='win32' name='Microsoft.Windows.Common-Controls' version='6.0.0.0' processorArchitecture='amd64' publicKeyToken='6595b64144ccf1df' language='*'\"")
+#   else
+#       pragma comment(linker, "/manifestdependency:\"type='win32' name='Microsoft.Windows.Common-Controls' version='6.0.0.0' processorArchitecture='*' publicKeyToken='6595b64144ccf1df' language='*'\"")
+#   endif
+#   // unwinding
+#   if defined(DEBUG) || defined(_DEBUG)
+#       include <CrtDbg.h>
+#   endif
+#   include <DbgHelp.h>
+#   pragma comment(lib, "dbghelp.lib")
+#   ifndef TD_SHIELD_ICON
+#       define TD_SHIELD_ICON          MAKEINTRESOURCEW(-4)
+#   endif
+#else
+#   include <unistd.h>
+#   include <pthread.h>
+#   include <signal.h>
+#   include <sys/time.h>
+#   include <sys/types.h>
+//  --
+#   if defined(HAVE_SYS_SYSCTL_H) && \
+		!defined(_SC_NPROCESSORS_ONLN) && !defined(_SC_NPROC_ONLN)
+#       include <sys/param.h>
+#       include <sys/sysctl.h>
+#   endif
+//  --
+#   include <execinfo.h>
+//  --
+#   include <cxxabi.h>
+#endif
+
+#if defined(__linux__) && defined(__x86_64__)
+#   include <atomic>
+#   include <mutex>
+#   include <dlfcn.h>
+#   include <link.h>
+#   include <stddef.h>
+#   define HEAL_HAS_CFI 1
+#else
+#   define HEAL_HAS_CFI 0
+#endif
+
+#if defined(__linux__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#   include <mutex>
+#   include <thread>
+#   include <errno.h>
+#   include <dlfcn.h>
+#   include <elf.h>
+#   include <fcntl.h>
+#   include <link.h>
+#   include <spawn.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <sys/wait.h>
+#   define HEAL_HAS_ELF 1
+#else
+#   define HEAL_HAS_ELF 0
+#endif
+
+#ifdef __MINGW32__
+#define backtrace(a,b) 0
+#define backtrace_symbols(a,b) 0
+#endif
+
+// API
+#include "heal.hpp"
+
+namespace heal {
+	// sfstring is a safe string replacement that does not rely on stringstream
+	// this is actually safer on corner cases, like crashes, exception unwinding and in exit conditions
+	class sfstring : public std::string
+	{
+		public:
+
+		// basic constructors
+
+		sfstring() : std::string()
+		{}
+
+		template<size_t N>
+		sfstring( const char (&cstr)[N] ) : std::string( cstr )
+		{}
+
+		// constructor sugars
+
+#if 0
+		// version that may crash on /MT on destructors
+		// (just because it depends on std::locale which may be deinitialized before crashing code)
+		template <typename T>
+		/* explicit */ sfstring( const T &t ) : std::string()
+		{
+			std::stringstream ss;
+			ss.precision( std::numeric_limits< long double >::digits10 + 1 );
+			if( ss << t )
+				this->assign( ss.str() );
+		}
+#else
+		template<typename T>
+		sfstring( const T &t ) : std::string( std::string(t) )
+		{}
+		sfstring( const std::string &t ) : std::string( t )
+		{}
+
+		sfstring( const int &t ) : std::string() {
+			char buf[128];
+			if( sprintf(buf, "%d", t ) > 0 ) this->assign(buf);
+		}
+		sfstring( const uint16_t &t ) : std::string() {
+			char buf[128];
+			if( sprintf(buf, "%" SCNu16, t ) > 0 ) this->assign(buf);
+		}
+		sfstring( const uint32_t &t ) : std::string() {
+			char buf[128];
+			if( sprintf(buf, "%" SCNu32, t ) > 0 ) this->assign(buf);
+		}
+		sfstring( const uint64_t &t ) : std::string() {
+			char buf[128];
+			if( sprintf(buf, "%" SCNu64, t ) > 0 ) this->assign(buf);
+		}
+		sfstring( const float &t ) : std::string() {
+			char buf[128];
+			if( sprintf(buf, "%f", t ) > 0 ) this->assign(buf);
+		}
+		sfstring( const double &t ) : std::string() {
+			char buf[128];
+			if( sprintf(buf, "%lf", t ) > 0 ) this->assign(buf);
+		}
+$msvc(
+		sfstring( const DWORD &t ) : std::string() {
+			char buf[128];
+			if( sprintf(buf, "%" SCNu32, t ) > 0 ) this->assign(buf);
+		}
+)
+
+		sfstring( char *t ) : std::string( t ? t : "" )
+		{}
+		sfstring( const char *t ) : std::string( t ? t : "" )
+		{}
+
+		sfstring( void *t ) : std::string() {
+			char buf[128];
+			if( sprintf(buf, "%p", t ) > 0 ) this->assign(buf);
+		}
+		sfstring( const void *t ) : std::string() {
+			char buf[128];
+			if( sprintf(buf, "%p", t ) > 0 ) this->assign(buf);
+		}
+#endif
+
+		// extended constructors; safe formatting
+
+		private:
+		template<unsigned N>
+		std::string &safefmt( const std::string &fmt, std::string (&t)[N] ) {
+			for( std::string::const_iterator it = fmt.begin(), end = fmt.end(); it != end; ++it ) {
+				unsigned index(*it);
+				if( index <= N ) t[0] += t[index];
+				else t[0] += *it;
+			}
+			return t[0];
+		}
+		public:
+
+		template< typename T1 >
+		sfstring( const std::string &fmt, const T1 &t1 ) : std::string() {
+			std::string t[] = { std::string(), sfstring(t1) };
+			assign( safefmt( fmt, t ) );
+		}
+
+		template< typename T1, typename T2 >
+		sfstring( const std::string &fmt, const T1 &t1, const T2 &t2 ) : std::string() {
+			std::string t[] = { std::string(), sfstring(t1), sfstring(t2) };
+			assign( safefmt( fmt, t ) );
+		}
+
+		template< typename T1, typename T2, typename T3 >
+		sfstring( const std::string &fmt, const T1 &t1, const T2 &t2, const T3 &t3 ) : std::string() {
+			std::string t[] = { std::string(), sfstring(t1), sfstring(t2), sfstring(t3) };
+			assign( safefmt( fmt, t ) );
+		}
+
+		template< typename T1, typename T2, typename T3, typename T4 >
+		sfstring( const std::string &fmt, const T1 &t1, const T2 &t2, const T3 &t3, const T4 &t4 ) : std::string() {
+			std::string t[] = { std::string(), sfstring(t1), sfstring(t2), sfstring(t3), sfstring(t4) };
+			assign( safefmt( fmt, t ) );
+		}
+
+		template< typename T1, typename T2, typename T3, typename T4, typename T5 >
+		sfstring( const std::string &fmt, const T1 &t1, const T2 &t2, const T3 &t3, const T4 &t4, const T5 &t5 ) : std::string() {
+			std::string t[] = { std::string(), sfstring(t1), sfstring(t2), sfstring(t3), sfstring(t4), sfstring(t5) };
+			assign( safefmt( fmt, t ) );
+		}
+
+		template< typename T1, typename T2, typename T3, typename T4, typename T5, typename T6 >
+		sfstring( const std::string &fmt, const T1 &t1, const T2 &t2, const T3 &t3, const T4 &t4, const T5 &t5, const T6 &t6 ) : std::string() {
+			std::string t[] = { std::string(), sfstring(t1), sfstring(t2), sfstring(t3), sfstring(t4), sfstring(t5), sfstring(t6) };
+			assign( safefmt( fmt, t ) );
+		}
+
+		template< typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7 >
+		sfstring( const std::string &fmt, const T1 &t1, const T2 &t2, const T3 &t3, const T4 &t4, const T5 &t5, const T6 &t6, const T7 &t7 ) : std::string() {
+			std::string t[] = { std::string(), sfstring(t1), sfstring(t2), sfstring(t3), sfstring(t4), sfstring(t5), sfstring(t6), sfstring(t7) };
+			assign( safefmt( fmt, t ) );
+		}
+
+		// chaining operators
+
+		template< typename T >
+		sfstring &operator +=( const T &t ) {
+			return append( sfstring(t) ), *this;
+		}
+
+		template< typename T >
+		sfstring &operator <<( const T &t ) {
+			return append( sfstring(t) ), *this;
+		}
+
+		sfstring &operator <<( std::ostream &( *pf )(std::ostream &) ) {
+			return *pf == static_cast<std::ostream& ( * )(std::ostream&)>( std::endl ) ? (*this) += "\n", *this : *this;
+		}
+
+		// assignment sugars
+
+		template< typename T >
+		sfstring& operator=( const T &t ) {
+			if( &t != this ) {
+				*this = sfstring(t);
+			}
+			return *this;
+		}
+
+		sfstring &operator=( const char *t ) {
+			return assign( t ? t : "" ), *this;
+		}
+
+		std::string str() const {
+			return *this;
+		}
+
+		size_t count( const std::string &substr ) const {
+			size_t n = 0;
+			std::string::size_type pos = 0;
+			while( (pos = this->find( substr, pos )) != std::string::npos ) {
+				n++;
+				pos += substr.size();
+			}
+			return n;
+		}
+
+		sfstring replace( const std::string &target, const std::string &replacement ) const {
+			size_t found = 0;
+			sfstring s = *this;
+			while( ( found = s.find( target, found ) ) != std::string::npos ) {
+				s.std::string::replace( found, target.length(), replacement );
+				found += replacement.length();
+			}
+			return s;
+		}
+	};
+
+	class sfstrings : public std::deque< sfstring >
+	{
+		public:
+
+		sfstrings( unsigned size = 0 ) : std::deque< sfstring >( size )
+		{}
+
+		template <typename CONTAINER>
+		sfstrings( const CONTAINER &c ) : std::deque< sfstring >( c.begin(), c.end() )
+		{}
+
+		template <typename CONTAINER>
+		sfstrings &operator =( const CONTAINER &c ) {
+			if( &c != this ) {
+				*this = sfstrings( c );
+			}
+			return *this;
+		}
+
+		sfstring str( const char *format1 = "\1\n" ) const {
+			if( this->size() == 1 )
+				return *this->begin();
+
+			sfstring out;
+
+			for( const_iterator it = this->begin(); it != this->end(); ++it )
+				out += sfstring( format1, (*it) );
+
+			return out;
+		}
+
+		sfstring flat() const {
+			return str( "\1" );
+		}
+	};
+}
+
+// INFO MESSAGES
+// Reminders for retrieving symbols
+/*
+#  if $on($msvc)
+	$warning( "<heal/heal.cpp> says: do not forget /Zi, /Z7 or /C7 compiler settings! /Oy- also helps!" )
+#elif $on($clang)
+	$warning( "<heal/heal.cpp> says: do not forget -g compiler setting!" )
+#elif $on($gnuc)
+	$warning( "<heal/heal.cpp> says: do not forget -g -lpthread compiler settings!" )
+#endif
+*/
+// ASSERT
+
+namespace heal {
+
+std::vector< heal_callback_in > warns(1);
+std::vector< heal_callback_in > fails(1);
+
+namespace {
+	bool default_warn( const std::string &text ) {
+		if( text.size() ) {
+			alert( text, "Warning" );
+		}
+		return true;
+	}
+	bool default_fail( const std::string &text ) {
+		if( text.size() ) {
+			errorbox( text, "Error" );
+		}
+		if( !debugger() ) {
+			alert( "Could not launch debugger" );
+		}
+		return true;
+	}
+	const bool init_warns = (warns[0] = default_warn, true);
+	const bool init_fails = (fails[0] = default_fail, true);
+}
+
+void warn( const std::string &error ) {
+	static bool recursive = false;
+	if( !recursive ) {
+		recursive = true;
+		for( unsigned i = warns.size(); i--; ) {
+			if( warns[i] ) if( warns[i]( error ) ) break;
+		}
+		recursive = false;
+	}
+}
+
+void fail( const std::string &error ) {
+	static bool recursive = false;
+	if( !recursive ) {
+		recursive = true;
+		for( unsigned i = fails.size(); i--; ) {
+			if( fails[i] ) if( fails[i]( error ) ) break;
+		}
+		recursive = false;
+	}
+}
+
+bool is_asserting() {
+	bool asserting = false;
+	assert( asserting |= true );
+	return asserting;
+}
+
+// IS_DEBUG
+// IS_RELEASE
+
+bool is_debug() {
+	return $debug(true) $release(false);
+}
+bool is_release() {
+	return !is_debug();
+}
+
+bool is_devel() {
+	return $devel(true) $public(false);
+}
+bool is_public() {
+	return !is_devel();
+}
+
+// DEBUGGER
+
+#if $on($linux) || $on($apple)
+
+	// enable core dumps for debug builds
+	// after a crash try to do something like 'gdb ./a.out core'
+#   if defined(NDEBUG) || defined(_NDEBUG)
+		const bool are_coredumps_enabled = false;
+#   else
+#       include <sys/resource.h>
+		rlimit core_limit = { RLIM_INFINITY, RLIM_INFINITY };
+		const bool are_coredumps_enabled = setrlimit( RLIMIT_CORE, &core_limit ) == 0;
+#   endif
+
+	struct file {
+		static bool exists( const std::string &pathfile) {
+		/*struct stat buffer;
+		  return stat( pathfile.c_str(), &buffer ) == 0; */
+		  return access( pathfile.c_str(), F_OK ) != -1; // _access(fn,0) on win
+		}
+	};
+
+	bool has( const std::string &app ) {
+		return file::exists( std::string("/usr/bin/") + app );
+	}
+
+	std::string pipe( const std::string &sys, const std::string &sys2 = std::string() ) {
+		char buf[512];
+		std::string out;
+
+		FILE *fp = popen( (sys+sys2).c_str(), "r" );
+		if( fp ) {
+			while( !std::feof(fp) ) {
+				if( std::fgets(buf,sizeof(buf),fp) != NULL ) {
+					out += buf;
+				}
+			}
+			pclose(fp);
+		}
+
+		return out;
+	}
+
+	// gdb apparently opens FD(s) 3,4,5 (whereas a typical prog uses only stdin=0, stdout=1,stderr=2)
+	// Silviocesare and xorl
+	bool detect_gdb(void)
+	{
+		bool rc = false;
+		FILE *fd = fopen("/tmp", "r");
+
+		if( fileno(fd) > 5 )
+			rc = true;
+
+		fclose(fd);
+		return rc;
+	}
+
+#endif
+
+void breakpoint() {
+// os based
+
+	$windows(
+	DebugBreak();
+	)
+
+	$linux(
+	raise(SIGTRAP);
+//    asm("trap");
+//    asm("int3");
+//    kill( getpid(), SIGINT );
+	/*
+	kill( getpid(), SIGSTOP );
+	kill( getpid(), SIGTERM );
+	kill( getpid(), SIGHUP );
+	kill( getpid(), SIGTRAP );
+	*/
+	// kill( getpid(), SIGSEGV );
+	// raise(SIGTRAP); //POSIX
+	// raise(SIGINT);  //POSIX
+	)
+
+	$apple(
+	raise(SIGTRAP);
+	)
+
+// compiler based
+
+	//msvc
+	$msvc(
+	// "With native code, I prefer using int 3 vs DebugBreak, because the int 3 occurs right in the same stack frame and module as the code in question, whereas DebugBreak occurs one level down in another DLL, as shown in this callstack:"
+	// [ref] http://blogs.msdn.com/b/calvin_hsia/archive/2006/08/25/724572.aspx
+	// __debugbreak();
+	)
+
+	// gnuc
+	$gnuc(
+	//__builtin_trap();
+	//__asm__ __volatile__("int3");
+	)
+
+// standard
+
+	//abort();
+	//assert( !"<heal/heal.cpp> says: debugger() has been requested" );
+	// still here? duh, maybe we are in release mode...
+
+// host based
+
+	//macosx: asm {trap}            ; Halts a program running on PPC32 or PPC64.
+	//macosx: __asm {int 3}         ; Halts a program running on IA-32.
+
+	//$x86( // ifdef _M_X86
+	//__asm int 3;
+	//)
+}
+
+bool debugger( const std::string &reason )
+{
+	if( reason.size() > 0 )
+		errorbox( reason );
+
+// os based
+
+	$windows(
+		if( IsDebuggerPresent() ) {
+			return breakpoint(), true;
+		}
+	)
+
+	$linux(
+		if( detect_gdb() ) {
+			return breakpoint(), true;
+		}
+		// else try to invoke && attach to current process
+
+		static std::string sys, tmpfile;
+		sys = ( has("ddd") && false ? "/usr/bin/ddd" : ( has("gdb") ? "/usr/bin/gdb" : "" ));
+		tmpfile = "./heal.tmp.tmp"; //get_pipe("tempfile");
+		if( !sys.empty() ) {
+			std::string pid = std::to_string( getpid() );
+			// [ok]
+			// eval-command=bt
+			// -ex "bt full"
+			// gdb --batch --quiet -ex "thread apply all bt full" -ex "quit" ${exe} ${corefile}
+			sys = sys + (" --tui -q -ex 'set pagination off' -ex 'shell rm " +tmpfile+ "' -ex 'continue' -ex 'finish' -ex 'finish' -ex 'finish' --pid=") + pid + " --args `cat /proc/" + pid + "/cmdline`";
+			if( has("xterm") && false ) {
+				sys = std::string("/usr/bin/xterm 2>/dev/null -maximized -e \"") + sys + "\"";
+			} else {
+				//sys = std::string(/*"exec"*/ "/usr/bin/splitvt -upper \"") + sys + "\"";
+				//sys = std::string("/bin/bash -c \"") + sys + " && /usr/bin/reset\"";
+				sys = std::string("/bin/bash -c \"") + sys + "\"";
+			}
+
+		pipe( "echo heal.cpp says: waiting for debugger to catch pid > ", tmpfile );
+		std::thread( system, sys.c_str() ).detach();
+		while( file::exists(tmpfile) )
+			usleep( 250000 );
+				return true;
+		}
+	)
+
+	//errorbox( "<heal/heal.cpp> says:\n\nDebugger invokation failed.\nPlease attach a debugger now.", "Error!");
+	return false;
+}
+
+// ERRORBOX
+
+namespace {
+
+	template<typename T>
+	std::string to_string( const T &t, int digits = 20 ) {
+		std::stringstream ss;
+		ss.precision( digits );
+		ss << std::fixed << t;
+		return ss.str();
+	}
+
+	template<>
+	std::string to_string( const bool &boolean, int digits ) {
+		return boolean ? "true" : "false";
+	}
+
+	template<>
+	std::string to_string( const std::istream &is, int digits ) {
+		std::stringstream ss;
+		std::streamsize at = is.rdbuf()->pubseekoff(0,is.cur);
+		ss << is.rdbuf();
+		is.rdbuf()->pubseekpos(at);
+		return ss.str();
+	}
+
+	void show( const std::string &body = std::string(), const std::string &head = std::string(), const std::string &title = std::string(), bool is_error = false ) {
+		std::string headtitle = ( head.size() > 0 ? head + ": " + title : title );
+		std::string headtitlebody = ( headtitle.size() > 0 ? headtitle + ": " + body : body );
+		$windows(
+			$no(
+			int nButton;
+			auto icon = is_error ? TD_ERROR_ICON : TD_WARNING_ICON;
+			// TD_INFORMATION_ICON, TD_SHIELD_ICON
+			std::wstring wbody( body.begin(), body.end() );
+			std::wstring whead( head.begin(), head.end() );
+			std::wstring wtitle( title.begin(), title.end() );
+			HWND hWnd = ::GetActiveWindow(); // force modal
+			TaskDialog(hWnd, NULL, wtitle.c_str(), whead.c_str(), wbody.c_str(), TDCBF_OK_BUTTON, icon, &nButton );
+			)
+			$yes(
+			MessageBoxA( 0, body.c_str(), head.size() ? head.c_str() : "", 0 | ( is_error ? MB_ICONERROR : 0 ) | MB_SYSTEMMODAL );
+			)
+			return;
+		)
+		$linux(
+			if( has("whiptail") ) {
+				// gtkdialog3
+				// xmessage -file ~/.bashrc -buttons "Ok:1, Cancel:2, Help:3" -print -nearmouse
+				//std::string cmd = std::string("/usr/bin/zenity --information --text \"") + body + std::string("\" --title=\"") + headtitle + "\"";
+				//std::string cmd = std::string("/usr/bin/dialog --title \"") + headtitle + std::string("\" --msgbox \"") + body + "\" 0 0";
+				std::string cmd = std::string("/usr/bin/whiptail --title \"") + headtitle + std::string("\" --msgbox \"") + body + "\" 0 0";
+				//std::string cmd = std::string("/usr/bin/xmessage \"") + headtitle + body + "\"";
+				std::system( cmd.c_str() );
+				return;
+			}
+		)
+		// fallback
+		std::string s;
+		fprintf( stderr, "%s\n", headtitlebody.c_str() );
+		std::cout << "Press enter to continue..." << std::endl;
+		std::getline( std::cin, s );
+	}
+}
+
+void    alert(                                                    ) { show();                        }
+void    alert( const         char *text, const std::string &title ) { show( text, title );           }
+void    alert( const  std::string &text, const std::string &title ) { show( text, title );           }
+void    alert( const std::istream &text, const std::string &title ) { show( to_string(text), title ); }
+void    alert( const       size_t &text, const std::string &title ) { show( to_string(text), title ); }
+void    alert( const       double &text, const std::string &title ) { show( to_string(text), title ); }
+void    alert( const        float &text, const std::string &title ) { show( to_string(text), title ); }
+void    alert( const          int &text, const std::string &title ) { show( to_string(text), title ); }
+void    alert( const         char &text, const std::string &title ) { show( to_string(text), title ); }
+void    alert( const         bool &text, const std::string &title ) { show( to_string(text), title ); }
+void errorbox( const  std::string &body, const std::string &title ) { show( body, title, "", true );  }
+
+// DEMANGLE
+
+#if 1
+#   // Disable optimizations. Nothing gets inlined. You get pleasant stacktraces to work with.
+#   // This is the default setting.
+#   ifdef _MSC_VER
+#       pragma optimize( "gsy", off )       // disable optimizations on msvc
+#   else
+#       pragma OPTIMIZE OFF                 // disable optimizations on gcc 4.4+
+#   endif
+#else
+#   // Enable optimizations. HEAL performs better. However, functions get inlined (specially new/delete operators).
+#   // This behaviour is disabled by default, since you may get wrong stacktraces.
+#   ifdef _MSC_VER
+#       pragma optimize( "gsy", on )        // enable optimizations on msvc
+#   else
+#       pragma GCC optimize                 // enable optimizations on gcc 4.4+
+#       pragma optimize                     // enable optimizations on a few other compilers, hopefully
+#   endif
+#endif
+
+std::string demangle( const std::string &mangled ) {
+	$apple({
+		std::stringstream ss;
+		if( !(ss << mangled) )
+			return mangled;
+		std::string number, filename, address, funcname, plus, offset;
+		if( !(ss >> number >> filename >> address >> funcname >> plus >> offset) )
+			return mangled;
+		int status = 0;
+		char *demangled = abi::__cxa_demangle(funcname.c_str(), NULL, NULL, &status);
+		heal::sfstring out;
+		if( status == 0 && demangled ) {
+			out = std::string() + demangled + " ([" + filename + "]:" + offset + ")";
+		} else {
+			out = std::string() + funcname  + " ([" + filename + "]:" + offset + ")";
+		}
+		if( demangled ) free( demangled );
+		return out;
+	})
+	$linux({
+		// "module(function+offset) [address]", as told by backtrace_symbols()
+		std::string::size_type open = mangled.find_first_of( '(' ), plus = mangled.find_first_of( "+)", open );
+		if( open == std::string::npos || plus == std::string::npos || plus == open + 1 )
+			return mangled;
+		std::string funcname = mangled.substr( open + 1, plus - open - 1 );
+		int status = 0;
+		char *demangled = abi::__cxa_demangle( funcname.c_str(), 0, 0, &status );
+		heal::sfstring out;
+		out = std::string() + ( status == 0 && demangled ? demangled : funcname.c_str() ) + " ([" + mangled.substr( 0, open ) + "])";
+		if( demangled ) free( demangled );
+		return out;
+	})
+	$windows({
+		char demangled[1024];
+		return (UnDecorateSymbolName(mangled.c_str(), demangled, sizeof( demangled ), UNDNAME_COMPLETE)) ? std::string(demangled) : mangled;
+	})
+	/*
+	$gnuc({
+		std::string out;
+		int status = 0;
+		char *demangled = abi::__cxa_demangle(mangled.c_str(), 0, 0, &status);
+		out = ( status == 0 && demangled ? std::string(demangled) : mangled );
+		if( demangled ) free( demangled );
+		return out;
+	})
+	*/
+		return mangled;
+}
+
+// STACK BOUNDS
+
+namespace {
+	// per-thread stack limits, so a corrupt or missing frame chain cannot make unwinders fault
+	bool stack_bounds( uintptr_t &lo, uintptr_t &hi ) {
+		$linux({
+			static $tls(uintptr_t) stack_lo = 0;
+			static $tls(uintptr_t) stack_hi = 0;
+			if( !stack_hi ) {
+				pthread_attr_t attr;
+				void *addr = 0;
+				size_t size = 0;
+				if( pthread_getattr_np( pthread_self(), &attr ) == 0 ) {
+					pthread_attr_getstack( &attr, &addr, &size );
+					pthread_attr_destroy( &attr );
+				}
+				stack_lo = (uintptr_t)addr;
+				stack_hi = (uintptr_t)addr + size;
+			}
+			lo = stack_lo;
+			hi = stack_hi;
+			return hi != 0;
+		})
+		return false;
+	}
+}
+
+// CFI UNWINDER
+// Walks the stack by applying the DWARF call frame information found in .eh_frame, so it works on
+// -fomit-frame-pointer builds. Modules are found with dl_iterate_phdr() and looked up through their
+// .eh_frame_hdr tables. Rules are compiled once per return address into a lock-free cache.
+
+#if HEAL_HAS_CFI
+
+namespace cfi {
+
+	// dwarf register numbers on x86-64
+	enum { REG_RBP = 6, REG_RSP = 7, REG_RA = 16 };
+
+	// compiled rule: bits 0-1 cfa base (1 rsp, 2 rbp, 3 end of stack, 0 unknown),
+	// bits 8-23 rbp slot offset (0 if rbp is unchanged), bits 24-39 return address offset,
+	// bits 40-63 cfa offset. all offsets are signed and relative to cfa.
+	enum { RULE_NONE = 0, RULE_RSP = 1, RULE_RBP = 2, RULE_END = 3 };
+
+	inline uint64_t pack( unsigned base, int64_t cfa_off, int64_t ra_off, int64_t rbp_off ) {
+		if( cfa_off < -(1 << 23) || cfa_off >= (1 << 23) ) return RULE_NONE;
+		if( ra_off < -32768 || ra_off > 32767 || rbp_off < -32768 || rbp_off > 32767 ) return RULE_NONE;
+		return uint64_t(base) | ( uint64_t(uint16_t(rbp_off)) << 8 ) | ( uint64_t(uint16_t(ra_off)) << 24 ) | ( uint64_t(cfa_off) << 40 );
+	}
+	inline unsigned base_of( uint64_t rule ) { return unsigned( rule & 3 ); }
+	inline int64_t rbp_of( uint64_t rule ) { return int16_t( rule >> 8 ); }
+	inline int64_t ra_of( uint64_t rule ) { return int16_t( rule >> 24 ); }
+	inline int64_t cfa_of( uint64_t rule ) { return int64_t( rule ) >> 40; }
+
+	struct reader {
+		const uint8_t *p;
+
+		uint8_t u8() {
+			return *p++;
+		}
+		template<typename T>
+		T get() {
+			T t;
+			std::memcpy( &t, p, sizeof(T) );
+			return p += sizeof(T), t;
+		}
+		uint64_t uleb() {
+			uint64_t r = 0;
+			unsigned shift = 0;
+			uint8_t b;
+			do { b = *p++; if( shift < 64 ) r |= uint64_t(b & 0x7f) << shift; shift += 7; } while( b & 0x80 );
+			return r;
+		}
+		int64_t sleb() {
+			int64_t r = 0;
+			unsigned shift = 0;
+			uint8_t b;
+			do { b = *p++; if( shift < 64 ) r |= int64_t(b & 0x7f) << shift; shift += 7; } while( b & 0x80 );
+			if( shift < 64 && (b & 0x40) ) r |= -(int64_t(1) << shift);
+			return r;
+		}
+		// DW_EH_PE encoded pointer
+		bool encoded( uint8_t enc, uintptr_t datarel, uintptr_t &out ) {
+			if( enc == 0xff ) return out = 0, true;
+			uintptr_t base = (uintptr_t)p, v;
+			switch( enc & 0x0f ) {
+				case 0x00: v = get<uintptr_t>(); break;
+				case 0x01: v = uleb(); break;
+				case 0x02: v = get<uint16_t>(); break;
+				case 0x03: v = get<uint32_t>(); break;
+				case 0x04: v = get<uint64_t>(); break;
+				case 0x09: v = sleb(); break;
+				case 0x0a: v = get<int16_t>(); break;
+				case 0x0b: v = get<int32_t>(); break;
+				case 0x0c: v = get<int64_t>(); break;
+				default: return false;
+			}
+			switch( enc & 0x70 ) {
+				case 0x00: break;
+				case 0x10: v += base; break;
+				case 0x30: v += datarel; break;
+				default: return false;
+			}
+			if( enc & 0x80 ) v = *(const uintptr_t *)v;
+			return out = v, true;
+		}
+	};
+
+	// modules {
+
+	struct module {
+		uintptr_t lo, hi;       // executable range
+		const uint8_t *hdr;     // .eh_frame_hdr
+	};
+
+	enum { MAX_MODULES = 1024 };
+	module modules[ MAX_MODULES ];
+	unsigned num_modules = 0;
+	unsigned long long loads = ~0ULL, unloads = ~0ULL;
+	std::atomic<unsigned> generation( 0 );  // bumped by every unload; see dlclose() below
+	unsigned scanned = 0;                   // generation the table was scanned at
+	std::mutex modules_mutex;
+
+	struct scan {
+		unsigned long long loads, unloads;
+		unsigned count;
+	};
+
+	int collect( struct dl_phdr_info *info, size_t size, void *data ) {
+		scan &sc = *(scan *)data;
+		if( size >= offsetof(struct dl_phdr_info, dlpi_subs) + sizeof(info->dlpi_subs) ) {
+			sc.loads = info->dlpi_adds;
+			sc.unloads = info->dlpi_subs;
+		}
+		if( sc.count >= MAX_MODULES )
+			return 0;
+		module m = { ~uintptr_t(0), 0, 0 };
+		for( unsigned i = 0; i < info->dlpi_phnum; ++i ) {
+			const ElfW(Phdr) &ph = info->dlpi_phdr[i];
+			uintptr_t start = info->dlpi_addr + ph.p_vaddr;
+			if( ph.p_type == PT_GNU_EH_FRAME ) {
+				m.hdr = (const uint8_t *)start;
+			}
+			if( ph.p_type == PT_LOAD && (ph.p_flags & PF_X) ) {
+				m.lo = std::min( m.lo, start );
+				m.hi = std::max( m.hi, start + ph.p_memsz );
+			}
+		}
+		if( m.hdr && m.lo < m.hi ) {
+			modules[ sc.count++ ] = m;
+		}
+		return 0;
+	}
+
+	// rescans loaded modules if any dlopen()/dlclose() happened since last scan. modules_mutex must be held
+	bool refresh() {
+		scan sc = { 0, 0, 0 };
+		dl_iterate_phdr( collect, &sc );
+		bool changed = sc.loads != loads || sc.unloads != unloads;
+		if( sc.unloads != unloads ) {
+			generation++; // cached rules may belong to unloaded code
+		}
+		num_modules = sc.count;
+		loads = sc.loads;
+		unloads = sc.unloads;
+		scanned = generation.load();
+		return changed;
+	}
+
+	const module *find_module( uintptr_t pc ) {
+		for( unsigned i = 0; i < num_modules; ++i ) {
+			if( pc >= modules[i].lo && pc < modules[i].hi ) return &modules[i];
+		}
+		return 0;
+	}
+
+	// }
+
+	// frame description entries {
+
+	const uint8_t *find_fde( const uint8_t *hdr, uintptr_t pc ) {
+		reader r = { hdr };
+		if( r.u8() != 1 ) return 0;
+		uint8_t eh_frame_ptr_enc = r.u8(), fde_count_enc = r.u8(), table_enc = r.u8();
+		uintptr_t eh_frame, count;
+		if( !r.encoded( eh_frame_ptr_enc, (uintptr_t)hdr, eh_frame ) || !r.encoded( fde_count_enc, (uintptr_t)hdr, count ) )
+			return 0;
+		if( table_enc != 0x3b ) // datarel|sdata4; the only one emitted by linkers
+			return 0;
+		const uint8_t *table = r.p;
+		size_t lo = 0, hi = count;
+		while( lo < hi ) {
+			size_t mid = lo + (hi - lo) / 2;
+			int32_t loc;
+			std::memcpy( &loc, table + mid * 8, 4 );
+			if( (uintptr_t)hdr + loc <= pc ) lo = mid + 1; else hi = mid;
+		}
+		if( !lo ) return 0;
+		int32_t fde;
+		std::memcpy( &fde, table + (lo - 1) * 8 + 4, 4 );
+		return hdr + fde;
+	}
+
+	struct state {
+		unsigned cfa_reg;
+		int64_t cfa_off, ra_off, rbp_off;
+		bool ra_saved, rbp_saved;
+	};
+
+	// runs cfa program until location goes past pc. returns false on unsupported opcodes
+	bool execute( reader r, const uint8_t *end, uintptr_t loc, uintptr_t pc, uint64_t code_align, int64_t data_align, const state &initial, state &st ) {
+		enum { MAX_REMEMBERED = 8 };
+		state remembered[ MAX_REMEMBERED ];
+		unsigned depth = 0;
+
+		while( r.p < end ) {
+			uint8_t op = r.u8();
+			uint64_t reg;
+			int64_t off;
+			switch( op & 0xc0 ) {
+				case 0x40: // DW_CFA_advance_loc
+					loc += (op & 0x3f) * code_align;
+					if( loc > pc ) return true;
+					continue;
+				case 0x80: // DW_CFA_offset
+					reg = op & 0x3f;
+					off = int64_t( r.uleb() ) * data_align;
+					if( reg == REG_RA ) st.ra_off = off, st.ra_saved = true;
+					if( reg == REG_RBP ) st.rbp_off = off, st.rbp_saved = true;
+					continue;
+				case 0xc0: // DW_CFA_restore
+					reg = op & 0x3f;
+					if( reg == REG_RA ) st.ra_off = initial.ra_off, st.ra_saved = initial.ra_saved;
+					if( reg == REG_RBP ) st.rbp_off = initial.rbp_off, st.rbp_saved = initial.rbp_saved;
+					continue;
+			}
+			switch( op ) {
+				case 0x00: // DW_CFA_nop
+					break;
+				case 0x02: // DW_CFA_advance_loc1
+					loc += r.u8() * code_align;
+					if( loc > pc ) return true;
+					break;
+				case 0x03: // DW_CFA_advance_loc2
+					loc += r.get<uint16_t>() * code_align;
+					if( loc > pc ) return true;
+					break;
+				case 0x04: // DW_CFA_advance_loc4
+					loc += r.get<uint32_t>() * code_align;
+					if( loc > pc ) return true;
+					break;
+				case 0x05: // DW_CFA_offset_extended
+				case 0x11: // DW_CFA_offset_extended_sf
+					reg = r.uleb();
+					off = ( op == 0x05 ? int64_t( r.uleb() ) : r.sleb() ) * data_align;
+					if( reg == REG_RA ) st.ra_off = off, st.ra_saved = true;
+					if( reg == REG_RBP ) st.rbp_off = off, st.rbp_saved = true;
+					break;
+				case 0x06: // DW_CFA_restore_extended
+					reg = r.uleb();
+					if( reg == REG_RA ) st.ra_off = initial.ra_off, st.ra_saved = initial.ra_saved;
+					if( reg == REG_RBP ) st.rbp_off = initial.rbp_off, st.rbp_saved = initial.rbp_saved;
+					break;
+				case 0x07: // DW_CFA_undefined
+					reg = r.uleb();
+					if( reg == REG_RA ) st.ra_saved = false; // outermost frame
+					if( reg == REG_RBP ) st.rbp_saved = false;
+					break;
+				case 0x08: // DW_CFA_same_value
+					reg = r.uleb();
+					if( reg == REG_RBP ) st.rbp_saved = false;
+					break;
+				case 0x09: // DW_CFA_register
+					reg = r.uleb(); r.uleb();
+					if( reg == REG_RA || reg == REG_RBP ) return false;
+					break;
+				case 0x0a: // DW_CFA_remember_state
+					if( depth == MAX_REMEMBERED ) return false;
+					remembered[ depth++ ] = st;
+					break;
+				case 0x0b: // DW_CFA_restore_state
+					if( !depth ) return false;
+					st = remembered[ --depth ];
+					break;
+				case 0x0c: // DW_CFA_def_cfa
+					st.cfa_reg = unsigned( r.uleb() );
+					st.cfa_off = int64_t( r.uleb() );
+					break;
+				case 0x12: // DW_CFA_def_cfa_sf
+					st.cfa_reg = unsigned( r.uleb() );
+					st.cfa_off = r.sleb() * data_align;
+					break;
+				case 0x0d: // DW_CFA_def_cfa_register
+					st.cfa_reg = unsigned( r.uleb() );
+					break;
+				case 0x0e: // DW_CFA_def_cfa_offset
+					st.cfa_off = int64_t( r.uleb() );
+					break;
+				case 0x13: // DW_CFA_def_cfa_offset_sf
+					st.cfa_off = r.sleb() * data_align;
+					break;
+				case 0x14: // DW_CFA_val_offset
+				case 0x15: // DW_CFA_val_offset_sf
+					reg = r.uleb();
+					if( op == 0x14 ) r.uleb(); else r.sleb();
+					if( reg == REG_RA || reg == REG_RBP ) return false;
+					break;
+				case 0x10: // DW_CFA_expression
+				case 0x16: // DW_CFA_val_expression
+					reg = r.uleb();
+					r.p += r.uleb();
+					if( reg == REG_RA || reg == REG_RBP ) return false;
+					break;
+				case 0x2e: // DW_CFA_GNU_args_size
+					r.uleb();
+					break;
+				case 0x0f: // DW_CFA_def_cfa_expression
+				default:
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// compiles the unwinding rule that applies at pc, or RULE_NONE
+	uint64_t compile( const uint8_t *fde, uintptr_t pc ) {
+		reader r = { fde };
+		uint32_t length = r.get<uint32_t>();
+		if( !length || length == 0xffffffff ) return RULE_NONE; // terminator or 64-bit dwarf
+		const uint8_t *fde_end = r.p + length;
+		const uint8_t *cie_pointer = r.p;
+		uint32_t cie_offset = r.get<uint32_t>();
+		if( !cie_offset ) return RULE_NONE; // not a fde
+
+		// common information entry
+		reader c = { cie_pointer - cie_offset };
+		uint32_t cie_length = c.get<uint32_t>();
+		if( !cie_length || cie_length == 0xffffffff ) return RULE_NONE;
+		const uint8_t *cie_end = c.p + cie_length;
+		c.get<uint32_t>(); // cie id
+		uint8_t version = c.u8();
+		const char *augmentation = (const char *)c.p;
+		c.p += std::strlen( augmentation ) + 1;
+		if( version >= 4 ) c.p += 2; // address and segment selector sizes
+		uint64_t code_align = c.uleb();
+		int64_t data_align = c.sleb();
+		if( version == 1 ) c.u8(); else c.uleb(); // return address register
+		uint8_t fde_encoding = 0;
+		bool has_augmentation_data = augmentation[0] == 'z';
+		if( has_augmentation_data ) {
+			uint64_t len = c.uleb();
+			const uint8_t *data_end = c.p + len;
+			for( const char *a = augmentation + 1; *a; ++a ) {
+				uintptr_t dummy;
+				/**/ if( *a == 'R' ) fde_encoding = c.u8();
+				else if( *a == 'L' ) c.u8();
+				else if( *a == 'P' ) { uint8_t enc = c.u8(); if( !c.encoded( enc & 0x7f, 0, dummy ) ) return RULE_NONE; }
+				else if( *a == 'S' || *a == 'B' ) {}
+				else return RULE_NONE;
+			}
+			c.p = data_end;
+		} else if( augmentation[0] ) {
+			return RULE_NONE;
+		}
+
+		// address range covered by this fde
+		uintptr_t pc_begin, pc_range;
+		if( !r.encoded( fde_encoding, 0, pc_begin ) || !r.encoded( fde_encoding & 0x0f, 0, pc_range ) )
+			return RULE_NONE;
+		if( pc < pc_begin || pc >= pc_begin + pc_range )
+			return RULE_NONE;
+		if( has_augmentation_data ) {
+			uint64_t len = r.uleb();
+			r.p += len;
+		}
+
+		// cie initial instructions, then fde instructions up to pc
+		state initial = { REG_RSP, 8, -8, 0, true, false }, st;
+		if( !execute( c, cie_end, pc_begin, pc, code_align, data_align, initial, initial ) )
+			return RULE_NONE;
+		st = initial;
+		if( !execute( r, fde_end, pc_begin, pc, code_align, data_align, initial, st ) )
+			return RULE_NONE;
+
+		if( !st.ra_saved ) return RULE_END;
+		if( st.cfa_reg != REG_RSP && st.cfa_reg != REG_RBP ) return RULE_NONE;
+		return pack( st.cfa_reg == REG_RSP ? RULE_RSP : RULE_RBP, st.cfa_off, st.ra_off, st.rbp_saved ? st.rbp_off : 0 );
+	}
+
+	// }
+
+	// lock-free pc -> rule cache {
+	// a writer claims an empty slot with a pending key, stores the rule, then publishes the key.
+	// readers only accept fully published keys, and recheck them after reading the rule. keys carry the
+	// module generation, so rules of unloaded modules stop matching, and their slots are reused.
+
+	enum { CACHE_BITS = 14, CACHE_SIZE = 1 << CACHE_BITS, MAX_PROBES = 16 };
+	const uint64_t PENDING = ~0ULL;
+
+	struct slot {
+		std::atomic<uint64_t> key;
+		std::atomic<uint64_t> rule;
+	};
+	slot cache[ CACHE_SIZE ];
+
+	inline bool stale( uint64_t k, uint64_t key ) {
+		return k && k != PENDING && ( k >> 48 ) != ( key >> 48 );
+	}
+
+	uint64_t lookup( uintptr_t pc ) {
+		unsigned gen = generation.load();
+		uint64_t key = ( uint64_t(pc) & 0xFFFFFFFFFFFFULL ) | ( uint64_t( gen & 0xFFFF ) << 48 );
+		size_t home = size_t( ( key * 0x9E3779B97F4A7C15ULL ) >> (64 - CACHE_BITS) );
+
+		for( unsigned i = 0; i < MAX_PROBES; ++i ) {
+			slot &s = cache[ (home + i) & (CACHE_SIZE - 1) ];
+			uint64_t k = s.key.load( std::memory_order_acquire );
+			if( k == key ) {
+				uint64_t rule = s.rule.load( std::memory_order_acquire );
+				if( s.key.load( std::memory_order_relaxed ) == key ) return rule;
+				break; // evicted meanwhile
+			}
+			if( !k ) break;
+		}
+
+		// slow path: find module and fde, then compile its rule
+		uint64_t rule = RULE_NONE;
+		modules_mutex.lock();
+		if( scanned != generation.load() ) refresh(); // something was unloaded; the table may be stale
+		const module *m = find_module( pc );
+		if( !m && refresh() ) m = find_module( pc );
+		if( m ) {
+			if( const uint8_t *fde = find_fde( m->hdr, pc ) ) rule = compile( fde, pc );
+		}
+		modules_mutex.unlock();
+		if( !m ) return rule; // unknown code; do not cache, it may be dlopen()ed later
+		if( generation.load() != gen ) return rule; // key is outdated already
+
+		for( unsigned i = 0; i < MAX_PROBES; ++i ) {
+			slot &s = cache[ (home + i) & (CACHE_SIZE - 1) ];
+			uint64_t k = s.key.load( std::memory_order_acquire );
+			if( k == key ) break;
+			if( ( !k || stale( k, key ) ) && s.key.compare_exchange_strong( k, PENDING ) ) {
+				s.rule.store( rule, std::memory_order_relaxed );
+				s.key.store( key, std::memory_order_release );
+				break;
+			}
+		}
+		return rule;
+	}
+
+	// }
+
+	unsigned walk( uintptr_t pc, uintptr_t sp, uintptr_t bp, void **out_frames, unsigned max_frames, unsigned frames_to_skip ) {
+		uintptr_t lo, hi;
+		if( !stack_bounds( lo, hi ) ) return 0;
+
+		unsigned captured = 0;
+		for( bool first = true; captured < max_frames; first = false ) {
+			// return addresses point past the call; look the call itself up
+			uint64_t rule = lookup( first ? pc : pc - 1 );
+			unsigned base = base_of( rule );
+			if( base != RULE_RSP && base != RULE_RBP ) break;
+
+			uintptr_t cfa = ( base == RULE_RSP ? sp : bp ) + cfa_of( rule );
+			uintptr_t ra_at = cfa + ra_of( rule );
+			if( cfa < lo || cfa > hi || ra_at < lo || ra_at + sizeof(void *) > hi ) break;
+			uintptr_t ra = *(const uintptr_t *)ra_at;
+			if( rbp_of( rule ) ) {
+				uintptr_t bp_at = cfa + rbp_of( rule );
+				if( bp_at < lo || bp_at + sizeof(void *) > hi ) break;
+				bp = *(const uintptr_t *)bp_at;
+			}
+			if( !ra || cfa <= sp ) break;
+			sp = cfa;
+			pc = ra;
+			if( frames_to_skip ) --frames_to_skip;
+			else out_frames[ captured++ ] = (void *)ra;
+		}
+		return captured;
+	}
+}
+
+// unloads are learnt here rather than by asking the loader on every capture, which takes its lock.
+// bumped after the module is gone, so rules cached meanwhile carry the old generation and stop matching
+extern "C" int dlclose( void *handle ) throw() {
+	static int (*next)( void * ) = (int (*)( void * ))dlsym( RTLD_NEXT, "dlclose" );
+	int result = next ? next( handle ) : -1;
+	cfi::generation++;
+	return result;
+}
+
+#endif
+
+// SYMBOLIZER
+// Resolves addresses in-process, so reports never spawn addr2line. Modules are found with
+// dl_iterate_phdr() and mapped read-only the first time one of their addresses is looked up; then
+// .symtab (or .dynsym) becomes a sorted table of functions and .debug_line a sorted table of rows.
+// Every lookup is a couple of binary searches on link-time addresses (runtime address - load bias).
+
+#if HEAL_HAS_ELF
+
+namespace elf {
+
+	struct symbol {
+		uintptr_t lo, hi;           // link-time range; sizeless symbols end where the next one starts
+		const char *name;           // into the mapped string table
+	};
+
+	struct file {
+		const char *dir, *name;     // into the mapped line tables
+	};
+
+	struct row {
+		uintptr_t addr;             // link-time address
+		unsigned file, line;        // line 0 ends a sequence
+	};
+
+	struct image {
+		std::string path, name;     // file mapped, and name shown in reports
+		std::string build_id;       // GNU build-id as hex, if the module has one
+		uintptr_t bias, lo, hi;     // load bias; runtime range of loadable segments
+		const uint8_t *data;
+		size_t size;
+		bool parsed, lines;         // lines: has its own .debug_line (not split into a separate debug file)
+		std::mutex lock;            // held while parsing
+		std::vector<symbol> symbols;
+		std::vector<file> files;
+		std::vector<row> rows;
+	};
+
+	// bounded little-endian reader; reading past the end yields zeros and stays at the end
+	struct cursor {
+		const uint8_t *p, *end;
+
+		bool left( uint64_t n ) const {
+			return uint64_t( end - p ) >= n;
+		}
+		uint64_t fixed( unsigned n ) {
+			uint64_t v = 0;
+			if( n > 8 || !left( n ) ) return p = end, 0;
+			std::memcpy( &v, p, n );
+			return p += n, v;
+		}
+		uint64_t uleb() {
+			uint64_t r = 0;
+			unsigned shift = 0;
+			uint8_t b;
+			do { if( p >= end ) return r; b = *p++; if( shift < 64 ) r |= uint64_t(b & 0x7f) << shift; shift += 7; } while( b & 0x80 );
+			return r;
+		}
+		int64_t sleb() {
+			int64_t r = 0;
+			unsigned shift = 0;
+			uint8_t b;
+			do { if( p >= end ) return r; b = *p++; if( shift < 64 ) r |= int64_t(b & 0x7f) << shift; shift += 7; } while( b & 0x80 );
+			if( shift < 64 && (b & 0x40) ) r |= -(int64_t(1) << shift);
+			return r;
+		}
+		const char *str() {
+			const uint8_t *nul = (const uint8_t *)std::memchr( p, 0, end - p );
+			if( !nul ) return p = end, "";
+			const char *s = (const char *)p;
+			return p = nul + 1, s;
+		}
+	};
+
+	struct blob {
+		const uint8_t *data;
+		size_t size;
+
+		const char *at( uint64_t offset ) const {
+			return offset < size && std::memchr( data + offset, 0, size - offset ) ? (const char *)data + offset : "";
+		}
+	};
+
+	// mapping {
+
+	bool map( image &im ) {
+		int fd = open( im.path.c_str(), O_RDONLY | O_CLOEXEC );
+		if( fd < 0 )
+			return false;
+		struct stat st;
+		void *data = MAP_FAILED;
+		if( fstat( fd, &st ) == 0 && size_t( st.st_size ) >= sizeof(ElfW(Ehdr)) ) {
+			data = mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		}
+		close( fd );
+		if( data == MAP_FAILED )
+			return false;
+		const ElfW(Ehdr) &eh = *(const ElfW(Ehdr) *)data;
+		if( std::memcmp( eh.e_ident, ELFMAG, SELFMAG ) || eh.e_ident[EI_CLASS] != ( sizeof(void *) == 8 ? ELFCLASS64 : ELFCLASS32 ) ||
+			eh.e_shentsize != sizeof(ElfW(Shdr)) || eh.e_shstrndx >= eh.e_shnum ||
+			eh.e_shoff > size_t( st.st_size ) || eh.e_shnum > ( size_t( st.st_size ) - eh.e_shoff ) / sizeof(ElfW(Shdr)) ) {
+			munmap( data, st.st_size );
+			return false;
+		}
+		im.data = (const uint8_t *)data;
+		im.size = st.st_size;
+		return true;
+	}
+
+	// section contents, if they lie within the file and are stored uncompressed
+	blob contents( const image &im, const ElfW(Shdr) &sh ) {
+		blob b = { 0, 0 };
+		if( sh.sh_type != SHT_NOBITS && !( sh.sh_flags & SHF_COMPRESSED ) && sh.sh_offset <= im.size && sh.sh_size <= im.size - sh.sh_offset ) {
+			b.data = im.data + sh.sh_offset;
+			b.size = sh.sh_size;
+		}
+		return b;
+	}
+
+	// }
+
+	// symbols {
+
+	bool by_lo( const symbol &a, const symbol &b ) {
+		return a.lo < b.lo;
+	}
+	bool below_symbol( uintptr_t addr, const symbol &s ) {
+		return addr < s.lo;
+	}
+
+	void load_symbols( image &im, const ElfW(Shdr) *sh, unsigned count, unsigned type ) {
+		for( unsigned i = 0; i < count; ++i ) {
+			if( sh[i].sh_type != type || sh[i].sh_link >= count || sh[i].sh_entsize != sizeof(ElfW(Sym)) )
+				continue;
+			blob table = contents( im, sh[i] ), names = contents( im, sh[ sh[i].sh_link ] );
+			const ElfW(Sym) *sym = (const ElfW(Sym) *)table.data;
+			for( size_t j = 0, n = table.size / sizeof(ElfW(Sym)); j < n; ++j ) {
+				unsigned kind = ELF32_ST_TYPE( sym[j].st_info ); // same in both classes
+				if( ( kind == STT_FUNC || kind == STT_GNU_IFUNC ) && sym[j].st_shndx != SHN_UNDEF && sym[j].st_value ) {
+					symbol s = { uintptr_t( sym[j].st_value ), uintptr_t( sym[j].st_value + sym[j].st_size ), names.at( sym[j].st_name ) };
+					im.symbols.push_back( s );
+				}
+			}
+		}
+	}
+
+	void sort_symbols( image &im ) {
+		std::vector<symbol> &s = im.symbols;
+		std::stable_sort( s.begin(), s.end(), by_lo );
+		size_t kept = 0;
+		for( size_t i = 0; i < s.size(); ++i ) {
+			if( kept && s[kept - 1].lo == s[i].lo ) { // aliases; keep the sized one
+				if( s[i].hi > s[kept - 1].hi ) s[kept - 1].hi = s[i].hi;
+				continue;
+			}
+			s[ kept++ ] = s[i];
+		}
+		s.resize( kept );
+		for( size_t i = 0; i < s.size(); ++i ) {
+			if( s[i].hi == s[i].lo ) s[i].hi = i + 1 < s.size() ? s[i + 1].lo : s[i].lo + 1;
+		}
+	}
+
+	const symbol *find_symbol( const image &im, uintptr_t addr ) {
+		std::vector<symbol>::const_iterator it = std::upper_bound( im.symbols.begin(), im.symbols.end(), addr, below_symbol );
+		if( it == im.symbols.begin() ) return 0;
+		--it;
+		return addr < it->hi ? &*it : 0;
+	}
+
+	// }
+
+	// line tables {
+
+	enum { DW_LNCT_path = 1, DW_LNCT_directory_index = 2 };
+
+	// reads one attribute of a dwarf 5 directory or file entry. false on forms that cannot be skipped
+	bool attribute( cursor &c, uint64_t form, bool dwarf64, const blob &str, const blob &line_str, const char *&text, uint64_t &num ) {
+		switch( form ) {
+			case 0x08: text = c.str(); return true;                                      // DW_FORM_string
+			case 0x0e: text = str.at( c.fixed( dwarf64 ? 8 : 4 ) ); return true;         // DW_FORM_strp
+			case 0x1f: text = line_str.at( c.fixed( dwarf64 ? 8 : 4 ) ); return true;    // DW_FORM_line_strp
+			case 0x0b: num = c.fixed( 1 ); return true;                                  // DW_FORM_data1
+			case 0x05: num = c.fixed( 2 ); return true;                                  // DW_FORM_data2
+			case 0x06: num = c.fixed( 4 ); return true;                                  // DW_FORM_data4
+			case 0x07: num = c.fixed( 8 ); return true;                                  // DW_FORM_data8
+			case 0x0f: num = c.uleb(); return true;                                      // DW_FORM_udata
+			case 0x1e: c.p = c.left( 16 ) ? c.p + 16 : c.end; return true;              // DW_FORM_data16
+			case 0x09: num = c.uleb(); c.p = c.left( num ) ? c.p + num : c.end; return true; // DW_FORM_block
+			default: return false;
+		}
+	}
+
+	// dwarf 5 directory or file table; paths and directory indices of every entry
+	bool entries( cursor &c, bool dwarf64, const blob &str, const blob &line_str, std::vector<const char *> &paths, std::vector<uint64_t> &dirs ) {
+		uint64_t format[ 32 ];
+		unsigned formats = unsigned( c.fixed( 1 ) );
+		if( formats > 16 ) return false;
+		for( unsigned i = 0; i < formats; ++i ) {
+			format[ i * 2 + 0 ] = c.uleb();
+			format[ i * 2 + 1 ] = c.uleb();
+		}
+		for( uint64_t n = c.uleb(); n-- && c.p < c.end; ) {
+			const char *path = "";
+			uint64_t dir = 0;
+			for( unsigned i = 0; i < formats; ++i ) {
+				const char *text = "";
+				uint64_t num = 0;
+				if( !attribute( c, format[ i * 2 + 1 ], dwarf64, str, line_str, text, num ) ) return false;
+				if( format[ i * 2 ] == DW_LNCT_path ) path = text;
+				if( format[ i * 2 ] == DW_LNCT_directory_index ) dir = num;
+			}
+			paths.push_back( path );
+			dirs.push_back( dir );
+		}
+		return true;
+	}
+
+	void load_lines( image &im, const blob &lines, const blob &str, const blob &line_str ) {
+		cursor all = { lines.data, lines.data + lines.size };
+		while( all.left( 4 ) ) {
+			uint64_t length = all.fixed( 4 );
+			bool dwarf64 = length == 0xffffffff;
+			if( dwarf64 ) length = all.fixed( 8 );
+			if( !all.left( length ) ) return;
+			cursor unit = { all.p, all.p + length };
+			all.p += length;
+
+			unsigned version = unsigned( unit.fixed( 2 ) );
+			if( version < 2 || version > 5 ) continue;
+			if( version >= 5 ) unit.fixed( 2 ); // address and segment selector sizes
+			uint64_t header_length = unit.fixed( dwarf64 ? 8 : 4 );
+			if( !unit.left( header_length ) ) continue;
+			const uint8_t *program = unit.p + header_length;
+			unsigned min_inst = unsigned( unit.fixed( 1 ) );
+			if( version >= 4 ) unit.fixed( 1 ); // maximum operations per instruction; vliw only
+			unit.fixed( 1 ); // default is_stmt; every row is kept, as addr2line does
+			int line_base = int8_t( unit.fixed( 1 ) );
+			unsigned line_range = unsigned( unit.fixed( 1 ) );
+			unsigned opcode_base = unsigned( unit.fixed( 1 ) );
+			if( !line_range || !opcode_base ) continue;
+			uint8_t lengths[ 256 ] = { 0 };
+			for( unsigned i = 1; i < opcode_base; ++i ) lengths[i] = uint8_t( unit.fixed( 1 ) );
+
+			// file table of this unit, appended to the image's. numbering starts at 1 before dwarf 5
+			std::vector<const char *> dirs, paths;
+			std::vector<uint64_t> indices, unused;
+			if( version < 5 ) {
+				dirs.push_back( "" ); // compilation directory; it lives in .debug_info
+				for( const char *d; *( d = unit.str() ); ) dirs.push_back( d );
+				paths.push_back( "" );
+				indices.push_back( 0 );
+				for( const char *f; *( f = unit.str() ); ) {
+					indices.push_back( unit.uleb() );
+					unit.uleb(); // modification time
+					unit.uleb(); // length
+					paths.push_back( f );
+				}
+			} else if( !entries( unit, dwarf64, str, line_str, dirs, unused ) || !entries( unit, dwarf64, str, line_str, paths, indices ) ) {
+				continue;
+			}
+			unsigned first = unsigned( im.files.size() );
+			for( size_t i = 0; i < paths.size(); ++i ) {
+				file f = { indices[i] < dirs.size() ? dirs[ indices[i] ] : "", paths[i] };
+				im.files.push_back( f );
+			}
+
+			// line number program
+			unit.p = program;
+			uintptr_t addr = 0;
+			unsigned fileno = 1, line = 1;
+			bool live = true; // sequences of code discarded at link time start at 0 (or ~0)
+			size_t sequence = im.rows.size();
+			while( unit.p < unit.end ) {
+				uint8_t op = uint8_t( unit.fixed( 1 ) );
+				bool emit = false;
+				if( op >= opcode_base ) {
+					unsigned adjusted = op - opcode_base;
+					addr += ( adjusted / line_range ) * min_inst;
+					line += line_base + int( adjusted % line_range );
+					emit = true;
+				}
+				else if( op == 0 ) {
+					uint64_t len = unit.uleb();
+					if( !len || !unit.left( len ) ) break;
+					const uint8_t *next = unit.p + len;
+					uint8_t sub = uint8_t( unit.fixed( 1 ) );
+					if( sub == 1 ) { // DW_LNE_end_sequence
+						while( im.rows.size() > sequence && im.rows.back().addr >= addr ) {
+							im.rows.pop_back(); // empty rows, which would hide the end
+						}
+						if( live ) {
+							row r = { addr, ~0u, 0 };
+							im.rows.push_back( r );
+						}
+						addr = 0, fileno = 1, line = 1, live = true;
+						sequence = im.rows.size();
+					}
+					else if( sub == 2 ) { // DW_LNE_set_address
+						addr = uintptr_t( unit.fixed( unsigned( len - 1 ) ) );
+						live = addr != 0 && addr != ~uintptr_t(0);
+					}
+					unit.p = next;
+				}
+				else switch( op ) {
+					case 1: emit = true; break;                                                     // DW_LNS_copy
+					case 2: addr += uintptr_t( unit.uleb() ) * min_inst; break;                     // DW_LNS_advance_pc
+					case 3: line += int( unit.sleb() ); break;                                      // DW_LNS_advance_line
+					case 4: fileno = unsigned( unit.uleb() ); break;                                // DW_LNS_set_file
+					case 8: addr += ( ( 255 - opcode_base ) / line_range ) * min_inst; break;       // DW_LNS_const_add_pc
+					case 9: addr += uintptr_t( unit.fixed( 2 ) ); break;                            // DW_LNS_fixed_advance_pc
+					default: for( unsigned i = 0; i < lengths[ op ]; ++i ) unit.uleb();             // operands ignored
+				}
+				if( emit && live && line ) {
+					row r = { addr, fileno < paths.size() ? first + fileno : ~0u, line };
+					im.rows.push_back( r );
+				}
+			}
+		}
+	}
+
+	// sequence ends go first, so a sequence starting where another one ends wins the lookup
+	bool by_addr( const row &a, const row &b ) {
+		return a.addr < b.addr || ( a.addr == b.addr && !a.line && b.line );
+	}
+	bool below_row( uintptr_t addr, const row &r ) {
+		return addr < r.addr;
+	}
+
+	const row *find_row( const image &im, uintptr_t addr ) {
+		std::vector<row>::const_iterator it = std::upper_bound( im.rows.begin(), im.rows.end(), addr, below_row );
+		if( it == im.rows.begin() ) return 0;
+		--it;
+		return it->line && it->file != ~0u ? &*it : 0;
+	}
+
+	// }
+
+	void parse( image &im ) {
+		im.parsed = true;
+		if( !map( im ) )
+			return;
+		const ElfW(Ehdr) &eh = *(const ElfW(Ehdr) *)im.data;
+		const ElfW(Shdr) *sh = (const ElfW(Shdr) *)( im.data + eh.e_shoff );
+		load_symbols( im, sh, eh.e_shnum, SHT_SYMTAB );
+		if( im.symbols.empty() ) {
+			load_symbols( im, sh, eh.e_shnum, SHT_DYNSYM ); // stripped
+		}
+		sort_symbols( im );
+
+		blob names = contents( im, sh[ eh.e_shstrndx ] ), lines = { 0, 0 }, str = { 0, 0 }, line_str = { 0, 0 };
+		for( unsigned i = 0; i < eh.e_shnum; ++i ) {
+			const char *name = names.at( sh[i].sh_name );
+			/**/ if( !std::strcmp( name, ".debug_line" ) )     lines = contents( im, sh[i] );
+			else if( !std::strcmp( name, ".debug_str" ) )      str = contents( im, sh[i] );
+			else if( !std::strcmp( name, ".debug_line_str" ) ) line_str = contents( im, sh[i] );
+		}
+		im.lines = lines.size != 0;
+		if( lines.size ) {
+			load_lines( im, lines, str, line_str );
+			std::stable_sort( im.rows.begin(), im.rows.end(), by_addr );
+		}
+	}
+
+	// modules {
+
+	std::mutex images_mutex;
+
+	// never destroyed, since reports are also made from atexit() handlers
+	std::vector<image *> &loaded() {
+		static std::vector<image *> *images = new std::vector<image *>();
+		return *images;
+	}
+
+	int collect( struct dl_phdr_info *info, size_t, void *data ) {
+		std::vector<image *> &found = *(std::vector<image *> *)data;
+		image *im = new image();
+		im->path = info->dlpi_name && info->dlpi_name[0] ? info->dlpi_name : "/proc/self/exe";
+		im->bias = info->dlpi_addr;
+		im->lo = ~uintptr_t(0);
+		im->hi = 0;
+		im->data = 0;
+		im->size = 0;
+		im->parsed = false;
+		im->lines = false;
+		for( unsigned i = 0; i < info->dlpi_phnum; ++i ) {
+			const ElfW(Phdr) &ph = info->dlpi_phdr[i];
+			if( ph.p_type == PT_LOAD ) {
+				im->lo = std::min( im->lo, uintptr_t( info->dlpi_addr + ph.p_vaddr ) );
+				im->hi = std::max( im->hi, uintptr_t( info->dlpi_addr + ph.p_vaddr + ph.p_memsz ) );
+			}
+			if( ph.p_type == PT_NOTE && im->build_id.empty() ) {
+				// notes are loaded, so they are read in place: header, name and desc, each 4-byte aligned
+				cursor c = { (const uint8_t *)( info->dlpi_addr + ph.p_vaddr ), (const uint8_t *)( info->dlpi_addr + ph.p_vaddr + ph.p_memsz ) };
+				while( c.left( 12 ) ) {
+					uint32_t namesz = uint32_t( c.fixed( 4 ) ), descsz = uint32_t( c.fixed( 4 ) ), type = uint32_t( c.fixed( 4 ) );
+					uint64_t skip = ( uint64_t( namesz ) + 3 ) & ~3ull;
+					if( !c.left( skip + descsz ) ) break;
+					const uint8_t *name = c.p, *desc = c.p + skip;
+					c.p = c.left( skip + ( ( uint64_t( descsz ) + 3 ) & ~3ull ) ) ? desc + ( ( descsz + 3 ) & ~3u ) : c.end;
+					if( type == NT_GNU_BUILD_ID && namesz == 4 && !std::memcmp( name, "GNU", 4 ) ) {
+						static const char hex[] = "0123456789abcdef";
+						for( uint32_t b = 0; b < descsz; ++b ) {
+							im->build_id += hex[ desc[b] >> 4 ];
+							im->build_id += hex[ desc[b] & 15 ];
+						}
+						break;
+					}
+				}
+			}
+		}
+		found.push_back( im );
+		return 0;
+	}
+
+	// rescans loaded modules. images that are still loaded are kept; images_mutex must be held.
+	// images of unloaded modules are dropped but never freed, since a batch may still be resolving them
+	void refresh() {
+		std::vector<image *> &images = loaded(), found;
+		dl_iterate_phdr( collect, &found );
+		for( size_t i = 0; i < found.size(); ++i ) {
+			for( size_t j = 0; j < images.size(); ++j ) {
+				if( images[j] && images[j]->path == found[i]->path && images[j]->bias == found[i]->bias ) {
+					delete found[i];
+					found[i] = images[j];
+					images[j] = 0;
+					break;
+				}
+			}
+		}
+		images.swap( found );
+	}
+
+	image *find_image( uintptr_t pc ) {
+		const std::vector<image *> &images = loaded();
+		for( size_t i = 0; i < images.size(); ++i ) {
+			if( pc >= images[i]->lo && pc < images[i]->hi ) return images[i];
+		}
+		return 0;
+	}
+
+	// }
+
+	std::string pretty( const char *name ) {
+		int status = -1;
+		char *demangled = name[0] == '_' && name[1] == 'Z' ? abi::__cxa_demangle( name, 0, 0, &status ) : 0;
+		std::string out = status == 0 && demangled ? demangled : name;
+		if( demangled ) free( demangled );
+		return out;
+	}
+
+	std::string offset( uintptr_t addr ) {
+		char text[ 32 ];
+		std::snprintf( text, sizeof(text), "+0x%llx", (unsigned long long)addr ); // for offline tools
+		return text;
+	}
+
+	// module an address belongs to, if any
+	image *locate( const void *ptr ) {
+		std::lock_guard<std::mutex> lock( images_mutex );
+		uintptr_t pc = (uintptr_t)ptr;
+		image *im = find_image( pc );
+		if( !im ) {
+			refresh(); // dlopen()ed since last time
+			im = find_image( pc );
+		}
+		return im;
+	}
+
+	// parses a module on first use. tables are read-only afterwards, so lookups need no locking
+	void prepare( image &im ) {
+		std::lock_guard<std::mutex> lock( im.lock );
+		if( im.parsed )
+			return;
+		if( im.path == "/proc/self/exe" ) {
+			char exe[ 4096 ];
+			ssize_t len = readlink( im.path.c_str(), exe, sizeof(exe) - 1 );
+			if( len > 0 ) im.name.assign( exe, len );
+		}
+		if( im.name.empty() ) im.name = im.path;
+		parse( im );
+	}
+
+	// "function (file:line)" when debug info is there, "function ([module]+0xoffset)" otherwise.
+	// module must be prepared; returns whether a line was found
+	bool lookup( const image &im, const void *ptr, std::string &out ) {
+		uintptr_t addr = (uintptr_t)ptr - im.bias;
+		const symbol *s = find_symbol( im, addr );
+		// frames are return addresses, which may belong to the next line (or to nothing, after a noreturn call)
+		const row *r = find_row( im, s && addr > s->lo ? addr - 1 : addr );
+		std::string name = s ? pretty( s->name ) : std::string( "????" );
+		if( r ) {
+			const file &f = im.files[ r->file ];
+			std::string path = f.dir[0] && f.name[0] != '/' ? std::string( f.dir ) + "/" + f.name : std::string( f.name );
+			out = heal::sfstring( "\1 (\2:\3)", name, path, r->line );
+			return true;
+		}
+		out = heal::sfstring( "\1 ([\2]\3)", name, im.name, offset( addr ) );
+		return false;
+	}
+
+	// empty if unknown
+	std::string symbolize( const void *ptr ) {
+		std::string out;
+		if( image *im = locate( ptr ) ) {
+			prepare( *im );
+			lookup( *im, ptr, out );
+		}
+		return out;
+	}
+
+	// dynamic symbols only, for addresses outside the scanned modules. an address past the end of the
+	// symbol dladdr() picked is not part of it, so only the module offset is told then; empty if unknown
+	std::string describe( const void *ptr ) {
+		Dl_info info;
+		const ElfW(Sym) *sym = 0;
+		if( !dladdr1( ptr, &info, (void **)&sym, RTLD_DL_SYMENT ) || !info.dli_fname )
+			return std::string();
+		uintptr_t pc = (uintptr_t)ptr;
+		std::string module = heal::sfstring( "[\1]\2", info.dli_fname, offset( pc - (uintptr_t)info.dli_fbase ) );
+		if( info.dli_sname && sym && pc - (uintptr_t)info.dli_saddr < sym->st_size )
+			return heal::sfstring( "\1 (\2)", pretty( info.dli_sname ), module );
+		return module;
+	}
+
+	// external symbolizer {
+
+	// any addr2line-compatible command (llvm-addr2line, eu-addr2line...); empty disables it.
+	// only asked about modules with no line tables of their own, whose debug info lives elsewhere
+	const char *fallback = "addr2line";
+
+	struct feeder {
+		int fd;
+		std::string text;
+		void operator()() {
+			for( size_t sent = 0; sent < text.size(); ) {
+				ssize_t n = write( fd, text.data() + sent, text.size() - sent );
+				if( n <= 0 ) break;
+				sent += n;
+			}
+			close( fd );
+		}
+	};
+
+	// one process per module: addresses are written from a thread while replies are read here, so
+	// neither side blocks on a full pipe. outputs are only touched for frames that got a function or
+	// a line, and *found (if given) flags the ones that got a line
+	void external( const image &im, const std::vector<void *> &frames, const std::vector<std::string *> &outputs, std::vector<char> *found = 0 ) {
+		if( !fallback || !fallback[0] || !im.data || frames.empty() )
+			return;
+		int in[2], out[2];
+		if( pipe2( in, O_CLOEXEC ) )
+			return;
+		if( pipe2( out, O_CLOEXEC ) ) {
+			close( in[0] ), close( in[1] );
+			return;
+		}
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init( &actions );
+		posix_spawn_file_actions_adddup2( &actions, in[0], 0 );
+		posix_spawn_file_actions_adddup2( &actions, out[1], 1 );
+		posix_spawn_file_actions_addopen( &actions, 2, "/dev/null", O_WRONLY, 0 );
+		std::string module = im.name;
+		char *argv[] = { (char *)fallback, (char *)"-f", (char *)"-C", (char *)"-e", &module[0], 0 };
+		pid_t pid;
+		int failed = posix_spawnp( &pid, fallback, &actions, 0, argv, environ );
+		posix_spawn_file_actions_destroy( &actions );
+		close( in[0] ), close( out[1] );
+		if( failed ) {
+			close( in[1] ), close( out[0] );
+			return;
+		}
+
+		feeder feed;
+		feed.fd = in[1];
+		for( size_t i = 0; i < frames.size(); ++i ) {
+			uintptr_t addr = (uintptr_t)frames[i] - im.bias;
+			char line[ 32 ];
+			std::snprintf( line, sizeof(line), "%llx\n", (unsigned long long)( addr ? addr - 1 : addr ) );
+			feed.text += line;
+		}
+		std::thread writer( feed );
+
+		std::string reply;
+		char buf[ 4096 ];
+		for( ssize_t n; ( n = read( out[0], buf, sizeof(buf) ) ) > 0 || ( n < 0 && errno == EINTR ); ) {
+			if( n > 0 ) reply.append( buf, n );
+		}
+		close( out[0] );
+		writer.join();
+		int status;
+		while( waitpid( pid, &status, 0 ) < 0 && errno == EINTR ) {
+		}
+
+		// two lines per address: function, then file:line
+		std::stringstream ss( reply );
+		for( size_t i = 0; i < frames.size(); ++i ) {
+			std::string fn, where;
+			if( !std::getline( ss, fn ) || !std::getline( ss, where ) )
+				break;
+			size_t discriminator = where.find( " (discriminator" );
+			if( discriminator != std::string::npos ) where.resize( discriminator );
+			size_t colon = where.rfind( ':' );
+			bool known = colon != std::string::npos && where.compare( 0, 2, "??" ) && where[ colon + 1 ] >= '1' && where[ colon + 1 ] <= '9';
+			if( known ) {
+				*outputs[i] = heal::sfstring( "\1 (\2)", fn, where );
+				if( found ) (*found)[i] = 1;
+			} else if( fn != "??" ) {
+				*outputs[i] = heal::sfstring( "\1 ([\2]\3)", fn, im.name, offset( (uintptr_t)frames[i] - im.bias ) );
+			}
+		}
+	}
+
+	// }
+}
+
+#endif
+
+// CALLSTACK
+
+		callstack::callstack( bool autosave ) {
+			if( autosave ) save();
+		}
+
+		size_t callstack::space() const {
+			return sizeof(frames) + sizeof(void *) * frames.size();
+		}
+
+		void callstack::save( unsigned frames_to_skip ) {
+
+			if( frames_to_skip > max_frames )
+				return;
+
+			// capture into a local buffer, then commit to frames with a single allocation
+			void *out_frames[ max_frames ];
+			unsigned captured = capture( out_frames, max_frames, frames_to_skip + 1 );
+			frames.assign( out_frames, out_frames + captured );
+		}
+
+		volatile int callstack::unwinder = HEAL_UNWINDER;
+
+		unsigned callstack::capture_fp( void **out_frames, unsigned max_frames, unsigned frames_to_skip ) {
+			return walk_frames( (uintptr_t)__builtin_frame_address(0), out_frames, max_frames, frames_to_skip );
+		}
+
+		unsigned callstack::walk_frames( uintptr_t fp, void **out_frames, unsigned max_frames, unsigned frames_to_skip ) {
+			$linux({
+				uintptr_t stack_lo, stack_hi;
+				if( !stack_bounds( stack_lo, stack_hi ) )
+					return 0;
+
+				// frame layout: fp[0] is caller's frame pointer, fp[1] is return address
+				unsigned captured = 0;
+				while( captured < max_frames ) {
+					if( fp < stack_lo || fp + 2 * sizeof(void *) > stack_hi || fp % sizeof(void *) )
+						break;
+					void **frame = (void **)fp;
+					void *ret = frame[1];
+					uintptr_t next = (uintptr_t)frame[0];
+					if( !ret )
+						break;
+					if( frames_to_skip ) --frames_to_skip;
+					else out_frames[ captured++ ] = ret;
+					// stack grows downwards; callers always live above
+					if( next <= fp )
+						break;
+					fp = next;
+				}
+				return captured;
+			})
+			return 0;
+		}
+
+		unsigned callstack::capture( void **out_frames, unsigned max_frames, unsigned frames_to_skip, int how ) {
+
+			if( frames_to_skip > max_frames )
+				return 0;
+
+			const int use = how < 0 ? int( unwinder ) : how;
+
+			$linux(
+				if( use == UNWIND_FRAME_POINTERS )
+					return walk_frames( (uintptr_t)__builtin_frame_address(0), out_frames, max_frames, frames_to_skip );
+			)
+#if HEAL_HAS_CFI
+			if( use == UNWIND_DWARF ) {
+				// registers are read together, so they match the cfi row at this very instruction
+				uintptr_t pc, sp, bp;
+				__asm__ __volatile__( "lea 0(%%rip), %0\n\tmov %%rsp, %1\n\tmov %%rbp, %2" : "=r"(pc), "=r"(sp), "=r"(bp) );
+				return cfi::walk( pc, sp, bp, out_frames, max_frames, frames_to_skip );
+			}
+#endif
+
+			$windows({
+				unsigned short capturedFrames = 0;
+
+				// RtlCaptureStackBackTrace is only available on Windows XP or newer versions of Windows
+				typedef WORD(NTAPI FuncRtlCaptureStackBackTrace)(DWORD, DWORD, PVOID *, PDWORD);
+
+				static struct raii
+				{
+					raii() : module(0), ptrRtlCaptureStackBackTrace(0)
+					{
+						module = LoadLibraryA("kernel32.dll");
+						if( !module )
+							fail( "<heal/heal.cpp> says: error! cant load kernel32.dll" );
+
+						ptrRtlCaptureStackBackTrace = (FuncRtlCaptureStackBackTrace *)GetProcAddress(module, "RtlCaptureStackBackTrace");
+						if( !ptrRtlCaptureStackBackTrace )
+							fail( "<heal/heal.cpp> says: error! cant find RtlCaptureStackBackTrace() process address" );
+					}
+					~raii() { if(module) FreeLibrary(module); }
+
+					HMODULE module;
+					FuncRtlCaptureStackBackTrace *ptrRtlCaptureStackBackTrace;
+				} module;
+
+				if( module.ptrRtlCaptureStackBackTrace )
+					capturedFrames = module.ptrRtlCaptureStackBackTrace(frames_to_skip+1, max_frames, out_frames, (DWORD *) 0);
+
+				return capturedFrames;
+			})
+			$gnuc({
+				// backtrace() cannot skip frames, so drop them afterwards (this one included)
+				int captured = backtrace(out_frames, max_frames);
+				unsigned skip = std::min<unsigned>( frames_to_skip + 1, captured > 0 ? captured : 0 );
+				if( skip ) std::memmove( out_frames, out_frames + skip, (captured - skip) * sizeof(void *) );
+				return captured > 0 ? captured - skip : 0;
+			})
+			return 0;
+		}
+
+		std::vector<std::string> callstack::unwind( unsigned from, unsigned to ) const
+		{
+			if( to == ~0 )
+				to = this->frames.size();
+
+			if( from > to || from > this->frames.size() || to > this->frames.size() )
+				return std::vector<std::string>();
+
+			const size_t num_frames = to - from;
+			std::vector<std::string> backtraces( num_frames );
+
+			void * const * frames = &this->frames[ from ];
+			const std::string invalid = "????";
+
+#if HEAL_HAS_ELF
+			{
+				// in-process symbolizer first; backtrace_symbols() only for addresses outside any module
+				bool missing = false;
+				for( unsigned i = 0; i < num_frames; i++ ) {
+					backtraces[i] = elf::symbolize( frames[i] );
+					if( backtraces[i].empty() )
+						backtraces[i] = elf::describe( frames[i] );
+					missing |= backtraces[i].empty();
+				}
+				if( !missing )
+					return backtraces;
+			}
+#endif
+
+			$windows({
+				SymSetOptions(SYMOPT_UNDNAME);
+
+				$no(
+					// polite version. this is how things should be done.
+					HANDLE process = GetCurrentProcess();
+					if( SymInitialize( process, NULL, TRUE ) )
+				)
+				$yes(
+					// this is what we have to do because other memory managers are not polite enough. fuck them off
+					static HANDLE process = GetCurrentProcess();
+					static int init = SymInitialize( process, NULL, TRUE );
+					if( !init )
+						fail( "<heal/heal.cpp> says: cannot initialize Dbghelp.lib" );
+				)
+				{
+					enum { MAXSYMBOLNAME = 512 - sizeof(IMAGEHLP_SYMBOL64) };
+					char symbol64_buf     [ 512 ];
+					char symbol64_bufblank[ 512 ] = {0};
+					IMAGEHLP_SYMBOL64 *symbol64       = reinterpret_cast<IMAGEHLP_SYMBOL64*>(symbol64_buf);
+					IMAGEHLP_SYMBOL64 *symbol64_blank = reinterpret_cast<IMAGEHLP_SYMBOL64*>(symbol64_bufblank);
+					symbol64_blank->SizeOfStruct = sizeof(IMAGEHLP_SYMBOL64);
+					symbol64_blank->MaxNameLength = (MAXSYMBOLNAME-1) / 2; //wchar?
+
+					IMAGEHLP_LINE64 line64, line64_blank = {0};
+					line64_blank.SizeOfStruct = sizeof(IMAGEHLP_LINE64);
+
+					for( unsigned i = 0; i < num_frames; i++ ) {
+						*symbol64 = *symbol64_blank;
+						DWORD64 displacement64 = 0;
+
+						if( SymGetSymFromAddr64( process, (DWORD64) frames[i], &displacement64, symbol64 ) ) {
+							line64 = line64_blank;
+							DWORD displacement = 0;
+							if( SymGetLineFromAddr64( process, (DWORD64) frames[i], &displacement, &line64 ) ) {
+								backtraces[i] = heal::sfstring( "\1 (\2:\3)", symbol64->Name, line64.FileName, line64.LineNumber );
+							} else {
+								backtraces[i] = symbol64->Name;
+							}
+						} else  backtraces[i] = invalid;
+					}
+
+					$no(
+						// fuck the others. cleanup commented.
+						SymCleanup(process);
+					)
+				}
+				DWORD error = GetLastError();
+
+				return backtraces;
+			})
+			$gnuc({
+				char **strings = backtrace_symbols(frames, num_frames);
+
+				// Decode the strings
+				if( strings ) {
+					for( unsigned i = 0; i < num_frames; i++ ) {
+						if( backtraces[i].empty() )
+							backtraces[i] = ( strings[i] ? demangle(strings[i]) : invalid );
+					}
+					free( strings );
+				}
+
+				return backtraces;
+			})
+
+			return backtraces;
+		}
+
+		std::vector<std::string> callstack::str( const char *format12, size_t skip_begin ) const {
+			callstack copy = *this;
+			std::vector<std::string> stacktrace = copy.unwind( skip_begin );
+
+			for( size_t i = 0, end = stacktrace.size(); i < end; i++ )
+				stacktrace[i] = heal::sfstring( format12, i + 1, stacktrace[i] );
+
+			return stacktrace;
+		}
+
+		std::string callstack::flat( const char *format12, size_t skip_begin ) const {
+			std::vector<std::string> vec = str( format12, skip_begin );
+			std::string str;
+			for( std::vector<std::string>::const_iterator it = vec.begin(), end = vec.end(); it != end; ++it ) {
+				str += *it;
+			}
+			return str;
+		}
+
+std::vector<std::string> stacktrace( const char *format12, size_t skip_initial ) {
+	return callstack(true).str( format12, skip_initial );
+}
+
+std::string stackstring( const char *format12, size_t skip_initial ) {
+	std::string out;
+	std::vector<std::string> stack = stacktrace( format12, skip_initial );
+	for( std::vector<std::string>::const_iterator it = stack.begin(), end = stack.end(); it != end; ++it ) {
+		out += *it;
+	}
+	return out;
+}
+
+// DIE
+
+void die( const std::string &reason, int errorcode )
+{
+	if( !reason.empty() ) {
+		fail( reason );
+	}
+
+	$windows(
+	FatalExit( errorcode );
+	)
+
+	// fallback
+	std::exit( errorcode );
+}
+
+void die( int errorcode, const std::string &reason )
+{
+	die( reason, errorcode );
+}
+
+// HEXDUMP
+// @todo: maxwidth != 80 doesnt work
+
+std::string hexdump( const void *data, size_t num_bytes, const void *self )
+{
+#   ifdef _MSC_VER
+#       pragma warning( push )
+#       pragma warning( disable : 4996 )
+#       define $vsnprintf _vsnprintf
+#   else
+#       define $vsnprintf  vsnprintf
+#   endif
+
+	struct local {
+		static std::string format( const char *fmt, ... )
+		{
+			int len;
+			std::string self;
+
+			using namespace std;
+
+			// Calculate the final length of the formatted string
+			{
+				va_list args;
+				va_start( args, fmt );
+				len = $vsnprintf( 0, 0, fmt, args );
+				va_end( args );
+			}
+
+			// Allocate a buffer (including room for null termination
+			char* target_string = new char[++len];
+
+			// Generate the formatted string
+			{
+				va_list args;
+				va_start( args, fmt );
+				$vsnprintf( target_string, len, fmt, args );
+				va_end( args );
+			}
+
+			// Assign the formatted string
+			self.assign( target_string );
+
+			// Clean up
+			delete [] target_string;
+
+			return self;
+		}
+	};
+
+	unsigned maxwidth = 80;
+	unsigned width = 16; //column width
+	unsigned width_offset_block = (8 + 1);
+	unsigned width_chars_block  = (width * 3 + 1) + sizeof("asc");
+	unsigned width_hex_block    = (width * 3 + 1) + sizeof("hex");
+	unsigned width_padding = (std::max)( 0, int( maxwidth - ( width_offset_block + width_chars_block + width_hex_block ) ) );
+	unsigned blocks = width_padding / ( width_chars_block + width_hex_block ) ;
+
+	unsigned dumpsize = ( num_bytes < width * 16 ? num_bytes : width * 16 ); //16 lines max
+
+	std::string result;
+
+	result += local::format( "%-*s %-.*s [ptr=%p sz=%d]\n", width_offset_block - 1, "offset", width_chars_block - 1, "00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F", self ? self : data, num_bytes );
+
+	if( !num_bytes )
+		return result;
+
+	blocks++;
+
+	const unsigned char *p = reinterpret_cast<const unsigned char *>( data );
+	size_t i = 0;
+
+	while( i < dumpsize )
+	{
+		//offset block
+		result += local::format("%p ", (size_t)(p + i) ); //%08x, %08zx
+
+		//chars blocks
+		for( unsigned b = 0; b < blocks; b++)
+		{
+			for( unsigned c = 0 ; c < width ; c++ )
+				result += local::format(" %c ", i + c >= dumpsize ? '.' : p[i + c] < 32 || p[i + c] >= 127 ? '.' : p[i + c]);
+
+			result += "asc\n";
+		}
+
+		//offset block
+		result += local::format("%p ", (size_t)(p + i) ); //%08x, %08zx
+
+		//hex blocks
+		for( unsigned b = 0; b < blocks; b++)
+		{
+			for( unsigned c = 0; c < width ; c++)
+				result += local::format( i + c < dumpsize ? "%02x " : "?? ", p[i + c]);
+
+			result += "hex\n";
+		}
+
+		//next line
+		//result += '\n';
+		i += width * blocks;
+	}
+
+	return result;
+
+#   undef $vsnprintf
+#   ifdef _MSC_VER
+#       pragma warning( pop )
+#   endif
+}
+
+std::string timestamp() {
+	std::stringstream ss;
+	ss << __TIMESTAMP__;
+	return ss.str();
+}
+
+/*
+ * Simple prompt dialog (based on legolas558's code). zlib/libpng license.
+ * - rlyeh
+ */
+
+#if !$on($windows)
+
+std::string prompt( const std::string &current_value, const std::string &title, const std::string &caption )
+{
+	std::string out;
+
+	if( has("whiptail") && false )
+	{
+		std::string out = pipe( std::string() +
+			"/usr/bin/whiptail 3>&1 1>&2 2>&3 --title \"" +title+ "\" --inputbox \"" +caption+ "\" 0 0 \"" +current_value+ "\"" );
+	}
+	else
+	{
+		if( title.size() && caption.size() )
+			fprintf(stdout, "%s", title.c_str());
+		else
+			fprintf(stdout, "%s", title.empty() ? caption.c_str() : title.c_str());
+
+		if( !current_value.empty() )
+			fprintf(stdout, " (enter defaults to '%s')", current_value.c_str());
+
+		fprintf(stdout, "%s", "\n");
+
+		std::getline( std::cin, out );
+
+		if( out.empty() )
+			out = current_value;
+	}
+
+	return out;
+}
+
+#endif
+
+#if $on($msvc)
+#   pragma warning( push )
+#   pragma warning( disable : 4996 )
+#endif
+
+#if $on($windows)
+#   pragma comment(lib,"user32.lib")
+#   pragma comment(lib,"gdi32.lib")
+//$warning("<heal/heal.cpp> says: dialog aware dpi fix (@todo)")
+
+std::string prompt( const std::string &current_value, const std::string &title, const std::string &caption )
+{
+	class InputBox
+	{
+		private:
+
+		HWND                hwndParent,
+							hwndInputBox,
+							hwndQuery,
+							hwndOk,
+							hwndCancel,
+							hwndEditBox;
+		LPSTR               szInputText;
+		WORD                wInputMaxLength, wInputLength;
+		bool                bRegistered,
+							bResult;
+
+		HINSTANCE           hThisInstance;
+
+		enum
+		{
+			CIB_SPAN = 10,
+			CIB_LEFT_OFFSET = 6,
+			CIB_TOP_OFFSET = 4,
+			CIB_WIDTH = 300,
+			CIB_HEIGHT = 130,
+			CIB_BTN_WIDTH = 60,
+			CIB_BTN_HEIGHT = 20
+		};
+
+		public:
+
+#       define CIB_CLASS_NAME   "CInputBoxA"
+
+		static LRESULT CALLBACK CIB_WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
+		{
+			InputBox *self;
+			self = (InputBox *)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+
+			switch (msg)
+			{
+				case WM_CREATE:
+					self = (InputBox *) ((CREATESTRUCT *)lParam)->lpCreateParams;
+					SetWindowLongPtr(hWnd, GWLP_USERDATA, (LONG_PTR)self);
+					self->create(hWnd);
+				break;
+				case WM_COMMAND:
+					switch(LOWORD(wParam)) {
+						case IDOK:
+							self->submit();
+						case IDCANCEL:
+							self->close();
+						break;
+					}
+					break;
+				case WM_CLOSE:
+					self->close();
+					return 0;
+				case WM_DESTROY:
+					self->destroy();
+					break;
+			}
+			return(DefWindowProc (hWnd, msg, wParam, lParam));
+		}
+
+		InputBox( HINSTANCE hInst ) :
+			hwndParent(0),
+			hwndInputBox(0),
+			hwndQuery(0),
+			hwndOk(0),
+			hwndCancel(0),
+			hwndEditBox(0),
+			szInputText(0),
+			wInputMaxLength(0), wInputLength(0),
+			bRegistered(false),
+			bResult(false),
+			hThisInstance(hInst)
+		{
+			WNDCLASSEXA wndInputBox;
+			RECT rect;
+
+			memset(&wndInputBox, 0, sizeof(WNDCLASSEXA));
+
+			hThisInstance = hInst;
+
+			wndInputBox.cbSize                  = sizeof(wndInputBox);
+			wndInputBox.lpszClassName           = CIB_CLASS_NAME;
+			wndInputBox.style                   = CS_HREDRAW | CS_VREDRAW;
+			wndInputBox.lpfnWndProc             = CIB_WndProc;
+			wndInputBox.lpszMenuName            = NULL;
+			wndInputBox.hIconSm                 = NULL;
+			wndInputBox.cbClsExtra              = 0;
+			wndInputBox.cbWndExtra              = 0;
+			wndInputBox.hInstance               = hInst;
+			wndInputBox.hIcon                   = LoadIcon(NULL, IDI_WINLOGO);
+			wndInputBox.hCursor                 = LoadCursor(NULL, IDC_ARROW);
+			wndInputBox.hbrBackground           = (HBRUSH)(COLOR_WINDOW);
+
+			RegisterClassExA(&wndInputBox);
+
+			if (hwndParent)
+				GetWindowRect(hwndParent, &rect); //always false?
+			else
+				GetWindowRect(GetDesktopWindow(), &rect);
+
+			hwndInputBox = CreateWindowA( CIB_CLASS_NAME, "",
+							(WS_BORDER | WS_CAPTION), rect.left+(rect.right-rect.left-CIB_WIDTH)/2,
+							rect.top+(rect.bottom-rect.top-CIB_HEIGHT)/2,
+							CIB_WIDTH, CIB_HEIGHT, hwndParent, NULL,
+							hThisInstance, this);
+		}
+
+		void destroy()
+		{
+			EnableWindow(hwndParent, true);
+			SendMessage(hwndInputBox, WM_CLOSE/*WM_DESTROY*/, 0, 0);
+		}
+
+		~InputBox()
+		{
+			UnregisterClassA(CIB_CLASS_NAME, hThisInstance);
+		}
+
+		void submit()
+		{
+			wInputLength = (int)SendMessage(hwndEditBox, EM_LINELENGTH, 0, 0);
+			if (wInputLength) {
+				*((LPWORD)szInputText) = wInputMaxLength;
+				wInputLength = (WORD)SendMessage(hwndEditBox, EM_GETLINE, 0, (LPARAM)szInputText);
+			}
+			szInputText[wInputLength] = '\0';
+			bResult = true;
+		}
+
+		void create(HWND hwndNew)
+		{
+			static HFONT myFont = NULL;
+
+			if( myFont != NULL )
+			{
+				DeleteObject( myFont );
+				myFont = NULL;
+			}
+
+			hwndInputBox = hwndNew;
+
+			NONCLIENTMETRICS ncm;
+			ncm.cbSize = sizeof(NONCLIENTMETRICS);
+
+			if (SystemParametersInfo(SPI_GETNONCLIENTMETRICS, sizeof(NONCLIENTMETRICS), &ncm, 0))
+			{
+#if 0
+				LOGFONT lf;
+				memset(&lf,0,sizeof(LOGFONT));
+
+				lf.lfWeight= FW_NORMAL;
+				lf.lfCharSet= ANSI_CHARSET;
+				//lf.lfPitchAndFamily = 35;
+				lf.lfHeight= 10;
+				strcpy(lf.lfFaceName, "Tahoma");
+				myFont=CreateFontIndirect(&lf);
+#else
+				myFont = CreateFontIndirect(&ncm.lfMessageFont);
+#endif
+			}
+			else
+			{
+				myFont = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
+			}
+
+			//  SetWindowPos(hwndInputBox, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
+			hwndQuery = CreateWindowA("Static", "", WS_CHILD | WS_VISIBLE,
+									CIB_LEFT_OFFSET, CIB_TOP_OFFSET,
+									CIB_WIDTH-CIB_LEFT_OFFSET*2, CIB_BTN_HEIGHT*2,
+									hwndInputBox, NULL,
+									hThisInstance, NULL);
+			hwndEditBox = CreateWindowA("Edit", "", WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL | ES_LEFT, CIB_LEFT_OFFSET,
+									CIB_TOP_OFFSET + CIB_BTN_HEIGHT*2, CIB_WIDTH-CIB_LEFT_OFFSET*3, CIB_BTN_HEIGHT,
+									hwndInputBox,   NULL,
+									hThisInstance, NULL);
+			hwndOk = CreateWindowA("Button", "OK", WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_PUSHBUTTON,
+									CIB_WIDTH/2 - CIB_SPAN*2 - CIB_BTN_WIDTH, CIB_HEIGHT - CIB_TOP_OFFSET*4 - CIB_BTN_HEIGHT*2,
+									CIB_BTN_WIDTH, CIB_BTN_HEIGHT, hwndInputBox, (HMENU)IDOK,
+									hThisInstance, NULL);
+			hwndCancel = CreateWindowA("Button", "Cancel",
+									WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_PUSHBUTTON,
+									CIB_WIDTH/2 + CIB_SPAN, CIB_HEIGHT - CIB_TOP_OFFSET*4 - CIB_BTN_HEIGHT*2,  CIB_BTN_WIDTH, CIB_BTN_HEIGHT,
+									hwndInputBox, (HMENU)IDCANCEL,
+									hThisInstance, NULL);
+
+		//  SendMessage(hwndInputBox,WM_SETFONT,(WPARAM)myFont,FALSE);
+			SendMessage(hwndQuery,WM_SETFONT,(WPARAM)myFont,FALSE);
+			SendMessage(hwndEditBox,WM_SETFONT,(WPARAM)myFont,FALSE);
+			SendMessage(hwndOk,WM_SETFONT,(WPARAM)myFont,FALSE);
+			SendMessage(hwndCancel,WM_SETFONT,(WPARAM)myFont,FALSE);
+		}
+
+		void close()
+		{
+			PostMessage(hwndInputBox, WM_CLOSE, 0, 0);
+		}
+
+		void hide()
+		{
+			ShowWindow(hwndInputBox, SW_HIDE);
+		}
+
+		void show(LPCSTR lpszTitle, LPCSTR  lpszQuery)
+		{
+			SetWindowTextA(hwndInputBox, lpszTitle);
+			SetWindowTextA(hwndEditBox, szInputText);
+			SetWindowTextA(hwndQuery, lpszQuery);
+			SendMessage(hwndEditBox, EM_LIMITTEXT, wInputMaxLength, 0);
+			SendMessage(hwndEditBox, EM_SETSEL, 0, -1);
+			SetFocus(hwndEditBox);
+			ShowWindow(hwndInputBox, SW_NORMAL);
+		}
+
+		int show(HWND hwndParentWindow, LPCSTR lpszTitle, LPCSTR lpszQuery, LPSTR szResult, WORD wMax)
+		{
+			MSG msg;
+			BOOL    bRet;
+			hwndParent = hwndParentWindow;
+			szInputText = szResult;
+			wInputMaxLength = wMax;
+
+			bResult = false;
+
+		//  EnableWindow(hwndParent, false);
+
+			show(lpszTitle, lpszQuery);
+
+			while( (bRet = GetMessageA( &msg, NULL, 0, 0 )) != 0)
+			{
+				if (msg.message==WM_KEYDOWN) {
+					switch (msg.wParam) {
+					case VK_RETURN:
+						submit();
+					case VK_ESCAPE:
+						close();
+						break;
+					default:
+						TranslateMessage(&msg);
+						break;
+					}
+				} else
+		//      if (!IsDialogMessage(hwndInputBox, &msg)) {
+					TranslateMessage(&msg);
+		//      }
+				DispatchMessage(&msg);
+				if (msg.message == WM_CLOSE)
+					break;
+			}
+
+		//  EnableWindow(hwndParent, true);
+
+			return bResult;
+		}
+
+	#   undef CIB_CLASS_NAME
+	}
+	myinp(GetModuleHandle(0));
+
+	char *result = new char [2048+1];
+
+	memset( result, 0, 2048+1 ); //default value
+
+	strcpy( result, current_value.c_str() );
+
+	myinp.show(0, "L", caption.size() ? caption.c_str() : title.c_str(), result, 2048);
+
+	std::string _r = result;
+
+	delete [] result;
+
+	return _r;
+}
+
+#endif
+
+}
+
+#if $on($msvc)
+#   pragma warning( pop )
+#endif
+
+/*
+#undef $debug
+#undef $release
+#undef $other
+#undef $gnuc
+#undef $msvc
+
+#undef $undefined
+#undef $apple
+#undef $linux
+#undef $windows
+
+#undef $no
+#undef $yes
+*/
@@ -75,6 +75,7 @@
 
 #include <cassert>
 #include <cctype>
+#include <cmath>
 // #include <cstddef> // (stddef.h fails on ArchLinux w/ clang 3.4)
 #include <cstdio>
 #include <cstdlib>
@@ -92,35 +93,60 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 // Our API {
 #   include "tracey.hpp"
 // }
 
+// LD_PRELOAD build, for binaries that cannot be rebuilt:
+//   g++ -std=c++11 -O2 -g -shared -fPIC -DTRACEY_PRELOAD tracey.cpp -o libtracey.so -ldl -lpthread
+//   TRACEY_REPORT=/tmp/leaks-%p.html LD_PRELOAD=./libtracey.so ./app
+// operators and C allocator are always hooked; TRACEY_* environment variables configure the rest.
+#ifdef TRACEY_PRELOAD
+#   undef  kTraceyDefineMemoryOperators
+#   define kTraceyDefineMemoryOperators 1
+#   undef  kTraceyHookLegacyCRT
+#   define kTraceyHookLegacyCRT 1
+#endif
+
 // external; tree implementation {
 #   include "deps/oak/oak.hpp"
 // }
 
 // external; macros, OS utils. Here is where the fun starts {
 #   define HEAL_MAX_TRACES kTraceyMaxStacktraces
+#   define HEAL_UNWINDER kTraceyUnwinder
 #   define heal tracey_heal
 #   include "deps/heal/heal.cpp" // also includes heal.hpp
 // }
 
 // mutexes and threads
 #if $on($cpp11)
+#include <atomic>
 #include <mutex>
 #include <thread>
 #else
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/thread.hpp>
 namespace std {
+    using boost::atomic;
     using boost::thread;
+    using boost::mutex;
     using boost::recursive_mutex;
 }
 #endif
 
+// private memory for tracey metadata
+#if $on($windows)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
 // external; route66 uses c++11
 #if kTraceyWebserverPort
 #   include "deps/route66/route66.cpp"  // also includes route66.hpp
@@ -128,17 +154,59 @@ namespace std {
 
 // checks: todo
 // if /MD or /MDd and kTraceyReportWildPointers warn user "not a good idea"
-#if kTraceyHookLegacyCRT
+#if kTraceyHookLegacyCRT && !$on($linux)
     $warning( "<tracey/tracey.cpp> says: kTraceyHookLegacyCRT option ignored. CRT hooking not supported on this platform.")
 #   undef  kTraceyHookLegacyCRT
 #   define kTraceyHookLegacyCRT 0
 #endif
 
+#if kTraceyHookMmap && !$on($linux)
+    $warning( "<tracey/tracey.cpp> says: kTraceyHookMmap option ignored. mmap hooking not supported on this platform.")
+#   undef  kTraceyHookMmap
+#   define kTraceyHookMmap 0
+#endif
+
+// inline headers are written by the allocating thread, so they cannot wait for the aggregator
+#if kTraceyHeaders && kTraceyAsync
+    $warning( "<tracey/tracey.cpp> says: kTraceyAsync option ignored. Not compatible with kTraceyHeaders.")
+#   undef  kTraceyAsync
+#   define kTraceyAsync 0
+#endif
+
+// forked children restart the async aggregator, see container::after_fork()
+#if !$on($windows)
+#include <pthread.h>
+#endif
+
+// C allocator is interposed at the end of this file, so tracey reaches the real one through crt::realloc
+#if kTraceyHookLegacyCRT
+#include <dlfcn.h>
+namespace tracey { namespace crt { void *realloc( void *ptr, size_t size ); void *calloc( size_t num, size_t size ); void *memalign( size_t alignment, size_t size ); void free( void *ptr ); } }
+#   undef  kTraceyRealloc
+#   define kTraceyRealloc tracey::crt::realloc
+#   undef  kTraceyCalloc
+#   define kTraceyCalloc tracey::crt::calloc
+#   undef  kTraceyFree
+#   define kTraceyFree tracey::crt::free
+#endif
+
+
+// mmap and friends are interposed at the end of this file too, so tracey maps its own memory through vm::
+#if kTraceyHookMmap
+#include <dlfcn.h>
+namespace tracey { namespace vm { void *mmap( void *addr, size_t length, int prot, int flags, int fd, off_t offset ); int madvise( void *addr, size_t length, int advice ); } }
+#   define kTraceyMmap    tracey::vm::mmap
+#   define kTraceyMadvise tracey::vm::madvise
+#else
+#   define kTraceyMmap    mmap
+#   define kTraceyMadvise madvise
+#endif
 
 namespace tracey
 {
     static void webmain( void * );
     static void hotkeymain( void * );
+    static void on_report_signal( int );
 
     typedef heal::sfstring string;
     typedef heal::sfstrings strings;
@@ -262,26 +330,312 @@ namespace tracey {
         return print( self, total, dummy, format, sorted_by, reversed );
     }
 
+    // calling-context tree with the same contents as tracey::tree, for reports over many leaks.
+    // nodes live in one array and refer to each other by 32-bit index (0 is the root); while the
+    // tree grows, children are found through one open-addressing table keyed by (parent, frame).
+    // refresh() lays every node's children out as a sorted run of one shared index array.
+    class calltree {
+        public:
+
+            struct node {
+                K frame;
+                uint32_t parent, first, count;  // children: kids[first .. first+count)
+                V value;
+            };
+
+            std::vector<node> nodes;
+            std::vector<uint32_t> kids;
+
+            calltree() {
+                node root = { 0, 0, 0, 0, V() };
+                nodes.push_back( root );
+            }
+
+            // child of parent for frame, added if missing
+            uint32_t insert( uint32_t parent, K frame ) {
+                if( ( nodes.size() + 1 ) * 2 > slots.size() ) {
+                    grow();
+                }
+                for( size_t i = hash( parent, frame ) & ( slots.size() - 1 ); ; i = ( i + 1 ) & ( slots.size() - 1 ) ) {
+                    uint32_t at = slots[i];
+                    if( !at ) {
+                        node child = { frame, parent, 0, 0, V() };
+                        nodes.push_back( child );
+                        return slots[i] = uint32_t( nodes.size() - 1 );
+                    }
+                    if( nodes[at].frame == frame && nodes[at].parent == parent ) {
+                        return at;
+                    }
+                }
+            }
+
+            // as oak::tree::refresh(): leaves keep their value; inner nodes get the sum of their
+            // children's sizes. children are created after their parent, so one backwards pass does
+            void refresh() {
+                std::vector<uint32_t>().swap( slots );
+                for( size_t i = 0; i < nodes.size(); ++i ) {
+                    nodes[i].first = nodes[i].count = 0;
+                }
+                for( size_t i = 1; i < nodes.size(); ++i ) {
+                    nodes[ nodes[i].parent ].count++;
+                }
+                uint32_t first = 0;
+                for( size_t i = 0; i < nodes.size(); ++i ) {
+                    nodes[i].first = first;
+                    first += nodes[i].count;
+                    nodes[i].count = 0;
+                }
+                kids.resize( first );
+                for( size_t i = 1; i < nodes.size(); ++i ) {
+                    node &up = nodes[ nodes[i].parent ];
+                    kids[ up.first + up.count++ ] = uint32_t( i );
+                }
+                std::vector<V> sums( nodes.size() );
+                for( size_t i = nodes.size(); i-- > 0; ) {
+                    node &n = nodes[i];
+                    std::sort( kids.begin() + n.first, kids.begin() + n.first + n.count, by_frame( nodes ) );
+                    if( n.count ) {
+                        n.value = sums[i];
+                    }
+                    if( i ) {
+                        sums[ n.parent ] += n.value;
+                    }
+                }
+            }
+
+            // as tracey::chopper: drops branches (and everything below them) smaller than threshold
+            void chop( double threshold ) {
+                for( size_t i = 0; i < nodes.size(); ++i ) {
+                    node &n = nodes[i];
+                    uint32_t kept = 0;
+                    for( uint32_t k = 0; k < n.count; ++k ) {
+                        if( !( nodes[ kids[ n.first + k ] ].value < threshold ) ) {
+                            kids[ n.first + kept++ ] = kids[ n.first + k ];
+                        }
+                    }
+                    n.count = kept;
+                }
+            }
+
+        private:
+
+            std::vector<uint32_t> slots; // node indices; 0 (the root, never a child) marks a free slot
+
+            static size_t hash( uint32_t parent, K frame ) {
+                uint64_t h = uint64_t( uintptr_t( frame ) ) * 0x9E3779B97F4A7C15ull ^ uint64_t( parent ) * 0xC2B2AE3D27D4EB4Full;
+                return size_t( h ^ ( h >> 29 ) );
+            }
+
+            void grow() {
+                std::vector<uint32_t>( std::max<size_t>( 1024, slots.size() * 2 ), 0 ).swap( slots );
+                for( uint32_t at = 1; at < nodes.size(); ++at ) {
+                    size_t i = hash( nodes[at].parent, nodes[at].frame ) & ( slots.size() - 1 );
+                    while( slots[i] ) i = ( i + 1 ) & ( slots.size() - 1 );
+                    slots[i] = at;
+                }
+            }
+
+            struct by_frame {
+                const std::vector<node> &nodes;
+                by_frame( const std::vector<node> &nodes ) : nodes( nodes ) {
+                }
+                bool operator()( uint32_t a, uint32_t b ) const {
+                    return nodes[a].frame < nodes[b].frame;
+                }
+            };
+    };
+
+    // same output as print( const tree & ... ): siblings ordered by their sort key, ties by frame
+    struct sibling {
+        std::string key, line;
+        uint32_t at;
+    };
+
+    struct by_key {
+        bool reversed;
+        bool operator()( const sibling &a, const sibling &b ) const {
+            return reversed ? b.key < a.key : a.key < b.key;
+        }
+    };
+
+    template<typename U>
+    void print( const calltree &self, uint32_t at, double total, const tracey::string &fmt1234, const tracey::string &sorted_by, bool reversed, const std::map<K,U> &tmap, unsigned depth, std::string &out ) {
+        const calltree::node &n = self.nodes[ at ];
+        std::string tabs( depth, kTraceyCharTab[0] );
+        std::vector<sibling> list( n.count );
+        for( uint32_t k = 0; k < n.count; ++k ) {
+            const calltree::node &child = self.nodes[ self.kids[ n.first + k ] ];
+            std::string value = child.value.str(total);
+            if( !tmap.empty() ) {
+                const U &name = tmap.find( child.frame )->second;
+                list[k].key = tracey::string( sorted_by, name, value, tabs, n.count );
+                list[k].line = tracey::string( fmt1234, name, value, tabs, n.count );
+            } else {
+                list[k].key = tracey::string( sorted_by, child.frame, value, tabs, n.count );
+                list[k].line = tracey::string( fmt1234, child.frame, value, tabs, n.count );
+            }
+            list[k].at = self.kids[ n.first + k ];
+        }
+        by_key order = { reversed };
+        std::stable_sort( list.begin(), list.end(), order );
+        for( size_t i = 0; i < list.size(); ++i ) {
+            out += list[i].line;
+            print( self, list[i].at, total, fmt1234, sorted_by, reversed, tmap, depth + 1, out );
+        }
+    }
+
+    template<typename U>
+    std::string print( const calltree &self, double total, const std::map<K,U> &tmap, const tracey::string &format = "{tabs}[{size}] {key} ({value})\n", const tracey::string &sorted_by = "{key}", bool reversed = false ) {
+        tracey::string fmt = format
+        .replace("{key}",   "\1")
+        .replace("{value}", "\2")
+        .replace("{tabs}",  "\3")
+        .replace("{size}",  "\4");
+        tracey::string sort = sorted_by
+        .replace("{key}",   "\1")
+        .replace("{value}", "\2")
+        .replace("{tabs}",  "\3")
+        .replace("{size}",  "\4");
+        std::string out;
+        print( self, 0, total, fmt, sort, reversed, tmap, 0, out );
+        return out;
+    }
+
     // callstack, demangle, lookup
     using namespace heal;
 }
 
+namespace tracey
+{
+    // compile-time choice of what the allocation hot path does. the kTracey* options only build
+    // tracey::defaults; the code below reads these features through policy_t (kTraceyPolicy), so
+    // whatever a policy leaves out is compiled out instead of being tested on every allocation.
+    //   DEPTH     frames captured per allocation
+    //   UNWINDER  callstack::UNWIND_* used always; -1 follows callstack::unwinder (TRACEY_UNWINDER)
+    //   FILL      byte new blocks are filled with; -1 leaves them as the backend returns them
+    //   OVERHEAD  extra bytes allocated per block, in hundredths of a percent
+    //   WILD      reports wild pointers and sized deallocations that disagree
+    //   SAMPLING  allows sampling (kTraceySampleRate, TRACEY_SAMPLE_RATE); false tracks every allocation
+    //   HEADERS   inline allocation headers instead of hashing on deallocations
+    //   ASYNC     per-thread event buffers instead of locking the registry; ignored along with HEADERS
+    template< unsigned DEPTH_, int UNWINDER_, int FILL_, unsigned OVERHEAD_, bool WILD_, bool SAMPLING_, bool HEADERS_, bool ASYNC_ >
+    struct policy {
+        enum { DEPTH = DEPTH_, UNWINDER = UNWINDER_, FILL = FILL_ };
+        enum { OVERHEAD = OVERHEAD_ };
+        enum { WILD = WILD_, SAMPLING = SAMPLING_, HEADERS = HEADERS_, ASYNC = ASYNC_ && !HEADERS_ };
+
+        // bytes requested for a block of given size. integer math, split so it cannot overflow
+        static size_t budget( size_t size ) {
+            return OVERHEAD != 0 ? size + ( size / 10000 ) * OVERHEAD + ( size % 10000 ) * OVERHEAD / 10000 : size;
+        }
+        static void *fill( void *ptr, size_t size ) {
+            return FILL >= 0 ? kTraceyMemset( ptr, FILL, size ) : ptr;
+        }
+    };
+
+    typedef policy< kTraceyMaxStacktraces, -1,
+        kTraceyMemsetAllocations ? int( (unsigned char)kTraceyMemsetChar ) : -1,
+        unsigned( kTraceyBudgetOverhead * 100 ),
+        !!kTraceyReportWildPointers, true, !!kTraceyHeaders, !!kTraceyAsync > defaults;
+
+    typedef kTraceyPolicy policy_t;
+}
+
 namespace tracey
 {
     namespace
     {
         volatile size_t timestamp_id = 0;
+
+        // inline allocation header (kTraceyHeaders). it sits right before every block handed out by
+        // tracey::malloc() and doubles as the registry record of that block, so a deallocation reaches
+        // its record at a fixed offset. live records are chained per shard for reporting. the cookie
+        // binds the header to its block address, which tells tracey blocks apart from foreign pointers.
+        struct header {
+            header *prev, *next;   // live records of the shard; unused while not tracked
+            size_t size, id;
+            uint32_t stack;
+            uint32_t offset;       // from underlying allocation to block; larger than header_size when aligned
+            uintptr_t cookie;      // block address ^ BLOCK or LIVE
+            float weight;          // allocations this record stands for, as sampled when tracked
+
+            enum { BLOCK = 0x7ACEB10C, LIVE = 0x7ACE11FE };
+
+            bool is( const void *ptr, uintptr_t state ) const {
+                return cookie == ( (uintptr_t)ptr ^ state );
+            }
+            void mark( const void *ptr, uintptr_t state ) {
+                cookie = (uintptr_t)ptr ^ state;
+            }
+        };
+
+        enum { header_size = ( sizeof(header) + 15 ) & ~15 }; // keeps blocks 16-byte aligned
+
+        header *header_of( const void *ptr ) {
+            return (header *)( (char *)ptr - header_size );
+        }
+
         struct stats_t {
             size_t usage, usage_peak, num_leaks, leak_peak, overhead;
-            stats_t() : usage(0), usage_peak(0), num_leaks(0), leak_peak(0), overhead(0) {}
+            size_t buffer_peak, buffer_stalls; // async mode only
+            size_t sample_rate; // sampling mode only
+            size_t arena_used, arena_footprint; // tracey metadata
+            size_t slab_used, slab_footprint; // slab backend only
+            size_t headers; // header mode only
+            size_t filter_rejects, filter_passes, filter_false_positives; // frees, as seen by the free filter
+            size_t resized, moved, copied; // reallocations of watched blocks (in place, moved) and bytes moved
+            size_t regions, mapped, mapped_anonymous, mapped_discarded, mapped_peak; // mmap hooks only
+            size_t symbol_hits, symbol_misses; // symbol cache, over all reports so far
+            stats_t() : usage(0), usage_peak(0), num_leaks(0), leak_peak(0), overhead(0), buffer_peak(0), buffer_stalls(0), sample_rate(0), arena_used(0), arena_footprint(0), slab_used(0), slab_footprint(0), headers(0),
+                filter_rejects(0), filter_passes(0), filter_false_positives(0), resized(0), moved(0), copied(0),
+                regions(0), mapped(0), mapped_anonymous(0), mapped_discarded(0), mapped_peak(0), symbol_hits(0), symbol_misses(0) {}
+            stats_t &operator +=( const stats_t &other ) {
+                num_leaks += other.num_leaks;
+                leak_peak = std::max( leak_peak, other.leak_peak );
+                overhead += other.overhead;
+                buffer_peak = std::max( buffer_peak, other.buffer_peak );
+                buffer_stalls += other.buffer_stalls;
+                headers += other.headers;
+                resized += other.resized;
+                moved += other.moved;
+                copied += other.copied;
+                return *this;
+            }
             std::string str() const {
-                return tracey::string("highest peak: \1 total, \2 greatest peak // \3 allocs in use: \4 + overhead: \5 = total: \6",
+                std::string out = tracey::string("highest peak: \1 total, \2 greatest peak // \3 allocs in use: \4 + overhead: \5 = total: \6",
                                     human(usage_peak), human(leak_peak), num_leaks, human(usage), human(overhead), human( usage + overhead ) );
+                out += tracey::string(" // metadata arena: \1 in use, \2 mapped", human(arena_used), human(arena_footprint) );
+                if( slab_footprint ) {
+                    out += tracey::string(" // slab backend: \1 in use, \2 mapped", human(slab_used), human(slab_footprint) );
+                }
+                if( sample_rate ) {
+                    out += tracey::string(" // sampled every ~\1 (estimated)", human(sample_rate) );
+                }
+                if( kTraceyHookMmap ) {
+                    out += tracey::string(" // mappings: \1 regions, \2 mapped (\3 anonymous), \4 discarded, \5 peak in use",
+                                    regions, human(mapped), human(mapped_anonymous), human(mapped_discarded), human(mapped_peak) );
+                }
+                if( resized || moved ) {
+                    out += tracey::string(" // reallocs: \1 in place, \2 moved, \3 copied", resized, moved, human(copied) );
+                }
+                if( symbol_hits || symbol_misses ) {
+                    out += tracey::string(" // symbol cache: \1 hits, \2 misses", symbol_hits, symbol_misses );
+                }
+                if( kTraceyFreeFilterKB ) {
+                    out += tracey::string(" // free filter: \1 rejected, \2 passed, \3 false positives", filter_rejects, filter_passes, filter_false_positives );
+                }
+                if( policy_t::HEADERS ) {
+                    out += tracey::string(" // inline headers: \1 in use, \2 per allocation", human(headers), human(header_size) );
+                }
+                if( policy_t::ASYNC ) {
+                    out += tracey::string(" // event buffers: \1/\2 events high-water, \3 stalls", buffer_peak, int(kTraceyAsyncBufferSize), buffer_stalls );
+                }
+                return out;
             }
-        } stats;
+        };
 
         size_t create_id() {
-            static size_t id = 0;
+            static std::atomic<size_t> id( 0 );
             return ++id;
         }
 
@@ -309,205 +663,2414 @@ namespace tracey
         struct leak {
             size_t id, size;
             const void *addr;
-            tracey::callstack cs;
+            uint32_t stack; // interned callstack id, 0 if none
+            float weight;   // allocations this record stands for, as sampled when tracked
 
-            leak() : size(0), id(0), addr(0)
+            leak() : size(0), id(0), addr(0), stack(0), weight(1)
             {}
 
             void wipe() {
                 id = create_id();
-                cs = tracey::callstack();
+                stack = 0;
                 size = 0;
                 addr = 0;
+                weight = 1;
             }
 
-            ~leak() {
-                wipe();
+            void swap( leak &other ) {
+                std::swap( id, other.id );
+                std::swap( size, other.size );
+                std::swap( addr, other.addr );
+                std::swap( stack, other.stack );
+                std::swap( weight, other.weight );
             }
         };
+
+        inline void swap( leak &a, leak &b ) {
+            a.swap( b );
+        }
     }
 
     namespace
     {
         using namespace tracey::detail;
 
-        typedef std::vector< const leak * > leaks;
-
-        // recursive mutex
-        std::recursive_mutex *mutex = 0;
-
-        // hard on/off switch
-        static const    bool kTraceyEnabledHard = kTraceyEnabled;
-        // soft on/off switch
-        static volatile bool kTraceyEnabledSoft = true;
+        typedef std::vector< leak > leaks;
 
-        class container : public std::map< const void *, leak, std::less< const void * > > //, tracey::malloc_allocator< std::pair< const void *, leak * > > >
+        // private memory for tracey's own data structures, off the application heap. one big address
+        // range is reserved up front and carved into 64 KB spans. small blocks come from per size-class
+        // free lists (16 bytes .. 32 KB, one class per span); bigger ones take whole runs of spans, which
+        // are given back to the kernel when freed. ownership is a range check, so any thread may free.
+        // blocks are aligned to their class size, runs to a span. the slab backend is an arena too.
+        // if the range cannot be reserved, requests fall back to kTraceyRealloc.
+        class arena
         {
             public:
 
-            container() 
-            {
-                 mutex = new std::recursive_mutex();
-            }
-
-            ~container() {
-                mutex = 0;
+            enum { SPAN_BITS = 16, SPAN = 1 << SPAN_BITS, MIN_BITS = 4, CLASSES = SPAN_BITS - MIN_BITS, SMALL = SPAN / 2 };
 
-                if( kTraceyReportOnExit && kTraceyEnabledSoft ) {
-                    view_report( _report() );
-                }
-                
-                // We should clear the memory involved in all allocations but after all, we are a memory tracker and we should be the very
-                // last thing to deallocate in any program. So we don't do it and we save some time for developing when exiting the app.
-                // Silent & quick exit. Not a requirement in all architectures but who knows.
-                kTraceyDie( __LINE__ );
+            static unsigned size_class( size_t size ) {
+                unsigned c = 0;
+                while( (size_t(1) << (c + MIN_BITS)) < size ) ++c;
+                return c;
             }
 
-            void _clear() {
-
-                for( iterator it = this->begin(), end = this->end(); it != end; ++it ) {
-                    it->second.wipe();
-                }
+            private:
 
-                this->clear();
-            }
+            enum { RUN = 0xFF, TAIL = 0xFE };
 
-            leaks collect_leaks( size_t *wasted ) const {
-                leaks list;
-                *wasted = 0;
-                for( const_iterator it = this->begin(), end = this->end(); it != end; ++it ) {
-                    const tracey::detail::leak &L = it->second;
-                    if( L.addr && L.size && L.id >= timestamp_id ) {
-                        *wasted += L.size;
-                        list.push_back( &L );
-                    }
-                }
-                return list;
-            }
+            struct node {
+                node *next;
+                size_t spans; // free runs only
+            };
 
-            std::string _report() const {
+            char *base;
+            size_t reserved, bumped;     // in spans
+            unsigned char *kinds;        // size class of every span; RUN heads a run, TAIL continues it
+            uint32_t *lengths;           // spans of every run, by head span
+            node *lists[ CLASSES ];
+            node *runs;
+            size_t in_use, mapped;       // bytes
+            std::mutex mutex;
 
-                std::string logfile = get_temp_pathfile() + "xxx-tracey.html";
+            arena( const arena & );
+            arena &operator=( const arena & );
 
-                kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: summary: \1" kTraceyCharLinefeed, stats.str() ).c_str() );
-                kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: creating report: \1" kTraceyCharLinefeed, logfile).c_str() );
-                kTraceyfFile *fp = kTraceyfOpen( logfile.c_str(), "wb" );
+            void *reserve( size_t bytes ) {
+                $windows(
+                    return VirtualAlloc( 0, bytes, MEM_RESERVE, PAGE_READWRITE );
+                )
+                $welse(
+                    void *ptr = kTraceyMmap( 0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0 );
+                    return ptr == MAP_FAILED ? 0 : ptr;
+                )
+            }
 
-                // this code often runs at the very end of a program cycle (even when static memory has been deallocated)
-                // so, avoid using global C++ objects like std::cout/cerr as much as possible; otherwise crashes may happen
+            char *span( size_t n ) const {
+                return base + (n << SPAN_BITS);
+            }
 
+            // takes a run of spans, reusing freed ones first
+            char *take( size_t spans ) {
+                for( node **it = &runs; *it; it = &(*it)->next ) {
+                    node *run = *it;
+                    if( run->spans >= spans ) {
+                        if( run->spans > spans ) {
+                            node *rest = (node *)( (char *)run + spans * SPAN );
+                            rest->next = run->next;
+                            rest->spans = run->spans - spans;
+                            *it = rest;
+                        } else {
+                            *it = run->next;
+                        }
+                        return (char *)run;
+                    }
+                }
+                if( bumped + spans > reserved ) {
+                    return 0;
+                }
+                char *ptr = span( bumped );
                 $windows(
-                    AllocConsole();
+                    if( !VirtualAlloc( ptr, spans * SPAN, MEM_COMMIT, PAGE_READWRITE ) ) return 0;
                 )
+                bumped += spans;
+                mapped += spans * SPAN;
+                return ptr;
+            }
 
-                // Find leaks
-                kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: filtering leaks..." kTraceyCharLinefeed).c_str() );
-                size_t wasted, n_leak;
-                leaks filtered = collect_leaks( &wasted );
-                n_leak = filtered.size();
-                kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: found \1 leaks wasting \2" kTraceyCharLinefeed, n_leak, human(wasted)).c_str() );
-
-                // Calc score
-                double leaks_pct = this->size() ? n_leak * 100.0 / this->size() : 0.0;
-                std::string score = "perfect!";
-                if( leaks_pct >  0.00 ) score = "excellent";
-                if( leaks_pct >  1.25 ) score = "good";
-                if( leaks_pct >  2.50 ) score = "poor";
-                if( leaks_pct >  5.00 ) score = "mediocre";
-                if (leaks_pct > 10.00 ) score = "lame";
+            // returns a run of spans, releasing its pages
+            void give( char *ptr, size_t spans ) {
+                $windows( VirtualAlloc( ptr, spans * SPAN, MEM_RESET, PAGE_READWRITE ); )
+                $welse( kTraceyMadvise( ptr, spans * SPAN, MADV_DONTNEED ); )
+                node *run = (node *)ptr;
+                run->spans = spans;
+                run->next = runs;
+                runs = run;
+            }
 
-                // Header
-                kTraceyfPrintf( fp, "%s", tracey::string( "<html><body><xmp>" ).c_str() );
-                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: generated with \1 (\2)" kTraceyCharLinefeed, tracey::version(), tracey::url() ).c_str() );
-                if( tracey::lookup(url) == "????" )
-                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: failed to decode symbols!! Is debug information available?" $msvc(" Are .PDB files available?") kTraceyCharLinefeed ).c_str() );
-                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: best viewed on foldable text editor (like SublimeText2) with tabs=2sp and no word-wrap" kTraceyCharLinefeed ).c_str() );
-                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: \1, \2 leaks found; \3 wasted ('\4' score)" kTraceyCharLinefeed, !n_leak ? "ok" : "error", n_leak, human(wasted), score ).c_str() );
-                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: summary: \1" kTraceyCharLinefeed, stats.str() ).c_str() );
-                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: report filename: \1" kTraceyCharLinefeed, logfile).c_str() );
+            // pops a block of class c, carving a fresh span if its list is empty. mutex must be held
+            void *pop( unsigned c ) {
+                size_t bytes = size_t(1) << (c + MIN_BITS);
+                if( !lists[c] ) {
+                    if( char *fresh = take( 1 ) ) {
+                        kinds[ size_t( fresh - base ) >> SPAN_BITS ] = (unsigned char)c;
+                        for( size_t at = SPAN; at >= bytes; at -= bytes ) {
+                            node *n = (node *)( fresh + at - bytes );
+                            n->next = lists[c];
+                            lists[c] = n;
+                        }
+                    }
+                }
+                node *n = lists[c];
+                if( n ) {
+                    lists[c] = n->next;
+                    in_use += bytes;
+                }
+                return n;
+            }
 
-                // Body
-                // Get all frame addresses involved in all leaks
-                // Also, create a tree of frames; so we will take decisions from above by examining node weights (@todo)
-                kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: creating trees of frames..."  kTraceyCharLinefeed).c_str() );
-                std::set< void * > set;
-                tracey::tree tree;
-                tree[ (void *)((~0)-0) ]; // bottom-top branch
-                tree[ (void *)((~0)-1) ]; // top-bottom branch
-                for( leaks::const_iterator it = filtered.begin(), end = filtered.end(); it != end; ++it ) {
-                    const leak &L = **it;
-                    const tracey::callstack &callstack = L.cs;
-                    tracey::tree *_tree = &tree[(void *)((~0)-0)];
-                    tracey::tree *_tree_inv = &tree[(void *)((~0)-1)];
-                    if( !callstack.frames.size() ) continue;
+            // pushes a block of class c back. mutex must be held
+            void push( void *ptr, unsigned c ) {
+                node *n = (node *)ptr;
+                n->next = lists[c];
+                lists[c] = n;
+                in_use -= size_t(1) << (c + MIN_BITS);
+            }
 
-                    for( unsigned i = 0, start = kTraceyStacktraceSkipBegin, end = callstack.frames.size() - 1 - kTraceyStacktraceSkipEnd; start+i <= end; ++i ) {
+            public:
 
-                        double size;
-                        size = (start+i == end ? L.size : 0);
-                        (*_tree)[ callstack.frames[start + i] ].get().size += size;
-                        (*_tree)[ callstack.frames[start + i] ].get().hits ++;
-                        //(*_tree)[ callstack.frames[start + i] ].get().total = 100.0 * size / wasted;
-                        _tree = &(*_tree)[ callstack.frames[start + i] ];
-                        set.insert( callstack.frames[start + i] );
-
-                        size = (end - i == start ? L.size : 0);
-                        (*_tree_inv)[ callstack.frames[end - i] ].get().size += size;
-                        (*_tree_inv)[ callstack.frames[end - i] ].get().hits ++;
-                        //(*_tree_inv)[ callstack.frames[end - i] ].get().total = 100.0 * size / wasted;
-                        _tree_inv = &(*_tree_inv)[ callstack.frames[end - i] ];
-                        set.insert( callstack.frames[end - i] );
+            // reserves up to 2^bits bytes of address range, less if the system refuses
+            explicit arena( unsigned bits ) : base(0), reserved(0), bumped(0), kinds(0), lengths(0), runs(0), in_use(0), mapped(0) {
+                for( unsigned c = 0; c < CLASSES; ++c ) {
+                    lists[c] = 0;
+                }
+                for( size_t bytes = size_t(1) << bits; bytes >= (size_t(1) << 26) && !base; bytes /= 4 ) {
+                    char *range = (char *)reserve( bytes );
+                    if( range ) {
+                        // first span starts on a span boundary, so class alignment holds for every block
+                        base = (char *)( ( (uintptr_t)range + SPAN - 1 ) & ~uintptr_t(SPAN - 1) );
+                        reserved = ( bytes - size_t( base - range ) ) >> SPAN_BITS;
+                    }
+                }
+                if( base ) {
+                    // span tables live at the start of the range itself
+                    size_t table = reserved * ( sizeof(unsigned char) + sizeof(uint32_t) );
+                    size_t spans = ( table + SPAN - 1 ) >> SPAN_BITS;
+                    char *ptr = take( spans );
+                    lengths = (uint32_t *)ptr;
+                    kinds = (unsigned char *)( ptr + reserved * sizeof(uint32_t) );
+                    for( size_t n = 0; n < spans; ++n ) {
+                        kinds[n] = n ? TAIL : RUN;
                     }
+                    lengths[0] = uint32_t( spans );
+                    mapped = 0; // tables are touched lazily; not worth accounting
                 }
+            }
 
-                // Some apps are low on memory in here, so we free memory as soon as possible
-                filtered = leaks();
+            bool owns( const void *ptr ) const {
+                return (const char *)ptr >= base && (const char *)ptr < base + (reserved << SPAN_BITS);
+            }
 
-                if( !set.size() ) {
-                    if( n_leak ) {
-                        kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: error! failed to resolve symbols." $msvc(" Are PDB files available?") kTraceyCharLinefeed).c_str() );
-                    }
+            // zeroed: block is returned zero-filled. runs come from the kernel (fresh or given back) and
+            // are zero already, but for the free-run node written at their start
+            void *alloc( size_t size, bool zeroed = false ) {
+                if( !base ) {
+                    return zeroed ? kTraceyCalloc( 1, size ) : kTraceyRealloc( 0, size );
+                }
+                if( !size ) size = 1;
+                void *ptr = 0;
+                mutex.lock();
+                if( size <= SMALL ) {
+                    ptr = pop( size_class( size ) );
+                    mutex.unlock();
+                    if( ptr && zeroed ) std::memset( ptr, 0, size );
                 } else {
-                    kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: resolving \1 unique frames..." kTraceyCharLinefeed, set.size()).c_str() );
-                    // convert set of unique frames into array of frames
-                    tracey::callstack cs;
-                    std::vector< void * > &frames = cs.frames;
-                    frames.reserve( set.size() );
-                    for( std::set< void * >::iterator it = set.begin(), end = set.end(); it != end; ++it ) {
-                        frames.push_back( *it );
-                    }
-                    tracey::strings symbols = cs.unwind();
-                    std::map< void *, std::string > translate;
-                    {
-                        if( frames.size() != symbols.size() ) {
-                            kTraceyfPrintf( fp, "%s", tracey::string("<tracey/tracey.cpp> says: error! cannot resolve all frames (\1 vs \2)!" kTraceyCharLinefeed, frames.size(), symbols.size() ).c_str() );
-                            for( unsigned i = 0, end = frames.size(); i < end; ++i ) {
-                                translate[ frames[i] ] = tracey::string("\1", frames[i]);
-                            }
-                        } else {
-                            for( unsigned i = 0, end = frames.size(); i < end; ++i ) {
-                                translate[ frames[i] ] = symbols[ i ];
-                            }
+                    size_t spans = ( size + SPAN - 1 ) >> SPAN_BITS;
+                    if( char *run = take( spans ) ) {
+                        size_t head = size_t( run - base ) >> SPAN_BITS;
+                        kinds[ head ] = RUN;
+                        for( size_t n = 1; n < spans; ++n ) {
+                            kinds[ head + n ] = TAIL;
                         }
+                        lengths[ head ] = uint32_t( spans );
+                        in_use += spans * SPAN;
+                        ptr = run;
+                    }
+                    mutex.unlock();
+                    if( ptr && zeroed ) std::memset( ptr, 0, $windows( size ) $welse( sizeof(node) ) ); // MEM_RESET pages keep their data
+                }
+                if( !ptr ) { // range exhausted
+                    return zeroed ? kTraceyCalloc( 1, size ) : kTraceyRealloc( 0, size );
+                }
+                return ptr;
+            }
 
-                        // Create a tree report, if possible
-                        kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: converting tree of frames into tree of symbols..." kTraceyCharLinefeed).c_str() );
-                        translate[ (void *)((~0)-1) ] = "begin";
-                        translate[ (void *)((~0)-0) ] = "end";
-                        tree.refresh();
-                        //std::cout << tree << std::endl;
+            // moves up to n blocks of class c into a chain linked through their first word, under one lock
+            void *alloc_chain( unsigned c, unsigned n, unsigned *got ) {
+                void *chain = 0;
+                *got = 0;
+                if( !base ) return 0;
+                mutex.lock();
+                while( *got < n ) {
+                    void *ptr = pop( c );
+                    if( !ptr ) break;
+                    *(void **)ptr = chain;
+                    chain = ptr;
+                    ++*got;
+                }
+                mutex.unlock();
+                return chain;
+            }
 
-                        // truncate branches lower than user-defined percentage (it helps reducing log size)
-                        // note: kTraceyTruncateBranchesSmallerThan defaults to 0% (~do not truncate branches, show all leaks)
+            // gives n chained blocks of class c back, under one lock
+            void free_chain( void *chain, unsigned c, unsigned n ) {
+                mutex.lock();
+                while( n-- ) {
+                    void *next = *(void **)chain;
+                    push( chain, c );
+                    chain = next;
+                }
+                mutex.unlock();
+            }
 
-                        kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: flattering tree of symbols..." kTraceyCharLinefeed).c_str() );
-                        if( kTraceyTruncateBranchesSmallerThan > 0 ) {
-                            tree.walk<tracey::chopper>();
-                        }
+            void free( void *ptr ) {
+                if( !owns( ptr ) ) {
+                    if( ptr ) kTraceyFree( ptr );
+                    return;
+                }
+                size_t head = size_t( (char *)ptr - base ) >> SPAN_BITS;
+                mutex.lock();
+                unsigned kind = kinds[ head ];
+                if( kind == RUN ) {
+                    in_use -= lengths[ head ] * size_t(SPAN);
+                    give( (char *)ptr, lengths[ head ] );
+                } else {
+                    push( ptr, kind );
+                }
+                mutex.unlock();
+            }
 
-                        kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: dumping tree log..." kTraceyCharLinefeed).c_str() );
-                        kTraceyfPrintf( fp, "%s", tracey::print(tree, wasted, translate, "{tabs}[{size}] ({value}) {key}\n", "{value}", true).c_str() );
-                    }
+            size_t usable( const void *ptr ) const {
+                size_t head = size_t( (const char *)ptr - base ) >> SPAN_BITS;
+                return kinds[ head ] == RUN ? lengths[ head ] * size_t(SPAN) : size_t(1) << (kinds[ head ] + MIN_BITS);
+            }
+
+            void *realloc( void *ptr, size_t size ) {
+                if( !ptr ) return alloc( size );
+                if( !size ) return free( ptr ), (void *)0;
+                if( !owns( ptr ) ) return kTraceyRealloc( ptr, size );
+                size_t have = usable( ptr );
+                if( size <= have && size > have / 2 ) return ptr;
+                void *fresh = alloc( size );
+                if( fresh ) {
+                    std::memcpy( fresh, ptr, have < size ? have : size );
+                    free( ptr );
+                }
+                return fresh;
+            }
+
+            // bytes handed out, and bytes of address range touched so far
+            size_t used() const {
+                return in_use;
+            }
+            size_t footprint() const {
+                return mapped;
+            }
+        };
+
+        arena &metadata() {
+            static char placement[ sizeof(arena) ];
+            static arena *self = new (placement) arena( sizeof(void *) > 4 ? 36 : 28 );
+            return *self;
+        }
+
+        // allocation backends. blocks handed out by tracey::malloc() come from the selected one
+        // (kTraceyBackend, TRACEY_BACKEND) and are given back to the one that owns them, so both can
+        // hold blocks at once and the selection can change at any time.
+        struct backend {
+            const char *name;
+            void *(*allocate)( size_t size, bool zeroed );
+            void *(*reallocate)( void *ptr, size_t size );   // ptr is never null, size never 0
+            void  (*deallocate)( void *ptr );
+            void *(*align)( size_t alignment, size_t size ); // power-of-two alignment; null if unsupported
+            size_t (*usable_size)( const void *ptr );        // 0 if unknown
+            bool  (*owns)( const void *ptr );
+
+            enum { SYSTEM = 0, SLAB = 1 };
+            static volatile int selected;
+        };
+
+        volatile int backend::selected = kTraceyBackend;
+
+        // kTraceyRealloc, kTraceyCalloc and kTraceyFree
+        struct system_heap {
+            static void *allocate( size_t size, bool zeroed ) {
+                return zeroed ? kTraceyCalloc( 1, size ) : kTraceyRealloc( 0, size );
+            }
+            static void *reallocate( void *ptr, size_t size ) {
+                return kTraceyRealloc( ptr, size );
+            }
+            static void deallocate( void *ptr ) {
+                kTraceyFree( ptr );
+            }
+            static void *align( size_t alignment, size_t size ) {
+#if $on($windows)
+                return 0; // _aligned_malloc blocks cannot go through kTraceyRealloc
+#elif kTraceyHookLegacyCRT
+                return tracey::crt::memalign( alignment, size );
+#else
+                void *ptr;
+                return posix_memalign( &ptr, alignment, size ) ? 0 : ptr;
+#endif
+            }
+            static size_t usable_size( const void * ) {
+                return 0; // kTraceyRealloc may be any allocator
+            }
+            static bool owns( const void * ) {
+                return true;
+            }
+        };
+
+        // power-of-two size classes (16 bytes .. 32 KB) carved from an arena of their own, with a cache
+        // of free blocks per thread and class in front of it, so most allocations and frees take no lock.
+        // blocks move between the caches and the arena in batches. bigger blocks go to the system heap.
+        class slab
+        {
+            enum { BATCH = 32, LIMIT = 2 * BATCH };
+            enum { FRESH, CACHING, GONE };
+
+            struct cache {
+                void *heads[ arena::CLASSES ];   // free blocks, chained through their first word
+                unsigned counts[ arena::CLASSES ];
+                int state;
+            };
+
+            static cache &mine() {
+                static $tls(cache) mine;
+                return mine;
+            }
+
+            // gives the cached blocks of an exiting thread back; later frees go to the arena directly
+            struct flush {
+                ~flush() {
+                    cache &c = mine();
+                    c.state = GONE;
+                    for( unsigned k = 0; k < arena::CLASSES; ++k ) {
+                        if( c.counts[k] ) {
+                            heap().free_chain( c.heads[k], k, c.counts[k] );
+                        }
+                        c.heads[k] = 0;
+                        c.counts[k] = 0;
+                    }
+                }
+            };
+
+            static cache *local() {
+                cache &c = mine();
+                if( c.state != FRESH ) {
+                    return c.state == CACHING ? &c : 0;
+                }
+                c.state = GONE; // registering the flush may allocate
+                static thread_local flush on_exit;
+                (void)on_exit;
+                c.state = CACHING;
+                return &c;
+            }
+
+            static arena &heap() {
+                static char placement[ sizeof(arena) ];
+                static arena *self = instance() = new (placement) arena( sizeof(void *) > 4 ? 38 : 29 );
+                return *self;
+            }
+
+            public:
+
+            // null until the slab is first used
+            static arena *&instance() {
+                static arena *self = 0;
+                return self;
+            }
+
+            static void *allocate( size_t size, bool zeroed ) {
+                if( size > arena::SMALL ) {
+                    return system_heap::allocate( size, zeroed );
+                }
+                unsigned k = arena::size_class( size );
+                void *ptr = 0;
+                if( cache *c = local() ) {
+                    if( !c->heads[k] ) {
+                        c->heads[k] = heap().alloc_chain( k, BATCH, &c->counts[k] );
+                    }
+                    if( ( ptr = c->heads[k] ) != 0 ) {
+                        c->heads[k] = *(void **)ptr;
+                        c->counts[k]--;
+                    }
+                }
+                if( !ptr ) {
+                    ptr = heap().alloc( size ); // falls back to kTraceyRealloc when the range is exhausted
+                }
+                return ptr && zeroed ? std::memset( ptr, 0, size ) : ptr;
+            }
+            static void deallocate( void *ptr ) {
+                size_t bytes = heap().usable( ptr );
+                cache *c = bytes <= arena::SMALL ? local() : 0;
+                if( !c ) {
+                    heap().free( ptr );
+                    return;
+                }
+                unsigned k = arena::size_class( bytes );
+                *(void **)ptr = c->heads[k];
+                c->heads[k] = ptr;
+                if( ++c->counts[k] > LIMIT ) {
+                    // keeps the most recent blocks, which are the likeliest to be warm
+                    void *last = ptr;
+                    for( unsigned n = 1; n < BATCH; ++n ) {
+                        last = *(void **)last;
+                    }
+                    heap().free_chain( *(void **)last, k, c->counts[k] - BATCH );
+                    *(void **)last = 0;
+                    c->counts[k] = BATCH;
+                }
+            }
+            static void *reallocate( void *ptr, size_t size ) {
+                size_t have = heap().usable( ptr );
+                void *fresh = allocate( size, false );
+                if( fresh ) {
+                    std::memcpy( fresh, ptr, have < size ? have : size );
+                    deallocate( ptr );
+                }
+                return fresh;
+            }
+            static void *align( size_t alignment, size_t size ) {
+                // blocks are aligned to their class size
+                size_t bytes = size > alignment ? size : alignment;
+                return bytes > arena::SMALL ? system_heap::align( alignment, size ) : allocate( bytes, false );
+            }
+            static size_t usable_size( const void *ptr ) {
+                return heap().usable( ptr );
+            }
+            static bool owns( const void *ptr ) {
+                arena *self = instance();
+                return self && self->owns( ptr );
+            }
+        };
+
+        const backend backends[] = {
+            { "system", system_heap::allocate, system_heap::reallocate, system_heap::deallocate, system_heap::align, system_heap::usable_size, system_heap::owns },
+            { "slab", slab::allocate, slab::reallocate, slab::deallocate, slab::align, slab::usable_size, slab::owns },
+        };
+
+        // backend for new blocks
+        const backend &chosen() {
+            return backends[ backend::selected == backend::SLAB ? backend::SLAB : backend::SYSTEM ];
+        }
+
+        // backend holding ptr
+        const backend &owner( const void *ptr ) {
+            return backends[ slab::owns( ptr ) ? backend::SLAB : backend::SYSTEM ];
+        }
+
+        // header of ptr if ptr is a tracey block, or null. a header crossing into the previous page is
+        // never peeked at, so foreign pointers cannot fault here; such blocks are tracked by the table.
+        // slab blocks are always peeked at, as their header is slab memory too.
+        header *headed( const void *ptr ) {
+            if( !policy_t::HEADERS || ( ( (uintptr_t)ptr & 4095 ) < header_size && !( slab::owns( ptr ) && slab::owns( header_of( ptr ) ) ) ) ) {
+                return 0;
+            }
+            header *h = header_of( ptr );
+            return h->is( ptr, header::BLOCK ) || h->is( ptr, header::LIVE ) ? h : 0;
+        }
+
+        // writes an untracked header at the end of the first offset bytes of base; returns the block
+        void *stamp( void *base, size_t offset, size_t size ) {
+            char *ptr = (char *)base + offset;
+            header *h = header_of( ptr );
+            h->prev = h->next = 0;
+            h->size = size;
+            h->id = 0;
+            h->stack = 0;
+            h->weight = 1;
+            h->offset = uint32_t( offset );
+            h->mark( ptr, header::BLOCK );
+            return ptr;
+        }
+
+        // open addressing hash table (robin hood), keyed by the address of its records.
+        // records are stored inline and a null address marks an empty slot. erasing shifts
+        // following records backwards, so there are no tombstones and probes stay short.
+        // slots are requested to the metadata arena directly, so the table never tracks itself.
+        template<typename V>
+        class table
+        {
+            V *slots;
+            size_t mask, count;
+            unsigned shift;
+
+            table( const table & );
+            table &operator=( const table & );
+
+            size_t home( const void *key ) const {
+                return size_t( ( uint64_t( (uintptr_t)key >> 4 ) * 0xFF51AFD7ED558CCDULL ) >> shift );
+            }
+            size_t distance( size_t pos ) const {
+                return ( pos - home( slots[pos].addr ) ) & mask;
+            }
+
+            void rehash( size_t capacity, unsigned bits ) {
+                V *old = slots;
+                size_t old_capacity = this->capacity();
+
+                slots = (V *)metadata().alloc( capacity * sizeof(V) );
+                if( !slots ) tracey::badalloc();
+                for( size_t i = 0; i < capacity; ++i ) {
+                    new (&slots[i]) V();
+                }
+                mask = capacity - 1;
+                shift = 64 - bits;
+                count = 0;
+
+                for( size_t i = 0; i < old_capacity; ++i ) {
+                    if( old[i].addr ) {
+                        using std::swap;
+                        swap( insert( old[i].addr ), old[i] );
+                    }
+                    old[i].~V();
+                }
+                if( old ) metadata().free( old );
+            }
+
+            public:
+
+            table() : slots(0), mask(0), count(0), shift(64)
+            {}
+
+            ~table() {
+                clear();
+            }
+
+            size_t size() const {
+                return count;
+            }
+            size_t capacity() const {
+                return slots ? mask + 1 : 0;
+            }
+            size_t space() const {
+                return capacity() * sizeof(V);
+            }
+
+            V &at( size_t pos ) {
+                return slots[pos];
+            }
+            const V &at( size_t pos ) const {
+                return slots[pos];
+            }
+
+            V *find( const void *key ) {
+                if( !count ) return 0;
+                for( size_t pos = home( key ), dist = 0; slots[pos].addr && distance( pos ) >= dist; pos = (pos + 1) & mask, ++dist ) {
+                    if( slots[pos].addr == key ) return &slots[pos];
+                }
+                return 0;
+            }
+
+            // returns the record of given key, which is created (empty but keyed) if missing
+            V &insert( const void *key ) {
+                if( V *found = find( key ) ) return *found;
+                if( (count + 1) * 8 > capacity() * 7 ) {
+                    rehash( capacity() ? capacity() * 2 : 64, capacity() ? 64 - shift + 1 : 6 );
+                }
+
+                using std::swap;
+                V entry;
+                entry.addr = key;
+                V *inserted = 0;
+                for( size_t pos = home( key ), dist = 0; ; pos = (pos + 1) & mask, ++dist ) {
+                    if( !slots[pos].addr ) {
+                        swap( slots[pos], entry );
+                        if( !inserted ) inserted = &slots[pos];
+                        break;
+                    }
+                    size_t other = distance( pos );
+                    if( other < dist ) {
+                        // rich record found; steal its slot and keep on probing for the poor one
+                        swap( slots[pos], entry );
+                        if( !inserted ) inserted = &slots[pos];
+                        dist = other;
+                    }
+                }
+                ++count;
+                return *inserted;
+            }
+
+            void erase( V *record ) {
+                using std::swap;
+                size_t pos = record - slots;
+                V empty;
+                swap( slots[pos], empty );
+                for( size_t next = (pos + 1) & mask; slots[next].addr && distance( next ); pos = next, next = (next + 1) & mask ) {
+                    swap( slots[pos], slots[next] );
+                }
+                --count;
+            }
+
+            void clear() {
+                for( size_t i = 0, end = capacity(); i < end; ++i ) {
+                    slots[i].~V();
+                }
+                if( slots ) metadata().free( slots );
+                slots = 0;
+                mask = count = 0;
+                shift = 64;
+            }
+        };
+
+        // registry is alive (constructed and not yet destroyed)
+        std::atomic<bool> ready( false );
+
+        // hard on/off switch
+        static const    bool kTraceyEnabledHard = kTraceyEnabled;
+        // soft on/off switch
+        static volatile bool kTraceyEnabledSoft = true;
+
+        // interning table of callstacks. identical stacks are stored once and are referred by a
+        // 32-bit id (low bits pick the stripe, high bits the entry within it; 0 means no stack).
+        // entries and frames never move once written, so they can be read by id without locking:
+        // entry chunks double in size and hang from a fixed directory published with release stores.
+        class stacktable
+        {
+            enum { SHARD_BITS = 6, SHARDS = 1 << SHARD_BITS, ENTRIES_PER_CHUNK = 512, FRAMES_PER_CHUNK = 4096 };
+            enum { DIRECTORY = 32 - SHARD_BITS, MAX_ENTRIES = ( 1u << (32 - SHARD_BITS) ) - 1 };
+
+            struct entry {
+                uint64_t hash;
+                void **frames;
+                unsigned depth;
+                size_t regrows, copied;          // reallocations of blocks allocated here, and bytes they moved
+            };
+
+            struct shard {
+                mutable std::mutex mutex;
+                std::atomic< entry * > entries[ DIRECTORY ];  // chunk k holds ENTRIES_PER_CHUNK << k entries
+                void **frames;                   // last chunk of FRAMES_PER_CHUNK frames; older ones are owned by their entries
+                size_t chunks, count, used;      // frame chunks allocated, entries in use, frames in use within last chunk
+                uint32_t *index;                 // open addressing index of entry numbers (+1), 0 is empty
+                size_t mask;
+                shard() : frames(0), chunks(0), count(0), used(FRAMES_PER_CHUNK), index(0), mask(0) {
+                    for( unsigned k = 0; k < DIRECTORY; ++k ) entries[k].store( 0, std::memory_order_relaxed );
+                }
+            } shards[ SHARDS ];
+
+            stacktable( const stacktable & );
+            stacktable &operator=( const stacktable & );
+
+            static uint64_t hash( void *const *frames, unsigned depth ) {
+                uint64_t h = 0xCBF29CE484222325ULL ^ depth;
+                for( unsigned i = 0; i < depth; ++i ) {
+                    h = ( h ^ uint64_t( (uintptr_t)frames[i] ) ) * 0x100000001B3ULL;
+                    h ^= h >> 29;
+                }
+                return h;
+            }
+
+            static void *alloc( size_t bytes ) {
+                void *ptr = metadata().alloc( bytes );
+                if( !ptr ) tracey::badalloc();
+                return ptr;
+            }
+
+            // chunk holding entry number n, and its offset within it
+            static unsigned chunk( size_t n, size_t *offset ) {
+                unsigned k = 0;
+                for( size_t q = n / ENTRIES_PER_CHUNK + 1; q >>= 1; ) ++k;
+                *offset = n - ENTRIES_PER_CHUNK * ( ( size_t(1) << k ) - 1 );
+                return k;
+            }
+
+            static entry &at( const shard &sh, size_t n ) {
+                size_t offset;
+                unsigned k = chunk( n, &offset );
+                return sh.entries[k].load( std::memory_order_acquire )[ offset ];
+            }
+
+            static void reindex( shard &sh, size_t capacity ) {
+                if( sh.index ) metadata().free( sh.index );
+                sh.index = (uint32_t *)alloc( capacity * sizeof(uint32_t) );
+                std::memset( sh.index, 0, capacity * sizeof(uint32_t) );
+                sh.mask = capacity - 1;
+                for( size_t n = 0; n < sh.count; ++n ) {
+                    size_t pos = size_t( at( sh, n ).hash >> SHARD_BITS ) & sh.mask;
+                    while( sh.index[pos] ) pos = (pos + 1) & sh.mask;
+                    sh.index[pos] = uint32_t( n + 1 );
+                }
+            }
+
+            public:
+
+            stacktable()
+            {}
+
+            // returns the id of given stack, which is stored first time it is seen
+            uint32_t intern( void *const *frames, unsigned depth ) {
+                if( !depth ) return 0;
+
+                uint64_t h = hash( frames, depth );
+                unsigned s = unsigned( h & (SHARDS - 1) );
+                shard &sh = shards[s];
+
+                sh.mutex.lock();
+                size_t pos = sh.index ? size_t( h >> SHARD_BITS ) & sh.mask : 0;
+                for( ; sh.index && sh.index[pos]; pos = (pos + 1) & sh.mask ) {
+                    const entry &e = at( sh, sh.index[pos] - 1 );
+                    if( e.hash == h && e.depth == depth && !std::memcmp( e.frames, frames, depth * sizeof(void *) ) ) {
+                        uint32_t id = uint32_t( ( sh.index[pos] << SHARD_BITS ) | s );
+                        sh.mutex.unlock();
+                        return id;
+                    }
+                }
+
+                // not found; copy frames and entry into their chunks, then index them
+                if( sh.count >= MAX_ENTRIES ) {
+                    sh.mutex.unlock();
+                    tracey::fail( "<tracey/tracey.cpp> says: error! too many callstacks for 32-bit ids" );
+                    return 0;
+                }
+                if( sh.used + depth > FRAMES_PER_CHUNK ) {
+                    sh.frames = (void **)alloc( FRAMES_PER_CHUNK * sizeof(void *) );
+                    sh.chunks++;
+                    sh.used = 0;
+                }
+                size_t offset;
+                unsigned k = chunk( sh.count, &offset );
+                if( !offset ) {
+                    sh.entries[k].store( (entry *)alloc( ( size_t( ENTRIES_PER_CHUNK ) << k ) * sizeof(entry) ), std::memory_order_release );
+                }
+                entry &e = at( sh, sh.count );
+                e.hash = h;
+                e.depth = depth;
+                e.regrows = e.copied = 0;
+                e.frames = sh.frames + sh.used;
+                std::memcpy( e.frames, frames, depth * sizeof(void *) );
+                sh.used += depth;
+                sh.count++;
+
+                if( !sh.index || sh.count * 4 > (sh.mask + 1) * 3 ) {
+                    reindex( sh, sh.index ? (sh.mask + 1) * 2 : 256 );
+                } else {
+                    while( sh.index[pos] ) pos = (pos + 1) & sh.mask;
+                    sh.index[pos] = uint32_t( sh.count );
+                }
+
+                uint32_t id = uint32_t( ( sh.count << SHARD_BITS ) | s );
+                sh.mutex.unlock();
+                return id;
+            }
+
+            void *const *frames( uint32_t id, unsigned *depth ) const {
+                if( !id ) return *depth = 0, (void *const *)0;
+                const entry &e = at( shards[ id & (SHARDS - 1) ], (id >> SHARD_BITS) - 1 );
+                return *depth = e.depth, e.frames;
+            }
+
+            // realloc chains, per allocation site {
+
+            struct chain {
+                uint32_t stack;
+                size_t regrows, copied;
+                bool operator<( const chain &other ) const {
+                    return copied != other.copied ? copied > other.copied : regrows > other.regrows;
+                }
+            };
+
+            // counts a reallocation of a block allocated at given stack; copied is 0 if done in place
+            void regrew( uint32_t id, size_t copied ) {
+                if( !id ) return;
+                shard &sh = shards[ id & (SHARDS - 1) ];
+                sh.mutex.lock();
+                entry &e = at( sh, (id >> SHARD_BITS) - 1 );
+                e.regrows++;
+                e.copied += copied;
+                sh.mutex.unlock();
+            }
+
+            // sites that reallocated their blocks, most bytes copied first
+            std::vector< chain > chains() const {
+                std::vector< chain > list;
+                for( unsigned s = 0; s < SHARDS; ++s ) {
+                    const shard &sh = shards[s];
+                    sh.mutex.lock();
+                    for( size_t n = 0; n < sh.count; ++n ) {
+                        const entry &e = at( sh, n );
+                        if( e.regrows ) {
+                            chain c = { uint32_t( ( (n + 1) << SHARD_BITS ) | s ), e.regrows, e.copied };
+                            list.push_back( c );
+                        }
+                    }
+                    sh.mutex.unlock();
+                }
+                std::sort( list.begin(), list.end() );
+                return list;
+            }
+
+            void clear_chains() {
+                for( unsigned s = 0; s < SHARDS; ++s ) {
+                    shard &sh = shards[s];
+                    sh.mutex.lock();
+                    for( size_t n = 0; n < sh.count; ++n ) {
+                        at( sh, n ).regrows = at( sh, n ).copied = 0;
+                    }
+                    sh.mutex.unlock();
+                }
+            }
+
+            // }
+
+            size_t size() const {
+                size_t total = 0;
+                for( unsigned s = 0; s < SHARDS; ++s ) {
+                    shards[s].mutex.lock();
+                    total += shards[s].count;
+                    shards[s].mutex.unlock();
+                }
+                return total;
+            }
+
+            size_t space() const {
+                size_t total = 0;
+                for( unsigned s = 0; s < SHARDS; ++s ) {
+                    const shard &sh = shards[s];
+                    sh.mutex.lock();
+                    for( unsigned k = 0; k < DIRECTORY && sh.entries[k].load(); ++k ) {
+                        total += ( size_t( ENTRIES_PER_CHUNK ) << k ) * sizeof(entry);
+                    }
+                    total += sh.chunks * FRAMES_PER_CHUNK * sizeof(void *);
+                    total += sh.index ? (sh.mask + 1) * sizeof(uint32_t) : 0;
+                    sh.mutex.unlock();
+                }
+                return total;
+            }
+        };
+
+        // byte-based poisson sampling, as in tcmalloc heap profiler. every thread counts down the bytes
+        // it allocates and samples the allocation that crosses zero; distances between samples are
+        // exponentially distributed with mean `rate` bytes. an allocation of size s is then sampled with
+        // probability p = 1 - exp(-s/rate), so each record stands for 1/p allocations and s/p bytes.
+        // unsampled pointers are never marked in the free filter below, so their frees return early.
+        class sampler
+        {
+            // next distance between samples, in bytes
+            static size_t draw() {
+                static $tls(uint64_t) seed = 0;
+                if( !seed ) {
+                    seed = uint64_t( (uintptr_t)&seed ) ^ uint64_t( std::time(0) ) ^ 0x9E3779B97F4A7C15ULL;
+                }
+                seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; // xorshift64
+                double u = double( (seed >> 11) + 1 ) / 9007199254740992.0; // (0..1]
+                double bytes = -std::log( u ) * double( rate );
+                return bytes < 1.0 ? 1 : size_t( bytes );
+            }
+
+            public:
+
+            // mean bytes between samples; 0 tracks every allocation. defaults to kTraceySampleRate
+            static volatile size_t rate;
+
+            // whether allocations are being sampled. never, when the policy compiles sampling out
+            static bool on() {
+                return policy_t::SAMPLING && rate;
+            }
+
+            // decides whether calling thread samples this allocation
+            static bool pick( size_t size ) {
+                static $tls(size_t) left = 0;
+                if( !left ) {
+                    left = draw();
+                }
+                if( left > size ) {
+                    left -= size;
+                    return false;
+                }
+                left = draw();
+                return true;
+            }
+
+            // allocations that an allocation of given size stands for, if sampled now. records keep it,
+            // so their estimates are added and taken back alike even if the rate changes meanwhile
+            static float weight( size_t size ) {
+                return on() && size ? float( 1.0 / ( 1.0 - std::exp( -double( size ) / double( rate ) ) ) ) : 1.0f;
+            }
+
+            // number of allocations and bytes that a record of given size and weight stands for
+            static size_t count( float weight ) {
+                return size_t( weight + 0.5 );
+            }
+            static size_t bytes( size_t size, float weight ) {
+                return size_t( size * double( weight ) + 0.5 );
+            }
+        };
+
+        volatile size_t sampler::rate = policy_t::SAMPLING ? kTraceySampleRate : 0;
+
+        // counting blocked bloom filter of tracked addresses, so frees of pointers that were never tracked
+        // (allocated while disabled, unsampled, foreign...) skip the registry and its locks altogether.
+        // both probes of an address fall in the same 64-byte block (one cache line). counters saturate
+        // and stay, so maybe() never lies about a tracked address; it just grows less selective.
+        // tallies are split in per-thread stripes, so counting does not bounce a shared cache line.
+        class bloomfilter
+        {
+            enum { BLOCK = 64, BLOCKS = kTraceyFreeFilterKB * 1024 / BLOCK, STICKY = 255, STRIPES = 64 };
+
+            struct tally {
+                std::atomic<size_t> rejected, passed, confused;
+                char pad[ 64 - 3 * sizeof(std::atomic<size_t>) ];
+            };
+
+            std::atomic<unsigned char> counters[ BLOCKS != 0 ? BLOCKS * BLOCK : 1 ];
+            tally tallies[ STRIPES ];
+
+            static uint64_t hash( const void *ptr ) {
+                return uint64_t( (uintptr_t)ptr >> 4 ) * 0x9E3779B97F4A7C15ULL;
+            }
+            std::atomic<unsigned char> &probe( uint64_t h, unsigned which ) {
+                return counters[ size_t( (h >> 32) & (BLOCKS - 1) ) * BLOCK + size_t( (h >> (20 + 6 * which)) & (BLOCK - 1) ) ];
+            }
+            static void up( std::atomic<unsigned char> &c ) {
+                unsigned char n = c.load( std::memory_order_relaxed );
+                while( n != STICKY && !c.compare_exchange_weak( n, n + 1 ) );
+            }
+            static void down( std::atomic<unsigned char> &c ) {
+                unsigned char n = c.load( std::memory_order_relaxed );
+                while( n != STICKY && n && !c.compare_exchange_weak( n, n - 1 ) );
+            }
+            tally &local() {
+                static std::atomic<unsigned> threads( 0 );
+                static $tls(unsigned) stripe = 0;
+                if( !stripe ) stripe = ++threads;
+                return tallies[ stripe & (STRIPES - 1) ];
+            }
+
+            public:
+
+            bloomfilter() {
+                for( size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); ++i ) {
+                    counters[i] = 0;
+                }
+                for( unsigned i = 0; i < STRIPES; ++i ) {
+                    tallies[i].rejected = tallies[i].passed = tallies[i].confused = 0;
+                }
+            }
+
+            void mark( const void *ptr ) {
+                if( BLOCKS == 0 ) return;
+                uint64_t h = hash( ptr );
+                up( probe( h, 0 ) );
+                up( probe( h, 1 ) );
+            }
+            void unmark( const void *ptr ) {
+                if( BLOCKS == 0 ) return;
+                uint64_t h = hash( ptr );
+                down( probe( h, 0 ) );
+                down( probe( h, 1 ) );
+            }
+
+            // false if ptr is not tracked for sure; true if it may be
+            bool maybe( const void *ptr ) {
+                if( BLOCKS == 0 ) return true;
+                uint64_t h = hash( ptr );
+                bool hit = probe( h, 0 ).load( std::memory_order_relaxed ) && probe( h, 1 ).load( std::memory_order_relaxed );
+                ( hit ? local().passed : local().rejected ).fetch_add( 1, std::memory_order_relaxed );
+                return hit;
+            }
+            // maybe() said yes but there was no record
+            void false_positive() {
+                local().confused.fetch_add( 1, std::memory_order_relaxed );
+            }
+
+            void totals( size_t *rejected, size_t *passed, size_t *confused ) const {
+                *rejected = *passed = *confused = 0;
+                for( unsigned i = 0; i < STRIPES; ++i ) {
+                    *rejected += tallies[i].rejected.load( std::memory_order_relaxed );
+                    *passed += tallies[i].passed.load( std::memory_order_relaxed );
+                    *confused += tallies[i].confused.load( std::memory_order_relaxed );
+                }
+            }
+        };
+
+        // address space mapped by the application itself (kTraceyHookMmap). mappings are ranges, not
+        // points: one munmap() or madvise(MADV_DONTNEED) may cover several of them or just the middle of
+        // one, which splits it in two. regions are kept sorted by start address; every piece keeps the
+        // callstack and id of the mmap() it comes from. discarded pages are still mapped, but not in use.
+        class mappings
+        {
+            public:
+
+            struct region {
+                uintptr_t end;
+                size_t id;
+                uint32_t stack;
+                bool anonymous, discarded;
+            };
+
+            private:
+
+            typedef std::map< uintptr_t, region > regions;
+
+            mutable std::mutex mutex;
+            regions live;
+            size_t in_use, peak;
+
+            static uintptr_t page_up( uintptr_t at ) {
+                static const uintptr_t page = $windows( 4096 ) $welse( uintptr_t( sysconf( _SC_PAGESIZE ) ) );
+                return ( at + page - 1 ) & ~( page - 1 );
+            }
+
+            // makes `at` a region boundary, if some region spans across it. mutex must be held
+            void split( uintptr_t at ) {
+                regions::iterator it = live.upper_bound( at );
+                if( it == live.begin() ) return;
+                --it;
+                if( it->first < at && at < it->second.end ) {
+                    region tail = it->second;
+                    it->second.end = at;
+                    live.insert( std::make_pair( at, tail ) );
+                }
+            }
+
+            // removes [lo, hi) from every region; mutex must be held
+            void cut( uintptr_t lo, uintptr_t hi ) {
+                split( lo );
+                split( hi );
+                regions::iterator it = live.lower_bound( lo );
+                while( it != live.end() && it->first < hi ) {
+                    if( !it->second.discarded ) in_use -= it->second.end - it->first;
+                    live.erase( it++ );
+                }
+            }
+
+            public:
+
+            mappings() : in_use(0), peak(0)
+            {}
+
+            void map( const void *addr, size_t length, const region &props ) {
+                uintptr_t lo = (uintptr_t)addr, hi = page_up( lo + length );
+                mutex.lock();
+                cut( lo, hi ); // MAP_FIXED replaces whatever was there
+                region r = props;
+                r.end = hi;
+                r.discarded = false;
+                live.insert( std::make_pair( lo, r ) );
+                in_use += hi - lo;
+                if( in_use > peak ) peak = in_use;
+                mutex.unlock();
+            }
+
+            // *found receives the region holding addr, if any, so a remap can carry it over
+            bool unmap( const void *addr, size_t length, region *found = 0 ) {
+                uintptr_t lo = (uintptr_t)addr, hi = page_up( lo + length );
+                mutex.lock();
+                bool hit = false;
+                if( found ) {
+                    regions::iterator it = live.upper_bound( lo );
+                    if( it != live.begin() && (--it)->second.end > lo ) {
+                        *found = it->second;
+                        hit = true;
+                    }
+                }
+                cut( lo, hi );
+                mutex.unlock();
+                return hit;
+            }
+
+            void discard( const void *addr, size_t length ) {
+                uintptr_t lo = (uintptr_t)addr, hi = page_up( lo + length );
+                mutex.lock();
+                split( lo );
+                split( hi );
+                for( regions::iterator it = live.lower_bound( lo ); it != live.end() && it->first < hi; ++it ) {
+                    if( !it->second.discarded ) in_use -= it->second.end - it->first;
+                    it->second.discarded = true;
+                }
+                mutex.unlock();
+            }
+
+            void clear() {
+                mutex.lock();
+                live.clear();
+                in_use = 0;
+                mutex.unlock();
+            }
+
+            // regions, mapped and discarded bytes (anonymous ones included in *anonymous), and peak in use
+            void totals( size_t *count, size_t *mapped, size_t *anonymous, size_t *discarded, size_t *high ) const {
+                mutex.lock();
+                *count = live.size();
+                *mapped = *anonymous = *discarded = 0;
+                for( regions::const_iterator it = live.begin(), end = live.end(); it != end; ++it ) {
+                    size_t bytes = it->second.end - it->first;
+                    *mapped += bytes;
+                    if( it->second.anonymous ) *anonymous += bytes;
+                    if( it->second.discarded ) *discarded += bytes;
+                }
+                *high = peak;
+                mutex.unlock();
+            }
+
+            // bytes in use (discarded pages excluded) and regions, per callstack; most bytes first
+            struct site {
+                uint32_t stack;
+                size_t bytes, count;
+                bool operator<( const site &other ) const {
+                    return bytes > other.bytes;
+                }
+            };
+            std::vector< site > sites() const {
+                std::map< uint32_t, site > by_stack;
+                mutex.lock();
+                for( regions::const_iterator it = live.begin(), end = live.end(); it != end; ++it ) {
+                    if( it->second.discarded || it->second.id < timestamp_id ) continue;
+                    site &s = by_stack[ it->second.stack ];
+                    s.stack = it->second.stack;
+                    s.bytes += it->second.end - it->first;
+                    s.count++;
+                }
+                mutex.unlock();
+                std::vector< site > list;
+                for( std::map< uint32_t, site >::const_iterator it = by_stack.begin(), end = by_stack.end(); it != end; ++it ) {
+                    list.push_back( it->second );
+                }
+                std::sort( list.begin(), list.end() );
+                return list;
+            }
+        };
+
+        // set while a thread runs tracey code, so tracey's own allocations are not tracked
+        $tls(bool) acquired = false;
+
+        // asynchronous bookkeeping. every thread appends compact events to its own ring buffer
+        // (single producer, single consumer) and one aggregator thread drains all rings into the
+        // registry, each ring in the order it was written. across rings, only events on the same
+        // address need an order (a free() before the allocation recycling it), so addresses are hashed
+        // into lanes and every event takes the next sequence number of its lane. the aggregator applies
+        // a lane strictly in that order; a ring whose next event is early waits for the other rings.
+        struct event {
+            const void *addr;
+            size_t size;        // 0 on deallocations
+            uint32_t stack;
+            uint32_t seq;       // within the lane of addr
+        };
+
+        class eventlog
+        {
+            enum { CAPACITY = kTraceyAsyncBufferSize, MAX_RINGS = 1024, LANE_BITS = 12, LANES = 1 << LANE_BITS };
+
+            struct ring {
+                std::atomic<size_t> tail;   // owner thread only
+                char pad0[ 64 - sizeof(std::atomic<size_t>) ];
+                std::atomic<size_t> head;   // aggregator only
+                char pad1[ 64 - sizeof(std::atomic<size_t>) ];
+                std::atomic<bool> retired;  // no owner thread; adopted by the next thread once drained
+                event events[ CAPACITY ];
+
+                ring() : tail(0), head(0), retired(false)
+                {}
+            };
+
+            std::atomic<ring *> rings[ MAX_RINGS ]; // never freed, so they can be read at any time
+            std::atomic<unsigned> used;         // rings[] high-water mark
+            std::atomic<unsigned> allocated;
+            std::atomic<bool> closed;           // no aggregator anymore; events are tracked synchronously
+            std::atomic<size_t> peak, stalls;
+            std::atomic<uint32_t> issued[ LANES ];  // next sequence number of every lane
+            uint32_t applied[ LANES ];              // next one the aggregator applies; aggregator only
+
+            static unsigned lane( const void *addr ) {
+                return unsigned( ( uint64_t( (uintptr_t)addr >> 4 ) * 0x9E3779B97F4A7C15ULL ) >> (64 - LANE_BITS) );
+            }
+
+            static bool &gone() {
+                static $tls(bool) gone = false;
+                return gone;
+            }
+            static ring *&mine() {
+                static $tls(ring *) mine = 0;
+                return mine;
+            }
+
+            // hands the ring of an exiting thread back, to be adopted by another thread once drained
+            struct retire {
+                ~retire() {
+                    gone() = true;
+                    if( ring *r = mine() ) {
+                        mine() = 0;
+                        r->retired.store( true, std::memory_order_release );
+                    }
+                }
+            };
+
+            ring *claim( ring *r ) {
+                static thread_local retire on_exit;
+                (void)on_exit;
+                return mine() = r;
+            }
+
+            ring *local() {
+                ring *r = mine();
+                if( r || gone() ) {
+                    return r;
+                }
+                for( unsigned i = 0, end = used.load(); i < end; ++i ) {
+                    bool retired = true;
+                    r = rings[i].load( std::memory_order_acquire );
+                    if( r && r->retired.load() && r->head.load( std::memory_order_acquire ) == r->tail.load() &&
+                        r->retired.compare_exchange_strong( retired, false ) ) {
+                        return claim( r );
+                    }
+                }
+                void *mem = metadata().alloc( sizeof(ring) );
+                if( !mem ) {
+                    return 0;
+                }
+                r = new (mem) ring();
+                for( unsigned i = 0; i < MAX_RINGS; ++i ) {
+                    ring *empty = 0;
+                    if( rings[i].compare_exchange_strong( empty, r ) ) {
+                        unsigned n = used.load();
+                        while( n < i + 1 && !used.compare_exchange_weak( n, i + 1 ) );
+                        allocated++;
+                        return claim( r );
+                    }
+                }
+                r->~ring();
+                metadata().free( r );
+                gone() = true; // too many threads; this one stays synchronous
+                return 0;
+            }
+
+            public:
+
+            eventlog() : used(0), allocated(0), closed(false), peak(0), stalls(0) {
+                for( unsigned i = 0; i < MAX_RINGS; ++i ) {
+                    rings[i] = 0;
+                }
+                for( unsigned i = 0; i < LANES; ++i ) {
+                    issued[i] = applied[i] = 0;
+                }
+            }
+
+            // producer side; returns false if calling thread has no ring (caller falls back to sync path)
+            bool push( const void *addr, size_t size, uint32_t stack ) {
+                ring *r = closed.load( std::memory_order_relaxed ) ? 0 : local();
+                if( !r ) {
+                    return false;
+                }
+                size_t t = r->tail.load( std::memory_order_relaxed );
+                size_t h = r->head.load( std::memory_order_acquire );
+                if( t - h == CAPACITY ) {
+                    // backpressure: aggregator is behind, so wait for room
+                    stalls++;
+                    do {
+                        std::this_thread::yield();
+                        h = r->head.load( std::memory_order_acquire );
+                    } while( t - h == CAPACITY && !closed.load() );
+                    if( t - h == CAPACITY ) {
+                        return false;
+                    }
+                }
+                // room is reserved before taking a sequence number, so published numbers have no gaps
+                event &e = r->events[ t & (CAPACITY - 1) ];
+                e.addr = addr;
+                e.size = size;
+                e.stack = stack;
+                e.seq = issued[ lane( addr ) ]++;
+                r->tail.store( t + 1, std::memory_order_release );
+
+                size_t level = t + 1 - h, top = peak.load( std::memory_order_relaxed );
+                while( level > top && !peak.compare_exchange_weak( top, level ) );
+                return true;
+            }
+
+            // consumer side; applies every event that is next in its lane. returns false when idle.
+            // force applies whatever is queued regardless, as the last drain does
+            template<typename SINK>
+            bool drain( SINK &sink, bool force = false ) {
+                bool any = false;
+                for( bool progress = true; progress; any |= progress ) {
+                    progress = false;
+                    for( unsigned i = 0, end = used.load(); i < end; ++i ) {
+                        ring *r = rings[i].load( std::memory_order_acquire );
+                        if( !r ) {
+                            continue;
+                        }
+                        size_t h = r->head.load( std::memory_order_relaxed );
+                        size_t t = r->tail.load( std::memory_order_acquire );
+                        while( h != t ) {
+                            const event &e = r->events[ h & (CAPACITY - 1) ];
+                            uint32_t &next = applied[ lane( e.addr ) ];
+                            if( e.seq != next && !force ) {
+                                break; // an earlier event on this lane is in another ring
+                            }
+                            next = e.seq + 1;
+                            sink.apply( e );
+                            r->head.store( ++h, std::memory_order_release );
+                            progress = true;
+                        }
+                    }
+                }
+                return any;
+            }
+
+            // blocks until every event pushed so far has been applied, or nobody is left to apply it
+            void flush() const {
+                for( unsigned i = 0, end = used.load(); i < end; ++i ) {
+                    ring *r = rings[i].load( std::memory_order_acquire );
+                    size_t t = r ? r->tail.load( std::memory_order_acquire ) : 0;
+                    while( r && r->head.load( std::memory_order_acquire ) < t && !closed.load() ) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            // no more events are queued; producers fall back to the synchronous path from now on
+            void close() {
+                closed = true;
+            }
+            bool done() const {
+                return closed.load();
+            }
+
+            // forked child: the threads that owned rings are gone, and so is whatever they queued.
+            // calling thread gets a ring again on its next event
+            void reset() {
+                for( unsigned i = 0, end = used.load(); i < end; ++i ) {
+                    if( ring *r = rings[i].load() ) {
+                        r->head.store( r->tail.load() );
+                        r->retired = true;
+                    }
+                }
+                for( unsigned i = 0; i < LANES; ++i ) {
+                    applied[i] = issued[i].load();
+                }
+                mine() = 0;
+            }
+
+            size_t high_water() const {
+                return peak.load();
+            }
+            size_t backpressure() const {
+                return stalls.load();
+            }
+            size_t space() const {
+                return allocated.load() * sizeof(ring);
+            }
+        };
+
+        // runtime settings. they default to kTracey* macros and are overridden by TRACEY_* environment
+        // variables, so a preloaded build can be configured without rebuilding it:
+        //   TRACEY_ENABLED, TRACEY_REPORT_ON_EXIT, TRACEY_VIEW, TRACEY_REPORT (report file; %p is pid),
+        //   TRACEY_REPORT_SIGNAL (signal that writes a report on demand), TRACEY_WEBSERVER_PORT,
+        //   TRACEY_SAMPLE_RATE, TRACEY_UNWINDER, TRACEY_BACKEND, TRACEY_INHERIT (keep LD_PRELOAD for child processes),
+        //   TRACEY_SYMBOLIZER (addr2line-compatible command for modules without line tables; empty disables it),
+        //   TRACEY_SYMBOL_CACHE (symbol cache directory, even with kTraceySymbolCache off; empty disables it).
+        struct options_t {
+            bool report_on_exit, view, inherit;
+            unsigned port;
+            int signal;
+            const char *report, *symbol_cache;
+
+            static long env( const char *name, long fallback ) {
+                const char *value = std::getenv( name );
+                return value && *value ? std::strtol( value, 0, 0 ) : fallback;
+            }
+
+            options_t() {
+                bool preload = false;
+#ifdef TRACEY_PRELOAD
+                preload = true;
+#endif
+                kTraceyEnabledSoft = env( "TRACEY_ENABLED", kTraceyEnabledSoft ) != 0;
+                report_on_exit = env( "TRACEY_REPORT_ON_EXIT", kTraceyReportOnExit ) != 0;
+                view = env( "TRACEY_VIEW", !preload ) != 0;
+                inherit = env( "TRACEY_INHERIT", 0 ) != 0;
+#ifdef TRACEY_PRELOAD
+                if( !inherit ) {
+                    uninherit(); // child processes must not report themselves
+                }
+#endif
+                port = unsigned( env( "TRACEY_WEBSERVER_PORT", kTraceyWebserverPort ) );
+                signal = int( env( "TRACEY_REPORT_SIGNAL", 0 ) );
+                report = std::getenv( "TRACEY_REPORT" );
+                symbol_cache = std::getenv( "TRACEY_SYMBOL_CACHE" );
+                if( policy_t::SAMPLING ) {
+                    sampler::rate = size_t( env( "TRACEY_SAMPLE_RATE", long( sampler::rate ) ) );
+                }
+                tracey::callstack::unwinder = int( env( "TRACEY_UNWINDER", tracey::callstack::unwinder ) );
+                backend::selected = int( env( "TRACEY_BACKEND", backend::selected ) );
+#if HEAL_HAS_ELF
+                if( const char *symbolizer = std::getenv( "TRACEY_SYMBOLIZER" ) ) {
+                    tracey::elf::fallback = symbolizer;
+                }
+#endif
+            }
+
+#ifdef TRACEY_PRELOAD
+            // drops this library from LD_PRELOAD, keeping any other library preloaded along with it.
+            // runs while options are read, before tracey starts its own thread.
+            static void uninherit() {
+                Dl_info info;
+                const char *preload = std::getenv( "LD_PRELOAD" );
+                if( !preload || !dladdr( (void *)&uninherit, &info ) || !info.dli_fname ) {
+                    return;
+                }
+                std::string self = info.dli_fname, kept;
+                self = self.substr( self.find_last_of( '/' ) + 1 );
+                for( const char *it = preload; *it; ) {
+                    size_t len = std::strcspn( it, ": " );
+                    std::string lib( it, len );
+                    if( len && lib.substr( lib.find_last_of( '/' ) + 1 ) != self ) {
+                        kept += ( kept.empty() ? "" : ":" ) + lib;
+                    }
+                    it += len + ( it[len] ? 1 : 0 );
+                }
+                if( kept.empty() ) unsetenv( "LD_PRELOAD" );
+                else setenv( "LD_PRELOAD", kept.c_str(), 1 );
+            }
+#endif
+
+            std::string report_path() const {
+                if( !report || !*report ) {
+                    return get_temp_pathfile() + "xxx-tracey.html";
+                }
+                unsigned pid = $windows( GetCurrentProcessId() ) $welse( getpid() );
+                return tracey::string( report ).replace( "%p", tracey::string( "\1", pid ) );
+            }
+        };
+
+        const options_t &options() {
+            static const options_t opts;
+            return opts;
+        }
+
+#if HEAL_HAS_ELF
+        // persistent symbol cache. frames resolved to a line are kept on disk, in one file per module
+        // named after its GNU build-id, so reports on an unchanged binary start warm across reports and
+        // restarts. file layout: header, entries sorted by offset into the module, then their text.
+        namespace symbol_cache {
+            struct header {
+                char magic[8];          // "tracey1"
+                uint64_t count;
+            };
+
+            struct entry {
+                uint64_t offset;        // address minus load bias
+                uint32_t text, size;    // into the text that follows the entries
+            };
+
+            std::atomic< size_t > hits( 0 ), misses( 0 );
+
+            // TRACEY_SYMBOL_CACHE, else $XDG_CACHE_HOME/tracey or ~/.cache/tracey when kTraceySymbolCache is on
+            // and that cache home is writable; empty if disabled. never destroyed, since reports are also made
+            // from atexit() handlers
+            std::string *locate() {
+                const char *env = options().symbol_cache, *xdg = std::getenv( "XDG_CACHE_HOME" ), *home = std::getenv( "HOME" );
+                if( env ) return new std::string( env );
+                if( !kTraceySymbolCache ) return new std::string();
+                std::string base = xdg && *xdg ? std::string( xdg ) : home && *home ? std::string( home ) + "/.cache" : std::string();
+                if( base.empty() || access( base.c_str(), W_OK ) != 0 ) return new std::string();
+                return new std::string( base + "/tracey" );
+            }
+            const std::string &directory() {
+                static const std::string *dir = locate();
+                return *dir;
+            }
+
+            // a mapped cache file. a missing or malformed file is just empty
+            struct file {
+                const uint8_t *data;
+                size_t size;
+                const entry *entries;
+                uint64_t count;
+                const char *text;
+                size_t text_size;
+
+                void open( const std::string &path ) {
+                    data = 0, size = 0, entries = 0, count = 0, text = 0, text_size = 0;
+                    int fd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+                    if( fd < 0 )
+                        return;
+                    struct stat st;
+                    if( fstat( fd, &st ) == 0 && size_t( st.st_size ) >= sizeof(header) ) {
+                        void *map = mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+                        if( map != MAP_FAILED ) data = (const uint8_t *)map, size = st.st_size;
+                    }
+                    ::close( fd );
+                    if( !data )
+                        return;
+                    const header &h = *(const header *)data;
+                    if( std::memcmp( h.magic, "tracey1", 8 ) || h.count > ( size - sizeof(header) ) / sizeof(entry) ) {
+                        close();
+                        return;
+                    }
+                    entries = (const entry *)( data + sizeof(header) );
+                    count = h.count;
+                    text = (const char *)( entries + count );
+                    text_size = size - sizeof(header) - count * sizeof(entry);
+                }
+                void close() {
+                    if( data ) munmap( (void *)data, size );
+                    data = 0, size = 0, entries = 0, count = 0, text = 0, text_size = 0;
+                }
+
+                bool find( uint64_t offset, std::string &out ) const {
+                    size_t lo = 0, hi = count;
+                    while( lo < hi ) {
+                        size_t mid = lo + ( hi - lo ) / 2;
+                        if( entries[mid].offset < offset ) lo = mid + 1; else hi = mid;
+                    }
+                    if( lo == count || entries[lo].offset != offset || uint64_t( entries[lo].text ) + entries[lo].size > text_size )
+                        return false;
+                    out.assign( text + entries[lo].text, entries[lo].size );
+                    return true;
+                }
+            };
+
+            std::string path( const tracey::elf::image &im ) {
+                return directory() + "/" + im.build_id + ".symbols";
+            }
+
+            // just the cache directory itself; its parent must exist. failing that is told once
+            bool make_directory( const std::string &dir ) {
+                static std::atomic< bool > told( false );
+                struct stat st;
+                if( mkdir( dir.c_str(), 0700 ) == 0 || ( stat( dir.c_str(), &st ) == 0 && S_ISDIR( st.st_mode ) ) )
+                    return true;
+                if( !told.exchange( true ) ) {
+                    kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: Warning, cannot create symbol cache directory \1; symbols are not cached." kTraceyCharLinefeed, dir ).c_str() );
+                }
+                return false;
+            }
+
+            // merges fresh symbols with the current file and swaps the result in, so concurrent readers
+            // see either file whole. concurrent writers may drop each other's additions, which is harmless
+            void store( const std::string &name, const file &current, std::map< uint64_t, std::string > &fresh ) {
+                for( uint64_t i = 0; i < current.count; ++i ) {
+                    std::string text;
+                    if( current.find( current.entries[i].offset, text ) ) {
+                        fresh.insert( std::make_pair( current.entries[i].offset, text ) );
+                    }
+                }
+                if( !make_directory( directory() ) )
+                    return;
+                static std::atomic< unsigned > serial( 0 );
+                std::string temp = tracey::string( "\1.\2.\3", name, unsigned( getpid() ), serial++ ); // unique among concurrent reports
+                kTraceyfFile *fp = kTraceyfOpen( temp.c_str(), "wb" );
+                if( !fp )
+                    return;
+                header h;
+                std::memcpy( h.magic, "tracey1", 8 );
+                h.count = fresh.size();
+                bool ok = std::fwrite( &h, sizeof(h), 1, fp ) == 1;
+                uint64_t at = 0;
+                for( std::map< uint64_t, std::string >::const_iterator it = fresh.begin(); ok && it != fresh.end(); ++it ) {
+                    entry e = { it->first, uint32_t( at ), uint32_t( it->second.size() ) };
+                    ok = std::fwrite( &e, sizeof(e), 1, fp ) == 1;
+                    at += it->second.size();
+                }
+                for( std::map< uint64_t, std::string >::const_iterator it = fresh.begin(); ok && it != fresh.end(); ++it ) {
+                    ok = std::fwrite( it->second.data(), 1, it->second.size(), fp ) == it->second.size();
+                }
+                ok = kTraceyfClose( fp ) == 0 && ok && at <= ~uint32_t(0);
+                if( !ok || std::rename( temp.c_str(), name.c_str() ) ) {
+                    std::remove( temp.c_str() );
+                }
+            }
+        }
+
+        // symbols for the unique frames of a report. frames are grouped by module and cut into chunks,
+        // which a few threads resolve against the cache and the in-process tables. modules whose line
+        // tables live elsewhere are handed to one external symbolizer process each, also in parallel.
+        namespace batch {
+            struct task {
+                tracey::elf::image *im;
+                size_t begin, end;    // into frames
+                const symbol_cache::file *cache;
+            };
+
+            struct job {
+                const std::vector< void * > *frames;
+                std::vector< std::string > *symbols;
+                std::vector< char > *resolved;
+                const std::vector< task > *tasks;
+                bool external;
+                std::atomic< size_t > next;
+            };
+
+            enum { UNRESOLVED, LINE, CACHED };
+
+            void worker( job *j ) {
+                bool was = acquired;
+                acquired = true;
+                size_t hits = 0, misses = 0;
+                for( size_t t; ( t = j->next++ ) < j->tasks->size(); ) {
+                    const task &k = (*j->tasks)[ t ];
+                    if( !j->external ) {
+                        bool prepared = false;
+                        for( size_t i = k.begin; i < k.end; ++i ) {
+                            if( k.cache ) {
+                                if( k.cache->find( uintptr_t( (*j->frames)[ i ] ) - k.im->bias, (*j->symbols)[ i ] ) ) {
+                                    (*j->resolved)[ i ] = CACHED;
+                                    ++hits;
+                                    continue;
+                                }
+                                ++misses;
+                            }
+                            if( !prepared ) {
+                                tracey::elf::prepare( *k.im );
+                                prepared = true;
+                            }
+                            (*j->resolved)[ i ] = tracey::elf::lookup( *k.im, (*j->frames)[ i ], (*j->symbols)[ i ] ) ? LINE : UNRESOLVED;
+                        }
+                    } else {
+                        std::vector< void * > pending;
+                        std::vector< std::string * > outputs;
+                        std::vector< size_t > at;
+                        for( size_t i = k.begin; i < k.end; ++i ) {
+                            if( (*j->resolved)[ i ] == UNRESOLVED ) {
+                                pending.push_back( (*j->frames)[ i ] );
+                                outputs.push_back( &(*j->symbols)[ i ] );
+                                at.push_back( i );
+                            }
+                        }
+                        std::vector< char > found( pending.size(), 0 );
+                        tracey::elf::external( *k.im, pending, outputs, &found );
+                        for( size_t i = 0; i < found.size(); ++i ) {
+                            if( found[ i ] ) (*j->resolved)[ at[ i ] ] = LINE;
+                        }
+                    }
+                }
+                symbol_cache::hits += hits;
+                symbol_cache::misses += misses;
+                acquired = was;
+            }
+
+            // calling thread takes part
+            void run( job &j, const std::vector< task > &tasks, bool external ) {
+                j.tasks = &tasks;
+                j.external = external;
+                j.next = 0;
+                size_t threads = std::min< size_t >( std::max( 1u, std::thread::hardware_concurrency() ), tasks.size() );
+                // thread state and its TLS belong to tracey, as does the pool itself
+                bool was_acquired = acquired;
+                acquired = true;
+                std::vector< std::thread > pool;
+                for( size_t t = 1; t < threads; ++t ) {
+                    pool.push_back( std::thread( worker, &j ) );
+                }
+                acquired = was_acquired;
+                worker( &j );
+                acquired = true;
+                for( size_t t = 0; t < pool.size(); ++t ) {
+                    pool[ t ].join();
+                }
+                pool = std::vector< std::thread >();
+                acquired = was_acquired;
+            }
+        }
+
+        std::vector< std::string > symbolize( const std::vector< void * > &frames ) {
+            enum { CHUNK = 4096 };
+            std::vector< std::string > symbols( frames.size() );
+            std::vector< char > resolved( frames.size(), batch::UNRESOLVED );
+            std::vector< batch::task > chunks, external;
+            std::vector< symbol_cache::file > caches;
+            std::vector< void * > strays;
+            std::vector< size_t > stray_at;
+            // sorted frames make each module a single run
+            for( size_t i = 0, end; i < frames.size(); i = end ) {
+                end = i + 1;
+                tracey::elf::image *im = tracey::elf::locate( frames[ i ] );
+                if( !im ) {
+                    strays.push_back( frames[ i ] );
+                    stray_at.push_back( i );
+                    continue;
+                }
+                while( end < frames.size() && uintptr_t( frames[ end ] ) >= im->lo && uintptr_t( frames[ end ] ) < im->hi ) {
+                    ++end;
+                }
+                batch::task m = { im, i, end, 0 };
+                external.push_back( m );
+            }
+            // mapped after grouping, so tasks can point into a vector that no longer grows
+            caches.resize( external.size() );
+            for( size_t m = 0; m < external.size(); ++m ) {
+                batch::task &k = external[ m ];
+                if( !symbol_cache::directory().empty() && !k.im->build_id.empty() ) {
+                    caches[ m ].open( symbol_cache::path( *k.im ) );
+                    k.cache = &caches[ m ];
+                }
+                for( size_t c = k.begin; c < k.end; c += CHUNK ) {
+                    batch::task chunk = { k.im, c, std::min< size_t >( c + CHUNK, k.end ), k.cache };
+                    chunks.push_back( chunk );
+                }
+            }
+
+            batch::job j;
+            j.frames = &frames;
+            j.symbols = &symbols;
+            j.resolved = &resolved;
+            batch::run( j, chunks, false );
+
+            // lookups are done, so whether a module has line tables of its own is known now
+            std::vector< batch::task > missing;
+            for( size_t m = 0; m < external.size(); ++m ) {
+                const batch::task &k = external[ m ];
+                if( !k.im->lines && std::find( resolved.begin() + k.begin, resolved.begin() + k.end, char( batch::UNRESOLVED ) ) != resolved.begin() + k.end ) {
+                    missing.push_back( k );
+                }
+            }
+            batch::run( j, missing, true );
+
+            for( size_t m = 0; m < external.size(); ++m ) {
+                const batch::task &k = external[ m ];
+                std::map< uint64_t, std::string > fresh;
+                for( size_t i = k.begin; k.cache && i < k.end; ++i ) {
+                    if( resolved[ i ] == batch::LINE ) {
+                        fresh[ uintptr_t( frames[ i ] ) - k.im->bias ] = symbols[ i ];
+                    }
+                }
+                if( !fresh.empty() ) {
+                    symbol_cache::store( symbol_cache::path( *k.im ), caches[ m ], fresh );
+                }
+                caches[ m ].close();
+            }
+
+            if( strays.size() ) {
+                tracey::callstack cs;
+                cs.frames = strays;
+                std::vector< std::string > unwound = cs.unwind();
+                for( size_t i = 0; i < unwound.size() && i < stray_at.size(); ++i ) {
+                    symbols[ stray_at[ i ] ] = unwound[ i ];
+                }
+            }
+            return symbols;
+        }
+#else
+        std::vector< std::string > symbolize( const std::vector< void * > &frames ) {
+            tracey::callstack cs;
+            cs.frames = frames;
+            return cs.unwind();
+        }
+#endif
+
+        class container
+        {
+            public:
+
+            // registry is split by pointer hash into independently locked stripes, each one
+            // with its own map and counters. alloc/free from different threads rarely contend.
+            struct shard {
+                mutable std::mutex mutex;
+                table< leak > map;
+                stats_t stats;
+                header *live;      // header mode: tracked blocks with an inline record
+                size_t linked;
+
+                shard() : live(0), linked(0)
+                {}
+
+                void link( header *h ) {
+                    h->prev = 0;
+                    h->next = live;
+                    if( live ) live->prev = h;
+                    live = h;
+                    linked++;
+                    stats.headers += h->offset;
+                }
+                void unlink( header *h ) {
+                    if( h->prev ) h->prev->next = h->next; else live = h->next;
+                    if( h->next ) h->next->prev = h->prev;
+                    linked--;
+                    stats.headers -= h->offset;
+                }
+            };
+
+            shard shards[ kTraceyRegistryShards ];
+            stacktable stacks;
+            bloomfilter filter;
+            eventlog events;
+            mappings maps;
+            std::atomic<bool> aggregating;
+            std::thread worker;                 // the aggregator, once started
+            std::atomic<size_t> usage, usage_peak; // registry-wide, so the peak is a real high-water mark
+
+            shard &find_shard( const void *ptr ) {
+                // skip alignment bits, then fibonacci hashing spreads neighbour blocks across stripes
+                uint64_t hash = uint64_t( (uintptr_t)ptr >> 4 ) * 0x9E3779B97F4A7C15ULL;
+                return shards[ (hash >> 32) & (kTraceyRegistryShards - 1) ];
+            }
+
+            container() : aggregating(false), usage(0), usage_peak(0)
+            {
+                ready = true;
+            }
+
+            ~container() {
+                ready = false;
+                acquired = true; // report below allocates from the metadata arena
+                stop();
+
+                if( options().report_on_exit && kTraceyEnabledSoft ) {
+                    std::string logfile = _report();
+                    if( options().view ) view_report( logfile );
+                }
+
+#ifdef TRACEY_PRELOAD
+                // preloaded into someone else's program: its exit status and its remaining atexit handlers and
+                // static destructors are left alone. the arena is never freed, and later frees see ready=false
+                return;
+#endif
+
+                // We should clear the memory involved in all allocations but after all, we are a memory tracker and we should be the very
+                // last thing to deallocate in any program. So we don't do it and we save some time for developing when exiting the app.
+                // Silent & quick exit. Not a requirement in all architectures but who knows.
+                kTraceyDie( __LINE__ );
+            }
+
+            void _clear() {
+
+                for( unsigned s = 0; s < kTraceyRegistryShards; ++s ) {
+                    shard &sh = shards[s];
+                    sh.mutex.lock();
+                    sh.map.clear();
+                    for( header *h = sh.live; h; h = h->next ) {
+                        h->mark( (char *)h + header_size, header::BLOCK );
+                    }
+                    sh.live = 0;
+                    sh.linked = 0;
+                    sh.stats = stats_t();
+                    sh.mutex.unlock();
+                }
+                usage = usage_peak = 0;
+                stacks.clear_chains();
+                maps.clear();
+            }
+
+            size_t size() const {
+                size_t total = 0;
+                for( unsigned s = 0; s < kTraceyRegistryShards; ++s ) {
+                    shards[s].mutex.lock();
+                    total += shards[s].map.size() + shards[s].linked;
+                    shards[s].mutex.unlock();
+                }
+                return total;
+            }
+
+            stats_t stats() const {
+                stats_t total;
+                for( unsigned s = 0; s < kTraceyRegistryShards; ++s ) {
+                    shards[s].mutex.lock();
+                    total += shards[s].stats;
+                    total.overhead += shards[s].map.space();
+                    shards[s].mutex.unlock();
+                }
+                total.usage = usage.load();
+                total.usage_peak = usage_peak.load();
+                total.overhead += total.headers;
+                total.overhead += stacks.space();
+                total.overhead += sizeof(filter);
+                total.overhead += events.space();
+                total.buffer_peak = events.high_water();
+                total.buffer_stalls = events.backpressure();
+                total.sample_rate = sampler::rate;
+                total.arena_used = metadata().used();
+                total.arena_footprint = metadata().footprint();
+                if( const arena *slabs = slab::instance() ) {
+                    total.slab_used = slabs->used();
+                    total.slab_footprint = slabs->footprint();
+                }
+                filter.totals( &total.filter_rejects, &total.filter_passes, &total.filter_false_positives );
+                maps.totals( &total.regions, &total.mapped, &total.mapped_anonymous, &total.mapped_discarded, &total.mapped_peak );
+#if HEAL_HAS_ELF
+                total.symbol_hits = symbol_cache::hits.load();
+                total.symbol_misses = symbol_cache::misses.load();
+#endif
+                return total;
+            }
+
+            // registry bookkeeping, shared by synchronous tracer and async aggregator {
+
+            // adds bytes in use and raises the peak if exceeded
+            void account( size_t delta ) {
+                size_t now = usage.fetch_add( delta ) + delta, top = usage_peak.load( std::memory_order_relaxed );
+                while( now > top && !usage_peak.compare_exchange_weak( top, now ) );
+            }
+
+            // returns false if ptr was not being watched (wild pointer)
+            // *mismatch is set to the recorded size if it differs from a non-zero expected size
+            // *detached receives the record, so a reallocation can carry it over to the new block
+            bool untrack( const void *ptr, size_t expected = 0, size_t *mismatch = 0, leak *detached = 0 ) {
+                shard &sh = find_shard( ptr );
+                sh.mutex.lock();
+                size_t size = 0;
+                float weight = 1;
+                bool found;
+                if( header *h = headed( ptr ) ) {
+                    // header mode: the record is right before ptr, no lookup
+                    found = h->is( ptr, header::LIVE );
+                    if( found ) {
+                        size = h->size;
+                        weight = h->weight;
+                        if( detached ) {
+                            detached->id = h->id;
+                            detached->size = h->size;
+                            detached->addr = ptr;
+                            detached->stack = h->stack;
+                            detached->weight = h->weight;
+                        }
+                        sh.unlink( h );
+                        h->mark( ptr, header::BLOCK );
+                    }
+                } else {
+                    leak *L = sh.map.find( ptr );
+                    found = ( L != 0 );
+                    if( found ) {
+                        size = L->size;
+                        weight = L->weight;
+                        if( detached ) *detached = *L;
+                        sh.map.erase( L );
+                    }
+                }
+                if( found )
+                {
+                    if( expected && mismatch && size != expected ) *mismatch = size;
+                    usage -= sampler::bytes( size, weight );
+                    sh.stats.num_leaks -= sampler::count( weight );
+                }
+                sh.mutex.unlock();
+                if( found ) {
+                    filter.unmark( ptr );
+                } else {
+                    filter.false_positive(); // every caller asked the filter first
+                }
+                return found;
+            }
+
+            // returns true if ptr was already being watched (double allocation)
+            // previous: record detached from the block ptr was reallocated from; its id and stack are kept
+            bool track( const void *ptr, size_t size, uint32_t stack, const leak *previous = 0 ) {
+                size_t id = previous ? previous->id : create_id();
+                float weight = sampler::weight( size );
+                shard &sh = find_shard( ptr );
+                sh.mutex.lock();
+                header *h = headed( ptr );
+                leak *L = h ? 0 : sh.map.find( ptr );
+                bool found = h ? h->is( ptr, header::LIVE ) : ( L != 0 );
+
+                if( found ) {
+                    // forget previous record before reusing it
+                    size_t previous = h ? h->size : L->size;
+                    float previous_weight = h ? h->weight : L->weight;
+                    usage -= sampler::bytes( previous, previous_weight );
+                    sh.stats.num_leaks -= sampler::count( previous_weight );
+                }
+
+                if( h ) {
+                    // header mode: fill the inline record and chain it
+                    if( !found ) {
+                        sh.link( h );
+                        h->mark( ptr, header::LIVE );
+                    }
+                    h->id = id;
+                    h->stack = stack;
+                    h->size = size;
+                    h->weight = weight;
+                } else {
+                    // create a leak and (re)insert it into map
+                    tracey::detail::leak &leak = found ? *L : sh.map.insert( ptr );
+                    leak.id = id;
+                    leak.stack = stack;
+                    leak.size = size;
+                    leak.weight = weight;
+                }
+
+                // realloc chain of the allocation site; failed reallocations give the record back unchanged
+                size_t copied = 0;
+                bool resized = previous && ( previous->addr != ptr || previous->size != size );
+                if( resized ) {
+                    if( previous->addr == ptr ) {
+                        sh.stats.resized++;
+                    } else {
+                        copied = std::min( previous->size, size );
+                        sh.stats.moved++;
+                        sh.stats.copied += copied;
+                    }
+                }
+
+                // update stats (scaled back up when sampling)
+                sh.stats.num_leaks += sampler::count( weight );
+                account( sampler::bytes( size, weight ) );
+
+                // and peaks
+                if( size > sh.stats.leak_peak ) sh.stats.leak_peak = size;
+
+                sh.mutex.unlock();
+                if( resized ) {
+                    stacks.regrew( stack, copied );
+                }
+                return found;
+            }
+
+            // }
+
+            // async mode {
+
+            // queues an event for the aggregator. returns false if caller must track synchronously,
+            // which waits for queued events first so they cannot land after the synchronous update
+            bool defer( const void *ptr, size_t size, uint32_t stack ) {
+                if( !aggregating.load( std::memory_order_relaxed ) && !aggregating.exchange( true ) ) {
+                    $welse(
+                        if( !forking() ) {
+                            forking() = this;
+                            pthread_atfork( before_fork, 0, after_fork );
+                        }
+                    )
+                    worker = std::thread( aggregator, this );
+                }
+                if( events.push( ptr, size, stack ) ) {
+                    return true;
+                }
+                events.flush();
+                return false;
+            }
+
+            void flush() const {
+                if( policy_t::ASYNC && aggregating.load() ) {
+                    events.flush();
+                }
+            }
+
+            // joins the aggregator and applies whatever it left behind
+            void stop() {
+                if( policy_t::ASYNC && aggregating.load() ) {
+                    events.close();
+                    if( worker.joinable() ) {
+                        worker.join();
+                    }
+                    events.drain( *this, true );
+                }
+            }
+
+            // forked child has no aggregator: queued events are applied before forking, and the
+            // child starts a new aggregator (with fresh rings) on its first event
+            static container *&forking() {
+                static container *self = 0;
+                return self;
+            }
+            static void before_fork() {
+                forking()->flush();
+            }
+            static void after_fork() {
+                container *self = forking();
+                self->events.reset();
+                new (&self->worker) std::thread(); // parent's handle means nothing here
+                self->aggregating = false;
+            }
+
+            void apply( const event &e ) {
+                if( !e.size ) {
+                    if( !untrack( e.addr ) && policy_t::WILD && !sampler::on() ) {
+                        kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: Error, wild pointer deallocation (\1)." kTraceyCharLinefeed, e.addr ).c_str() );
+                    }
+                } else {
+                    if( track( e.addr, e.size, e.stack ) && kTraceyReportDoubleAllocations ) {
+                        kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: Error, double pointer allocation (\1). This should never happen" kTraceyCharLinefeed, e.addr ).c_str() );
+                    }
+                }
+            }
+
+            static void aggregator( container *self ) {
+                acquired = true; // aggregator allocations are never tracked
+                for( unsigned idle = 0; !self->events.done(); ) {
+                    if( self->events.drain( *self ) ) {
+                        idle = 0;
+                    } else if( ++idle < 64 ) {
+                        std::this_thread::yield();
+                    } else {
+                        std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+                    }
+                }
+            }
+
+            // }
+
+            // leaks of one callstack, folded together; a table<> record keyed by the interned stack id
+            struct stack_total {
+                const void *addr;     // stack id << 4, so that table<> hashes consecutive ids apart
+                size_t count, bytes;  // as sampler::count() and sampler::bytes() estimate them
+                stack_total() : addr(0), count(0), bytes(0)
+                {}
+                uint32_t stack() const {
+                    return uint32_t( uintptr_t( addr ) >> 4 );
+                }
+            };
+
+            // leaks are copied out shard by shard, so no stripe stays locked while the report is built
+            leaks collect_leaks( size_t *wasted ) const {
+                leaks list;
+                *wasted = 0;
+                for( unsigned s = 0; s < kTraceyRegistryShards; ++s ) {
+                    const shard &sh = shards[s];
+                    sh.mutex.lock();
+                    for( size_t i = 0, end = sh.map.capacity(); i < end; ++i ) {
+                        const tracey::detail::leak &L = sh.map.at( i );
+                        if( L.addr && L.size && L.id >= timestamp_id ) {
+                            *wasted += sampler::bytes( L.size, L.weight );
+                            list.push_back( L );
+                        }
+                    }
+                    for( const header *h = sh.live; h; h = h->next ) {
+                        if( h->size && h->id >= timestamp_id ) {
+                            leak L;
+                            L.id = h->id;
+                            L.size = h->size;
+                            L.addr = (const char *)h + header_size;
+                            L.stack = h->stack;
+                            L.weight = h->weight;
+                            *wasted += sampler::bytes( L.size, L.weight );
+                            list.push_back( L );
+                        }
+                    }
+                    sh.mutex.unlock();
+                }
+                return list;
+            }
+
+            // sites listed apart from the tree (realloc chains, mappings) show their innermost frames only {
+
+            enum { SITES = 20, SITE_FRAMES = 4 };
+
+            void site_frames( uint32_t stack, std::set< void * > &set ) const {
+                unsigned depth;
+                void *const *frames = stacks.frames( stack, &depth );
+                for( unsigned i = kTraceyStacktraceSkipBegin; i < depth && i < kTraceyStacktraceSkipBegin + SITE_FRAMES; ++i ) {
+                    set.insert( frames[i] );
+                }
+            }
+
+            std::string site_symbols( uint32_t stack, std::map< void *, std::string > &translate ) const {
+                unsigned depth;
+                void *const *frames = stacks.frames( stack, &depth );
+                std::string site;
+                for( unsigned i = kTraceyStacktraceSkipBegin; i < depth && i < kTraceyStacktraceSkipBegin + SITE_FRAMES; ++i ) {
+                    site += ( site.empty() ? "" : " <- " ) + translate[ frames[i] ];
+                }
+                return site;
+            }
+
+            // }
+
+            std::string _report() const {
+
+                std::string logfile = options().report_path();
+                stats_t stats = this->stats();
+
+                kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: summary: \1" kTraceyCharLinefeed, stats.str() ).c_str() );
+                kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: creating report: \1" kTraceyCharLinefeed, logfile).c_str() );
+                kTraceyfFile *fp = kTraceyfOpen( logfile.c_str(), "wb" );
+
+                // this code often runs at the very end of a program cycle (even when static memory has been deallocated)
+                // so, avoid using global C++ objects like std::cout/cerr as much as possible; otherwise crashes may happen
+
+                $windows(
+                    AllocConsole();
+                )
+
+                // Find leaks
+                kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: filtering leaks..." kTraceyCharLinefeed).c_str() );
+                size_t wasted, n_leak, n_estimated = 0;
+                leaks filtered = collect_leaks( &wasted );
+                n_leak = filtered.size();
+                for( leaks::const_iterator it = filtered.begin(), end = filtered.end(); it != end; ++it ) {
+                    n_estimated += sampler::count( it->weight );
+                }
+                kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: found \1 leaks wasting \2" kTraceyCharLinefeed, n_estimated, human(wasted)).c_str() );
+
+                // Calc score
+                double leaks_pct = this->size() ? n_leak * 100.0 / this->size() : 0.0;
+                std::string score = "perfect!";
+                if( leaks_pct >  0.00 ) score = "excellent";
+                if( leaks_pct >  1.25 ) score = "good";
+                if( leaks_pct >  2.50 ) score = "poor";
+                if( leaks_pct >  5.00 ) score = "mediocre";
+                if (leaks_pct > 10.00 ) score = "lame";
+
+                // Header
+                kTraceyfPrintf( fp, "%s", tracey::string( "<html><body><xmp>" ).c_str() );
+                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: generated with \1 (\2)" kTraceyCharLinefeed, tracey::version(), tracey::url() ).c_str() );
+                if( tracey::lookup(url) == "????" )
+                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: failed to decode symbols!! Is debug information available?" $msvc(" Are .PDB files available?") kTraceyCharLinefeed ).c_str() );
+                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: best viewed on foldable text editor (like SublimeText2) with tabs=2sp and no word-wrap" kTraceyCharLinefeed ).c_str() );
+                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: \1, \2 leaks found; \3 wasted ('\4' score)" kTraceyCharLinefeed, !n_leak ? "ok" : "error", n_estimated, human(wasted), score ).c_str() );
+                if( sampler::rate )
+                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: sampled one allocation every ~\1; \2 samples, figures below are estimates" kTraceyCharLinefeed, human(sampler::rate), n_leak ).c_str() );
+                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: summary: \1" kTraceyCharLinefeed, stats.str() ).c_str() );
+                kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: report filename: \1" kTraceyCharLinefeed, logfile).c_str() );
+
+                // Leaks from the same callstack are folded first, so the trees cost one walk per distinct
+                // stack instead of one per leaked block
+                table< stack_total > folded;
+                for( leaks::const_iterator it = filtered.begin(), end = filtered.end(); it != end; ++it ) {
+                    if( it->stack ) {
+                        stack_total &S = folded.insert( (const void *)( uintptr_t( it->stack ) << 4 ) );
+                        S.count += sampler::count( it->weight );
+                        S.bytes += sampler::bytes( it->size, it->weight );
+                    }
+                }
+                kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: folded \1 leaks into \2 unique callstacks" kTraceyCharLinefeed, n_leak, folded.size()).c_str() );
+
+                // Some apps are low on memory in here, so we free memory as soon as possible
+                filtered = leaks();
+
+                // Body
+                // Get all frame addresses involved in all leaks
+                // Also, create a tree of frames; so we will take decisions from above by examining node weights (@todo)
+                kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: creating trees of frames..."  kTraceyCharLinefeed).c_str() );
+                std::set< void * > set;
+                tracey::tree tree;
+                tracey::calltree flat;
+                const uint32_t flat_top = flat.insert( 0, (void *)((~0)-0) ); // bottom-top branch
+                const uint32_t flat_inv = flat.insert( 0, (void *)((~0)-1) ); // top-bottom branch
+                if( !kTraceyFlatTree ) {
+                    tree[ (void *)((~0)-0) ]; // bottom-top branch
+                    tree[ (void *)((~0)-1) ]; // top-bottom branch
+                }
+                for( size_t s = 0, capacity = folded.capacity(); s < capacity; ++s ) {
+                    const stack_total &S = folded.at( s );
+                    if( !S.addr ) continue;
+                    unsigned depth;
+                    void *const *frames = stacks.frames( S.stack(), &depth );
+                    if( !depth ) continue;
+
+                    if( kTraceyFlatTree ) {
+                        uint32_t _top = flat_top, _inv = flat_inv;
+                        for( unsigned i = 0, start = kTraceyStacktraceSkipBegin, end = depth - 1 - kTraceyStacktraceSkipEnd; start+i <= end; ++i ) {
+                            double size;
+                            size = (start+i == end ? S.bytes : 0);
+                            _top = flat.insert( _top, frames[start + i] );
+                            flat.nodes[ _top ].value.size += size;
+                            flat.nodes[ _top ].value.hits += S.count;
+                            set.insert( frames[start + i] );
+
+                            size = (end - i == start ? S.bytes : 0);
+                            _inv = flat.insert( _inv, frames[end - i] );
+                            flat.nodes[ _inv ].value.size += size;
+                            flat.nodes[ _inv ].value.hits += S.count;
+                            set.insert( frames[end - i] );
+                        }
+                        continue;
+                    }
+
+                    tracey::tree *_tree = &tree[(void *)((~0)-0)];
+                    tracey::tree *_tree_inv = &tree[(void *)((~0)-1)];
+                    for( unsigned i = 0, start = kTraceyStacktraceSkipBegin, end = depth - 1 - kTraceyStacktraceSkipEnd; start+i <= end; ++i ) {
+
+                        double size;
+                        size = (start+i == end ? S.bytes : 0);
+                        (*_tree)[ frames[start + i] ].get().size += size;
+                        (*_tree)[ frames[start + i] ].get().hits += S.count;
+                        //(*_tree)[ frames[start + i] ].get().total = 100.0 * size / wasted;
+                        _tree = &(*_tree)[ frames[start + i] ];
+                        set.insert( frames[start + i] );
+
+                        size = (end - i == start ? S.bytes : 0);
+                        (*_tree_inv)[ frames[end - i] ].get().size += size;
+                        (*_tree_inv)[ frames[end - i] ].get().hits += S.count;
+                        //(*_tree_inv)[ frames[end - i] ].get().total = 100.0 * size / wasted;
+                        _tree_inv = &(*_tree_inv)[ frames[end - i] ];
+                        set.insert( frames[end - i] );
+                    }
+                }
+
+                folded.clear();
+
+                // Realloc chains: sites whose blocks kept growing (or shrinking)
+                std::vector< stacktable::chain > chains = stacks.chains();
+                if( chains.size() > SITES ) {
+                    chains.resize( SITES );
+                }
+                for( size_t c = 0; c < chains.size(); ++c ) {
+                    site_frames( chains[c].stack, set );
+                }
+
+                // Mappings: address space mapped by the application itself, which is not part of the tree
+                std::vector< mappings::site > mapped = maps.sites();
+                if( mapped.size() > SITES ) {
+                    mapped.resize( SITES );
+                }
+                for( size_t m = 0; m < mapped.size(); ++m ) {
+                    site_frames( mapped[m].stack, set );
+                }
+
+                if( !set.size() ) {
+                    if( n_leak ) {
+                        kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: error! failed to resolve symbols." $msvc(" Are PDB files available?") kTraceyCharLinefeed).c_str() );
+                    }
+                } else {
+                    kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: resolving \1 unique frames..." kTraceyCharLinefeed, set.size()).c_str() );
+                    // convert set of unique frames into array of frames
+                    tracey::callstack cs;
+                    std::vector< void * > &frames = cs.frames;
+                    frames.reserve( set.size() );
+                    for( std::set< void * >::iterator it = set.begin(), end = set.end(); it != end; ++it ) {
+                        frames.push_back( *it );
+                    }
+#if HEAL_HAS_ELF
+                    size_t hits = symbol_cache::hits.load(), misses = symbol_cache::misses.load();
+#endif
+                    tracey::strings symbols = symbolize( frames );
+#if HEAL_HAS_ELF
+                    if( !symbol_cache::directory().empty() ) {
+                        kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: symbol cache: \1 hits, \2 misses" kTraceyCharLinefeed, symbol_cache::hits.load() - hits, symbol_cache::misses.load() - misses).c_str() );
+                    }
+#endif
+                    std::map< void *, std::string > translate;
+                    {
+                        if( frames.size() != symbols.size() ) {
+                            kTraceyfPrintf( fp, "%s", tracey::string("<tracey/tracey.cpp> says: error! cannot resolve all frames (\1 vs \2)!" kTraceyCharLinefeed, frames.size(), symbols.size() ).c_str() );
+                            for( unsigned i = 0, end = frames.size(); i < end; ++i ) {
+                                translate[ frames[i] ] = tracey::string("\1", frames[i]);
+                            }
+                        } else {
+                            for( unsigned i = 0, end = frames.size(); i < end; ++i ) {
+                                translate[ frames[i] ] = symbols[ i ];
+                            }
+                        }
+
+                        // Create a tree report, if possible
+                        kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: converting tree of frames into tree of symbols..." kTraceyCharLinefeed).c_str() );
+                        translate[ (void *)((~0)-1) ] = "begin";
+                        translate[ (void *)((~0)-0) ] = "end";
+                        if( kTraceyFlatTree ) {
+                            flat.refresh();
+                        } else {
+                            tree.refresh();
+                        }
+                        //std::cout << tree << std::endl;
+
+                        // truncate branches lower than user-defined percentage (it helps reducing log size)
+                        // note: kTraceyTruncateBranchesSmallerThan defaults to 0% (~do not truncate branches, show all leaks)
+
+                        kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: flattering tree of symbols..." kTraceyCharLinefeed).c_str() );
+                        if( kTraceyTruncateBranchesSmallerThan > 0 ) {
+                            if( kTraceyFlatTree ) {
+                                flat.chop( kTraceyTruncateBranchesSmallerThan );
+                            } else {
+                                tree.walk<tracey::chopper>();
+                            }
+                        }
+
+                        kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: dumping tree log..." kTraceyCharLinefeed).c_str() );
+                        if( kTraceyFlatTree ) {
+                            kTraceyfPrintf( fp, "%s", tracey::print(flat, wasted, translate, "{tabs}[{size}] ({value}) {key}\n", "{value}", true).c_str() );
+                        } else {
+                            kTraceyfPrintf( fp, "%s", tracey::print(tree, wasted, translate, "{tabs}[{size}] ({value}) {key}\n", "{value}", true).c_str() );
+                        }
+
+                        if( !chains.empty() ) {
+                            kTraceyfPrintf( fp, "%s", tracey::string( kTraceyCharLinefeed "<tracey/tracey.cpp> says: realloc chains (\1 busiest sites)" kTraceyCharLinefeed, chains.size() ).c_str() );
+                        }
+                        for( size_t c = 0; c < chains.size(); ++c ) {
+                            kTraceyfPrintf( fp, "%s", tracey::string( kTraceyCharTab "[\1 regrows, \2 copied] \3" kTraceyCharLinefeed,
+                                chains[c].regrows, human( chains[c].copied ), site_symbols( chains[c].stack, translate ) ).c_str() );
+                        }
+
+                        if( !mapped.empty() ) {
+                            kTraceyfPrintf( fp, "%s", tracey::string( kTraceyCharLinefeed "<tracey/tracey.cpp> says: mappings (\1 biggest sites, discarded pages excluded)" kTraceyCharLinefeed, mapped.size() ).c_str() );
+                        }
+                        for( size_t m = 0; m < mapped.size(); ++m ) {
+                            kTraceyfPrintf( fp, "%s", tracey::string( kTraceyCharTab "[\1 in \2 regions] \3" kTraceyCharLinefeed,
+                                human( mapped[m].bytes ), mapped[m].count, site_symbols( mapped[m].stack, translate ) ).c_str() );
+                        }
+                    }
                 }
 
                 // Footer
@@ -518,34 +3081,97 @@ namespace tracey
             }
         };
 
-        void *tracer( void *ptr, size_t &size );
+        void *tracer( void *ptr, size_t &size, size_t expected = 0 );
+
+        // a record on its way across a reallocation, handed to tracer() twice: once to detach it from
+        // the old block before that block is released, and once to attach it to the new block.
+        struct moving {
+            void *from, *to;
+            size_t size;
+            leak record;
+            bool detached;
+        };
+
+        // tracer() size that hands it a moving record
+        const size_t moving_fn = size_t(~0) - 5;
+
+        // a change to the address space, handed to tracer() by the mmap hooks. a remap is handed twice,
+        // like a reallocation: the old range is released first, and the new one is mapped afterwards.
+        struct mapping {
+            enum kind { MAP, UNMAP, REMAP, DISCARD } op;
+            const void *addr;
+            size_t length;
+            mappings::region props;
+            bool detached;
+        };
+
+        // tracer() size that hands it a mapping event
+        const size_t mapping_fn = size_t(~0) - 6;
+
+        // one-time initialization is a lock-free state machine. first thread to flip the state builds
+        // the registry in the metadata arena and publishes it; threads racing with it spin until then.
+        // banner, webserver and hotkeys are left to start_services(), which only spawns their thread.
+        enum { UNINITIALIZED, INITIALIZING, INITIALIZED };
+        std::atomic<int> init_state( UNINITIALIZED );
+        std::atomic<container *> registry( 0 );
+
+        void start_services();
+
+        void shutdown() {
+            registry.load()->~container();
+        }
 
         container &init() {
-            //static unsigned char buy[ sizeof( container ) ];
-            //static container *map = new (buy) container();
-            static $cpp11(std::unique_ptr) $cpp03(std::auto_ptr)<container> map( new container() );
-
-            static bool once = false; if(! once ) { once = true;
-                kTraceyPrintf( "%s", tracey::settings().c_str() );
-                if( 1 ) {
-                    webmain( 0 );
-                }
-                if( 1 ) {
-                    volatile bool sitdown = false;
-                    std::thread(tracey::hotkeymain, (void *) &sitdown).detach();
-                    while( !sitdown ) {
-                    $windows( Sleep( 1000 ) );
-                    $welse( sleep( 1 ) );
-                    }
+            container *map = registry.load( std::memory_order_acquire );
+            if( map ) {
+                return *map;
+            }
+            int state = UNINITIALIZED;
+            if( init_state.compare_exchange_strong( state, INITIALIZING ) ) {
+                bool was_acquired = acquired;
+                acquired = true; // anything allocated meanwhile belongs to tracey
+                options(); // settings are read once, before anything is tracked
+                map = new ( metadata().alloc( sizeof(container) ) ) container();
+                std::atexit( shutdown );
+                registry.store( map, std::memory_order_release );
+                init_state = INITIALIZED;
+                if( kTraceyEnabled ) {
+                    start_services();
                 }
-                // Construct internals of tracer (static initializers)
-                // size_t dummy = 0;
-                // tracer( 0, dummy );
+                acquired = was_acquired;
+                return *map;
+            }
+            while( !(map = registry.load( std::memory_order_acquire )) ) {
+                std::this_thread::yield();
             }
             return *map;
         }
 
-        void *tracer( void *ptr, size_t &size )
+        // banner, webserver and hotkeys run on their own thread, which is spawned once by the first
+        // tracked allocation; no allocation ever waits for them.
+        void services() {
+            acquired = true;
+            kTraceyPrintf( "%s", tracey::settings().c_str() );
+            webmain( 0 );
+            acquired = false;
+            hotkeymain( 0 );
+        }
+
+        void start_services() {
+            $welse(
+                if( options().signal ) {
+                    signal( options().signal, on_report_signal ); // before anyone can send it
+                }
+            )
+            // thread state and its TLS are allocated by this thread, and belong to tracey
+            bool was_acquired = acquired;
+            acquired = true;
+            std::thread( services ).detach();
+            acquired = was_acquired;
+        }
+
+        // expected: size told by a sized deallocation, if any
+        void *tracer( void *ptr, size_t &size, size_t expected )
         {
             if( !ptr )
                 return size = 0, ptr;
@@ -553,80 +3179,128 @@ namespace tracey
             if( !kTraceyEnabledHard )                       // hard on/off switch
                 return size = 0, ptr;
 
-            if( !kTraceyEnabledSoft && (size < (~0) - 4) )  // soft on/off switch; only for mallocs & frees
-                return size = 0, ptr;
+            if( !kTraceyEnabledSoft && (size < (~0) - 4) && size != moving_fn && size != mapping_fn )  // soft on/off switch; only for mallocs & frees
+                return size = 0, ptr;                          // (records keep moving, and mappings check it themselves, as unmaps go on)
 
-#if         kTraceyHookLegacyCRT
-            // do nothing
-#else
-            static bool initialized = true;
-            if( !initialized )
+            if( metadata().owns( ptr ) )                    // tracey metadata is never tracked
                 return size = 0, ptr;
-            static container *init = 0;
-            static const bool reinit = (initialized = false, init = &tracey::init(), initialized = true);
-            static container &map = *init;
-#endif
 
-            if ( !mutex )
+            // threads will return on recursive calls (tracey allocating for itself).
+            // threads will lock the shard owning ptr; special functions visit every shard.
+            // in async mode threads just queue an event, and special functions flush the queues first.
+            // when sampling, unsampled allocations and frees of never sampled pointers return early.
+
+            if( acquired )
                 return size = 0, ptr;
 
-            // threads will lock here till the slot is free.
-            // threads will return on recursive locks.
+            container &map = tracey::init();                // one acquire load once initialized
 
-            static $tls(bool) acquired = false;
-            mutex->lock();
-            if( acquired ) {
-                mutex->unlock();
+            if ( !ready )
                 return size = 0, ptr;
-            } else {
-                acquired = true;               
-            }
 
-            // ready
-            container::iterator it = map.find( ptr );
-            bool found = ( it != map.end() );
+            acquired = true;
 
             if( size == ~0 || size == 0 )
             {
-                if( found )
-                {
-                    leak &L = it->second;
-                    stats.overhead -= L.cs.space();
-                    stats.usage -= L.size;
-                    stats.num_leaks--;
-                    L.wipe();
-                }
+                size_t mismatch = 0;
+
+                // filter: ptr was surely never tracked, so there is no record to look for (and no locking)
+                bool candidate = map.filter.maybe( ptr );
+
+                // async: ptr cannot be validated here, so it is always released
+                if( candidate && policy_t::ASYNC && map.defer( ptr, 0, 0 ) )
+                    (void)0;
                 else
+                // sampling: a missing record means an unsampled pointer rather than a wild one
+                if( !( candidate && map.untrack( ptr, expected, &mismatch ) ) && !sampler::on() )
                 {
                     // 1st) wild pointer deallocation found; warn user
-                    if( kTraceyReportWildPointers )
+                    if( policy_t::WILD )
                         kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, wild pointer deallocation." kTraceyCharLinefeed ) +
                             tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
 
                     // 2nd) normalize ptr for further deallocation (deallocating null pointers is ok)
                     ptr = 0;
                 }
+                else
+                if( mismatch && policy_t::WILD )
+                {
+                    // sized deallocation disagrees with the size that was allocated
+                    kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, sized deallocation of \1 bytes on a block of \2 bytes." kTraceyCharLinefeed, expected, mismatch ) +
+                        tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
+                }
             }
             else
             if( size == (~0) - 1 )
             {
-                int code = *((int*)ptr);
+                int code;
+                std::memcpy( &code, ptr, sizeof(code) );
                 //ptr = 0;
+                map.flush();
                 if( code == 1 ) {
                     map._clear();
-                    stats = stats_t();
                     timestamp_id = create_id();
                 }
 
-                if( code == 2 ) { *((stats_t*)ptr) = stats; };
+                if( code == 2 ) { *((stats_t*)ptr) = map.stats(); };
                 if( code == 3 ) (void)0;
                 if( code == 4 ) (void)0;
             }
             else
+            if( size == moving_fn )
+            {
+                moving &m = *((moving *)ptr);
+
+                // async: records of m.from may still be queued, so caller falls back to forget+watch
+                if( policy_t::ASYNC || metadata().owns( m.from ) )
+                    size = 0;
+                else
+                if( !m.detached )
+                {
+                    m.detached = map.filter.maybe( m.from ) && map.untrack( m.from, 0, 0, &m.record );
+
+                    if( !m.detached && !sampler::on() && policy_t::WILD )
+                        kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, wild pointer reallocation." kTraceyCharLinefeed ) +
+                            tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
+                }
+                else
+                {
+                    // same callstack as the original allocation, so there is nothing to unwind
+                    map.filter.mark( m.to );
+                    map.track( m.to, m.size, m.record.stack, &m.record );
+                }
+            }
+            else
+            if( size == mapping_fn )
+            {
+                mapping &m = *((mapping *)ptr);
+
+                if( m.op == mapping::UNMAP )
+                    map.maps.unmap( m.addr, m.length );
+                else
+                if( m.op == mapping::DISCARD )
+                    map.maps.discard( m.addr, m.length );
+                else
+                if( m.op == mapping::REMAP && !m.detached )
+                    m.detached = map.maps.unmap( m.addr, m.length, &m.props );
+                else
+                if( kTraceyEnabledSoft )
+                {
+                    // new mappings, and remaps of ranges mapped before tracey was watching, get their own callstack
+                    if( !m.detached ) {
+                        tracey::stackframes< policy_t::DEPTH, policy_t::UNWINDER > cs( true );
+                        m.props.stack = map.stacks.intern( cs.frames, cs.size );
+                        m.props.id = create_id();
+                    }
+                    map.maps.map( m.addr, m.length, m.props );
+                }
+            }
+            else
             if( size == (~0) - 2 )
             {
                 static char placement[ sizeof(std::string) ];
                 static std::string *log = new ((std::string *)placement) std::string();
+                map.flush();
                 *log = map._report();
                 ptr = (void *)log;
             }
@@ -641,40 +3315,36 @@ namespace tracey
             {
                 static char placement[ sizeof(std::string) ];
                 static std::string *log = new ((std::string *)placement) std::string();
-                *log = stats.str();
+                map.flush();
+                *log = map.stats().str();
                 ptr = (void *)log;
             }
             else
+            if( sampler::on() && !sampler::pick( size ) )
+            {
+                // not sampled; neither callstack nor record is kept
+            }
+            else
             {
-                if( found ) {
-                    if( kTraceyReportDoubleAllocations ) {
-                        kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, double pointer allocation. This should never happen" kTraceyCharLinefeed ) +
-                            tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
-                    }
-                    // kTraceyAssert( !map[ptr].first );
-                    // kTraceyAssert( !map[ptr].second );
-                }
                 kTraceyAssert( size > 0 );
 
-                // create a leak and (re)insert it into map
-                tracey::detail::leak &leak = (map[ptr] = map[ptr]);
-                leak.wipe();
-                leak.cs.save();
-                leak.addr = ptr;
-                leak.size = size;
+                map.filter.mark( ptr ); // before the record exists, so a racing free cannot miss it
 
-                // update stats
-                stats.num_leaks++;
-                stats.usage += size;
-                stats.overhead += leak.cs.space();
+                // unwind and intern before locking, so the stripe is held just for the map update
+                // frames are captured on the stack and copied once into the interning table (no mallocs)
+                tracey::stackframes< policy_t::DEPTH, policy_t::UNWINDER > cs( true );
+                uint32_t stack = map.stacks.intern( cs.frames, cs.size );
 
-                // and peaks
-                if( leak.size   > stats.leak_peak  ) stats.leak_peak = leak.size;
-                if( stats.usage > stats.usage_peak ) stats.usage_peak = stats.usage;
+                if( policy_t::ASYNC && map.defer( ptr, size, stack ) )
+                    (void)0;
+                else
+                if( map.track( ptr, size, stack ) && kTraceyReportDoubleAllocations ) {
+                    kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, double pointer allocation. This should never happen" kTraceyCharLinefeed ) +
+                        tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
+                }
             }
 
             acquired = false;
-            mutex->unlock();
 
             return ptr;
         }
@@ -693,6 +3363,39 @@ namespace tracey
         tracer( (void *)ptr, forget );
         return (void *)ptr;
     }
+    void *forget( const void *ptr, size_t size ) {
+        size_t forget = (~0);
+        tracer( (void *)ptr, forget, size );
+        return (void *)ptr;
+    }
+    // reallocates a watched block; its record moves along, so the original callstack is kept
+    void *rewatch( void *ptr, size_t resize, void *(*realloc)( void *, size_t ) ) {
+        if( !ptr || !resize ) {
+            return ptr ? realloc( tracey::forget( ptr ), 0 ) : tracey::watch( realloc( 0, resize ), resize );
+        }
+        moving m;
+        m.from = ptr;
+        m.to = 0;
+        m.size = resize;
+        m.detached = false;
+        size_t special_fn = moving_fn;
+        tracer( &m, special_fn );
+        if( !special_fn ) {
+            return tracey::watch( realloc( tracey::forget( ptr ), resize ), resize ); // not tracing right now
+        }
+        void *fresh = realloc( ptr, resize );
+        if( !m.detached ) {
+            return tracey::watch( fresh, resize ); // never watched: a brand new allocation as far as tracey knows
+        }
+        // old block is still valid if reallocation failed, and keeps its record then
+        m.to = fresh ? fresh : ptr;
+        m.size = fresh ? resize : m.record.size;
+        tracer( &m, special_fn );
+        return fresh;
+    }
+    void *rewatch( void *ptr, size_t resize ) {
+        return tracey::rewatch( ptr, resize, tracey::realloc );
+    }
     void enable() {
         kTraceyEnabledSoft = true;
     }
@@ -703,6 +3406,14 @@ namespace tracey
         size_t opcode = 1, special_fn = (~0) - 1;
         tracer( &opcode, special_fn );
     }
+    static stats_t snapshot() {
+        stats_t stats;
+        int opcode = 2; // overwritten by the aggregated stats of all shards
+        std::memcpy( (void *)&stats, &opcode, sizeof(opcode) ); // stats_t is plain counters
+        size_t special_fn = (~0) - 1;
+        tracer( &stats, special_fn );
+        return stats;
+    }
     std::string report() {
         size_t special_fn = (~0) - 2;
         return *((std::string *)tracey::tracer( (void*)&report, special_fn ));
@@ -749,6 +3460,7 @@ namespace tracey
             out += tracey::string( "\1failed to decode symbols!! Is debug information available?" $msvc(" Are .PDB files available?") kTraceyCharLinefeed, prefix );
         }
         out += tracey::string( "\1using \2 as realloc" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyRealloc) );
+        out += tracey::string( "\1using \2 as calloc" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyCalloc) );
         out += tracey::string( "\1using \2 as memset" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyMemset) );
         out += tracey::string( "\1using \2 as printf" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyPrintf) );
         out += tracey::string( "\1using \2 as exit" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyDie) );
@@ -756,19 +3468,38 @@ namespace tracey
         out += tracey::string( "\1using \2 as fclose" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyfClose) );
         out += tracey::string( "\1using \2 as fprintf" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyfPrintf) );
         out += tracey::string( "\1with C++ exceptions=\2" kTraceyCharLinefeed, prefix, $throw("enabled") $telse("disabled") );
-        out += tracey::string( "\1with kTraceyBudgetOverhead=\2%" kTraceyCharLinefeed, prefix, (100 + kTraceyBudgetOverhead) );
-        out += tracey::string( "\1with kTraceyMaxStacktraces=\2 range[\3..\4]" kTraceyCharLinefeed, prefix, int(kTraceyMaxStacktraces), int(kTraceyStacktraceSkipBegin), int(kTraceyStacktraceSkipEnd) );
+        const int unwinder = policy_t::UNWINDER < 0 ? int( tracey::callstack::unwinder ) : int( policy_t::UNWINDER );
+        out += tracey::string( "\1with kTraceyPolicy=\2" kTraceyCharLinefeed, prefix, std::is_same< policy_t, defaults >::value ? "defaults" : "custom" );
+        out += tracey::string( "\1with kTraceyBudgetOverhead=\2%" kTraceyCharLinefeed, prefix, (100 + policy_t::OVERHEAD / 100.0) );
+        out += tracey::string( "\1with kTraceyMaxStacktraces=\2 range[\3..\4]" kTraceyCharLinefeed, prefix, int(policy_t::DEPTH), int(kTraceyStacktraceSkipBegin), int(kTraceyStacktraceSkipEnd) );
+        out += tracey::string( "\1with kTraceyUnwinder=\2" kTraceyCharLinefeed, prefix,
+            unwinder == tracey::callstack::UNWIND_FRAME_POINTERS ? "frame pointers" :
+            unwinder == tracey::callstack::UNWIND_DWARF ? "dwarf cfi" : "platform" );
         // kTraceyCharLinefeed
         // kTraceyCharTab
-        out += tracey::string( "\1with kTraceyReportWildPointers=\2" kTraceyCharLinefeed, prefix, kTraceyReportWildPointers ? "yes" : "no" );
+        out += tracey::string( "\1with kTraceyReportWildPointers=\2" kTraceyCharLinefeed, prefix, policy_t::WILD ? "yes" : "no" );
         out += tracey::string( "\1with kTraceyDefineMemoryOperators=\2" kTraceyCharLinefeed, prefix, kTraceyDefineMemoryOperators ? "yes" : "no" );
-        out += tracey::string( "\1with kTraceyMemsetAllocations=\2" kTraceyCharLinefeed, prefix, kTraceyMemsetAllocations ? "yes" : "no" );
+        out += tracey::string( "\1with kTraceyMemsetAllocations=\2" kTraceyCharLinefeed, prefix, policy_t::FILL >= 0 ? "yes" : "no" );
         out += tracey::string( "\1with kTraceyStacktraceSkipBegin=\2" kTraceyCharLinefeed, prefix, int(kTraceyStacktraceSkipBegin) );
         out += tracey::string( "\1with kTraceyStacktraceSkipEnd=\2" kTraceyCharLinefeed, prefix, int(kTraceyStacktraceSkipEnd) );
-        out += tracey::string( "\1with kTraceyReportOnExit=\2" kTraceyCharLinefeed, prefix, kTraceyReportOnExit ? "yes" : "no" );
-        out += tracey::string( "\1with kTraceyWebserverPort=\2" kTraceyCharLinefeed, prefix, int(kTraceyWebserverPort) );
+        out += tracey::string( "\1with kTraceyReportOnExit=\2" kTraceyCharLinefeed, prefix, options().report_on_exit ? "yes" : "no" );
+        out += tracey::string( "\1with kTraceyWebserverPort=\2" kTraceyCharLinefeed, prefix, int(options().port) );
+        out += tracey::string( "\1with TRACEY_REPORT=\2" kTraceyCharLinefeed, prefix, options().report ? options().report : "(temp file)" );
+        out += tracey::string( "\1with TRACEY_REPORT_SIGNAL=\2" kTraceyCharLinefeed, prefix, options().signal );
         out += tracey::string( "\1with kTraceyHookLegacyCRT=\2" kTraceyCharLinefeed, prefix, int(kTraceyHookLegacyCRT) );
+        out += tracey::string( "\1with kTraceyHookMmap=\2" kTraceyCharLinefeed, prefix, int(kTraceyHookMmap) );
         out += tracey::string( "\1with kTraceyEnabled=\2" kTraceyCharLinefeed, prefix, int(kTraceyEnabled) );
+        out += tracey::string( "\1with kTraceyRegistryShards=\2" kTraceyCharLinefeed, prefix, int(kTraceyRegistryShards) );
+        out += tracey::string( "\1with kTraceyAsync=\2 (\3 events per thread)" kTraceyCharLinefeed, prefix, policy_t::ASYNC ? "yes" : "no", int(kTraceyAsyncBufferSize) );
+        out += tracey::string( "\1with kTraceySampleRate=\2" kTraceyCharLinefeed, prefix, sampler::rate ? tracey::human( sampler::rate ) : std::string("off (every allocation)") );
+        out += tracey::string( "\1with kTraceyFreeFilterKB=\2" kTraceyCharLinefeed, prefix, int(kTraceyFreeFilterKB) );
+        out += tracey::string( "\1with kTraceyBackend=\2" kTraceyCharLinefeed, prefix, chosen().name );
+        out += tracey::string( "\1with kTraceyFlatTree=\2" kTraceyCharLinefeed, prefix, kTraceyFlatTree ? "yes" : "no (oak::tree)" );
+#if HEAL_HAS_ELF
+        out += tracey::string( "\1with kTraceySymbolCache=\2 (\3 hits, \4 misses)" kTraceyCharLinefeed, prefix,
+            symbol_cache::directory().empty() ? std::string("off") : symbol_cache::directory(), symbol_cache::hits.load(), symbol_cache::misses.load() );
+#endif
+        out += tracey::string( "\1with kTraceyHeaders=\2 (\3 bytes per allocation)" kTraceyCharLinefeed, prefix, policy_t::HEADERS ? "yes" : "no", policy_t::HEADERS ? int(header_size) : 0 );
         return out;
     }
     std::string settings() {
@@ -782,32 +3513,118 @@ namespace tracey
         return true;
     }
     bool install_c_hooks() {
-        return false;
+        return kTraceyHookLegacyCRT != 0; // symbols are interposed at link time, nothing to install
     }
 
-    void *realloc( void *ptr, size_t resize ) {
+    // resizes a block through the backend owning it. blocks that still fit are left in place
+    static void *regrow( void *ptr, size_t bytes ) {
+        const backend &from = owner( ptr );
+        size_t have = from.usable_size( ptr );
+        return bytes <= have && bytes > have / 2 ? ptr : from.reallocate( ptr, bytes );
+    }
+
+    // zeroed: new block is requested zero-filled to the backend
+    static void *reallocate( void *ptr, size_t resize, bool zeroed ) {
         static const bool init = install_c_hooks();
 
-        ptr = kTraceyRealloc( ptr, (size_t)( resize + (kTraceyBudgetOverhead * resize) / 100.0 ) );
+        // allocations made by tracey itself (while tracing) and their frees go to the metadata arena
+        if( ptr ? metadata().owns( ptr ) : acquired ) {
+            ptr = metadata().realloc( ptr, resize );
+            if( !ptr && resize )
+                tracey::badalloc();
+            return zeroed ? kTraceyMemset( ptr, 0, resize ) : ptr;
+        }
+
+        size_t budget = policy_t::budget( resize );
+
+        if( policy_t::HEADERS ) {
+            // header mode: the header is part of the underlying allocation and moves along with the block
+            size_t offset = header_size;
+            char *base = 0;
+            if( ptr ) {
+                header *h = header_of( ptr );
+                if( h->is( ptr, header::LIVE ) ) {
+                    registry.load()->untrack( ptr ); // chained record must not outlive its block
+                }
+                offset = h->offset;
+                h->cookie = 0;
+                base = (char *)ptr - offset;
+                if( !resize ) {
+                    return owner( base ).deallocate( base ), (void *)0;
+                }
+            }
+            base = (char *)( base ? regrow( base, offset + budget ) : chosen().allocate( offset + budget, zeroed ) );
+            if( !base )
+                tracey::badalloc();
+            return stamp( base, offset, resize );
+        }
+
+        if( !ptr ) {
+            ptr = chosen().allocate( budget, zeroed );
+        } else if( !resize ) {
+            return owner( ptr ).deallocate( ptr ), (void *)0;
+        } else {
+            ptr = regrow( ptr, budget );
+        }
 
         if( !ptr && resize )
             tracey::badalloc();
 
         return ptr;
     }
+
+    // zero-filled blocks. big ones are requested zeroed to the allocator, which knows what memory is fresh
+    // from the kernel (and zero already) and only clears recycled memory; small ones are cheaper to clear here.
+    static void *zalloc( size_t size ) {
+        if( size < ( 128 << 10 ) ) {
+            return kTraceyMemset( reallocate( 0, size, false ), 0, size );
+        }
+        return reallocate( 0, size, true );
+    }
+
+    void *realloc( void *ptr, size_t resize ) {
+        return reallocate( ptr, resize, false );
+    }
     void *malloc( size_t size ) {
-        void *ptr = tracey::realloc( 0, size );
-        return kTraceyMemsetAllocations ? kTraceyMemset( ptr, kTraceyMemsetChar, size ) : ptr;
+        if( policy_t::FILL == 0 ) {
+            return zalloc( size );
+        }
+        return policy_t::fill( tracey::realloc( 0, size ), size );
     }
     void *calloc( size_t num, size_t size ) {
-        return kTraceyMemsetAllocations ? tracey::malloc( num * size ) : memset( tracey::malloc( num * size ), kTraceyMemsetChar, num * size );
+        if( size && num > size_t(~0) / size )
+            tracey::badalloc();
+        return zalloc( num * size );
     }
     void *free( void *ptr ) {
         return tracey::realloc( ptr, 0 ), ptr;
     }
 
     void *amalloc( size_t size, size_t alignment ) {
-        // kids, dont do this at home. this is horrible.
+        // real aligned allocation, releasable by tracey::free() like any other block
+        $welse(
+            if( alignment <= sizeof(void *) * 2 ) {
+                return tracey::malloc( size );
+            }
+            void *ptr;
+            size_t resize = policy_t::budget( size );
+            // header mode: header goes in front, padded so the block keeps its alignment
+            size_t offset = policy_t::HEADERS ? ( header_size + alignment - 1 ) & ~( alignment - 1 ) : 0;
+            if( acquired ) {
+                // arena blocks are aligned to their size class
+                ptr = metadata().alloc( resize > alignment ? resize : alignment );
+                offset = 0;
+            } else {
+                ptr = chosen().align( alignment, offset + resize );
+            }
+            if( !ptr )
+                tracey::badalloc();
+            if( offset )
+                ptr = stamp( ptr, offset, size );
+            return policy_t::fill( ptr, size );
+        )
+
+        // kids, dont do this at home. this is horrible. (_aligned_malloc blocks cannot go through kTraceyRealloc)
         std::vector<void *> invalids( 1, tracey::malloc(size) );
         if( alignment ) {
 #          define is_aligned(POINTER, BYTE_COUNT) \
@@ -847,11 +3664,17 @@ void operator delete[]( void *ptr, const std::nothrow_t &t ) throw() {
 
 //* Custom memory operators (with exceptions)
 
-void *operator new( size_t size ) throw(std::bad_alloc) {
+#if __cplusplus >= 201103L
+#define kTraceyThrowBadAlloc noexcept(false) // dynamic exception specifications are gone in C++17
+#else
+#define kTraceyThrowBadAlloc throw(std::bad_alloc)
+#endif
+
+void *operator new( size_t size ) kTraceyThrowBadAlloc {
     return tracey::watch( tracey::malloc( size ), size );
 }
 
-void *operator new[]( size_t size ) throw(std::bad_alloc) {
+void *operator new[]( size_t size ) kTraceyThrowBadAlloc {
     return tracey::watch( tracey::malloc( size ), size );
 }
 
@@ -863,6 +3686,411 @@ void operator delete[]( void *ptr ) throw() {
     tracey::free( tracey::forget( ptr ) );
 }
 
+//* Sized deallocation (C++14). Size is checked against the record
+
+#if defined(__cpp_sized_deallocation) || ( defined(_MSC_VER) && _MSC_VER >= 1900 )
+
+void operator delete( void *ptr, size_t size ) throw() {
+    tracey::free( tracey::forget( ptr, size ) );
+}
+
+void operator delete[]( void *ptr, size_t size ) throw() {
+    tracey::free( tracey::forget( ptr, size ) ); // same size new[] was given, array cookie included
+}
+
+#endif
+
+//* Aligned memory operators (C++17)
+
+#if defined(__cpp_aligned_new)
+
+void *operator new( size_t size, std::align_val_t al ) {
+    return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+}
+
+void *operator new[]( size_t size, std::align_val_t al ) {
+    return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+}
+
+// amalloc() throws on failure, which must not leave a noexcept operator
+void *operator new( size_t size, std::align_val_t al, const std::nothrow_t & ) noexcept {
+    $throw(
+        try {
+            return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+        } catch( const std::bad_alloc & ) {
+            return nullptr;
+        }
+    )
+    $telse(
+        return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+    )
+}
+
+void *operator new[]( size_t size, std::align_val_t al, const std::nothrow_t & ) noexcept {
+    $throw(
+        try {
+            return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+        } catch( const std::bad_alloc & ) {
+            return nullptr;
+        }
+    )
+    $telse(
+        return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+    )
+}
+
+void operator delete( void *ptr, std::align_val_t ) noexcept {
+    tracey::free( tracey::forget( ptr ) );
+}
+
+void operator delete[]( void *ptr, std::align_val_t ) noexcept {
+    tracey::free( tracey::forget( ptr ) );
+}
+
+void operator delete( void *ptr, std::align_val_t, const std::nothrow_t & ) noexcept {
+    tracey::free( tracey::forget( ptr ) );
+}
+
+void operator delete[]( void *ptr, std::align_val_t, const std::nothrow_t & ) noexcept {
+    tracey::free( tracey::forget( ptr ) );
+}
+
+void operator delete( void *ptr, size_t size, std::align_val_t ) noexcept {
+    tracey::free( tracey::forget( ptr, size ) );
+}
+
+void operator delete[]( void *ptr, size_t size, std::align_val_t ) noexcept {
+    tracey::free( tracey::forget( ptr, size ) );
+}
+
+#endif
+
+#endif
+
+#if kTraceyHookLegacyCRT
+
+//* C allocator hooks (linux). Every symbol forwards to the next definition in lookup order (glibc)
+//* and is watched like operator new. dlsym() may allocate while the real functions are looked up,
+//* so those early requests are served from a static bootstrap buffer that is never released.
+
+namespace tracey {
+namespace crt {
+
+    struct api {
+        void *(*malloc)( size_t );
+        void *(*calloc)( size_t, size_t );
+        void *(*realloc)( void *, size_t );
+        void  (*free)( void * );
+        int   (*posix_memalign)( void **, size_t, size_t );
+        void *(*aligned_alloc)( size_t, size_t );
+        void *(*memalign)( size_t, size_t );
+        void *(*valloc)( size_t );
+        void *(*pvalloc)( size_t );
+        size_t (*usable)( void * );
+    } next;
+
+    enum { UNRESOLVED, RESOLVING, RESOLVED };
+    std::atomic<int> state( UNRESOLVED );
+    $tls(bool) resolving = false;
+
+    template<typename FN>
+    void bind( FN &fn, const char *name ) {
+        fn = reinterpret_cast<FN>( dlsym( RTLD_NEXT, name ) );
+    }
+
+    // true once next.* can be used; false while calling thread is looking them up
+    bool resolved() {
+        if( state.load( std::memory_order_acquire ) == RESOLVED ) {
+            return true;
+        }
+        if( resolving ) {
+            return false;
+        }
+        int expected = UNRESOLVED;
+        if( state.compare_exchange_strong( expected, RESOLVING ) ) {
+            resolving = true;
+            bind( next.malloc, "malloc" );
+            bind( next.calloc, "calloc" );
+            bind( next.realloc, "realloc" );
+            bind( next.free, "free" );
+            bind( next.posix_memalign, "posix_memalign" );
+            bind( next.aligned_alloc, "aligned_alloc" );
+            bind( next.memalign, "memalign" );
+            bind( next.valloc, "valloc" );
+            bind( next.pvalloc, "pvalloc" );
+            bind( next.usable, "malloc_usable_size" );
+            resolving = false;
+            state.store( RESOLVED, std::memory_order_release );
+            return true;
+        }
+        while( state.load( std::memory_order_acquire ) != RESOLVED ) {
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // bootstrap buffer. every block is preceded by its size; blocks are zeroed and never reused
+    enum { BOOTSTRAP = 64 * 1024, HEADER = 16 };
+    union { char bytes[ BOOTSTRAP ]; double align; } bootstrap;
+    std::atomic<size_t> bootstrapped( 0 );
+
+    bool early( const void *ptr ) {
+        return (const char *)ptr >= bootstrap.bytes && (const char *)ptr < bootstrap.bytes + BOOTSTRAP;
+    }
+    void *early_alloc( size_t size, size_t alignment = HEADER ) {
+        if( alignment < HEADER ) alignment = HEADER;
+        size_t at, from = bootstrapped.load();
+        do {
+            at = ( from + HEADER + alignment - 1 ) & ~( alignment - 1 );
+            if( at + size > BOOTSTRAP ) return 0;
+        } while( !bootstrapped.compare_exchange_weak( from, at + size ) );
+        std::memcpy( bootstrap.bytes + at - sizeof(size_t), &size, sizeof(size_t) );
+        return bootstrap.bytes + at;
+    }
+    size_t early_size( const void *ptr ) {
+        size_t size;
+        std::memcpy( &size, (const char *)ptr - sizeof(size_t), sizeof(size_t) );
+        return size;
+    }
+
+    // kTraceyRealloc while hooked: untracked, realloc(ptr, 0) frees
+    void *realloc( void *ptr, size_t size ) {
+        if( !resolved() ) {
+            return ptr ? 0 : early_alloc( size );
+        }
+        if( early( ptr ) ) {
+            void *fresh = size ? next.malloc( size ) : 0;
+            if( fresh ) std::memcpy( fresh, ptr, std::min( size, early_size( ptr ) ) );
+            return fresh;
+        }
+        if( ptr && !size ) {
+            return next.free( ptr ), (void *)0;
+        }
+        return next.realloc( ptr, size );
+    }
+
+    // kTraceyFree while hooked: untracked. bootstrap blocks are never released
+    void free( void *ptr ) {
+        if( ptr && !early( ptr ) && resolved() ) {
+            next.free( ptr );
+        }
+    }
+
+    // zeroed counterpart of crt::realloc, untracked. bootstrap blocks are zeroed already
+    void *calloc( size_t num, size_t size ) {
+        return resolved() ? next.calloc( num, size ) : early_alloc( num * size );
+    }
+
+    // aligned counterpart of crt::realloc, untracked
+    void *memalign( size_t alignment, size_t size ) {
+        if( !resolved() ) {
+            return early_alloc( size, alignment );
+        }
+        void *ptr;
+        return next.posix_memalign( &ptr, alignment, size ) ? 0 : ptr;
+    }
+
+    void *watched( void *ptr, size_t size ) {
+        return ptr ? tracey::watch( ptr, size ? size : 1 ) : ptr;
+    }
+}
+}
+
+extern "C" {
+
+void *malloc( size_t size ) throw() {
+    using namespace tracey::crt;
+    return resolved() ? watched( next.malloc( size ), size ) : early_alloc( size );
+}
+
+void *calloc( size_t num, size_t size ) throw() {
+    using namespace tracey::crt;
+    if( size && num > size_t(~0) / size ) return 0;
+    return resolved() ? watched( next.calloc( num, size ), num * size ) : early_alloc( num * size );
+}
+
+void *realloc( void *ptr, size_t size ) throw() {
+    using namespace tracey::crt;
+    if( !ptr ) return malloc( size );
+    if( !size ) return ::free( ptr ), (void *)0;
+    if( !resolved() || early( ptr ) ) return watched( tracey::crt::realloc( ptr, size ), size );
+    return tracey::rewatch( ptr, size, next.realloc );
+}
+
+void free( void *ptr ) throw() {
+    using namespace tracey::crt;
+    if( !ptr || early( ptr ) ) return;
+    tracey::forget( ptr );
+    if( resolved() ) next.free( ptr );
+}
+
+int posix_memalign( void **ptr, size_t alignment, size_t size ) throw() {
+    using namespace tracey::crt;
+    if( !resolved() ) return ( *ptr = early_alloc( size, alignment ) ) ? 0 : 12 /*ENOMEM*/;
+    int error = next.posix_memalign( ptr, alignment, size );
+    if( !error ) watched( *ptr, size );
+    return error;
+}
+
+void *aligned_alloc( size_t alignment, size_t size ) throw() {
+    using namespace tracey::crt;
+    return resolved() ? watched( next.aligned_alloc( alignment, size ), size ) : early_alloc( size, alignment );
+}
+
+void *memalign( size_t alignment, size_t size ) throw() {
+    using namespace tracey::crt;
+    return resolved() ? watched( next.memalign( alignment, size ), size ) : early_alloc( size, alignment );
+}
+
+void *valloc( size_t size ) throw() {
+    using namespace tracey::crt;
+    return resolved() ? watched( next.valloc( size ), size ) : early_alloc( size, 4096 );
+}
+
+void *pvalloc( size_t size ) throw() {
+    using namespace tracey::crt;
+    return resolved() ? watched( next.pvalloc( size ), size ) : early_alloc( ( size + 4095 ) & ~size_t(4095), 4096 );
+}
+
+size_t malloc_usable_size( void *ptr ) throw() {
+    using namespace tracey::crt;
+    if( !ptr ) return 0;
+    return early( ptr ) ? early_size( ptr ) : resolved() ? next.usable( ptr ) : 0;
+}
+
+}
+
+#endif
+
+#if kTraceyHookMmap
+
+//* Address space hooks (linux). mmap, munmap, mremap and madvise forward to the next definition in
+//* lookup order and report mapped ranges to tracer(). Tracey maps its own arenas through vm::mmap, which
+//* is never tracked. Calls made while the real functions are being looked up go straight to the kernel.
+
+#include <stdarg.h>
+#include <sys/syscall.h>
+
+namespace tracey {
+namespace vm {
+
+    struct api {
+        void *(*mmap)( void *, size_t, int, int, int, off_t );
+        int   (*munmap)( void *, size_t );
+        void *(*mremap)( void *, size_t, size_t, int, ... );
+        int   (*madvise)( void *, size_t, int );
+    } next;
+
+    enum { UNBOUND, BINDING, BOUND };
+    std::atomic<int> state( UNBOUND );
+
+    template<typename FN>
+    void bind( FN &fn, const char *name ) {
+        fn = reinterpret_cast<FN>( dlsym( RTLD_NEXT, name ) );
+    }
+
+    // true once next.* can be used
+    bool bound() {
+        int current = state.load( std::memory_order_acquire );
+        if( current == BOUND ) {
+            return true;
+        }
+        if( current == UNBOUND && state.compare_exchange_strong( current, BINDING ) ) {
+            bind( next.mmap, "mmap" );
+            bind( next.munmap, "munmap" );
+            bind( next.mremap, "mremap" );
+            bind( next.madvise, "madvise" );
+            state.store( BOUND, std::memory_order_release );
+            return true;
+        }
+        return false;
+    }
+
+    // untracked mmap and madvise, for tracey's own memory
+    void *mmap( void *addr, size_t length, int prot, int flags, int fd, off_t offset ) {
+        if( bound() ) {
+            return next.mmap( addr, length, prot, flags, fd, offset );
+        }
+#ifdef SYS_mmap2
+        return (void *)syscall( SYS_mmap2, addr, length, prot, flags, fd, offset / 4096 );
+#else
+        return (void *)syscall( SYS_mmap, addr, length, prot, flags, fd, offset );
+#endif
+    }
+    int madvise( void *addr, size_t length, int advice ) {
+        return bound() ? next.madvise( addr, length, advice ) : int( syscall( SYS_madvise, addr, length, advice ) );
+    }
+
+    void report( int op, const void *addr, size_t length, mappings::region *props = 0, bool *detached = 0 ) {
+        mapping m;
+        m.op = (mapping::kind)op;
+        m.addr = addr;
+        m.length = length;
+        m.detached = detached ? *detached : false;
+        if( props ) m.props = *props;
+        else m.props.anonymous = true;
+        size_t special_fn = mapping_fn;
+        tracer( &m, special_fn );
+        if( props ) *props = m.props;
+        if( detached ) *detached = special_fn && m.detached;
+    }
+}
+}
+
+extern "C" {
+
+void *mmap( void *addr, size_t length, int prot, int flags, int fd, off_t offset ) throw() {
+    using namespace tracey::vm;
+    void *ptr = tracey::vm::mmap( addr, length, prot, flags, fd, offset );
+    if( ptr != MAP_FAILED ) {
+        tracey::mappings::region props;
+        props.anonymous = ( flags & MAP_ANONYMOUS ) != 0;
+        report( tracey::mapping::MAP, ptr, length, &props );
+    }
+    return ptr;
+}
+
+int munmap( void *addr, size_t length ) throw() {
+    using namespace tracey::vm;
+    report( tracey::mapping::UNMAP, addr, length ); // before the range can be mapped again by someone else
+    return bound() ? next.munmap( addr, length ) : int( syscall( SYS_munmap, addr, length ) );
+}
+
+void *mremap( void *old_address, size_t old_size, size_t new_size, int flags, ... ) throw() {
+    using namespace tracey::vm;
+    void *new_address = 0;
+    if( flags & MREMAP_FIXED ) {
+        va_list args;
+        va_start( args, flags );
+        new_address = va_arg( args, void * );
+        va_end( args );
+    }
+    // old range is released first and its callstack moves to the new range, as with reallocations
+    tracey::mappings::region props;
+    props.anonymous = true;
+    bool detached = false;
+    report( tracey::mapping::REMAP, old_address, old_size, &props, &detached );
+    void *ptr = bound() ? next.mremap( old_address, old_size, new_size, flags, new_address ) :
+        (void *)syscall( SYS_mremap, old_address, old_size, new_size, flags, new_address );
+    if( ptr != MAP_FAILED ) {
+        report( tracey::mapping::MAP, ptr, new_size, &props, &detached );
+    } else if( detached ) {
+        report( tracey::mapping::MAP, old_address, old_size, &props, &detached ); // old range is still there
+    }
+    return ptr;
+}
+
+int madvise( void *addr, size_t length, int advice ) throw() {
+    using namespace tracey::vm;
+    int error = tracey::vm::madvise( addr, length, advice );
+    if( !error && advice == MADV_DONTNEED ) {
+        report( tracey::mapping::DISCARD, addr, length );
+    }
+    return error;
+}
+
+}
+
 #endif
 
 namespace tracey {
@@ -901,8 +4129,8 @@ static tracey::string get_html_template() {
     );
 }
 
-static void webmain( void *arg ) {
-    if( kTraceyWebserverPort ) {
+static void webmain( void * ) {
+    if( unsigned port = options().port ) {
 
         struct local {
             static 
@@ -924,14 +4152,14 @@ static void webmain( void *arg ) {
             } 
         };
 
-        route66::create( kTraceyWebserverPort, "GET /", local::GET_root );
-        route66::create( kTraceyWebserverPort, "GET /report", local::GET_report );
+        route66::create( port, "GET /", local::GET_root );
+        route66::create( port, "GET /report", local::GET_report );
     }
 }
 
 #else
 
-static void webmain( void *arg )
+static void webmain( void * )
 {}
 
 #endif
@@ -940,10 +4168,11 @@ static void webmain( void *arg )
 
 namespace tracey {
     #pragma comment(lib, "user32.lib")
-    static void hotkeymain( void *arg ) {
-        volatile bool &sitdown = *(volatile bool *)arg;
-        sitdown = true;
-
+    static volatile sig_atomic_t report_requested = 0;
+    static void on_report_signal( int ) {
+        report_requested = 1;
+    }
+    static void hotkeymain( void * ) {
         $windows(
             for(;;) {
                 if( GetAsyncKeyState(VK_NUMLOCK) ) {
@@ -952,6 +4181,19 @@ namespace tracey {
                 Sleep( 1000/60 );
             }
         )
+        $welse(
+            // reports on demand: kill -<TRACEY_REPORT_SIGNAL> <pid>
+            if( options().signal ) {
+                for(;;) {
+                    if( report_requested ) {
+                        report_requested = 0;
+                        std::string logfile = tracey::report();
+                        if( options().view ) tracey::view( logfile );
+                    }
+                    usleep( 100 * 1000 );
+                }
+            }
+        )
     }
 }
 
@@ -975,7 +4217,7 @@ namespace tracey {
     }
     scope::~scope() {
         tracey::disable();
-        if( tracey::stats.num_leaks > 0 ) tracey::view( tracey::report() );
+        if( tracey::snapshot().num_leaks > 0 ) tracey::view( tracey::report() );
     }
 }
 
@@ -1051,7 +4293,7 @@ extern "C" {
             return tracey::watch( tracey::malloc( size ), size );
         }
         void *tracey_checked_realloc( void *ptr, size_t resize ) {
-            return tracey::watch( tracey::realloc( tracey::forget( ptr ), resize ), resize );
+            return tracey::rewatch( ptr, resize );
         }
         void  tracey_checked_free( void *ptr ) {
             tracey::free( tracey::forget( ptr ) );
@@ -17,6 +17,8 @@
 /*/ #define kTraceyBudgetOverhead              1.0
 /*/ Tracey retrieves up to 128 traces by default. The longer the slower, though.
 /*/ #define kTraceyMaxStacktraces              128
+/*/ Tracey unwinder: 0 for platform backtraces, 1 for frame pointers (faster; requires -fno-omit-frame-pointer, linux only), 2 for cached DWARF CFI (fast without frame pointers; x86-64 linux only)
+/*/ #define kTraceyUnwinder                    0
 /*/ Tracey head position on every stacktrace. It does not skip backtraces by default.
 /*/ #define kTraceyStacktraceSkipBegin         0
 /*/ Tracey tail position on every stacktrace. It does not skip backtraces by default.
@@ -25,7 +27,7 @@
 /*/ #define kTraceyCharLinefeed                "\n"
 /*/ Tracey tab character when logging.
 /*/ #define kTraceyCharTab                     "\t"
-/*/ When enabled, Tracey warns about deallocations on pointers that have been not allocated by Tracey (wild pointers)
+/*/ When enabled, Tracey warns about deallocations on pointers that have been not allocated by Tracey (wild pointers), and about sized deallocations that disagree with the allocated size
 /*/ #define kTraceyReportWildPointers          0
 /*/ When enabled, Tracey warns about double allocations on same pointer
 /*/ #define kTraceyReportDoubleAllocations     0
@@ -37,12 +39,34 @@
 /*/ #define kTraceyEnabled                     1
 /*/ When >0, Tracey web service is enabled. Note: requires C++11
 /*/ #define kTraceyWebserverPort               2001
-/*/ When enabled, Tracey will hook up C CRT as well (@todo)
+/*/ When enabled, Tracey will hook up C CRT as well (malloc, calloc, realloc, free, posix_memalign and friends; linux only)
 /*/ #define kTraceyHookLegacyCRT               0
+/*/ When enabled, Tracey will hook up mmap, munmap, mremap and madvise(MADV_DONTNEED) too, and report mapped ranges on their own (linux only)
+/*/ #define kTraceyHookMmap                    0
 /*/ When >0.0 (%), Tracey will ignore branches of leaks that are smaller than given percentage. It does not ignore branches by default.
 /*/ #define kTraceyTruncateBranchesSmallerThan 0.0 
 /*/ When enabled, Tracey implements all new/delete operators; else user must use runtime API manually (see below).
 /*/ #define kTraceyDefineMemoryOperators       1
+/*/ Tracey splits its allocation registry into this many independently locked stripes (power of two).
+/*/ #define kTraceyRegistryShards              64
+/*/ When enabled, Tracey defers registry bookkeeping to a background thread fed by per-thread event buffers. Wild pointers are then reported late and without callstack.
+/*/ #define kTraceyAsync                       0
+/*/ Tracey per-thread event buffer capacity, in events, when kTraceyAsync is enabled (power of two).
+/*/ #define kTraceyAsyncBufferSize             4096
+/*/ When >0, Tracey samples one allocation every this many bytes on average (poisson) and scales the report back up. Cheap enough for production.
+/*/ #define kTraceySampleRate                  0
+/*/ When enabled, Tracey puts a small header in front of every block it allocates, so deallocations find their record in O(1) instead of hashing. kTraceyAsync is ignored then.
+/*/ #define kTraceyHeaders                     0
+/*/ Tracey size of the filter that rejects deallocations of never tracked pointers without locking, in KB (power of two; 0 disables it).
+/*/ #define kTraceyFreeFilterKB                256
+/*/ Tracey allocation backend: 0 uses kTraceyRealloc (system heap), 1 uses a built-in thread-caching size-class slab. TRACEY_BACKEND overrides it at runtime.
+/*/ #define kTraceyBackend                     0
+/*/ Tracey policy the allocation hot path is built from. tracey::defaults follows the options above; a tracey::policy<...> (see tracey.cpp) compiles out every feature it leaves out.
+/*/ #define kTraceyPolicy                      tracey::defaults
+/*/ Tracey persistent symbol cache (ELF only): 1 keeps resolved symbols on disk, one file per module build-id, in $XDG_CACHE_HOME/tracey or ~/.cache/tracey when writable. 0 disables it unless TRACEY_SYMBOL_CACHE names a directory.
+/*/ #define kTraceySymbolCache                 0
+/*/ Tracey report tree: 1 builds a flat calling-context tree (one node array, 32-bit indices); 0 builds the former oak::tree of nested maps, kept for comparison.
+/*/ #define kTraceyFlatTree                    1
 
 /*/ Backend implementation. Tweak these if needed.
 /*/
@@ -51,6 +75,10 @@
 /*/ #define kTraceyPrintf           std::printf
 /*/ Default memory allocator
 /*/ #define kTraceyRealloc          std::realloc
+/*/ Default zeroed memory allocator
+/*/ #define kTraceyCalloc           std::calloc
+/*/ Default memory deallocator, for blocks of kTraceyRealloc and kTraceyCalloc
+/*/ #define kTraceyFree             std::free
 /*/ Default memory setter
 /*/ #define kTraceyMemset           std::memset
 /*/ Default filling character
@@ -84,6 +112,8 @@ namespace tracey {
     /*/
     void *watch( const void *ptr, size_t size );
     void *forget( const void *ptr );
+    void *forget( const void *ptr, size_t size );
+    void *rewatch( void *ptr, size_t resize );
     void  enable();
     void  disable();
     void  clear();
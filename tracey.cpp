@@ -75,6 +75,7 @@
 
 #include <cassert>
 #include <cctype>
+#include <cmath>
 // #include <cstddef> // (stddef.h fails on ArchLinux w/ clang 3.4)
 #include <cstdio>
 #include <cstdlib>
@@ -92,12 +93,24 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 // Our API {
 #   include "tracey.hpp"
 // }
 
+// LD_PRELOAD build, for binaries that cannot be rebuilt:
+//   g++ -std=c++11 -O2 -g -shared -fPIC -DTRACEY_PRELOAD tracey.cpp -o libtracey.so -ldl -lpthread
+//   TRACEY_REPORT=/tmp/leaks-%p.html LD_PRELOAD=./libtracey.so ./app
+// operators and C allocator are always hooked; TRACEY_* environment variables configure the rest.
+#ifdef TRACEY_PRELOAD
+#   undef  kTraceyDefineMemoryOperators
+#   define kTraceyDefineMemoryOperators 1
+#   undef  kTraceyHookLegacyCRT
+#   define kTraceyHookLegacyCRT 1
+#endif
+
 // external; tree implementation {
 
 //#line 1 "oak.hpp"
@@ -419,6 +432,7 @@ namespace oak
 
 // external; macros, OS utils. Here is where the fun starts {
 #   define HEAL_MAX_TRACES kTraceyMaxStacktraces
+#   define HEAL_UNWINDER kTraceyUnwinder
 #   define heal tracey_heal
 
 //#line 1 "heal.cpp"
@@ -492,6 +506,7 @@ namespace oak
 #   endif
 #else
 #   include <unistd.h>
+#   include <pthread.h>
 #   include <signal.h>
 #   include <sys/time.h>
 #   include <sys/types.h>
@@ -507,6 +522,34 @@ namespace oak
 #   include <cxxabi.h>
 #endif
 
+#if defined(__linux__) && defined(__x86_64__)
+#   include <atomic>
+#   include <mutex>
+#   include <dlfcn.h>
+#   include <link.h>
+#   include <stddef.h>
+#   define HEAL_HAS_CFI 1
+#else
+#   define HEAL_HAS_CFI 0
+#endif
+
+#if defined(__linux__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#   include <mutex>
+#   include <thread>
+#   include <errno.h>
+#   include <dlfcn.h>
+#   include <elf.h>
+#   include <fcntl.h>
+#   include <link.h>
+#   include <spawn.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <sys/wait.h>
+#   define HEAL_HAS_ELF 1
+#else
+#   define HEAL_HAS_ELF 0
+#endif
+
 #ifdef __MINGW32__
 #define backtrace(a,b) 0
 #define backtrace_symbols(a,b) 0
@@ -782,6 +825,12 @@ namespace heal {
 	#define HEAL_MAX_TRACES 128
 	#endif
 
+	// 0: platform unwinder (backtrace() on gnuc); 1: frame pointers (requires -fno-omit-frame-pointer);
+	// 2: cached dwarf cfi from .eh_frame (x86-64 linux only)
+	#ifndef HEAL_UNWINDER
+	#define HEAL_UNWINDER 0
+	#endif
+
 	struct callstack /* : public std::vector<const void*> */ {
 		enum { max_frames = HEAL_MAX_TRACES };
 		std::vector<void *> frames;
@@ -791,6 +840,29 @@ namespace heal {
 		std::vector<std::string> unwind( unsigned from = 0, unsigned to = ~0 ) const;
 		std::vector<std::string> str( const char *format12 = "#\1 \2\n", size_t skip_begin = 0 ) const;
 		std::string flat( const char *format12 = "#\1 \2\n", size_t skip_begin = 0 ) const;
+		// unwinds into caller's buffer. no heap allocations involved. returns number of frames captured
+		// how: unwinder to use (UNWIND_*); -1 for the selected one
+		static unsigned capture( void **out_frames, unsigned max_frames, unsigned frames_to_skip = 0, int how = -1 );
+		static unsigned capture_fp( void **out_frames, unsigned max_frames, unsigned frames_to_skip = 0 );
+		static unsigned walk_frames( uintptr_t fp, void **out_frames, unsigned max_frames, unsigned frames_to_skip );
+		// selected unwinder; defaults to HEAL_UNWINDER and can be switched at runtime
+		enum { UNWIND_PLATFORM = 0, UNWIND_FRAME_POINTERS = 1, UNWIND_DWARF = 2 };
+		static volatile int unwinder;
+	};
+
+	// fixed-size callstack that lives on the stack; save() never allocates memory
+	// UNWINDER: unwinder fixed at compile time (UNWIND_*); -1 for the selected one
+	template<unsigned N = HEAL_MAX_TRACES, int UNWINDER = -1>
+	struct stackframes {
+		enum { max_frames = N };
+		void *frames[ N ];
+		unsigned size;
+		stackframes( bool autosave = false ) : size( 0 ) {
+			if( autosave ) save();
+		}
+		void save( unsigned frames_to_skip = 0 ) {
+			size = callstack::capture( frames, N, frames_to_skip, UNWINDER );
+		}
 	};
 
 	template<typename T>
@@ -1464,28 +1536,17 @@ std::string demangle( const std::string &mangled ) {
 		return out;
 	})
 	$linux({
-		$no( /* c++filt way */
-		FILE *fp = popen( (std::string("echo -n \"") + mangled + std::string("\" | c++filt" )).c_str(), "r" );
-		if (!fp) { return mangled; }
-		char demangled[1024];
-		char *line_p = fgets(demangled, sizeof(demangled), fp);
-		pclose(fp);
-		return demangled;
-		)
-		$yes( /* addr2line way. wip & quick proof-of-concept. clean up required. */
-		heal::sfstring binary = mangled.substr( 0, mangled.find_first_of('(') );
-		heal::sfstring address = mangled.substr( mangled.find_last_of('[') + 1 );
-		address.pop_back();
-		heal::sfstring cmd( "addr2line -e \1 \2", binary, address );
-		FILE *fp = popen( cmd.c_str(), "r" );
-		if (!fp) { return mangled; }
-		char demangled[1024];
-		char *line_p = fgets(demangled, sizeof(demangled), fp);
-		pclose(fp);
-		heal::sfstring demangled_(demangled);
-		if( demangled_.size() ) demangled_.pop_back(); //remove \n
-		return demangled_.size() && demangled_.at(0) == '?' ? mangled : demangled_;
-		)
+		// "module(function+offset) [address]", as told by backtrace_symbols()
+		std::string::size_type open = mangled.find_first_of( '(' ), plus = mangled.find_first_of( "+)", open );
+		if( open == std::string::npos || plus == std::string::npos || plus == open + 1 )
+			return mangled;
+		std::string funcname = mangled.substr( open + 1, plus - open - 1 );
+		int status = 0;
+		char *demangled = abi::__cxa_demangle( funcname.c_str(), 0, 0, &status );
+		heal::sfstring out;
+		out = std::string() + ( status == 0 && demangled ? demangled : funcname.c_str() ) + " ([" + mangled.substr( 0, open ) + "])";
+		if( demangled ) free( demangled );
+		return out;
 	})
 	$windows({
 		char demangled[1024];
@@ -1504,1731 +1565,5050 @@ std::string demangle( const std::string &mangled ) {
 		return mangled;
 }
 
-// CALLSTACK
+// STACK BOUNDS
 
-		callstack::callstack( bool autosave ) {
-			if( autosave ) save();
-		}
+namespace {
+	// per-thread stack limits, so a corrupt or missing frame chain cannot make unwinders fault
+	bool stack_bounds( uintptr_t &lo, uintptr_t &hi ) {
+		$linux({
+			static $tls(uintptr_t) stack_lo = 0;
+			static $tls(uintptr_t) stack_hi = 0;
+			if( !stack_hi ) {
+				pthread_attr_t attr;
+				void *addr = 0;
+				size_t size = 0;
+				if( pthread_getattr_np( pthread_self(), &attr ) == 0 ) {
+					pthread_attr_getstack( &attr, &addr, &size );
+					pthread_attr_destroy( &attr );
+				}
+				stack_lo = (uintptr_t)addr;
+				stack_hi = (uintptr_t)addr + size;
+			}
+			lo = stack_lo;
+			hi = stack_hi;
+			return hi != 0;
+		})
+		return false;
+	}
+}
 
-		size_t callstack::space() const {
-			return sizeof(frames) + sizeof(void *) * frames.size();
-		}
+// CFI UNWINDER
+// Walks the stack by applying the DWARF call frame information found in .eh_frame, so it works on
+// -fomit-frame-pointer builds. Modules are found with dl_iterate_phdr() and looked up through their
+// .eh_frame_hdr tables. Rules are compiled once per return address into a lock-free cache.
 
-		void callstack::save( unsigned frames_to_skip ) {
+#if HEAL_HAS_CFI
 
-			if( frames_to_skip > max_frames )
-				return;
+namespace cfi {
 
-			frames.clear();
-			frames.resize( max_frames, (void *)0 );
-			void **out_frames = &frames[0]; // .data();
+	// dwarf register numbers on x86-64
+	enum { REG_RBP = 6, REG_RSP = 7, REG_RA = 16 };
 
-			$windows({
-				unsigned short capturedFrames = 0;
+	// compiled rule: bits 0-1 cfa base (1 rsp, 2 rbp, 3 end of stack, 0 unknown),
+	// bits 8-23 rbp slot offset (0 if rbp is unchanged), bits 24-39 return address offset,
+	// bits 40-63 cfa offset. all offsets are signed and relative to cfa.
+	enum { RULE_NONE = 0, RULE_RSP = 1, RULE_RBP = 2, RULE_END = 3 };
 
-				// RtlCaptureStackBackTrace is only available on Windows XP or newer versions of Windows
-				typedef WORD(NTAPI FuncRtlCaptureStackBackTrace)(DWORD, DWORD, PVOID *, PDWORD);
+	inline uint64_t pack( unsigned base, int64_t cfa_off, int64_t ra_off, int64_t rbp_off ) {
+		if( cfa_off < -(1 << 23) || cfa_off >= (1 << 23) ) return RULE_NONE;
+		if( ra_off < -32768 || ra_off > 32767 || rbp_off < -32768 || rbp_off > 32767 ) return RULE_NONE;
+		return uint64_t(base) | ( uint64_t(uint16_t(rbp_off)) << 8 ) | ( uint64_t(uint16_t(ra_off)) << 24 ) | ( uint64_t(cfa_off) << 40 );
+	}
+	inline unsigned base_of( uint64_t rule ) { return unsigned( rule & 3 ); }
+	inline int64_t rbp_of( uint64_t rule ) { return int16_t( rule >> 8 ); }
+	inline int64_t ra_of( uint64_t rule ) { return int16_t( rule >> 24 ); }
+	inline int64_t cfa_of( uint64_t rule ) { return int64_t( rule ) >> 40; }
 
-				static struct raii
-				{
-					raii() : module(0), ptrRtlCaptureStackBackTrace(0)
-					{
-						module = LoadLibraryA("kernel32.dll");
-						if( !module )
-							fail( "<heal/heal.cpp> says: error! cant load kernel32.dll" );
+	struct reader {
+		const uint8_t *p;
 
-						ptrRtlCaptureStackBackTrace = (FuncRtlCaptureStackBackTrace *)GetProcAddress(module, "RtlCaptureStackBackTrace");
-						if( !ptrRtlCaptureStackBackTrace )
-							fail( "<heal/heal.cpp> says: error! cant find RtlCaptureStackBackTrace() process address" );
-					}
-					~raii() { if(module) FreeLibrary(module); }
+		uint8_t u8() {
+			return *p++;
+		}
+		template<typename T>
+		T get() {
+			T t;
+			std::memcpy( &t, p, sizeof(T) );
+			return p += sizeof(T), t;
+		}
+		uint64_t uleb() {
+			uint64_t r = 0;
+			unsigned shift = 0;
+			uint8_t b;
+			do { b = *p++; if( shift < 64 ) r |= uint64_t(b & 0x7f) << shift; shift += 7; } while( b & 0x80 );
+			return r;
+		}
+		int64_t sleb() {
+			int64_t r = 0;
+			unsigned shift = 0;
+			uint8_t b;
+			do { b = *p++; if( shift < 64 ) r |= int64_t(b & 0x7f) << shift; shift += 7; } while( b & 0x80 );
+			if( shift < 64 && (b & 0x40) ) r |= -(int64_t(1) << shift);
+			return r;
+		}
+		// DW_EH_PE encoded pointer
+		bool encoded( uint8_t enc, uintptr_t datarel, uintptr_t &out ) {
+			if( enc == 0xff ) return out = 0, true;
+			uintptr_t base = (uintptr_t)p, v;
+			switch( enc & 0x0f ) {
+				case 0x00: v = get<uintptr_t>(); break;
+				case 0x01: v = uleb(); break;
+				case 0x02: v = get<uint16_t>(); break;
+				case 0x03: v = get<uint32_t>(); break;
+				case 0x04: v = get<uint64_t>(); break;
+				case 0x09: v = sleb(); break;
+				case 0x0a: v = get<int16_t>(); break;
+				case 0x0b: v = get<int32_t>(); break;
+				case 0x0c: v = get<int64_t>(); break;
+				default: return false;
+			}
+			switch( enc & 0x70 ) {
+				case 0x00: break;
+				case 0x10: v += base; break;
+				case 0x30: v += datarel; break;
+				default: return false;
+			}
+			if( enc & 0x80 ) v = *(const uintptr_t *)v;
+			return out = v, true;
+		}
+	};
 
-					HMODULE module;
-					FuncRtlCaptureStackBackTrace *ptrRtlCaptureStackBackTrace;
-				} module;
+	// modules {
 
-				if( module.ptrRtlCaptureStackBackTrace )
-					capturedFrames = module.ptrRtlCaptureStackBackTrace(frames_to_skip+1, max_frames, out_frames, (DWORD *) 0);
+	struct module {
+		uintptr_t lo, hi;       // executable range
+		const uint8_t *hdr;     // .eh_frame_hdr
+	};
 
-				frames.resize( capturedFrames );
-				std::vector<void *>(frames).swap(frames);
-				return;
-			})
-			$gnuc({
-				// Ensure the output is cleared
-				std::memset(out_frames, 0, (sizeof(void *)) * max_frames);
+	enum { MAX_MODULES = 1024 };
+	module modules[ MAX_MODULES ];
+	unsigned num_modules = 0;
+	unsigned long long loads = ~0ULL, unloads = ~0ULL;
+	std::atomic<unsigned> generation( 0 );  // bumped by every unload; see dlclose() below
+	unsigned scanned = 0;                   // generation the table was scanned at
+	std::mutex modules_mutex;
+
+	struct scan {
+		unsigned long long loads, unloads;
+		unsigned count;
+	};
 
-				frames.resize( backtrace(out_frames, max_frames) );
-				std::vector<void *>(frames).swap(frames);
-				return;
-			})
+	int collect( struct dl_phdr_info *info, size_t size, void *data ) {
+		scan &sc = *(scan *)data;
+		if( size >= offsetof(struct dl_phdr_info, dlpi_subs) + sizeof(info->dlpi_subs) ) {
+			sc.loads = info->dlpi_adds;
+			sc.unloads = info->dlpi_subs;
 		}
+		if( sc.count >= MAX_MODULES )
+			return 0;
+		module m = { ~uintptr_t(0), 0, 0 };
+		for( unsigned i = 0; i < info->dlpi_phnum; ++i ) {
+			const ElfW(Phdr) &ph = info->dlpi_phdr[i];
+			uintptr_t start = info->dlpi_addr + ph.p_vaddr;
+			if( ph.p_type == PT_GNU_EH_FRAME ) {
+				m.hdr = (const uint8_t *)start;
+			}
+			if( ph.p_type == PT_LOAD && (ph.p_flags & PF_X) ) {
+				m.lo = std::min( m.lo, start );
+				m.hi = std::max( m.hi, start + ph.p_memsz );
+			}
+		}
+		if( m.hdr && m.lo < m.hi ) {
+			modules[ sc.count++ ] = m;
+		}
+		return 0;
+	}
 
-		std::vector<std::string> callstack::unwind( unsigned from, unsigned to ) const
-		{
-			if( to == ~0 )
-				to = this->frames.size();
-
-			if( from > to || from > this->frames.size() || to > this->frames.size() )
-				return std::vector<std::string>();
+	// rescans loaded modules if any dlopen()/dlclose() happened since last scan. modules_mutex must be held
+	bool refresh() {
+		scan sc = { 0, 0, 0 };
+		dl_iterate_phdr( collect, &sc );
+		bool changed = sc.loads != loads || sc.unloads != unloads;
+		if( sc.unloads != unloads ) {
+			generation++; // cached rules may belong to unloaded code
+		}
+		num_modules = sc.count;
+		loads = sc.loads;
+		unloads = sc.unloads;
+		scanned = generation.load();
+		return changed;
+	}
 
-			const size_t num_frames = to - from;
-			std::vector<std::string> backtraces( num_frames );
+	const module *find_module( uintptr_t pc ) {
+		for( unsigned i = 0; i < num_modules; ++i ) {
+			if( pc >= modules[i].lo && pc < modules[i].hi ) return &modules[i];
+		}
+		return 0;
+	}
 
-			void * const * frames = &this->frames[ from ];
-			const std::string invalid = "????";
+	// }
 
-			$windows({
-				SymSetOptions(SYMOPT_UNDNAME);
+	// frame description entries {
 
-				$no(
-					// polite version. this is how things should be done.
-					HANDLE process = GetCurrentProcess();
-					if( SymInitialize( process, NULL, TRUE ) )
-				)
-				$yes(
-					// this is what we have to do because other memory managers are not polite enough. fuck them off
-					static HANDLE process = GetCurrentProcess();
-					static int init = SymInitialize( process, NULL, TRUE );
-					if( !init )
-						fail( "<heal/heal.cpp> says: cannot initialize Dbghelp.lib" );
-				)
-				{
-					enum { MAXSYMBOLNAME = 512 - sizeof(IMAGEHLP_SYMBOL64) };
-					char symbol64_buf     [ 512 ];
-					char symbol64_bufblank[ 512 ] = {0};
-					IMAGEHLP_SYMBOL64 *symbol64       = reinterpret_cast<IMAGEHLP_SYMBOL64*>(symbol64_buf);
-					IMAGEHLP_SYMBOL64 *symbol64_blank = reinterpret_cast<IMAGEHLP_SYMBOL64*>(symbol64_bufblank);
-					symbol64_blank->SizeOfStruct = sizeof(IMAGEHLP_SYMBOL64);
-					symbol64_blank->MaxNameLength = (MAXSYMBOLNAME-1) / 2; //wchar?
+	const uint8_t *find_fde( const uint8_t *hdr, uintptr_t pc ) {
+		reader r = { hdr };
+		if( r.u8() != 1 ) return 0;
+		uint8_t eh_frame_ptr_enc = r.u8(), fde_count_enc = r.u8(), table_enc = r.u8();
+		uintptr_t eh_frame, count;
+		if( !r.encoded( eh_frame_ptr_enc, (uintptr_t)hdr, eh_frame ) || !r.encoded( fde_count_enc, (uintptr_t)hdr, count ) )
+			return 0;
+		if( table_enc != 0x3b ) // datarel|sdata4; the only one emitted by linkers
+			return 0;
+		const uint8_t *table = r.p;
+		size_t lo = 0, hi = count;
+		while( lo < hi ) {
+			size_t mid = lo + (hi - lo) / 2;
+			int32_t loc;
+			std::memcpy( &loc, table + mid * 8, 4 );
+			if( (uintptr_t)hdr + loc <= pc ) lo = mid + 1; else hi = mid;
+		}
+		if( !lo ) return 0;
+		int32_t fde;
+		std::memcpy( &fde, table + (lo - 1) * 8 + 4, 4 );
+		return hdr + fde;
+	}
 
-					IMAGEHLP_LINE64 line64, line64_blank = {0};
-					line64_blank.SizeOfStruct = sizeof(IMAGEHLP_LINE64);
+	struct state {
+		unsigned cfa_reg;
+		int64_t cfa_off, ra_off, rbp_off;
+		bool ra_saved, rbp_saved;
+	};
 
-					for( unsigned i = 0; i < num_frames; i++ ) {
-						*symbol64 = *symbol64_blank;
-						DWORD64 displacement64 = 0;
+	// runs cfa program until location goes past pc. returns false on unsupported opcodes
+	bool execute( reader r, const uint8_t *end, uintptr_t loc, uintptr_t pc, uint64_t code_align, int64_t data_align, const state &initial, state &st ) {
+		enum { MAX_REMEMBERED = 8 };
+		state remembered[ MAX_REMEMBERED ];
+		unsigned depth = 0;
+
+		while( r.p < end ) {
+			uint8_t op = r.u8();
+			uint64_t reg;
+			int64_t off;
+			switch( op & 0xc0 ) {
+				case 0x40: // DW_CFA_advance_loc
+					loc += (op & 0x3f) * code_align;
+					if( loc > pc ) return true;
+					continue;
+				case 0x80: // DW_CFA_offset
+					reg = op & 0x3f;
+					off = int64_t( r.uleb() ) * data_align;
+					if( reg == REG_RA ) st.ra_off = off, st.ra_saved = true;
+					if( reg == REG_RBP ) st.rbp_off = off, st.rbp_saved = true;
+					continue;
+				case 0xc0: // DW_CFA_restore
+					reg = op & 0x3f;
+					if( reg == REG_RA ) st.ra_off = initial.ra_off, st.ra_saved = initial.ra_saved;
+					if( reg == REG_RBP ) st.rbp_off = initial.rbp_off, st.rbp_saved = initial.rbp_saved;
+					continue;
+			}
+			switch( op ) {
+				case 0x00: // DW_CFA_nop
+					break;
+				case 0x02: // DW_CFA_advance_loc1
+					loc += r.u8() * code_align;
+					if( loc > pc ) return true;
+					break;
+				case 0x03: // DW_CFA_advance_loc2
+					loc += r.get<uint16_t>() * code_align;
+					if( loc > pc ) return true;
+					break;
+				case 0x04: // DW_CFA_advance_loc4
+					loc += r.get<uint32_t>() * code_align;
+					if( loc > pc ) return true;
+					break;
+				case 0x05: // DW_CFA_offset_extended
+				case 0x11: // DW_CFA_offset_extended_sf
+					reg = r.uleb();
+					off = ( op == 0x05 ? int64_t( r.uleb() ) : r.sleb() ) * data_align;
+					if( reg == REG_RA ) st.ra_off = off, st.ra_saved = true;
+					if( reg == REG_RBP ) st.rbp_off = off, st.rbp_saved = true;
+					break;
+				case 0x06: // DW_CFA_restore_extended
+					reg = r.uleb();
+					if( reg == REG_RA ) st.ra_off = initial.ra_off, st.ra_saved = initial.ra_saved;
+					if( reg == REG_RBP ) st.rbp_off = initial.rbp_off, st.rbp_saved = initial.rbp_saved;
+					break;
+				case 0x07: // DW_CFA_undefined
+					reg = r.uleb();
+					if( reg == REG_RA ) st.ra_saved = false; // outermost frame
+					if( reg == REG_RBP ) st.rbp_saved = false;
+					break;
+				case 0x08: // DW_CFA_same_value
+					reg = r.uleb();
+					if( reg == REG_RBP ) st.rbp_saved = false;
+					break;
+				case 0x09: // DW_CFA_register
+					reg = r.uleb(); r.uleb();
+					if( reg == REG_RA || reg == REG_RBP ) return false;
+					break;
+				case 0x0a: // DW_CFA_remember_state
+					if( depth == MAX_REMEMBERED ) return false;
+					remembered[ depth++ ] = st;
+					break;
+				case 0x0b: // DW_CFA_restore_state
+					if( !depth ) return false;
+					st = remembered[ --depth ];
+					break;
+				case 0x0c: // DW_CFA_def_cfa
+					st.cfa_reg = unsigned( r.uleb() );
+					st.cfa_off = int64_t( r.uleb() );
+					break;
+				case 0x12: // DW_CFA_def_cfa_sf
+					st.cfa_reg = unsigned( r.uleb() );
+					st.cfa_off = r.sleb() * data_align;
+					break;
+				case 0x0d: // DW_CFA_def_cfa_register
+					st.cfa_reg = unsigned( r.uleb() );
+					break;
+				case 0x0e: // DW_CFA_def_cfa_offset
+					st.cfa_off = int64_t( r.uleb() );
+					break;
+				case 0x13: // DW_CFA_def_cfa_offset_sf
+					st.cfa_off = r.sleb() * data_align;
+					break;
+				case 0x14: // DW_CFA_val_offset
+				case 0x15: // DW_CFA_val_offset_sf
+					reg = r.uleb();
+					if( op == 0x14 ) r.uleb(); else r.sleb();
+					if( reg == REG_RA || reg == REG_RBP ) return false;
+					break;
+				case 0x10: // DW_CFA_expression
+				case 0x16: // DW_CFA_val_expression
+					reg = r.uleb();
+					r.p += r.uleb();
+					if( reg == REG_RA || reg == REG_RBP ) return false;
+					break;
+				case 0x2e: // DW_CFA_GNU_args_size
+					r.uleb();
+					break;
+				case 0x0f: // DW_CFA_def_cfa_expression
+				default:
+					return false;
+			}
+		}
+		return true;
+	}
 
-						if( SymGetSymFromAddr64( process, (DWORD64) frames[i], &displacement64, symbol64 ) ) {
-							line64 = line64_blank;
-							DWORD displacement = 0;
-							if( SymGetLineFromAddr64( process, (DWORD64) frames[i], &displacement, &line64 ) ) {
-								backtraces[i] = heal::sfstring( "\1 (\2:\3)", symbol64->Name, line64.FileName, line64.LineNumber );
-							} else {
-								backtraces[i] = symbol64->Name;
-							}
-						} else  backtraces[i] = invalid;
-					}
+	// compiles the unwinding rule that applies at pc, or RULE_NONE
+	uint64_t compile( const uint8_t *fde, uintptr_t pc ) {
+		reader r = { fde };
+		uint32_t length = r.get<uint32_t>();
+		if( !length || length == 0xffffffff ) return RULE_NONE; // terminator or 64-bit dwarf
+		const uint8_t *fde_end = r.p + length;
+		const uint8_t *cie_pointer = r.p;
+		uint32_t cie_offset = r.get<uint32_t>();
+		if( !cie_offset ) return RULE_NONE; // not a fde
+
+		// common information entry
+		reader c = { cie_pointer - cie_offset };
+		uint32_t cie_length = c.get<uint32_t>();
+		if( !cie_length || cie_length == 0xffffffff ) return RULE_NONE;
+		const uint8_t *cie_end = c.p + cie_length;
+		c.get<uint32_t>(); // cie id
+		uint8_t version = c.u8();
+		const char *augmentation = (const char *)c.p;
+		c.p += std::strlen( augmentation ) + 1;
+		if( version >= 4 ) c.p += 2; // address and segment selector sizes
+		uint64_t code_align = c.uleb();
+		int64_t data_align = c.sleb();
+		if( version == 1 ) c.u8(); else c.uleb(); // return address register
+		uint8_t fde_encoding = 0;
+		bool has_augmentation_data = augmentation[0] == 'z';
+		if( has_augmentation_data ) {
+			uint64_t len = c.uleb();
+			const uint8_t *data_end = c.p + len;
+			for( const char *a = augmentation + 1; *a; ++a ) {
+				uintptr_t dummy;
+				/**/ if( *a == 'R' ) fde_encoding = c.u8();
+				else if( *a == 'L' ) c.u8();
+				else if( *a == 'P' ) { uint8_t enc = c.u8(); if( !c.encoded( enc & 0x7f, 0, dummy ) ) return RULE_NONE; }
+				else if( *a == 'S' || *a == 'B' ) {}
+				else return RULE_NONE;
+			}
+			c.p = data_end;
+		} else if( augmentation[0] ) {
+			return RULE_NONE;
+		}
 
-					$no(
-						// fuck the others. cleanup commented.
-						SymCleanup(process);
-					)
-				}
-				DWORD error = GetLastError();
+		// address range covered by this fde
+		uintptr_t pc_begin, pc_range;
+		if( !r.encoded( fde_encoding, 0, pc_begin ) || !r.encoded( fde_encoding & 0x0f, 0, pc_range ) )
+			return RULE_NONE;
+		if( pc < pc_begin || pc >= pc_begin + pc_range )
+			return RULE_NONE;
+		if( has_augmentation_data ) {
+			uint64_t len = r.uleb();
+			r.p += len;
+		}
 
-				return backtraces;
-			})
-			$gnuc({
-				char **strings = backtrace_symbols(frames, num_frames);
+		// cie initial instructions, then fde instructions up to pc
+		state initial = { REG_RSP, 8, -8, 0, true, false }, st;
+		if( !execute( c, cie_end, pc_begin, pc, code_align, data_align, initial, initial ) )
+			return RULE_NONE;
+		st = initial;
+		if( !execute( r, fde_end, pc_begin, pc, code_align, data_align, initial, st ) )
+			return RULE_NONE;
+
+		if( !st.ra_saved ) return RULE_END;
+		if( st.cfa_reg != REG_RSP && st.cfa_reg != REG_RBP ) return RULE_NONE;
+		return pack( st.cfa_reg == REG_RSP ? RULE_RSP : RULE_RBP, st.cfa_off, st.ra_off, st.rbp_saved ? st.rbp_off : 0 );
+	}
 
-				// Decode the strings
-				if( strings ) {
-					for( unsigned i = 0; i < num_frames; i++ ) {
-						backtraces[i] = ( strings[i] ? demangle(strings[i]) : invalid );
-					}
-					free( strings );
-				}
+	// }
 
-				return backtraces;
-			})
+	// lock-free pc -> rule cache {
+	// a writer claims an empty slot with a pending key, stores the rule, then publishes the key.
+	// readers only accept fully published keys, and recheck them after reading the rule. keys carry the
+	// module generation, so rules of unloaded modules stop matching, and their slots are reused.
 
-			return backtraces;
-		}
+	enum { CACHE_BITS = 14, CACHE_SIZE = 1 << CACHE_BITS, MAX_PROBES = 16 };
+	const uint64_t PENDING = ~0ULL;
 
-		std::vector<std::string> callstack::str( const char *format12, size_t skip_begin ) const {
-			callstack copy = *this;
-			std::vector<std::string> stacktrace = copy.unwind( skip_begin );
+	struct slot {
+		std::atomic<uint64_t> key;
+		std::atomic<uint64_t> rule;
+	};
+	slot cache[ CACHE_SIZE ];
 
-			for( size_t i = 0, end = stacktrace.size(); i < end; i++ )
-				stacktrace[i] = heal::sfstring( format12, i + 1, stacktrace[i] );
+	inline bool stale( uint64_t k, uint64_t key ) {
+		return k && k != PENDING && ( k >> 48 ) != ( key >> 48 );
+	}
 
-			return stacktrace;
+	uint64_t lookup( uintptr_t pc ) {
+		unsigned gen = generation.load();
+		uint64_t key = ( uint64_t(pc) & 0xFFFFFFFFFFFFULL ) | ( uint64_t( gen & 0xFFFF ) << 48 );
+		size_t home = size_t( ( key * 0x9E3779B97F4A7C15ULL ) >> (64 - CACHE_BITS) );
+
+		for( unsigned i = 0; i < MAX_PROBES; ++i ) {
+			slot &s = cache[ (home + i) & (CACHE_SIZE - 1) ];
+			uint64_t k = s.key.load( std::memory_order_acquire );
+			if( k == key ) {
+				uint64_t rule = s.rule.load( std::memory_order_acquire );
+				if( s.key.load( std::memory_order_relaxed ) == key ) return rule;
+				break; // evicted meanwhile
+			}
+			if( !k ) break;
 		}
 
-		std::string callstack::flat( const char *format12, size_t skip_begin ) const {
-			std::vector<std::string> vec = str( format12, skip_begin );
-			std::string str;
-			for( std::vector<std::string>::const_iterator it = vec.begin(), end = vec.end(); it != end; ++it ) {
-				str += *it;
+		// slow path: find module and fde, then compile its rule
+		uint64_t rule = RULE_NONE;
+		modules_mutex.lock();
+		if( scanned != generation.load() ) refresh(); // something was unloaded; the table may be stale
+		const module *m = find_module( pc );
+		if( !m && refresh() ) m = find_module( pc );
+		if( m ) {
+			if( const uint8_t *fde = find_fde( m->hdr, pc ) ) rule = compile( fde, pc );
+		}
+		modules_mutex.unlock();
+		if( !m ) return rule; // unknown code; do not cache, it may be dlopen()ed later
+		if( generation.load() != gen ) return rule; // key is outdated already
+
+		for( unsigned i = 0; i < MAX_PROBES; ++i ) {
+			slot &s = cache[ (home + i) & (CACHE_SIZE - 1) ];
+			uint64_t k = s.key.load( std::memory_order_acquire );
+			if( k == key ) break;
+			if( ( !k || stale( k, key ) ) && s.key.compare_exchange_strong( k, PENDING ) ) {
+				s.rule.store( rule, std::memory_order_relaxed );
+				s.key.store( key, std::memory_order_release );
+				break;
 			}
-			return str;
 		}
+		return rule;
+	}
 
-std::vector<std::string> stacktrace( const char *format12, size_t skip_initial ) {
-	return callstack(true).str( format12, skip_initial );
+	// }
+
+	unsigned walk( uintptr_t pc, uintptr_t sp, uintptr_t bp, void **out_frames, unsigned max_frames, unsigned frames_to_skip ) {
+		uintptr_t lo, hi;
+		if( !stack_bounds( lo, hi ) ) return 0;
+
+		unsigned captured = 0;
+		for( bool first = true; captured < max_frames; first = false ) {
+			// return addresses point past the call; look the call itself up
+			uint64_t rule = lookup( first ? pc : pc - 1 );
+			unsigned base = base_of( rule );
+			if( base != RULE_RSP && base != RULE_RBP ) break;
+
+			uintptr_t cfa = ( base == RULE_RSP ? sp : bp ) + cfa_of( rule );
+			uintptr_t ra_at = cfa + ra_of( rule );
+			if( cfa < lo || cfa > hi || ra_at < lo || ra_at + sizeof(void *) > hi ) break;
+			uintptr_t ra = *(const uintptr_t *)ra_at;
+			if( rbp_of( rule ) ) {
+				uintptr_t bp_at = cfa + rbp_of( rule );
+				if( bp_at < lo || bp_at + sizeof(void *) > hi ) break;
+				bp = *(const uintptr_t *)bp_at;
+			}
+			if( !ra || cfa <= sp ) break;
+			sp = cfa;
+			pc = ra;
+			if( frames_to_skip ) --frames_to_skip;
+			else out_frames[ captured++ ] = (void *)ra;
+		}
+		return captured;
+	}
 }
 
-std::string stackstring( const char *format12, size_t skip_initial ) {
-	std::string out;
-	std::vector<std::string> stack = stacktrace( format12, skip_initial );
-	for( std::vector<std::string>::const_iterator it = stack.begin(), end = stack.end(); it != end; ++it ) {
-		out += *it;
-	}
-	return out;
+// unloads are learnt here rather than by asking the loader on every capture, which takes its lock.
+// bumped after the module is gone, so rules cached meanwhile carry the old generation and stop matching
+extern "C" int dlclose( void *handle ) throw() {
+	static int (*next)( void * ) = (int (*)( void * ))dlsym( RTLD_NEXT, "dlclose" );
+	int result = next ? next( handle ) : -1;
+	cfi::generation++;
+	return result;
 }
 
-// DIE
+#endif
 
-void die( const std::string &reason, int errorcode )
-{
-	if( !reason.empty() ) {
-		fail( reason );
-	}
+// SYMBOLIZER
+// Resolves addresses in-process, so reports never spawn addr2line. Modules are found with
+// dl_iterate_phdr() and mapped read-only the first time one of their addresses is looked up; then
+// .symtab (or .dynsym) becomes a sorted table of functions and .debug_line a sorted table of rows.
+// Every lookup is a couple of binary searches on link-time addresses (runtime address - load bias).
 
-	$windows(
-	FatalExit( errorcode );
-	)
+#if HEAL_HAS_ELF
 
-	// fallback
-	std::exit( errorcode );
-}
+namespace elf {
 
-void die( int errorcode, const std::string &reason )
-{
-	die( reason, errorcode );
-}
+	struct symbol {
+		uintptr_t lo, hi;           // link-time range; sizeless symbols end where the next one starts
+		const char *name;           // into the mapped string table
+	};
 
-// HEXDUMP
-// @todo: maxwidth != 80 doesnt work
+	struct file {
+		const char *dir, *name;     // into the mapped line tables
+	};
 
-std::string hexdump( const void *data, size_t num_bytes, const void *self )
-{
-#   ifdef _MSC_VER
-#       pragma warning( push )
-#       pragma warning( disable : 4996 )
-#       define $vsnprintf _vsnprintf
-#   else
-#       define $vsnprintf  vsnprintf
-#   endif
+	struct row {
+		uintptr_t addr;             // link-time address
+		unsigned file, line;        // line 0 ends a sequence
+	};
 
-	struct local {
-		static std::string format( const char *fmt, ... )
-		{
-			int len;
-			std::string self;
+	struct image {
+		std::string path, name;     // file mapped, and name shown in reports
+		std::string build_id;       // GNU build-id as hex, if the module has one
+		uintptr_t bias, lo, hi;     // load bias; runtime range of loadable segments
+		const uint8_t *data;
+		size_t size;
+		bool parsed, lines;         // lines: has its own .debug_line (not split into a separate debug file)
+		std::mutex lock;            // held while parsing
+		std::vector<symbol> symbols;
+		std::vector<file> files;
+		std::vector<row> rows;
+	};
 
-			using namespace std;
+	// bounded little-endian reader; reading past the end yields zeros and stays at the end
+	struct cursor {
+		const uint8_t *p, *end;
 
-			// Calculate the final length of the formatted string
-			{
-				va_list args;
-				va_start( args, fmt );
-				len = $vsnprintf( 0, 0, fmt, args );
-				va_end( args );
-			}
+		bool left( uint64_t n ) const {
+			return uint64_t( end - p ) >= n;
+		}
+		uint64_t fixed( unsigned n ) {
+			uint64_t v = 0;
+			if( n > 8 || !left( n ) ) return p = end, 0;
+			std::memcpy( &v, p, n );
+			return p += n, v;
+		}
+		uint64_t uleb() {
+			uint64_t r = 0;
+			unsigned shift = 0;
+			uint8_t b;
+			do { if( p >= end ) return r; b = *p++; if( shift < 64 ) r |= uint64_t(b & 0x7f) << shift; shift += 7; } while( b & 0x80 );
+			return r;
+		}
+		int64_t sleb() {
+			int64_t r = 0;
+			unsigned shift = 0;
+			uint8_t b;
+			do { if( p >= end ) return r; b = *p++; if( shift < 64 ) r |= int64_t(b & 0x7f) << shift; shift += 7; } while( b & 0x80 );
+			if( shift < 64 && (b & 0x40) ) r |= -(int64_t(1) << shift);
+			return r;
+		}
+		const char *str() {
+			const uint8_t *nul = (const uint8_t *)std::memchr( p, 0, end - p );
+			if( !nul ) return p = end, "";
+			const char *s = (const char *)p;
+			return p = nul + 1, s;
+		}
+	};
 
-			// Allocate a buffer (including room for null termination
-			char* target_string = new char[++len];
+	struct blob {
+		const uint8_t *data;
+		size_t size;
 
-			// Generate the formatted string
-			{
-				va_list args;
-				va_start( args, fmt );
-				$vsnprintf( target_string, len, fmt, args );
-				va_end( args );
-			}
+		const char *at( uint64_t offset ) const {
+			return offset < size && std::memchr( data + offset, 0, size - offset ) ? (const char *)data + offset : "";
+		}
+	};
 
-			// Assign the formatted string
-			self.assign( target_string );
+	// mapping {
 
-			// Clean up
-			delete [] target_string;
+	bool map( image &im ) {
+		int fd = open( im.path.c_str(), O_RDONLY | O_CLOEXEC );
+		if( fd < 0 )
+			return false;
+		struct stat st;
+		void *data = MAP_FAILED;
+		if( fstat( fd, &st ) == 0 && size_t( st.st_size ) >= sizeof(ElfW(Ehdr)) ) {
+			data = mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		}
+		close( fd );
+		if( data == MAP_FAILED )
+			return false;
+		const ElfW(Ehdr) &eh = *(const ElfW(Ehdr) *)data;
+		if( std::memcmp( eh.e_ident, ELFMAG, SELFMAG ) || eh.e_ident[EI_CLASS] != ( sizeof(void *) == 8 ? ELFCLASS64 : ELFCLASS32 ) ||
+			eh.e_shentsize != sizeof(ElfW(Shdr)) || eh.e_shstrndx >= eh.e_shnum ||
+			eh.e_shoff > size_t( st.st_size ) || eh.e_shnum > ( size_t( st.st_size ) - eh.e_shoff ) / sizeof(ElfW(Shdr)) ) {
+			munmap( data, st.st_size );
+			return false;
+		}
+		im.data = (const uint8_t *)data;
+		im.size = st.st_size;
+		return true;
+	}
 
-			return self;
+	// section contents, if they lie within the file and are stored uncompressed
+	blob contents( const image &im, const ElfW(Shdr) &sh ) {
+		blob b = { 0, 0 };
+		if( sh.sh_type != SHT_NOBITS && !( sh.sh_flags & SHF_COMPRESSED ) && sh.sh_offset <= im.size && sh.sh_size <= im.size - sh.sh_offset ) {
+			b.data = im.data + sh.sh_offset;
+			b.size = sh.sh_size;
 		}
-	};
+		return b;
+	}
 
-	unsigned maxwidth = 80;
-	unsigned width = 16; //column width
-	unsigned width_offset_block = (8 + 1);
-	unsigned width_chars_block  = (width * 3 + 1) + sizeof("asc");
-	unsigned width_hex_block    = (width * 3 + 1) + sizeof("hex");
-	unsigned width_padding = (std::max)( 0, int( maxwidth - ( width_offset_block + width_chars_block + width_hex_block ) ) );
-	unsigned blocks = width_padding / ( width_chars_block + width_hex_block ) ;
+	// }
 
-	unsigned dumpsize = ( num_bytes < width * 16 ? num_bytes : width * 16 ); //16 lines max
+	// symbols {
 
-	std::string result;
+	bool by_lo( const symbol &a, const symbol &b ) {
+		return a.lo < b.lo;
+	}
+	bool below_symbol( uintptr_t addr, const symbol &s ) {
+		return addr < s.lo;
+	}
 
-	result += local::format( "%-*s %-.*s [ptr=%p sz=%d]\n", width_offset_block - 1, "offset", width_chars_block - 1, "00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F", self ? self : data, num_bytes );
+	void load_symbols( image &im, const ElfW(Shdr) *sh, unsigned count, unsigned type ) {
+		for( unsigned i = 0; i < count; ++i ) {
+			if( sh[i].sh_type != type || sh[i].sh_link >= count || sh[i].sh_entsize != sizeof(ElfW(Sym)) )
+				continue;
+			blob table = contents( im, sh[i] ), names = contents( im, sh[ sh[i].sh_link ] );
+			const ElfW(Sym) *sym = (const ElfW(Sym) *)table.data;
+			for( size_t j = 0, n = table.size / sizeof(ElfW(Sym)); j < n; ++j ) {
+				unsigned kind = ELF32_ST_TYPE( sym[j].st_info ); // same in both classes
+				if( ( kind == STT_FUNC || kind == STT_GNU_IFUNC ) && sym[j].st_shndx != SHN_UNDEF && sym[j].st_value ) {
+					symbol s = { uintptr_t( sym[j].st_value ), uintptr_t( sym[j].st_value + sym[j].st_size ), names.at( sym[j].st_name ) };
+					im.symbols.push_back( s );
+				}
+			}
+		}
+	}
 
-	if( !num_bytes )
-		return result;
+	void sort_symbols( image &im ) {
+		std::vector<symbol> &s = im.symbols;
+		std::stable_sort( s.begin(), s.end(), by_lo );
+		size_t kept = 0;
+		for( size_t i = 0; i < s.size(); ++i ) {
+			if( kept && s[kept - 1].lo == s[i].lo ) { // aliases; keep the sized one
+				if( s[i].hi > s[kept - 1].hi ) s[kept - 1].hi = s[i].hi;
+				continue;
+			}
+			s[ kept++ ] = s[i];
+		}
+		s.resize( kept );
+		for( size_t i = 0; i < s.size(); ++i ) {
+			if( s[i].hi == s[i].lo ) s[i].hi = i + 1 < s.size() ? s[i + 1].lo : s[i].lo + 1;
+		}
+	}
 
-	blocks++;
+	const symbol *find_symbol( const image &im, uintptr_t addr ) {
+		std::vector<symbol>::const_iterator it = std::upper_bound( im.symbols.begin(), im.symbols.end(), addr, below_symbol );
+		if( it == im.symbols.begin() ) return 0;
+		--it;
+		return addr < it->hi ? &*it : 0;
+	}
 
-	const unsigned char *p = reinterpret_cast<const unsigned char *>( data );
-	size_t i = 0;
+	// }
+
+	// line tables {
+
+	enum { DW_LNCT_path = 1, DW_LNCT_directory_index = 2 };
+
+	// reads one attribute of a dwarf 5 directory or file entry. false on forms that cannot be skipped
+	bool attribute( cursor &c, uint64_t form, bool dwarf64, const blob &str, const blob &line_str, const char *&text, uint64_t &num ) {
+		switch( form ) {
+			case 0x08: text = c.str(); return true;                                      // DW_FORM_string
+			case 0x0e: text = str.at( c.fixed( dwarf64 ? 8 : 4 ) ); return true;         // DW_FORM_strp
+			case 0x1f: text = line_str.at( c.fixed( dwarf64 ? 8 : 4 ) ); return true;    // DW_FORM_line_strp
+			case 0x0b: num = c.fixed( 1 ); return true;                                  // DW_FORM_data1
+			case 0x05: num = c.fixed( 2 ); return true;                                  // DW_FORM_data2
+			case 0x06: num = c.fixed( 4 ); return true;                                  // DW_FORM_data4
+			case 0x07: num = c.fixed( 8 ); return true;                                  // DW_FORM_data8
+			case 0x0f: num = c.uleb(); return true;                                      // DW_FORM_udata
+			case 0x1e: c.p = c.left( 16 ) ? c.p + 16 : c.end; return true;              // DW_FORM_data16
+			case 0x09: num = c.uleb(); c.p = c.left( num ) ? c.p + num : c.end; return true; // DW_FORM_block
+			default: return false;
+		}
+	}
 
-	while( i < dumpsize )
-	{
-		//offset block
-		result += local::format("%p ", (size_t)(p + i) ); //%08x, %08zx
+	// dwarf 5 directory or file table; paths and directory indices of every entry
+	bool entries( cursor &c, bool dwarf64, const blob &str, const blob &line_str, std::vector<const char *> &paths, std::vector<uint64_t> &dirs ) {
+		uint64_t format[ 32 ];
+		unsigned formats = unsigned( c.fixed( 1 ) );
+		if( formats > 16 ) return false;
+		for( unsigned i = 0; i < formats; ++i ) {
+			format[ i * 2 + 0 ] = c.uleb();
+			format[ i * 2 + 1 ] = c.uleb();
+		}
+		for( uint64_t n = c.uleb(); n-- && c.p < c.end; ) {
+			const char *path = "";
+			uint64_t dir = 0;
+			for( unsigned i = 0; i < formats; ++i ) {
+				const char *text = "";
+				uint64_t num = 0;
+				if( !attribute( c, format[ i * 2 + 1 ], dwarf64, str, line_str, text, num ) ) return false;
+				if( format[ i * 2 ] == DW_LNCT_path ) path = text;
+				if( format[ i * 2 ] == DW_LNCT_directory_index ) dir = num;
+			}
+			paths.push_back( path );
+			dirs.push_back( dir );
+		}
+		return true;
+	}
 
-		//chars blocks
-		for( unsigned b = 0; b < blocks; b++)
-		{
-			for( unsigned c = 0 ; c < width ; c++ )
-				result += local::format(" %c ", i + c >= dumpsize ? '.' : p[i + c] < 32 || p[i + c] >= 127 ? '.' : p[i + c]);
+	void load_lines( image &im, const blob &lines, const blob &str, const blob &line_str ) {
+		cursor all = { lines.data, lines.data + lines.size };
+		while( all.left( 4 ) ) {
+			uint64_t length = all.fixed( 4 );
+			bool dwarf64 = length == 0xffffffff;
+			if( dwarf64 ) length = all.fixed( 8 );
+			if( !all.left( length ) ) return;
+			cursor unit = { all.p, all.p + length };
+			all.p += length;
+
+			unsigned version = unsigned( unit.fixed( 2 ) );
+			if( version < 2 || version > 5 ) continue;
+			if( version >= 5 ) unit.fixed( 2 ); // address and segment selector sizes
+			uint64_t header_length = unit.fixed( dwarf64 ? 8 : 4 );
+			if( !unit.left( header_length ) ) continue;
+			const uint8_t *program = unit.p + header_length;
+			unsigned min_inst = unsigned( unit.fixed( 1 ) );
+			if( version >= 4 ) unit.fixed( 1 ); // maximum operations per instruction; vliw only
+			unit.fixed( 1 ); // default is_stmt; every row is kept, as addr2line does
+			int line_base = int8_t( unit.fixed( 1 ) );
+			unsigned line_range = unsigned( unit.fixed( 1 ) );
+			unsigned opcode_base = unsigned( unit.fixed( 1 ) );
+			if( !line_range || !opcode_base ) continue;
+			uint8_t lengths[ 256 ] = { 0 };
+			for( unsigned i = 1; i < opcode_base; ++i ) lengths[i] = uint8_t( unit.fixed( 1 ) );
+
+			// file table of this unit, appended to the image's. numbering starts at 1 before dwarf 5
+			std::vector<const char *> dirs, paths;
+			std::vector<uint64_t> indices, unused;
+			if( version < 5 ) {
+				dirs.push_back( "" ); // compilation directory; it lives in .debug_info
+				for( const char *d; *( d = unit.str() ); ) dirs.push_back( d );
+				paths.push_back( "" );
+				indices.push_back( 0 );
+				for( const char *f; *( f = unit.str() ); ) {
+					indices.push_back( unit.uleb() );
+					unit.uleb(); // modification time
+					unit.uleb(); // length
+					paths.push_back( f );
+				}
+			} else if( !entries( unit, dwarf64, str, line_str, dirs, unused ) || !entries( unit, dwarf64, str, line_str, paths, indices ) ) {
+				continue;
+			}
+			unsigned first = unsigned( im.files.size() );
+			for( size_t i = 0; i < paths.size(); ++i ) {
+				file f = { indices[i] < dirs.size() ? dirs[ indices[i] ] : "", paths[i] };
+				im.files.push_back( f );
+			}
 
-			result += "asc\n";
+			// line number program
+			unit.p = program;
+			uintptr_t addr = 0;
+			unsigned fileno = 1, line = 1;
+			bool live = true; // sequences of code discarded at link time start at 0 (or ~0)
+			size_t sequence = im.rows.size();
+			while( unit.p < unit.end ) {
+				uint8_t op = uint8_t( unit.fixed( 1 ) );
+				bool emit = false;
+				if( op >= opcode_base ) {
+					unsigned adjusted = op - opcode_base;
+					addr += ( adjusted / line_range ) * min_inst;
+					line += line_base + int( adjusted % line_range );
+					emit = true;
+				}
+				else if( op == 0 ) {
+					uint64_t len = unit.uleb();
+					if( !len || !unit.left( len ) ) break;
+					const uint8_t *next = unit.p + len;
+					uint8_t sub = uint8_t( unit.fixed( 1 ) );
+					if( sub == 1 ) { // DW_LNE_end_sequence
+						while( im.rows.size() > sequence && im.rows.back().addr >= addr ) {
+							im.rows.pop_back(); // empty rows, which would hide the end
+						}
+						if( live ) {
+							row r = { addr, ~0u, 0 };
+							im.rows.push_back( r );
+						}
+						addr = 0, fileno = 1, line = 1, live = true;
+						sequence = im.rows.size();
+					}
+					else if( sub == 2 ) { // DW_LNE_set_address
+						addr = uintptr_t( unit.fixed( unsigned( len - 1 ) ) );
+						live = addr != 0 && addr != ~uintptr_t(0);
+					}
+					unit.p = next;
+				}
+				else switch( op ) {
+					case 1: emit = true; break;                                                     // DW_LNS_copy
+					case 2: addr += uintptr_t( unit.uleb() ) * min_inst; break;                     // DW_LNS_advance_pc
+					case 3: line += int( unit.sleb() ); break;                                      // DW_LNS_advance_line
+					case 4: fileno = unsigned( unit.uleb() ); break;                                // DW_LNS_set_file
+					case 8: addr += ( ( 255 - opcode_base ) / line_range ) * min_inst; break;       // DW_LNS_const_add_pc
+					case 9: addr += uintptr_t( unit.fixed( 2 ) ); break;                            // DW_LNS_fixed_advance_pc
+					default: for( unsigned i = 0; i < lengths[ op ]; ++i ) unit.uleb();             // operands ignored
+				}
+				if( emit && live && line ) {
+					row r = { addr, fileno < paths.size() ? first + fileno : ~0u, line };
+					im.rows.push_back( r );
+				}
+			}
 		}
+	}
 
-		//offset block
-		result += local::format("%p ", (size_t)(p + i) ); //%08x, %08zx
+	// sequence ends go first, so a sequence starting where another one ends wins the lookup
+	bool by_addr( const row &a, const row &b ) {
+		return a.addr < b.addr || ( a.addr == b.addr && !a.line && b.line );
+	}
+	bool below_row( uintptr_t addr, const row &r ) {
+		return addr < r.addr;
+	}
 
-		//hex blocks
-		for( unsigned b = 0; b < blocks; b++)
-		{
-			for( unsigned c = 0; c < width ; c++)
-				result += local::format( i + c < dumpsize ? "%02x " : "?? ", p[i + c]);
+	const row *find_row( const image &im, uintptr_t addr ) {
+		std::vector<row>::const_iterator it = std::upper_bound( im.rows.begin(), im.rows.end(), addr, below_row );
+		if( it == im.rows.begin() ) return 0;
+		--it;
+		return it->line && it->file != ~0u ? &*it : 0;
+	}
 
-			result += "hex\n";
+	// }
+
+	void parse( image &im ) {
+		im.parsed = true;
+		if( !map( im ) )
+			return;
+		const ElfW(Ehdr) &eh = *(const ElfW(Ehdr) *)im.data;
+		const ElfW(Shdr) *sh = (const ElfW(Shdr) *)( im.data + eh.e_shoff );
+		load_symbols( im, sh, eh.e_shnum, SHT_SYMTAB );
+		if( im.symbols.empty() ) {
+			load_symbols( im, sh, eh.e_shnum, SHT_DYNSYM ); // stripped
+		}
+		sort_symbols( im );
+
+		blob names = contents( im, sh[ eh.e_shstrndx ] ), lines = { 0, 0 }, str = { 0, 0 }, line_str = { 0, 0 };
+		for( unsigned i = 0; i < eh.e_shnum; ++i ) {
+			const char *name = names.at( sh[i].sh_name );
+			/**/ if( !std::strcmp( name, ".debug_line" ) )     lines = contents( im, sh[i] );
+			else if( !std::strcmp( name, ".debug_str" ) )      str = contents( im, sh[i] );
+			else if( !std::strcmp( name, ".debug_line_str" ) ) line_str = contents( im, sh[i] );
+		}
+		im.lines = lines.size != 0;
+		if( lines.size ) {
+			load_lines( im, lines, str, line_str );
+			std::stable_sort( im.rows.begin(), im.rows.end(), by_addr );
 		}
+	}
 
-		//next line
-		//result += '\n';
-		i += width * blocks;
+	// modules {
+
+	std::mutex images_mutex;
+
+	// never destroyed, since reports are also made from atexit() handlers
+	std::vector<image *> &loaded() {
+		static std::vector<image *> *images = new std::vector<image *>();
+		return *images;
 	}
 
-	return result;
+	int collect( struct dl_phdr_info *info, size_t, void *data ) {
+		std::vector<image *> &found = *(std::vector<image *> *)data;
+		image *im = new image();
+		im->path = info->dlpi_name && info->dlpi_name[0] ? info->dlpi_name : "/proc/self/exe";
+		im->bias = info->dlpi_addr;
+		im->lo = ~uintptr_t(0);
+		im->hi = 0;
+		im->data = 0;
+		im->size = 0;
+		im->parsed = false;
+		im->lines = false;
+		for( unsigned i = 0; i < info->dlpi_phnum; ++i ) {
+			const ElfW(Phdr) &ph = info->dlpi_phdr[i];
+			if( ph.p_type == PT_LOAD ) {
+				im->lo = std::min( im->lo, uintptr_t( info->dlpi_addr + ph.p_vaddr ) );
+				im->hi = std::max( im->hi, uintptr_t( info->dlpi_addr + ph.p_vaddr + ph.p_memsz ) );
+			}
+			if( ph.p_type == PT_NOTE && im->build_id.empty() ) {
+				// notes are loaded, so they are read in place: header, name and desc, each 4-byte aligned
+				cursor c = { (const uint8_t *)( info->dlpi_addr + ph.p_vaddr ), (const uint8_t *)( info->dlpi_addr + ph.p_vaddr + ph.p_memsz ) };
+				while( c.left( 12 ) ) {
+					uint32_t namesz = uint32_t( c.fixed( 4 ) ), descsz = uint32_t( c.fixed( 4 ) ), type = uint32_t( c.fixed( 4 ) );
+					uint64_t skip = ( uint64_t( namesz ) + 3 ) & ~3ull;
+					if( !c.left( skip + descsz ) ) break;
+					const uint8_t *name = c.p, *desc = c.p + skip;
+					c.p = c.left( skip + ( ( uint64_t( descsz ) + 3 ) & ~3ull ) ) ? desc + ( ( descsz + 3 ) & ~3u ) : c.end;
+					if( type == NT_GNU_BUILD_ID && namesz == 4 && !std::memcmp( name, "GNU", 4 ) ) {
+						static const char hex[] = "0123456789abcdef";
+						for( uint32_t b = 0; b < descsz; ++b ) {
+							im->build_id += hex[ desc[b] >> 4 ];
+							im->build_id += hex[ desc[b] & 15 ];
+						}
+						break;
+					}
+				}
+			}
+		}
+		found.push_back( im );
+		return 0;
+	}
 
-#   undef $vsnprintf
-#   ifdef _MSC_VER
-#       pragma warning( pop )
-#   endif
-}
+	// rescans loaded modules. images that are still loaded are kept; images_mutex must be held.
+	// images of unloaded modules are dropped but never freed, since a batch may still be resolving them
+	void refresh() {
+		std::vector<image *> &images = loaded(), found;
+		dl_iterate_phdr( collect, &found );
+		for( size_t i = 0; i < found.size(); ++i ) {
+			for( size_t j = 0; j < images.size(); ++j ) {
+				if( images[j] && images[j]->path == found[i]->path && images[j]->bias == found[i]->bias ) {
+					delete found[i];
+					found[i] = images[j];
+					images[j] = 0;
+					break;
+				}
+			}
+		}
+		images.swap( found );
+	}
 
-std::string timestamp() {
-	std::stringstream ss;
-	ss << __TIMESTAMP__;
-	return ss.str();
-}
+	image *find_image( uintptr_t pc ) {
+		const std::vector<image *> &images = loaded();
+		for( size_t i = 0; i < images.size(); ++i ) {
+			if( pc >= images[i]->lo && pc < images[i]->hi ) return images[i];
+		}
+		return 0;
+	}
 
-/*
- * Simple prompt dialog (based on legolas558's code). zlib/libpng license.
- * - rlyeh
- */
+	// }
 
-#if !$on($windows)
+	std::string pretty( const char *name ) {
+		int status = -1;
+		char *demangled = name[0] == '_' && name[1] == 'Z' ? abi::__cxa_demangle( name, 0, 0, &status ) : 0;
+		std::string out = status == 0 && demangled ? demangled : name;
+		if( demangled ) free( demangled );
+		return out;
+	}
 
-std::string prompt( const std::string &current_value, const std::string &title, const std::string &caption )
-{
-	std::string out;
+	std::string offset( uintptr_t addr ) {
+		char text[ 32 ];
+		std::snprintf( text, sizeof(text), "+0x%llx", (unsigned long long)addr ); // for offline tools
+		return text;
+	}
 
-	if( has("whiptail") && false )
-	{
-		std::string out = pipe( std::string() +
-			"/usr/bin/whiptail 3>&1 1>&2 2>&3 --title \"" +title+ "\" --inputbox \"" +caption+ "\" 0 0 \"" +current_value+ "\"" );
+	// module an address belongs to, if any
+	image *locate( const void *ptr ) {
+		std::lock_guard<std::mutex> lock( images_mutex );
+		uintptr_t pc = (uintptr_t)ptr;
+		image *im = find_image( pc );
+		if( !im ) {
+			refresh(); // dlopen()ed since last time
+			im = find_image( pc );
+		}
+		return im;
 	}
-	else
-	{
-		if( title.size() && caption.size() )
-			fprintf(stdout, "%s", title.c_str());
-		else
-			fprintf(stdout, "%s", title.empty() ? caption.c_str() : title.c_str());
 
-		if( !current_value.empty() )
-			fprintf(stdout, " (enter defaults to '%s')", current_value.c_str());
+	// parses a module on first use. tables are read-only afterwards, so lookups need no locking
+	void prepare( image &im ) {
+		std::lock_guard<std::mutex> lock( im.lock );
+		if( im.parsed )
+			return;
+		if( im.path == "/proc/self/exe" ) {
+			char exe[ 4096 ];
+			ssize_t len = readlink( im.path.c_str(), exe, sizeof(exe) - 1 );
+			if( len > 0 ) im.name.assign( exe, len );
+		}
+		if( im.name.empty() ) im.name = im.path;
+		parse( im );
+	}
 
-		fprintf(stdout, "%s", "\n");
+	// "function (file:line)" when debug info is there, "function ([module]+0xoffset)" otherwise.
+	// module must be prepared; returns whether a line was found
+	bool lookup( const image &im, const void *ptr, std::string &out ) {
+		uintptr_t addr = (uintptr_t)ptr - im.bias;
+		const symbol *s = find_symbol( im, addr );
+		// frames are return addresses, which may belong to the next line (or to nothing, after a noreturn call)
+		const row *r = find_row( im, s && addr > s->lo ? addr - 1 : addr );
+		std::string name = s ? pretty( s->name ) : std::string( "????" );
+		if( r ) {
+			const file &f = im.files[ r->file ];
+			std::string path = f.dir[0] && f.name[0] != '/' ? std::string( f.dir ) + "/" + f.name : std::string( f.name );
+			out = heal::sfstring( "\1 (\2:\3)", name, path, r->line );
+			return true;
+		}
+		out = heal::sfstring( "\1 ([\2]\3)", name, im.name, offset( addr ) );
+		return false;
+	}
 
-		std::getline( std::cin, out );
+	// empty if unknown
+	std::string symbolize( const void *ptr ) {
+		std::string out;
+		if( image *im = locate( ptr ) ) {
+			prepare( *im );
+			lookup( *im, ptr, out );
+		}
+		return out;
+	}
 
-		if( out.empty() )
-			out = current_value;
+	// dynamic symbols only, for addresses outside the scanned modules. an address past the end of the
+	// symbol dladdr() picked is not part of it, so only the module offset is told then; empty if unknown
+	std::string describe( const void *ptr ) {
+		Dl_info info;
+		const ElfW(Sym) *sym = 0;
+		if( !dladdr1( ptr, &info, (void **)&sym, RTLD_DL_SYMENT ) || !info.dli_fname )
+			return std::string();
+		uintptr_t pc = (uintptr_t)ptr;
+		std::string module = heal::sfstring( "[\1]\2", info.dli_fname, offset( pc - (uintptr_t)info.dli_fbase ) );
+		if( info.dli_sname && sym && pc - (uintptr_t)info.dli_saddr < sym->st_size )
+			return heal::sfstring( "\1 (\2)", pretty( info.dli_sname ), module );
+		return module;
 	}
 
-	return out;
-}
+	// external symbolizer {
 
-#endif
+	// any addr2line-compatible command (llvm-addr2line, eu-addr2line...); empty disables it.
+	// only asked about modules with no line tables of their own, whose debug info lives elsewhere
+	const char *fallback = "addr2line";
 
-#if $on($msvc)
-#   pragma warning( push )
-#   pragma warning( disable : 4996 )
-#endif
+	struct feeder {
+		int fd;
+		std::string text;
+		void operator()() {
+			for( size_t sent = 0; sent < text.size(); ) {
+				ssize_t n = write( fd, text.data() + sent, text.size() - sent );
+				if( n <= 0 ) break;
+				sent += n;
+			}
+			close( fd );
+		}
+	};
 
-#if $on($windows)
-#   pragma comment(lib,"user32.lib")
-#   pragma comment(lib,"gdi32.lib")
-//$warning("<heal/heal.cpp> says: dialog aware dpi fix (@todo)")
+	// one process per module: addresses are written from a thread while replies are read here, so
+	// neither side blocks on a full pipe. outputs are only touched for frames that got a function or
+	// a line, and *found (if given) flags the ones that got a line
+	void external( const image &im, const std::vector<void *> &frames, const std::vector<std::string *> &outputs, std::vector<char> *found = 0 ) {
+		if( !fallback || !fallback[0] || !im.data || frames.empty() )
+			return;
+		int in[2], out[2];
+		if( pipe2( in, O_CLOEXEC ) )
+			return;
+		if( pipe2( out, O_CLOEXEC ) ) {
+			close( in[0] ), close( in[1] );
+			return;
+		}
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init( &actions );
+		posix_spawn_file_actions_adddup2( &actions, in[0], 0 );
+		posix_spawn_file_actions_adddup2( &actions, out[1], 1 );
+		posix_spawn_file_actions_addopen( &actions, 2, "/dev/null", O_WRONLY, 0 );
+		std::string module = im.name;
+		char *argv[] = { (char *)fallback, (char *)"-f", (char *)"-C", (char *)"-e", &module[0], 0 };
+		pid_t pid;
+		int failed = posix_spawnp( &pid, fallback, &actions, 0, argv, environ );
+		posix_spawn_file_actions_destroy( &actions );
+		close( in[0] ), close( out[1] );
+		if( failed ) {
+			close( in[1] ), close( out[0] );
+			return;
+		}
 
-std::string prompt( const std::string &current_value, const std::string &title, const std::string &caption )
-{
-	class InputBox
-	{
-		private:
+		feeder feed;
+		feed.fd = in[1];
+		for( size_t i = 0; i < frames.size(); ++i ) {
+			uintptr_t addr = (uintptr_t)frames[i] - im.bias;
+			char line[ 32 ];
+			std::snprintf( line, sizeof(line), "%llx\n", (unsigned long long)( addr ? addr - 1 : addr ) );
+			feed.text += line;
+		}
+		std::thread writer( feed );
 
-		HWND                hwndParent,
-							hwndInputBox,
-							hwndQuery,
-							hwndOk,
-							hwndCancel,
-							hwndEditBox;
-		LPSTR               szInputText;
-		WORD                wInputMaxLength, wInputLength;
-		bool                bRegistered,
-							bResult;
+		std::string reply;
+		char buf[ 4096 ];
+		for( ssize_t n; ( n = read( out[0], buf, sizeof(buf) ) ) > 0 || ( n < 0 && errno == EINTR ); ) {
+			if( n > 0 ) reply.append( buf, n );
+		}
+		close( out[0] );
+		writer.join();
+		int status;
+		while( waitpid( pid, &status, 0 ) < 0 && errno == EINTR ) {
+		}
 
-		HINSTANCE           hThisInstance;
+		// two lines per address: function, then file:line
+		std::stringstream ss( reply );
+		for( size_t i = 0; i < frames.size(); ++i ) {
+			std::string fn, where;
+			if( !std::getline( ss, fn ) || !std::getline( ss, where ) )
+				break;
+			size_t discriminator = where.find( " (discriminator" );
+			if( discriminator != std::string::npos ) where.resize( discriminator );
+			size_t colon = where.rfind( ':' );
+			bool known = colon != std::string::npos && where.compare( 0, 2, "??" ) && where[ colon + 1 ] >= '1' && where[ colon + 1 ] <= '9';
+			if( known ) {
+				*outputs[i] = heal::sfstring( "\1 (\2)", fn, where );
+				if( found ) (*found)[i] = 1;
+			} else if( fn != "??" ) {
+				*outputs[i] = heal::sfstring( "\1 ([\2]\3)", fn, im.name, offset( (uintptr_t)frames[i] - im.bias ) );
+			}
+		}
+	}
 
-		enum
-		{
-			CIB_SPAN = 10,
-			CIB_LEFT_OFFSET = 6,
-			CIB_TOP_OFFSET = 4,
-			CIB_WIDTH = 300,
-			CIB_HEIGHT = 130,
-			CIB_BTN_WIDTH = 60,
-			CIB_BTN_HEIGHT = 20
-		};
+	// }
+}
 
-		public:
+#endif
 
-#       define CIB_CLASS_NAME   "CInputBoxA"
+// CALLSTACK
 
-		static LRESULT CALLBACK CIB_WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
-		{
-			InputBox *self;
-			self = (InputBox *)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+		callstack::callstack( bool autosave ) {
+			if( autosave ) save();
+		}
 
-			switch (msg)
-			{
-				case WM_CREATE:
-					self = (InputBox *) ((CREATESTRUCT *)lParam)->lpCreateParams;
-					SetWindowLongPtr(hWnd, GWLP_USERDATA, (LONG_PTR)self);
-					self->create(hWnd);
-				break;
-				case WM_COMMAND:
-					switch(LOWORD(wParam)) {
-						case IDOK:
-							self->submit();
-						case IDCANCEL:
-							self->close();
-						break;
-					}
-					break;
-				case WM_CLOSE:
-					self->close();
-					return 0;
-				case WM_DESTROY:
-					self->destroy();
-					break;
-			}
-			return(DefWindowProc (hWnd, msg, wParam, lParam));
+		size_t callstack::space() const {
+			return sizeof(frames) + sizeof(void *) * frames.size();
 		}
 
-		InputBox( HINSTANCE hInst ) :
-			hwndParent(0),
-			hwndInputBox(0),
-			hwndQuery(0),
-			hwndOk(0),
-			hwndCancel(0),
-			hwndEditBox(0),
-			szInputText(0),
-			wInputMaxLength(0), wInputLength(0),
-			bRegistered(false),
-			bResult(false),
-			hThisInstance(hInst)
-		{
-			WNDCLASSEXA wndInputBox;
-			RECT rect;
-
-			memset(&wndInputBox, 0, sizeof(WNDCLASSEXA));
-
-			hThisInstance = hInst;
-
-			wndInputBox.cbSize                  = sizeof(wndInputBox);
-			wndInputBox.lpszClassName           = CIB_CLASS_NAME;
-			wndInputBox.style                   = CS_HREDRAW | CS_VREDRAW;
-			wndInputBox.lpfnWndProc             = CIB_WndProc;
-			wndInputBox.lpszMenuName            = NULL;
-			wndInputBox.hIconSm                 = NULL;
-			wndInputBox.cbClsExtra              = 0;
-			wndInputBox.cbWndExtra              = 0;
-			wndInputBox.hInstance               = hInst;
-			wndInputBox.hIcon                   = LoadIcon(NULL, IDI_WINLOGO);
-			wndInputBox.hCursor                 = LoadCursor(NULL, IDC_ARROW);
-			wndInputBox.hbrBackground           = (HBRUSH)(COLOR_WINDOW);
-
-			RegisterClassExA(&wndInputBox);
+		void callstack::save( unsigned frames_to_skip ) {
 
-			if (hwndParent)
-				GetWindowRect(hwndParent, &rect); //always false?
-			else
-				GetWindowRect(GetDesktopWindow(), &rect);
+			if( frames_to_skip > max_frames )
+				return;
 
-			hwndInputBox = CreateWindowA( CIB_CLASS_NAME, "",
-							(WS_BORDER | WS_CAPTION), rect.left+(rect.right-rect.left-CIB_WIDTH)/2,
-							rect.top+(rect.bottom-rect.top-CIB_HEIGHT)/2,
-							CIB_WIDTH, CIB_HEIGHT, hwndParent, NULL,
-							hThisInstance, this);
+			// capture into a local buffer, then commit to frames with a single allocation
+			void *out_frames[ max_frames ];
+			unsigned captured = capture( out_frames, max_frames, frames_to_skip + 1 );
+			frames.assign( out_frames, out_frames + captured );
 		}
 
-		void destroy()
-		{
-			EnableWindow(hwndParent, true);
-			SendMessage(hwndInputBox, WM_CLOSE/*WM_DESTROY*/, 0, 0);
-		}
+		volatile int callstack::unwinder = HEAL_UNWINDER;
 
-		~InputBox()
-		{
-			UnregisterClassA(CIB_CLASS_NAME, hThisInstance);
+		unsigned callstack::capture_fp( void **out_frames, unsigned max_frames, unsigned frames_to_skip ) {
+			return walk_frames( (uintptr_t)__builtin_frame_address(0), out_frames, max_frames, frames_to_skip );
 		}
 
-		void submit()
-		{
-			wInputLength = (int)SendMessage(hwndEditBox, EM_LINELENGTH, 0, 0);
-			if (wInputLength) {
-				*((LPWORD)szInputText) = wInputMaxLength;
-				wInputLength = (WORD)SendMessage(hwndEditBox, EM_GETLINE, 0, (LPARAM)szInputText);
-			}
-			szInputText[wInputLength] = '\0';
-			bResult = true;
+		unsigned callstack::walk_frames( uintptr_t fp, void **out_frames, unsigned max_frames, unsigned frames_to_skip ) {
+			$linux({
+				uintptr_t stack_lo, stack_hi;
+				if( !stack_bounds( stack_lo, stack_hi ) )
+					return 0;
+
+				// frame layout: fp[0] is caller's frame pointer, fp[1] is return address
+				unsigned captured = 0;
+				while( captured < max_frames ) {
+					if( fp < stack_lo || fp + 2 * sizeof(void *) > stack_hi || fp % sizeof(void *) )
+						break;
+					void **frame = (void **)fp;
+					void *ret = frame[1];
+					uintptr_t next = (uintptr_t)frame[0];
+					if( !ret )
+						break;
+					if( frames_to_skip ) --frames_to_skip;
+					else out_frames[ captured++ ] = ret;
+					// stack grows downwards; callers always live above
+					if( next <= fp )
+						break;
+					fp = next;
+				}
+				return captured;
+			})
+			return 0;
 		}
 
-		void create(HWND hwndNew)
-		{
-			static HFONT myFont = NULL;
+		unsigned callstack::capture( void **out_frames, unsigned max_frames, unsigned frames_to_skip, int how ) {
 
-			if( myFont != NULL )
-			{
-				DeleteObject( myFont );
-				myFont = NULL;
-			}
+			if( frames_to_skip > max_frames )
+				return 0;
 
-			hwndInputBox = hwndNew;
+			const int use = how < 0 ? int( unwinder ) : how;
 
-			NONCLIENTMETRICS ncm;
-			ncm.cbSize = sizeof(NONCLIENTMETRICS);
+			$linux(
+				if( use == UNWIND_FRAME_POINTERS )
+					return walk_frames( (uintptr_t)__builtin_frame_address(0), out_frames, max_frames, frames_to_skip );
+			)
+#if HEAL_HAS_CFI
+			if( use == UNWIND_DWARF ) {
+				// registers are read together, so they match the cfi row at this very instruction
+				uintptr_t pc, sp, bp;
+				__asm__ __volatile__( "lea 0(%%rip), %0\n\tmov %%rsp, %1\n\tmov %%rbp, %2" : "=r"(pc), "=r"(sp), "=r"(bp) );
+				return cfi::walk( pc, sp, bp, out_frames, max_frames, frames_to_skip );
+			}
+#endif
 
-			if (SystemParametersInfo(SPI_GETNONCLIENTMETRICS, sizeof(NONCLIENTMETRICS), &ncm, 0))
-			{
-#if 0
-				LOGFONT lf;
-				memset(&lf,0,sizeof(LOGFONT));
+			$windows({
+				unsigned short capturedFrames = 0;
 
-				lf.lfWeight= FW_NORMAL;
-				lf.lfCharSet= ANSI_CHARSET;
-				//lf.lfPitchAndFamily = 35;
-				lf.lfHeight= 10;
-				strcpy(lf.lfFaceName, "Tahoma");
-				myFont=CreateFontIndirect(&lf);
-#else
-				myFont = CreateFontIndirect(&ncm.lfMessageFont);
-#endif
-			}
-			else
-			{
-				myFont = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
-			}
+				// RtlCaptureStackBackTrace is only available on Windows XP or newer versions of Windows
+				typedef WORD(NTAPI FuncRtlCaptureStackBackTrace)(DWORD, DWORD, PVOID *, PDWORD);
 
-			//  SetWindowPos(hwndInputBox, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
-			hwndQuery = CreateWindowA("Static", "", WS_CHILD | WS_VISIBLE,
-									CIB_LEFT_OFFSET, CIB_TOP_OFFSET,
-									CIB_WIDTH-CIB_LEFT_OFFSET*2, CIB_BTN_HEIGHT*2,
-									hwndInputBox, NULL,
-									hThisInstance, NULL);
-			hwndEditBox = CreateWindowA("Edit", "", WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL | ES_LEFT, CIB_LEFT_OFFSET,
-									CIB_TOP_OFFSET + CIB_BTN_HEIGHT*2, CIB_WIDTH-CIB_LEFT_OFFSET*3, CIB_BTN_HEIGHT,
-									hwndInputBox,   NULL,
-									hThisInstance, NULL);
-			hwndOk = CreateWindowA("Button", "OK", WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_PUSHBUTTON,
-									CIB_WIDTH/2 - CIB_SPAN*2 - CIB_BTN_WIDTH, CIB_HEIGHT - CIB_TOP_OFFSET*4 - CIB_BTN_HEIGHT*2,
-									CIB_BTN_WIDTH, CIB_BTN_HEIGHT, hwndInputBox, (HMENU)IDOK,
-									hThisInstance, NULL);
-			hwndCancel = CreateWindowA("Button", "Cancel",
-									WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_PUSHBUTTON,
-									CIB_WIDTH/2 + CIB_SPAN, CIB_HEIGHT - CIB_TOP_OFFSET*4 - CIB_BTN_HEIGHT*2,  CIB_BTN_WIDTH, CIB_BTN_HEIGHT,
-									hwndInputBox, (HMENU)IDCANCEL,
-									hThisInstance, NULL);
+				static struct raii
+				{
+					raii() : module(0), ptrRtlCaptureStackBackTrace(0)
+					{
+						module = LoadLibraryA("kernel32.dll");
+						if( !module )
+							fail( "<heal/heal.cpp> says: error! cant load kernel32.dll" );
 
-		//  SendMessage(hwndInputBox,WM_SETFONT,(WPARAM)myFont,FALSE);
-			SendMessage(hwndQuery,WM_SETFONT,(WPARAM)myFont,FALSE);
-			SendMessage(hwndEditBox,WM_SETFONT,(WPARAM)myFont,FALSE);
-			SendMessage(hwndOk,WM_SETFONT,(WPARAM)myFont,FALSE);
-			SendMessage(hwndCancel,WM_SETFONT,(WPARAM)myFont,FALSE);
-		}
+						ptrRtlCaptureStackBackTrace = (FuncRtlCaptureStackBackTrace *)GetProcAddress(module, "RtlCaptureStackBackTrace");
+						if( !ptrRtlCaptureStackBackTrace )
+							fail( "<heal/heal.cpp> says: error! cant find RtlCaptureStackBackTrace() process address" );
+					}
+					~raii() { if(module) FreeLibrary(module); }
 
-		void close()
-		{
-			PostMessage(hwndInputBox, WM_CLOSE, 0, 0);
-		}
+					HMODULE module;
+					FuncRtlCaptureStackBackTrace *ptrRtlCaptureStackBackTrace;
+				} module;
 
-		void hide()
-		{
-			ShowWindow(hwndInputBox, SW_HIDE);
-		}
+				if( module.ptrRtlCaptureStackBackTrace )
+					capturedFrames = module.ptrRtlCaptureStackBackTrace(frames_to_skip+1, max_frames, out_frames, (DWORD *) 0);
 
-		void show(LPCSTR lpszTitle, LPCSTR  lpszQuery)
-		{
-			SetWindowTextA(hwndInputBox, lpszTitle);
-			SetWindowTextA(hwndEditBox, szInputText);
-			SetWindowTextA(hwndQuery, lpszQuery);
-			SendMessage(hwndEditBox, EM_LIMITTEXT, wInputMaxLength, 0);
-			SendMessage(hwndEditBox, EM_SETSEL, 0, -1);
-			SetFocus(hwndEditBox);
-			ShowWindow(hwndInputBox, SW_NORMAL);
+				return capturedFrames;
+			})
+			$gnuc({
+				// backtrace() cannot skip frames, so drop them afterwards (this one included)
+				int captured = backtrace(out_frames, max_frames);
+				unsigned skip = std::min<unsigned>( frames_to_skip + 1, captured > 0 ? captured : 0 );
+				if( skip ) std::memmove( out_frames, out_frames + skip, (captured - skip) * sizeof(void *) );
+				return captured > 0 ? captured - skip : 0;
+			})
+			return 0;
 		}
 
-		int show(HWND hwndParentWindow, LPCSTR lpszTitle, LPCSTR lpszQuery, LPSTR szResult, WORD wMax)
+		std::vector<std::string> callstack::unwind( unsigned from, unsigned to ) const
 		{
-			MSG msg;
-			BOOL    bRet;
-			hwndParent = hwndParentWindow;
-			szInputText = szResult;
-			wInputMaxLength = wMax;
+			if( to == ~0 )
+				to = this->frames.size();
 
-			bResult = false;
+			if( from > to || from > this->frames.size() || to > this->frames.size() )
+				return std::vector<std::string>();
 
-		//  EnableWindow(hwndParent, false);
+			const size_t num_frames = to - from;
+			std::vector<std::string> backtraces( num_frames );
 
-			show(lpszTitle, lpszQuery);
+			void * const * frames = &this->frames[ from ];
+			const std::string invalid = "????";
 
-			while( (bRet = GetMessageA( &msg, NULL, 0, 0 )) != 0)
+#if HEAL_HAS_ELF
 			{
-				if (msg.message==WM_KEYDOWN) {
-					switch (msg.wParam) {
-					case VK_RETURN:
-						submit();
-					case VK_ESCAPE:
-						close();
-						break;
-					default:
-						TranslateMessage(&msg);
-						break;
-					}
-				} else
-		//      if (!IsDialogMessage(hwndInputBox, &msg)) {
-					TranslateMessage(&msg);
-		//      }
-				DispatchMessage(&msg);
-				if (msg.message == WM_CLOSE)
-					break;
+				// in-process symbolizer first; backtrace_symbols() only for addresses outside any module
+				bool missing = false;
+				for( unsigned i = 0; i < num_frames; i++ ) {
+					backtraces[i] = elf::symbolize( frames[i] );
+					if( backtraces[i].empty() )
+						backtraces[i] = elf::describe( frames[i] );
+					missing |= backtraces[i].empty();
+				}
+				if( !missing )
+					return backtraces;
 			}
+#endif
 
-		//  EnableWindow(hwndParent, true);
-
-			return bResult;
-		}
-
-	#   undef CIB_CLASS_NAME
-	}
-	myinp(GetModuleHandle(0));
-
-	char *result = new char [2048+1];
-
-	memset( result, 0, 2048+1 ); //default value
-
-	strcpy( result, current_value.c_str() );
-
-	myinp.show(0, "L", caption.size() ? caption.c_str() : title.c_str(), result, 2048);
-
-	std::string _r = result;
+			$windows({
+				SymSetOptions(SYMOPT_UNDNAME);
 
-	delete [] result;
+				$no(
+					// polite version. this is how things should be done.
+					HANDLE process = GetCurrentProcess();
+					if( SymInitialize( process, NULL, TRUE ) )
+				)
+				$yes(
+					// this is what we have to do because other memory managers are not polite enough. fuck them off
+					static HANDLE process = GetCurrentProcess();
+					static int init = SymInitialize( process, NULL, TRUE );
+					if( !init )
+						fail( "<heal/heal.cpp> says: cannot initialize Dbghelp.lib" );
+				)
+				{
+					enum { MAXSYMBOLNAME = 512 - sizeof(IMAGEHLP_SYMBOL64) };
+					char symbol64_buf     [ 512 ];
+					char symbol64_bufblank[ 512 ] = {0};
+					IMAGEHLP_SYMBOL64 *symbol64       = reinterpret_cast<IMAGEHLP_SYMBOL64*>(symbol64_buf);
+					IMAGEHLP_SYMBOL64 *symbol64_blank = reinterpret_cast<IMAGEHLP_SYMBOL64*>(symbol64_bufblank);
+					symbol64_blank->SizeOfStruct = sizeof(IMAGEHLP_SYMBOL64);
+					symbol64_blank->MaxNameLength = (MAXSYMBOLNAME-1) / 2; //wchar?
 
-	return _r;
-}
+					IMAGEHLP_LINE64 line64, line64_blank = {0};
+					line64_blank.SizeOfStruct = sizeof(IMAGEHLP_LINE64);
 
-#endif
+					for( unsigned i = 0; i < num_frames; i++ ) {
+						*symbol64 = *symbol64_blank;
+						DWORD64 displacement64 = 0;
 
-}
+						if( SymGetSymFromAddr64( process, (DWORD64) frames[i], &displacement64, symbol64 ) ) {
+							line64 = line64_blank;
+							DWORD displacement = 0;
+							if( SymGetLineFromAddr64( process, (DWORD64) frames[i], &displacement, &line64 ) ) {
+								backtraces[i] = heal::sfstring( "\1 (\2:\3)", symbol64->Name, line64.FileName, line64.LineNumber );
+							} else {
+								backtraces[i] = symbol64->Name;
+							}
+						} else  backtraces[i] = invalid;
+					}
 
-#if $on($msvc)
-#   pragma warning( pop )
-#endif
+					$no(
+						// fuck the others. cleanup commented.
+						SymCleanup(process);
+					)
+				}
+				DWORD error = GetLastError();
 
-/*
-#undef $debug
-#undef $release
-#undef $other
-#undef $gnuc
-#undef $msvc
+				return backtraces;
+			})
+			$gnuc({
+				char **strings = backtrace_symbols(frames, num_frames);
 
-#undef $undefined
-#undef $apple
-#undef $linux
-#undef $windows
+				// Decode the strings
+				if( strings ) {
+					for( unsigned i = 0; i < num_frames; i++ ) {
+						if( backtraces[i].empty() )
+							backtraces[i] = ( strings[i] ? demangle(strings[i]) : invalid );
+					}
+					free( strings );
+				}
 
-#undef $no
-#undef $yes
-*/
+				return backtraces;
+			})
 
+			return backtraces;
+		}
 
-// }
+		std::vector<std::string> callstack::str( const char *format12, size_t skip_begin ) const {
+			callstack copy = *this;
+			std::vector<std::string> stacktrace = copy.unwind( skip_begin );
 
-// mutexes and threads
-#if $on($cpp11)
-#include <mutex>
-#include <thread>
-#else
-#include <boost/thread/recursive_mutex.hpp>
-#include <boost/thread/thread.hpp>
-namespace std {
-	using boost::thread;
-	using boost::recursive_mutex;
-}
-#endif
+			for( size_t i = 0, end = stacktrace.size(); i < end; i++ )
+				stacktrace[i] = heal::sfstring( format12, i + 1, stacktrace[i] );
 
-// external; route66 uses c++11
-#if kTraceyWebserverPort
+			return stacktrace;
+		}
 
-//#line 1 "route66.cpp"
-// lightweight http server
-// - rlyeh, zlib/libpng licensed. based on code by Ivan Tikhonov (zlib licensed)
+		std::string callstack::flat( const char *format12, size_t skip_begin ) const {
+			std::vector<std::string> vec = str( format12, skip_begin );
+			std::string str;
+			for( std::vector<std::string>::const_iterator it = vec.begin(), end = vec.end(); it != end; ++it ) {
+				str += *it;
+			}
+			return str;
+		}
 
-// Sockets, taken from https://github.com/r-lyeh/knot
+std::vector<std::string> stacktrace( const char *format12, size_t skip_initial ) {
+	return callstack(true).str( format12, skip_initial );
+}
 
-#if defined(_WIN32)
+std::string stackstring( const char *format12, size_t skip_initial ) {
+	std::string out;
+	std::vector<std::string> stack = stacktrace( format12, skip_initial );
+	for( std::vector<std::string>::const_iterator it = stack.begin(), end = stack.end(); it != end; ++it ) {
+		out += *it;
+	}
+	return out;
+}
 
-#   include <winsock2.h>
-#   include <ws2tcpip.h>
-#   include <windows.h>
+// DIE
 
-#   ifndef _MSC_VER
-	static
-	const char* inet_ntop(int af, const void* src, char* dst, int cnt){
-		struct sockaddr_in srcaddr;
-		memset(&srcaddr, 0, sizeof(struct sockaddr_in));
-		memcpy(&(srcaddr.sin_addr), src, sizeof(srcaddr.sin_addr));
-		srcaddr.sin_family = af;
-		if (WSAAddressToString((struct sockaddr*) &srcaddr, sizeof(struct sockaddr_in), 0, dst, (LPDWORD) &cnt) != 0) {
-			DWORD rv = WSAGetLastError();
-			return NULL;
-		}
-		return dst;
+void die( const std::string &reason, int errorcode )
+{
+	if( !reason.empty() ) {
+		fail( reason );
 	}
-#   endif
-
-#   pragma comment(lib,"ws2_32.lib")
 
-#   define INIT()                    do { static WSADATA wsa_data; static const int init = WSAStartup( MAKEWORD(2, 2), &wsa_data ); } while(0)
-#   define SOCKET(A,B,C)             ::socket((A),(B),(C))
-#   define ACCEPT(A,B,C)             ::accept((A),(B),(C))
-#   define CONNECT(A,B,C)            ::connect((A),(B),(C))
-#   define CLOSE(A)                  ::closesocket((A))
-#   define RECV(A,B,C,D)             ::recv((A), (char *)(B), (C), (D))
-#   define READ(A,B,C)               ::recv((A), (char *)(B), (C), (0))
-#   define SELECT(A,B,C,D,E)         ::select((A),(B),(C),(D),(E))
-#   define SEND(A,B,C,D)             ::send((A), (const char *)(B), (int)(C), (D))
-#   define WRITE(A,B,C)              ::send((A), (const char *)(B), (int)(C), (0))
-#   define GETSOCKOPT(A,B,C,D,E)     ::getsockopt((A),(B),(C),(char *)(D), (int*)(E))
-#   define SETSOCKOPT(A,B,C,D,E)     ::setsockopt((A),(B),(C),(char *)(D), (int )(E))
+	$windows(
+	FatalExit( errorcode );
+	)
 
-#   define BIND(A,B,C)               ::bind((A),(B),(C))
-#   define LISTEN(A,B)               ::listen((A),(B))
-#   define SHUTDOWN(A)               ::shutdown((A),2)
-#   define SHUTDOWN_R(A)             ::shutdown((A),0)
-#   define SHUTDOWN_W(A)             ::shutdown((A),1)
+	// fallback
+	std::exit( errorcode );
+}
 
-	namespace
-	{
-		// fill missing api
+void die( int errorcode, const std::string &reason )
+{
+	die( reason, errorcode );
+}
 
-		enum
-		{
-			F_GETFL = 0,
-			F_SETFL = 1,
+// HEXDUMP
+// @todo: maxwidth != 80 doesnt work
 
-			O_NONBLOCK = 128 // dummy
-		};
+std::string hexdump( const void *data, size_t num_bytes, const void *self )
+{
+#   ifdef _MSC_VER
+#       pragma warning( push )
+#       pragma warning( disable : 4996 )
+#       define $vsnprintf _vsnprintf
+#   else
+#       define $vsnprintf  vsnprintf
+#   endif
 
-		int fcntl( int &sockfd, int mode, int value )
+	struct local {
+		static std::string format( const char *fmt, ... )
 		{
-			if( mode == F_GETFL ) // get socket status flags
-				return 0; // original return current sockfd flags
+			int len;
+			std::string self;
 
-			if( mode == F_SETFL ) // set socket status flags
+			using namespace std;
+
+			// Calculate the final length of the formatted string
 			{
-				u_long iMode = ( value & O_NONBLOCK ? 0 : 1 );
+				va_list args;
+				va_start( args, fmt );
+				len = $vsnprintf( 0, 0, fmt, args );
+				va_end( args );
+			}
 
-				bool result = ( ioctlsocket( sockfd, FIONBIO, &iMode ) == NO_ERROR );
+			// Allocate a buffer (including room for null termination
+			char* target_string = new char[++len];
 
-				return 0;
+			// Generate the formatted string
+			{
+				va_list args;
+				va_start( args, fmt );
+				$vsnprintf( target_string, len, fmt, args );
+				va_end( args );
 			}
 
-			return 0;
-		}
-	}
+			// Assign the formatted string
+			self.assign( target_string );
 
-#else
+			// Clean up
+			delete [] target_string;
 
-#   include <fcntl.h>
-#   include <sys/types.h>
-#   include <sys/socket.h>
-#   include <netdb.h>
-#   include <unistd.h>    //close
+			return self;
+		}
+	};
 
-#   include <arpa/inet.h> //inet_addr, inet_ntop
+	unsigned maxwidth = 80;
+	unsigned width = 16; //column width
+	unsigned width_offset_block = (8 + 1);
+	unsigned width_chars_block  = (width * 3 + 1) + sizeof("asc");
+	unsigned width_hex_block    = (width * 3 + 1) + sizeof("hex");
+	unsigned width_padding = (std::max)( 0, int( maxwidth - ( width_offset_block + width_chars_block + width_hex_block ) ) );
+	unsigned blocks = width_padding / ( width_chars_block + width_hex_block ) ;
 
-#   define INIT()                    do {} while(0)
-#   define SOCKET(A,B,C)             ::socket((A),(B),(C))
-#   define ACCEPT(A,B,C)             ::accept((A),(B),(C))
-#   define CONNECT(A,B,C)            ::connect((A),(B),(C))
-#   define CLOSE(A)                  ::close((A))
-#   define READ(A,B,C)               ::read((A),(B),(C))
-#   define RECV(A,B,C,D)             ::recv((A), (void *)(B), (C), (D))
-#   define SELECT(A,B,C,D,E)         ::select((A),(B),(C),(D),(E))
-#   define SEND(A,B,C,D)             ::send((A), (const int8 *)(B), (C), (D))
-#   define WRITE(A,B,C)              ::write((A),(B),(C))
-#   define GETSOCKOPT(A,B,C,D,E)     ::getsockopt((int)(A),(int)(B),(int)(C),(      void *)(D),(socklen_t *)(E))
-#   define SETSOCKOPT(A,B,C,D,E)     ::setsockopt((int)(A),(int)(B),(int)(C),(const void *)(D),(int)(E))
+	unsigned dumpsize = ( num_bytes < width * 16 ? num_bytes : width * 16 ); //16 lines max
 
-#   define BIND(A,B,C)               ::bind((A),(B),(C))
-#   define LISTEN(A,B)               ::listen((A),(B))
-#   define SHUTDOWN(A)               ::shutdown((A),SHUT_RDWR)
-#   define SHUTDOWN_R(A)             ::shutdown((A),SHUT_RD)
-#   define SHUTDOWN_W(A)             ::shutdown((A),SHUT_WR)
+	std::string result;
 
-#endif
+	result += local::format( "%-*s %-.*s [ptr=%p sz=%d]\n", width_offset_block - 1, "offset", width_chars_block - 1, "00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F", self ? self : data, num_bytes );
 
-#include <cstdlib>
-#include <cstring>
-#include <limits.h>
+	if( !num_bytes )
+		return result;
 
-#include <fstream>
-#include <map>
-#include <sstream>
-#include <string>
-#include <vector>
+	blocks++;
 
+	const unsigned char *p = reinterpret_cast<const unsigned char *>( data );
+	size_t i = 0;
 
-//#line 1 "route66.hpp"
-// lightweight http server
-// - rlyeh, zlib/libpng licensed. based on code by Ivan Tikhonov (zlib licensed)
+	while( i < dumpsize )
+	{
+		//offset block
+		result += local::format("%p ", (size_t)(p + i) ); //%08x, %08zx
 
-/**/// <-- remove an asterisk in a code editor to highlight API
+		//chars blocks
+		for( unsigned b = 0; b < blocks; b++)
+		{
+			for( unsigned c = 0 ; c < width ; c++ )
+				result += local::format(" %c ", i + c >= dumpsize ? '.' : p[i + c] < 32 || p[i + c] >= 127 ? '.' : p[i + c]);
 
-//#pragma once
+			result += "asc\n";
+		}
 
-#include <map>
-#include <ostream>
-#include <string>
-#include <utility>
-#include <sstream>
+		//offset block
+		result += local::format("%p ", (size_t)(p + i) ); //%08x, %08zx
 
-// taken from https://github.com/r-lyeh/bridge {
-#if (__cplusplus < 201103L && !defined(_MSC_VER)) || (defined(_MSC_VER) && (_MSC_VER < 1700)) || (defined(__GLIBCXX__) && __GLIBCXX__ < 20130322L)
-#   include <boost/functional.hpp> // if old libstdc++ or msc libs are found, use boost::function
-#   include <boost/function.hpp>   //
-#   include <boost/thread.hpp>     // and boost::thread
-namespace std {
-	namespace placeholders {
-		//...
+		//hex blocks
+		for( unsigned b = 0; b < blocks; b++)
+		{
+			for( unsigned c = 0; c < width ; c++)
+				result += local::format( i + c < dumpsize ? "%02x " : "?? ", p[i + c]);
+
+			result += "hex\n";
+		}
+
+		//next line
+		//result += '\n';
+		i += width * blocks;
 	}
-	using namespace boost;
+
+	return result;
+
+#   undef $vsnprintf
+#   ifdef _MSC_VER
+#       pragma warning( pop )
+#   endif
 }
-#else
-#   include <functional>       // else assume modern c++11 and use std::function<> instead
-#   include <mutex>            // and std::mutex
-#   include <thread>           // and std::thread
-#endif
-// }
 
-namespace route66 {
+std::string timestamp() {
+	std::stringstream ss;
+	ss << __TIMESTAMP__;
+	return ss.str();
+}
 
-	/*/ request:: 'class'
-	/*/
-	struct request {
-		std::string data;                              /*/      .data 'raw received data, as is' /*/
-		std::string method;                            /*/    .method 'raw method ("GET HEAD POST PUT ...")' /*/
-		std::string url;                               /*/       .url 'raw request ("/search?req1=blabla&req2=what%20ever")' /*/
-		std::string uri;                               /*/      .path 'decoded path uri ("/search")' /*/
-		std::string options;                           /*/   .options 'raw GET/POST options url ("req1=blabla&req2=what%20ever")' /*/
-		std::map<std::string, std::string> arguments;  /*/ .arguments 'decoded options decoupled as arguments ( {"req1","blabla"}, {"req2","what ever"} )' /*/
-		std::map<std::string, std::string> multipart;  /*/ .multipart 'multipart files when POST' /*/
-		std::string ip;                                /*/        .ip 'ip address of request' /*/
-		   unsigned port;                              /*/      .port 'number port of request' /*/
-		std::string str() const {
-			typedef std::map<std::string, std::string>::const_iterator cit;
-			std::stringstream ss;
-			ss << "route66::request[" << this << "] = {" << std::endl;
-			ss << "\t" "ip: " << ip << std::endl;
-			ss << "\t" "port: " << port << std::endl;
-			ss << "\t" "method: " << method << std::endl;
-			ss << "\t" "options: " << options << std::endl;
-			ss << "\t" "uri: " << uri << std::endl;
-			ss << "\t" "url: " << url << std::endl;
-			for( cit it = arguments.begin(), end = arguments.end(); it != end; ++it ) {
-				ss << "\t" "argument[" << it->first << "]: " << it->second << std::endl;
-			}
-			for( cit it = multipart.begin(), end = multipart.end(); it != end; ++it ) {
-				ss << "\t" "multipart[" << it->first << "]: " << it->second << std::endl;
-			}
-			ss << "\t" "data: " << data << std::endl;
-			ss << "}; //route66::request [" << this << "]" << std::endl;
-			return ss.str();
-		}
-	};
+/*
+ * Simple prompt dialog (based on legolas558's code). zlib/libpng license.
+ * - rlyeh
+ */
 
-	/*/ callback; 'alias'
-	/*/ typedef std::function< int(request &,std::ostream &,std::ostream &) > callback;
+#if !$on($windows)
 
-	/*/ create() 'start a daemon at given port and route mask, callback will be invoked; returns false if failed.'
-	/*/ bool create( unsigned port, const std::string &mask, const route66::callback &callback );
+std::string prompt( const std::string &current_value, const std::string &title, const std::string &caption )
+{
+	std::string out;
 
-	/*/ fserve() 'start a file server daemon at given port and relative path, all file uri contents will be returned; returns false if failed.'
-	/*/ bool fserve( unsigned port, const std::string &mask, const std::string &relpath );
+	if( has("whiptail") && false )
+	{
+		std::string out = pipe( std::string() +
+			"/usr/bin/whiptail 3>&1 1>&2 2>&3 --title \"" +title+ "\" --inputbox \"" +caption+ "\" 0 0 \"" +current_value+ "\"" );
+	}
+	else
+	{
+		if( title.size() && caption.size() )
+			fprintf(stdout, "%s", title.c_str());
+		else
+			fprintf(stdout, "%s", title.empty() ? caption.c_str() : title.c_str());
 
-	/*/ httpcode:: 'listing of HTTP result codes'
-	/*/
-	struct httpcode {
-		unsigned code;
-		const char *const description;
-	};
+		if( !current_value.empty() )
+			fprintf(stdout, " (enter defaults to '%s')", current_value.c_str());
 
-	/*/ 0XX 'route66'
-	/*/
-	extern const httpcode SHUTDOWN;
-	/*/ 1XX 'informational'
-	/*/
-	extern const httpcode CONTINUE;
-	extern const httpcode SWITCH_PROTOCOLS;
-	/*/ 2XX 'success'
-	/*/
-	extern const httpcode OK;
-	extern const httpcode CREATED;
-	extern const httpcode ACCEPTED;
-	extern const httpcode PARTIAL;
-	extern const httpcode NO_CONTENT;
-	extern const httpcode RESET_CONTENT;
-	extern const httpcode PARTIAL_CONTENT;
-	extern const httpcode WEBDAV_MULTI_STATUS;
-	/*/ 3XX 'redirection'
-	/*/
-	extern const httpcode AMBIGUOUS;
-	extern const httpcode MOVED;
-	extern const httpcode REDIRECT;
-	extern const httpcode REDIRECT_METHOD;
-	extern const httpcode NOT_MODIFIED;
-	extern const httpcode USE_PROXY;
-	extern const httpcode REDIRECT_KEEP_VERB;
-	/*/ 4XX 'client error'
-	/*/
-	extern const httpcode BAD_REQUEST;
-	extern const httpcode DENIED;
-	extern const httpcode PAYMENT_REQ;
-	extern const httpcode FORBIDDEN;
-	extern const httpcode NOT_FOUND;
-	extern const httpcode BAD_METHOD;
-	extern const httpcode NONE_ACCEPTABLE;
-	extern const httpcode PROXY_AUTH_REQ;
-	extern const httpcode REQUEST_TIMEOUT;
-	extern const httpcode CONFLICT;
-	extern const httpcode GONE;
-	extern const httpcode LENGTH_REQUIRED;
-	extern const httpcode PRECOND_FAILED;
-	extern const httpcode REQUEST_TOO_LARGE;
-	extern const httpcode URI_TOO_LONG;
-	extern const httpcode UNSUPPORTED_MEDIA;
-	extern const httpcode RETRY_WITH;
-	/*/ 5XX 'server error'
-	/*/
-	extern const httpcode SERVER_ERROR;
-	extern const httpcode NOT_SUPPORTED;
-	extern const httpcode BAD_GATEWAY;
-	extern const httpcode SERVICE_UNAVAIL;
-	extern const httpcode GATEWAY_TIMEOUT;
-	extern const httpcode VERSION_NOT_SUP;
+		fprintf(stdout, "%s", "\n");
 
-	/*/ mime() 'MIME string header based on file extension (ie, sample.json -> "Content-Type: application/json; charset=utf-8\r\n" )' /*/
-	/*/ tag()  'MIME string tag based on file extension (ie, sample.json -> "application/json" )' /*/
-	std::string mime( const std::string &filename_ext );
-	std::string tag( const std::string &filename_ext );
+		std::getline( std::cin, out );
+
+		if( out.empty() )
+			out = current_value;
+	}
+
+	return out;
 }
 
-namespace {
-	// http://stackoverflow.com/questions/2673207/c-c-url-decode-library
-	char * urldecode2(char *dst, const char *src) {
-		char a, b;
-		while (*src) {
-			if ((*src == '%') &&
-				((a = src[1]) && (b = src[2])) &&
-				(isxdigit(a) && isxdigit(b))) {
-					if (a >= 'a')
-							a -= 'a'-'A';
-					if (a >= 'A')
-							a -= ('A' - 10);
-					else
-							a -= '0';
-					if (b >= 'a')
-							b -= 'a'-'A';
-					if (b >= 'A')
-							b -= ('A' - 10);
-					else
-							b -= '0';
-					*dst++ = 16*a+b;
-					src+=3;
-			} else {
-				*dst++ = *src++;
+#endif
+
+#if $on($msvc)
+#   pragma warning( push )
+#   pragma warning( disable : 4996 )
+#endif
+
+#if $on($windows)
+#   pragma comment(lib,"user32.lib")
+#   pragma comment(lib,"gdi32.lib")
+//$warning("<heal/heal.cpp> says: dialog aware dpi fix (@todo)")
+
+std::string prompt( const std::string &current_value, const std::string &title, const std::string &caption )
+{
+	class InputBox
+	{
+		private:
+
+		HWND                hwndParent,
+							hwndInputBox,
+							hwndQuery,
+							hwndOk,
+							hwndCancel,
+							hwndEditBox;
+		LPSTR               szInputText;
+		WORD                wInputMaxLength, wInputLength;
+		bool                bRegistered,
+							bResult;
+
+		HINSTANCE           hThisInstance;
+
+		enum
+		{
+			CIB_SPAN = 10,
+			CIB_LEFT_OFFSET = 6,
+			CIB_TOP_OFFSET = 4,
+			CIB_WIDTH = 300,
+			CIB_HEIGHT = 130,
+			CIB_BTN_WIDTH = 60,
+			CIB_BTN_HEIGHT = 20
+		};
+
+		public:
+
+#       define CIB_CLASS_NAME   "CInputBoxA"
+
+		static LRESULT CALLBACK CIB_WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
+		{
+			InputBox *self;
+			self = (InputBox *)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+
+			switch (msg)
+			{
+				case WM_CREATE:
+					self = (InputBox *) ((CREATESTRUCT *)lParam)->lpCreateParams;
+					SetWindowLongPtr(hWnd, GWLP_USERDATA, (LONG_PTR)self);
+					self->create(hWnd);
+				break;
+				case WM_COMMAND:
+					switch(LOWORD(wParam)) {
+						case IDOK:
+							self->submit();
+						case IDCANCEL:
+							self->close();
+						break;
+					}
+					break;
+				case WM_CLOSE:
+					self->close();
+					return 0;
+				case WM_DESTROY:
+					self->destroy();
+					break;
+			}
+			return(DefWindowProc (hWnd, msg, wParam, lParam));
+		}
+
+		InputBox( HINSTANCE hInst ) :
+			hwndParent(0),
+			hwndInputBox(0),
+			hwndQuery(0),
+			hwndOk(0),
+			hwndCancel(0),
+			hwndEditBox(0),
+			szInputText(0),
+			wInputMaxLength(0), wInputLength(0),
+			bRegistered(false),
+			bResult(false),
+			hThisInstance(hInst)
+		{
+			WNDCLASSEXA wndInputBox;
+			RECT rect;
+
+			memset(&wndInputBox, 0, sizeof(WNDCLASSEXA));
+
+			hThisInstance = hInst;
+
+			wndInputBox.cbSize                  = sizeof(wndInputBox);
+			wndInputBox.lpszClassName           = CIB_CLASS_NAME;
+			wndInputBox.style                   = CS_HREDRAW | CS_VREDRAW;
+			wndInputBox.lpfnWndProc             = CIB_WndProc;
+			wndInputBox.lpszMenuName            = NULL;
+			wndInputBox.hIconSm                 = NULL;
+			wndInputBox.cbClsExtra              = 0;
+			wndInputBox.cbWndExtra              = 0;
+			wndInputBox.hInstance               = hInst;
+			wndInputBox.hIcon                   = LoadIcon(NULL, IDI_WINLOGO);
+			wndInputBox.hCursor                 = LoadCursor(NULL, IDC_ARROW);
+			wndInputBox.hbrBackground           = (HBRUSH)(COLOR_WINDOW);
+
+			RegisterClassExA(&wndInputBox);
+
+			if (hwndParent)
+				GetWindowRect(hwndParent, &rect); //always false?
+			else
+				GetWindowRect(GetDesktopWindow(), &rect);
+
+			hwndInputBox = CreateWindowA( CIB_CLASS_NAME, "",
+							(WS_BORDER | WS_CAPTION), rect.left+(rect.right-rect.left-CIB_WIDTH)/2,
+							rect.top+(rect.bottom-rect.top-CIB_HEIGHT)/2,
+							CIB_WIDTH, CIB_HEIGHT, hwndParent, NULL,
+							hThisInstance, this);
+		}
+
+		void destroy()
+		{
+			EnableWindow(hwndParent, true);
+			SendMessage(hwndInputBox, WM_CLOSE/*WM_DESTROY*/, 0, 0);
+		}
+
+		~InputBox()
+		{
+			UnregisterClassA(CIB_CLASS_NAME, hThisInstance);
+		}
+
+		void submit()
+		{
+			wInputLength = (int)SendMessage(hwndEditBox, EM_LINELENGTH, 0, 0);
+			if (wInputLength) {
+				*((LPWORD)szInputText) = wInputMaxLength;
+				wInputLength = (WORD)SendMessage(hwndEditBox, EM_GETLINE, 0, (LPARAM)szInputText);
+			}
+			szInputText[wInputLength] = '\0';
+			bResult = true;
+		}
+
+		void create(HWND hwndNew)
+		{
+			static HFONT myFont = NULL;
+
+			if( myFont != NULL )
+			{
+				DeleteObject( myFont );
+				myFont = NULL;
+			}
+
+			hwndInputBox = hwndNew;
+
+			NONCLIENTMETRICS ncm;
+			ncm.cbSize = sizeof(NONCLIENTMETRICS);
+
+			if (SystemParametersInfo(SPI_GETNONCLIENTMETRICS, sizeof(NONCLIENTMETRICS), &ncm, 0))
+			{
+#if 0
+				LOGFONT lf;
+				memset(&lf,0,sizeof(LOGFONT));
+
+				lf.lfWeight= FW_NORMAL;
+				lf.lfCharSet= ANSI_CHARSET;
+				//lf.lfPitchAndFamily = 35;
+				lf.lfHeight= 10;
+				strcpy(lf.lfFaceName, "Tahoma");
+				myFont=CreateFontIndirect(&lf);
+#else
+				myFont = CreateFontIndirect(&ncm.lfMessageFont);
+#endif
+			}
+			else
+			{
+				myFont = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
+			}
+
+			//  SetWindowPos(hwndInputBox, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
+			hwndQuery = CreateWindowA("Static", "", WS_CHILD | WS_VISIBLE,
+									CIB_LEFT_OFFSET, CIB_TOP_OFFSET,
+									CIB_WIDTH-CIB_LEFT_OFFSET*2, CIB_BTN_HEIGHT*2,
+									hwndInputBox, NULL,
+									hThisInstance, NULL);
+			hwndEditBox = CreateWindowA("Edit", "", WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL | ES_LEFT, CIB_LEFT_OFFSET,
+									CIB_TOP_OFFSET + CIB_BTN_HEIGHT*2, CIB_WIDTH-CIB_LEFT_OFFSET*3, CIB_BTN_HEIGHT,
+									hwndInputBox,   NULL,
+									hThisInstance, NULL);
+			hwndOk = CreateWindowA("Button", "OK", WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_PUSHBUTTON,
+									CIB_WIDTH/2 - CIB_SPAN*2 - CIB_BTN_WIDTH, CIB_HEIGHT - CIB_TOP_OFFSET*4 - CIB_BTN_HEIGHT*2,
+									CIB_BTN_WIDTH, CIB_BTN_HEIGHT, hwndInputBox, (HMENU)IDOK,
+									hThisInstance, NULL);
+			hwndCancel = CreateWindowA("Button", "Cancel",
+									WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_PUSHBUTTON,
+									CIB_WIDTH/2 + CIB_SPAN, CIB_HEIGHT - CIB_TOP_OFFSET*4 - CIB_BTN_HEIGHT*2,  CIB_BTN_WIDTH, CIB_BTN_HEIGHT,
+									hwndInputBox, (HMENU)IDCANCEL,
+									hThisInstance, NULL);
+
+		//  SendMessage(hwndInputBox,WM_SETFONT,(WPARAM)myFont,FALSE);
+			SendMessage(hwndQuery,WM_SETFONT,(WPARAM)myFont,FALSE);
+			SendMessage(hwndEditBox,WM_SETFONT,(WPARAM)myFont,FALSE);
+			SendMessage(hwndOk,WM_SETFONT,(WPARAM)myFont,FALSE);
+			SendMessage(hwndCancel,WM_SETFONT,(WPARAM)myFont,FALSE);
+		}
+
+		void close()
+		{
+			PostMessage(hwndInputBox, WM_CLOSE, 0, 0);
+		}
+
+		void hide()
+		{
+			ShowWindow(hwndInputBox, SW_HIDE);
+		}
+
+		void show(LPCSTR lpszTitle, LPCSTR  lpszQuery)
+		{
+			SetWindowTextA(hwndInputBox, lpszTitle);
+			SetWindowTextA(hwndEditBox, szInputText);
+			SetWindowTextA(hwndQuery, lpszQuery);
+			SendMessage(hwndEditBox, EM_LIMITTEXT, wInputMaxLength, 0);
+			SendMessage(hwndEditBox, EM_SETSEL, 0, -1);
+			SetFocus(hwndEditBox);
+			ShowWindow(hwndInputBox, SW_NORMAL);
+		}
+
+		int show(HWND hwndParentWindow, LPCSTR lpszTitle, LPCSTR lpszQuery, LPSTR szResult, WORD wMax)
+		{
+			MSG msg;
+			BOOL    bRet;
+			hwndParent = hwndParentWindow;
+			szInputText = szResult;
+			wInputMaxLength = wMax;
+
+			bResult = false;
+
+		//  EnableWindow(hwndParent, false);
+
+			show(lpszTitle, lpszQuery);
+
+			while( (bRet = GetMessageA( &msg, NULL, 0, 0 )) != 0)
+			{
+				if (msg.message==WM_KEYDOWN) {
+					switch (msg.wParam) {
+					case VK_RETURN:
+						submit();
+					case VK_ESCAPE:
+						close();
+						break;
+					default:
+						TranslateMessage(&msg);
+						break;
+					}
+				} else
+		//      if (!IsDialogMessage(hwndInputBox, &msg)) {
+					TranslateMessage(&msg);
+		//      }
+				DispatchMessage(&msg);
+				if (msg.message == WM_CLOSE)
+					break;
+			}
+
+		//  EnableWindow(hwndParent, true);
+
+			return bResult;
+		}
+
+	#   undef CIB_CLASS_NAME
+	}
+	myinp(GetModuleHandle(0));
+
+	char *result = new char [2048+1];
+
+	memset( result, 0, 2048+1 ); //default value
+
+	strcpy( result, current_value.c_str() );
+
+	myinp.show(0, "L", caption.size() ? caption.c_str() : title.c_str(), result, 2048);
+
+	std::string _r = result;
+
+	delete [] result;
+
+	return _r;
+}
+
+#endif
+
+}
+
+#if $on($msvc)
+#   pragma warning( pop )
+#endif
+
+/*
+#undef $debug
+#undef $release
+#undef $other
+#undef $gnuc
+#undef $msvc
+
+#undef $undefined
+#undef $apple
+#undef $linux
+#undef $windows
+
+#undef $no
+#undef $yes
+*/
+
+
+// }
+
+// mutexes and threads
+#if $on($cpp11)
+#include <atomic>
+#include <mutex>
+#include <thread>
+#else
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/thread.hpp>
+namespace std {
+	using boost::atomic;
+	using boost::thread;
+	using boost::mutex;
+	using boost::recursive_mutex;
+}
+#endif
+
+// private memory for tracey metadata
+#if $on($windows)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// external; route66 uses c++11
+#if kTraceyWebserverPort
+
+//#line 1 "route66.cpp"
+// lightweight http server
+// - rlyeh, zlib/libpng licensed. based on code by Ivan Tikhonov (zlib licensed)
+
+// Sockets, taken from https://github.com/r-lyeh/knot
+
+#if defined(_WIN32)
+
+#   include <winsock2.h>
+#   include <ws2tcpip.h>
+#   include <windows.h>
+
+#   ifndef _MSC_VER
+	static
+	const char* inet_ntop(int af, const void* src, char* dst, int cnt){
+		struct sockaddr_in srcaddr;
+		memset(&srcaddr, 0, sizeof(struct sockaddr_in));
+		memcpy(&(srcaddr.sin_addr), src, sizeof(srcaddr.sin_addr));
+		srcaddr.sin_family = af;
+		if (WSAAddressToString((struct sockaddr*) &srcaddr, sizeof(struct sockaddr_in), 0, dst, (LPDWORD) &cnt) != 0) {
+			DWORD rv = WSAGetLastError();
+			return NULL;
+		}
+		return dst;
+	}
+#   endif
+
+#   pragma comment(lib,"ws2_32.lib")
+
+#   define INIT()                    do { static WSADATA wsa_data; static const int init = WSAStartup( MAKEWORD(2, 2), &wsa_data ); } while(0)
+#   define SOCKET(A,B,C)             ::socket((A),(B),(C))
+#   define ACCEPT(A,B,C)             ::accept((A),(B),(C))
+#   define CONNECT(A,B,C)            ::connect((A),(B),(C))
+#   define CLOSE(A)                  ::closesocket((A))
+#   define RECV(A,B,C,D)             ::recv((A), (char *)(B), (C), (D))
+#   define READ(A,B,C)               ::recv((A), (char *)(B), (C), (0))
+#   define SELECT(A,B,C,D,E)         ::select((A),(B),(C),(D),(E))
+#   define SEND(A,B,C,D)             ::send((A), (const char *)(B), (int)(C), (D))
+#   define WRITE(A,B,C)              ::send((A), (const char *)(B), (int)(C), (0))
+#   define GETSOCKOPT(A,B,C,D,E)     ::getsockopt((A),(B),(C),(char *)(D), (int*)(E))
+#   define SETSOCKOPT(A,B,C,D,E)     ::setsockopt((A),(B),(C),(char *)(D), (int )(E))
+
+#   define BIND(A,B,C)               ::bind((A),(B),(C))
+#   define LISTEN(A,B)               ::listen((A),(B))
+#   define SHUTDOWN(A)               ::shutdown((A),2)
+#   define SHUTDOWN_R(A)             ::shutdown((A),0)
+#   define SHUTDOWN_W(A)             ::shutdown((A),1)
+
+	namespace
+	{
+		// fill missing api
+
+		enum
+		{
+			F_GETFL = 0,
+			F_SETFL = 1,
+
+			O_NONBLOCK = 128 // dummy
+		};
+
+		int fcntl( int &sockfd, int mode, int value )
+		{
+			if( mode == F_GETFL ) // get socket status flags
+				return 0; // original return current sockfd flags
+
+			if( mode == F_SETFL ) // set socket status flags
+			{
+				u_long iMode = ( value & O_NONBLOCK ? 0 : 1 );
+
+				bool result = ( ioctlsocket( sockfd, FIONBIO, &iMode ) == NO_ERROR );
+
+				return 0;
+			}
+
+			return 0;
+		}
+	}
+
+#else
+
+#   include <fcntl.h>
+#   include <sys/types.h>
+#   include <sys/socket.h>
+#   include <netdb.h>
+#   include <unistd.h>    //close
+
+#   include <arpa/inet.h> //inet_addr, inet_ntop
+
+#   define INIT()                    do {} while(0)
+#   define SOCKET(A,B,C)             ::socket((A),(B),(C))
+#   define ACCEPT(A,B,C)             ::accept((A),(B),(C))
+#   define CONNECT(A,B,C)            ::connect((A),(B),(C))
+#   define CLOSE(A)                  ::close((A))
+#   define READ(A,B,C)               ::read((A),(B),(C))
+#   define RECV(A,B,C,D)             ::recv((A), (void *)(B), (C), (D))
+#   define SELECT(A,B,C,D,E)         ::select((A),(B),(C),(D),(E))
+#   define SEND(A,B,C,D)             ::send((A), (const int8 *)(B), (C), (D))
+#   define WRITE(A,B,C)              ::write((A),(B),(C))
+#   define GETSOCKOPT(A,B,C,D,E)     ::getsockopt((int)(A),(int)(B),(int)(C),(      void *)(D),(socklen_t *)(E))
+#   define SETSOCKOPT(A,B,C,D,E)     ::setsockopt((int)(A),(int)(B),(int)(C),(const void *)(D),(int)(E))
+
+#   define BIND(A,B,C)               ::bind((A),(B),(C))
+#   define LISTEN(A,B)               ::listen((A),(B))
+#   define SHUTDOWN(A)               ::shutdown((A),SHUT_RDWR)
+#   define SHUTDOWN_R(A)             ::shutdown((A),SHUT_RD)
+#   define SHUTDOWN_W(A)             ::shutdown((A),SHUT_WR)
+
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <limits.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+//#line 1 "route66.hpp"
+// lightweight http server
+// - rlyeh, zlib/libpng licensed. based on code by Ivan Tikhonov (zlib licensed)
+
+/**/// <-- remove an asterisk in a code editor to highlight API
+
+//#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <sstream>
+
+// taken from https://github.com/r-lyeh/bridge {
+#if (__cplusplus < 201103L && !defined(_MSC_VER)) || (defined(_MSC_VER) && (_MSC_VER < 1700)) || (defined(__GLIBCXX__) && __GLIBCXX__ < 20130322L)
+#   include <boost/functional.hpp> // if old libstdc++ or msc libs are found, use boost::function
+#   include <boost/function.hpp>   //
+#   include <boost/thread.hpp>     // and boost::thread
+namespace std {
+	namespace placeholders {
+		//...
+	}
+	using namespace boost;
+}
+#else
+#   include <functional>       // else assume modern c++11 and use std::function<> instead
+#   include <mutex>            // and std::mutex
+#   include <thread>           // and std::thread
+#endif
+// }
+
+namespace route66 {
+
+	/*/ request:: 'class'
+	/*/
+	struct request {
+		std::string data;                              /*/      .data 'raw received data, as is' /*/
+		std::string method;                            /*/    .method 'raw method ("GET HEAD POST PUT ...")' /*/
+		std::string url;                               /*/       .url 'raw request ("/search?req1=blabla&req2=what%20ever")' /*/
+		std::string uri;                               /*/      .path 'decoded path uri ("/search")' /*/
+		std::string options;                           /*/   .options 'raw GET/POST options url ("req1=blabla&req2=what%20ever")' /*/
+		std::map<std::string, std::string> arguments;  /*/ .arguments 'decoded options decoupled as arguments ( {"req1","blabla"}, {"req2","what ever"} )' /*/
+		std::map<std::string, std::string> multipart;  /*/ .multipart 'multipart files when POST' /*/
+		std::string ip;                                /*/        .ip 'ip address of request' /*/
+		   unsigned port;                              /*/      .port 'number port of request' /*/
+		std::string str() const {
+			typedef std::map<std::string, std::string>::const_iterator cit;
+			std::stringstream ss;
+			ss << "route66::request[" << this << "] = {" << std::endl;
+			ss << "\t" "ip: " << ip << std::endl;
+			ss << "\t" "port: " << port << std::endl;
+			ss << "\t" "method: " << method << std::endl;
+			ss << "\t" "options: " << options << std::endl;
+			ss << "\t" "uri: " << uri << std::endl;
+			ss << "\t" "url: " << url << std::endl;
+			for( cit it = arguments.begin(), end = arguments.end(); it != end; ++it ) {
+				ss << "\t" "argument[" << it->first << "]: " << it->second << std::endl;
+			}
+			for( cit it = multipart.begin(), end = multipart.end(); it != end; ++it ) {
+				ss << "\t" "multipart[" << it->first << "]: " << it->second << std::endl;
+			}
+			ss << "\t" "data: " << data << std::endl;
+			ss << "}; //route66::request [" << this << "]" << std::endl;
+			return ss.str();
+		}
+	};
+
+	/*/ callback; 'alias'
+	/*/ typedef std::function< int(request &,std::ostream &,std::ostream &) > callback;
+
+	/*/ create() 'start a daemon at given port and route mask, callback will be invoked; returns false if failed.'
+	/*/ bool create( unsigned port, const std::string &mask, const route66::callback &callback );
+
+	/*/ fserve() 'start a file server daemon at given port and relative path, all file uri contents will be returned; returns false if failed.'
+	/*/ bool fserve( unsigned port, const std::string &mask, const std::string &relpath );
+
+	/*/ httpcode:: 'listing of HTTP result codes'
+	/*/
+	struct httpcode {
+		unsigned code;
+		const char *const description;
+	};
+
+	/*/ 0XX 'route66'
+	/*/
+	extern const httpcode SHUTDOWN;
+	/*/ 1XX 'informational'
+	/*/
+	extern const httpcode CONTINUE;
+	extern const httpcode SWITCH_PROTOCOLS;
+	/*/ 2XX 'success'
+	/*/
+	extern const httpcode OK;
+	extern const httpcode CREATED;
+	extern const httpcode ACCEPTED;
+	extern const httpcode PARTIAL;
+	extern const httpcode NO_CONTENT;
+	extern const httpcode RESET_CONTENT;
+	extern const httpcode PARTIAL_CONTENT;
+	extern const httpcode WEBDAV_MULTI_STATUS;
+	/*/ 3XX 'redirection'
+	/*/
+	extern const httpcode AMBIGUOUS;
+	extern const httpcode MOVED;
+	extern const httpcode REDIRECT;
+	extern const httpcode REDIRECT_METHOD;
+	extern const httpcode NOT_MODIFIED;
+	extern const httpcode USE_PROXY;
+	extern const httpcode REDIRECT_KEEP_VERB;
+	/*/ 4XX 'client error'
+	/*/
+	extern const httpcode BAD_REQUEST;
+	extern const httpcode DENIED;
+	extern const httpcode PAYMENT_REQ;
+	extern const httpcode FORBIDDEN;
+	extern const httpcode NOT_FOUND;
+	extern const httpcode BAD_METHOD;
+	extern const httpcode NONE_ACCEPTABLE;
+	extern const httpcode PROXY_AUTH_REQ;
+	extern const httpcode REQUEST_TIMEOUT;
+	extern const httpcode CONFLICT;
+	extern const httpcode GONE;
+	extern const httpcode LENGTH_REQUIRED;
+	extern const httpcode PRECOND_FAILED;
+	extern const httpcode REQUEST_TOO_LARGE;
+	extern const httpcode URI_TOO_LONG;
+	extern const httpcode UNSUPPORTED_MEDIA;
+	extern const httpcode RETRY_WITH;
+	/*/ 5XX 'server error'
+	/*/
+	extern const httpcode SERVER_ERROR;
+	extern const httpcode NOT_SUPPORTED;
+	extern const httpcode BAD_GATEWAY;
+	extern const httpcode SERVICE_UNAVAIL;
+	extern const httpcode GATEWAY_TIMEOUT;
+	extern const httpcode VERSION_NOT_SUP;
+
+	/*/ mime() 'MIME string header based on file extension (ie, sample.json -> "Content-Type: application/json; charset=utf-8\r\n" )' /*/
+	/*/ tag()  'MIME string tag based on file extension (ie, sample.json -> "application/json" )' /*/
+	std::string mime( const std::string &filename_ext );
+	std::string tag( const std::string &filename_ext );
+}
+
+namespace {
+	// http://stackoverflow.com/questions/2673207/c-c-url-decode-library
+	char * urldecode2(char *dst, const char *src) {
+		char a, b;
+		while (*src) {
+			if ((*src == '%') &&
+				((a = src[1]) && (b = src[2])) &&
+				(isxdigit(a) && isxdigit(b))) {
+					if (a >= 'a')
+							a -= 'a'-'A';
+					if (a >= 'A')
+							a -= ('A' - 10);
+					else
+							a -= '0';
+					if (b >= 'a')
+							b -= 'a'-'A';
+					if (b >= 'A')
+							b -= ('A' - 10);
+					else
+							b -= '0';
+					*dst++ = 16*a+b;
+					src+=3;
+			} else {
+				*dst++ = *src++;
+			}
+		}
+		*dst++ = '\0';
+		return dst - 1;
+	}
+
+	std::string &urldecode2( std::string &url ) {
+		char *begin = &url[0], *end = urldecode2( begin, begin );
+		url.resize( end - begin );
+		return url;
+	}
+
+	// taken from https://github.com/r-lyeh/wire
+	std::string replace( std::string s, const std::string &target, const std::string &repl ) {
+		for( size_t it = 0, tlen = target.length(), rlen = repl.length(); ( it = s.find( target, it ) ) != std::string::npos; it += rlen ) {
+			s.replace( it, tlen, repl );
+		}
+		return s;
+	};
+	std::vector< std::string > tokenize( const std::string &self, const std::string &delimiters ) {
+		std::string map( 256, '\0' );
+		for( std::string::const_iterator it = delimiters.begin(), end = delimiters.end(); it != end; ++it ) {
+			unsigned char ch( *it );
+			map[ ch ] = '\1';
+		}
+		std::vector< std::string > tokens(1);
+		for( std::string::const_iterator it = self.begin(), end = self.end(); it != end; ++it ) {
+			unsigned char ch( *it );
+			/**/ if( !map.at(ch)          ) tokens.back().push_back( char(ch) );
+			else if( tokens.back().size() ) tokens.push_back( std::string() );
+		}
+		while( tokens.size() && !tokens.back().size() ) tokens.pop_back();
+		return tokens;
+	}
+	bool match( const char *pattern, const char *str ) {
+		if( *pattern=='\0' ) return !*str;
+		if( *pattern=='*' )  return match(pattern+1, str) || (*str && match(pattern, str+1));
+		if( *pattern=='?' )  return *str && (*str != '.') && match(pattern+1, str+1);
+		return (*str == *pattern) && match(pattern+1, str+1);
+	}
+	bool matches( const std::string &self, const std::string &pattern ) {
+		return match( pattern.c_str(), self.c_str() );
+	}
+	bool endswith( const std::string &self, const std::string &eof ) {
+		return eof.size() < self.size() && self.substr( self.size() - eof.size() ) == eof;
+	}
+}
+
+namespace route66 {
+
+std::string tag( const std::string &pathfile ) {
+	static std::map< std::string, std::string> mimes;
+	if( mimes.empty() ) {
+		// [ref] taken from http://en.wikipedia.org/wiki/Internet_media_type
+
+		mimes[".avi"] = "video/avi";                  // Covers most Windows-compatible formats including .avi and .divx[16]
+		mimes[".mpg"] = "video/mpeg";                 // MPEG-1 video with multiplexed audio; Defined in RFC 2045 and RFC 2046
+		mimes[".mpeg"] = "video/mpeg";                // MPEG-1 video with multiplexed audio; Defined in RFC 2045 and RFC 2046
+		mimes[".mp4"] = "video/mp4";                  // MP4 video; Defined in RFC 4337
+		mimes[".mov"] = "video/quicktime";            // QuickTime video; Registered[17]
+		mimes[".webm"] = "video/webm";                // WebM Matroska-based open media format
+		mimes[".mkv"] = "video/x-matroska";           // Matroska open media format
+		mimes[".wmv"] = "video/x-ms-wmv";             // Windows Media Video; Documented in Microsoft KB 288102
+		mimes[".flv"] = "video/x-flv";                // Flash video (FLV files)
+
+		mimes[".css"] = "text/css";                   // Cascading Style Sheets; Defined in RFC 2318
+		mimes[".csv"] = "text/csv";                   // Comma-separated values; Defined in RFC 4180
+		mimes[".htm"] = "text/html";                  // HTML; Defined in RFC 2854
+		mimes[".html"] = "text/html";                 // HTML; Defined in RFC 2854
+		mimes[".txt"] = "text/plain";                 // Textual data; Defined in RFC 2046 and RFC 3676
+		mimes[".text"] = "text/plain";                // Textual data; Defined in RFC 2046 and RFC 3676
+		mimes[".rtf"] = "text/rtf";                   // RTF; Defined by Paul Lindner
+		mimes[".xml"] = "text/xml";                   // Extensible Markup Language; Defined in RFC 3023
+		mimes[".tsv"] = "text/tab-separated-values";
+
+		mimes[".gif"] = "image/gif";                  // GIF image; Defined in RFC 2045 and RFC 2046
+		mimes[".jpg"] = "image/jpeg";                 // JPEG JFIF image; Defined in RFC 2045 and RFC 2046
+		mimes[".jpeg"] = "image/jpeg";                // JPEG JFIF image; Defined in RFC 2045 and RFC 2046
+		mimes[".pjpg"] = "image/pjpeg";               // JPEG JFIF image; Associated with Internet Explorer; Listed in ms775147(v=vs.85) - Progressive JPEG, initiated before global browser support for progressive JPEGs (Microsoft and Firefox).
+		mimes[".pjpeg"] = "image/pjpeg";              // JPEG JFIF image; Associated with Internet Explorer; Listed in ms775147(v=vs.85) - Progressive JPEG, initiated before global browser support for progressive JPEGs (Microsoft and Firefox).
+		mimes[".png"] = "image/png";                  // Portable Network Graphics; Registered,[13] Defined in RFC 2083
+		mimes[".svg"] = "image/svg+xml";              // SVG vector image; Defined in SVG Tiny 1.2 Specification Appendix M
+		mimes[".psd"] = "image/vnd.adobe.photoshop";
+
+		mimes[".aif"] = "audio/x-aiff";
+		mimes[".s3m"] = "audio/s3m";
+		mimes[".xm"] = "audio/xm";
+		mimes[".snd"] = "audio/x-adpcm";
+		mimes[".mp3"] = "audio/mpeg3";
+		mimes[".ogg"] = "audio/ogg";                  // Ogg Vorbis, Speex, Flac and other audio; Defined in RFC 5334
+		mimes[".opus"] = "audio/opus";                // Opus audio
+		mimes[".vorbis"] = "audio/vorbis";            // Vorbis encoded audio; Defined in RFC 5215
+		mimes[".wav"] = "audio/x-wav";
+
+		mimes[".atom"] = "application/atom+xml";      // Atom feeds
+		mimes[".dart"] = "application/dart";          // Dart files [8]
+		mimes[".ejs"] = "application/ecmascript";     // ECMAScript/JavaScript; Defined in RFC 4329 (equivalent to application/javascript but with stricter processing rules)
+		mimes[".json"] = "application/json";          // JavaScript Object Notation JSON; Defined in RFC 4627
+		mimes[".js"] = "application/javascript";      // ECMAScript/JavaScript; Defined in RFC 4329 (equivalent to application/ecmascript but with looser processing rules) It is not accepted in IE 8 or earlier - text/javascript is accepted but it is defined as obsolete in RFC 4329. The "type" attribute of the <script> tag in HTML5 is optional. In practice, omitting the media type of JavaScript programs is the most interoperable solution, since all browsers have always assumed the correct default even before HTML5.
+		mimes[".bin"] = "application/octet-stream";   // Arbitrary binary data.[9] Generally speaking this type identifies files that are not associated with a specific application. Contrary to past assumptions by software packages such as Apache this is not a type that should be applied to unknown files. In such a case, a server or application should not indicate a content type, as it may be incorrect, but rather, should omit the type in order to allow the recipient to guess the type.[10]
+		mimes[".pdf"] = "application/pdf";            // Portable Document Format, PDF has been in use for document exchange on the Internet since 1993; Defined in RFC 3778
+		mimes[".ps"] = "application/postscript";      // PostScript; Defined in RFC 2046
+		mimes[".rdf"] = "application/rdf+xml";        // Resource Description Framework; Defined by RFC 3870
+		mimes[".rss"] = "application/rss+xml";        // RSS feeds
+		mimes[".soap"] = "application/soap+xml";      // SOAP; Defined by RFC 3902
+		mimes[".font"] = "application/font-woff";     // Web Open Font Format; (candidate recommendation; use application/x-font-woff until standard is official)
+		mimes[".xhtml"] = "application/xhtml+xml";    // XHTML; Defined by RFC 3236
+		mimes[".xml"] = "application/xml";            // XML files; Defined by RFC 3023
+		mimes[".zip"] = "application/zip";            // ZIP archive files; Registered[11]
+		mimes[".gz"] = "application/gzip";            // Gzip, Defined in RFC 6713
+		mimes[".nacl"] = "application/x-nacl";        // Native Client web module (supplied via Google Web Store only)
+		mimes[".pnacl"] = "application/x-pnacl";      // Portable Native Client web module (may supplied by any website as it is safer than x-nacl)
+	};
+
+	size_t ext = pathfile.find_last_of(".");
+	if( ext != std::string::npos ) {
+		std::map<std::string, std::string>::const_iterator found = mimes.find( &pathfile[ext] );
+		if( found != mimes.end() ) {
+			return found->second;
+		}
+	}
+	return mimes[".txt"];
+}
+
+std::string mime( const std::string &filename_ext ) {
+	return std::string("Content-Type: ") + tag(filename_ext) + "; charset=utf-8\r\n";
+};
+
+std::string interval_from_headers( const std::string &header, const std::string &text1, const std::string &text2 ) {
+	size_t pos = header.find(text1);
+	if( pos == std::string::npos ) {
+		return std::string();
+	}
+	pos += text1.size();
+	size_t pos2 = header.find(text2, pos);
+	if( pos2 == std::string::npos ) {
+		return header.substr(pos);
+	} else {
+		return header.substr(pos, pos2-pos);
+	}
+}
+
+std::string extract_from_headers( const std::string &header, const std::string &text ) {
+	size_t pos = header.find(text);
+	if( pos == std::string::npos ) {
+		return std::string();
+	}
+	pos += text.size();
+	size_t pos2 = header.find( "\r\n", pos );
+	if( pos2 == std::string::npos ) {
+		return header.substr(pos);
+	} else {
+		return header.substr(pos, pos2-pos);
+	}
+}
+
+struct daemon {
+	int socket;
+	const std::map< std::string /*path*/, route66::callback /*fn*/ > *routers;
+	std::string base;
+
+	daemon() : socket(-1), routers(0)
+	{}
+
+	void operator()() {
+		bool shutdown = false;
+		while( !shutdown ) {
+			enum { buflen = 1024 * 1024, SPACES = 2 /*>=2*/ };
+
+			int child = ACCEPT(socket,0,0), o = 0, h[SPACES] = {}, hi = 0;
+			if( child < 0 ) continue;
+
+			std::string buf( buflen, '\0' );
+			char *b = &buf[0];
+
+			while(hi<SPACES&&o<buflen) {
+				int n = READ(child,b+o,buflen-o);
+				if(n<=0) { break; }
+				else {
+					int i = o;
+					o+=n;
+					for(;i<n&&hi<SPACES;i++) {
+					if((hi < SPACES) && b[i] == ' ') { h[hi++] = i; }
+					}
+				}
+			}
+
+			if(hi >= SPACES) {
+				b[ o ] = '\0';
+				buf.resize( o );
+
+				const char *logmask = std::getenv("R66LOG");
+				if( logmask ) {
+					if( matches(b, logmask) ) {
+						//__asm int 3;
+						//fprintf(stdout, "%s,%s\n", multipart.c_str(), boundary.c_str());
+					}
+				}
+
+				typedef std::map< std::string, std::string > filemap;
+				static std::map< std::string /*boundary*/, filemap > boundaries;
+
+				unsigned curlen = 0;
+
+				std::string boundary = std::string("--") + extract_from_headers( buf, "Content-Type: multipart/form-data; boundary=");
+				std::string eof = boundary + "--\r\n";
+				std::string headers = buf.substr( 0, buf.find("\r\n\r\n") + 4 );
+				std::string payload = buf.substr( headers.size() );
+
+				while( boundary.size() > 2 && !endswith( payload, eof ) ) {
+					std::stringstream head1, head2;
+					head1 << "HTTP/1.1 100 Continue\r\n";
+					WRITE( child, head1.str().c_str(), head1.str().size() );
+
+					o = 0;
+					buf.clear();
+					buf.resize( buflen, '\0' );
+
+					int n;
+					n = READ(child,b+o,buflen-o);
+					if(n<=0) { break; }
+
+					buf.resize( n );
+
+					payload += buf;
+				}
+
+				route66::request rq;
+
+				if( boundary.size() > 2 ) {
+					payload = interval_from_headers( payload, boundary + "\r\n", boundary );
+
+					{
+						std::string headers = payload.substr( 0, payload.find("\r\n\r\n") + 4 );
+						std::string file = extract_from_headers( headers, "Content-Disposition: form-data; name=");
+						file = file.substr( 1, file.size() - 2 ); // remove ""
+
+						payload = payload.substr( headers.size() );
+						rq.multipart[ file ] = payload;
+					}
+
+					buf = headers;
+				}
+
+				rq.data = buf;
+
+				char org = b[h[1]];
+				b[h[1]] = '\0';
+
+#if 1
+				socklen_t len;
+				struct sockaddr_storage addr;
+				char ipstr[INET_ADDRSTRLEN];
+				len = sizeof addr;
+				getpeername(child, (struct sockaddr*) &addr, &len);
+				struct sockaddr_in *s = (struct sockaddr_in *) &addr;
+				inet_ntop(AF_INET, &s->sin_addr, ipstr, sizeof ipstr);
+				if( std::strcmp("127.0.0.1", ipstr) == 0 ) rq.ip = "localhost";
+				else rq.ip = ipstr;
+
+				struct sockaddr_in l;
+				len = sizeof(l);
+				if (getsockname(child, (struct sockaddr *)&l, &len) != -1) {
+					rq.port = ntohs(l.sin_port);
+				} else {
+					rq.port = 0;
+				}
+#endif
+
+				std::string method( b, h[0] );
+				std::string url( &b[h[0]+1] ); //skip "GET "
+				b[h[1]] = org;
+
+				std::string path, options;
+
+				size_t mark = url.find_first_of('?');
+				if( mark == std::string::npos ) {
+					path = url;
+				} else {
+					path = url.substr( 0, mark );
+					options = url.substr( mark + 1 );
+				}
+
+				if( method == "PUT" || method == "POST" )  {
+					options = &b[ std::string(b).find("\r\n\r\n") + 4 ];
+				}
+
+				std::string route = method + " " + path;
+				std::map< std::string, route66::callback >::const_iterator found = routers->find( route );
+				if( found == routers->end() ) {
+					// bad route, try index wildcard matching
+					for( found = routers->begin(); found != routers->end(); ++found ) {
+						if( matches( route, found->first ) ) {
+							break;
+						}
+					}
+				}
+				if( found == routers->end() ) {
+					// bad route, try index fallback
+					found = routers->find("GET /");
+				}
+
+				if( found != routers->end() ) {
+
+					rq.method = method;
+					rq.url = url;
+					rq.uri = path;
+					rq.options = options;
+
+					urldecode2( rq.uri );
+
+					// arguments
+					std::vector< std::string > split = tokenize( options, "&" );
+					for( std::vector< std::string >::const_iterator it = split.begin(), end = split.end(); it != end; ++it ) {
+						const std::string &glued = *it;
+						std::vector< std::string > pair = tokenize( glued, "=" );
+						if( 2 == pair.size() ) {
+							rq.arguments[ urldecode2(pair[0]) ] = urldecode2(pair[1]);
+						} else {
+							rq.arguments[ urldecode2(pair[0]) ] = std::string();
+						}
+					}
+
+					// normalize & rebase (if needed)
+					if( rq.uri == "" || rq.uri == "/" ) rq.uri = "index.html";
+					rq.uri = base + rq.uri;
+
+					if( logmask ) {
+						char addr[64]; sprintf(addr, "%s:%d", rq.ip.c_str(), rq.port );
+						if( matches(addr, logmask) || matches(rq.uri, logmask) || matches(rq.data, logmask) ) {
+							fprintf(stdout, "%s - %s\n%s\n", addr, rq.uri.c_str(), rq.str().c_str());
+						}
+					}
+
+					{
+						const route66::callback &fn = found->second;
+						std::stringstream headers, contents;
+						int httpcode = fn( rq, headers, contents );
+
+						std::string datas = contents.str();
+						shutdown = ( 0 == httpcode ? true : false );
+
+						if( !shutdown && datas.size() ) {
+							std::stringstream head1, head2;
+							head1 << "HTTP/1.1 " << httpcode << " OK\r\n";
+							head2 << headers.str() << "Content-Length: " << datas.size() << "\r\n\r\n";
+
+							WRITE( child, head1.str().c_str(), head1.str().size() );
+							WRITE( child, head2.str().c_str(), head2.str().size() );
+							if( method != "HEAD" )
+							WRITE( child, datas.c_str(), datas.size() );
+						}
+					}
+
+				}
+
+				SHUTDOWN(child);
+				CLOSE(child);
+			}
+		}
+	}
+};
+
+namespace {
+
+	typedef std::map< std::string /*path*/, route66::callback /*fn */> routers;
+
+	bool create( unsigned port, const std::string &mask, const route66::callback &fn, std::string base ) {
+		static std::map< unsigned, routers > daemons;
+
+		if( daemons.find(port) == daemons.end() ) {
+			INIT();
+			int socket = SOCKET(PF_INET, SOCK_STREAM, IPPROTO_IP);
+			if( socket < 0 ) {
+				return "cannot init socket", false;
+			}
+
+			struct sockaddr_in l;
+			std::memset( &l, 0, sizeof(sockaddr_in) );
+			l.sin_family = AF_INET;
+			l.sin_port = htons(port);
+			l.sin_addr.s_addr = INADDR_ANY;
+	#       if !defined(_WIN32)
+			int r = 1; setsockopt(socket,SOL_SOCKET,SO_REUSEADDR,&r,sizeof(r));
+	#       endif
+			BIND(socket,(struct sockaddr *)&l,sizeof(l));
+			LISTEN(socket,5);
+
+			route66::daemon dm;
+			dm.socket = socket;
+			dm.routers = &daemons[ port ];
+			dm.base = base;
+			std::thread( dm ).detach();
+		}
+
+		daemons[ port ][ mask ] = fn;
+
+		return "ok", true;
+	}
+}
+
+bool create( unsigned port, const std::string &mask, const route66::callback &fn ) {
+	return create( port, mask, fn, std::string() );
+}
+
+namespace {
+
+	std::string get_app_folder() {
+#       ifdef _WIN32
+			char s_path[MAX_PATH] = {0};
+			const size_t len = MAX_PATH;
+
+			HMODULE mod = 0;
+			::GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (LPCSTR)&get_app_folder, &mod);
+			DWORD size = ::GetModuleFileNameA(mod, s_path, (DWORD)len);
+
+			while( size > 0 ) {
+				if( s_path[size] == '\\' ) {
+					s_path[size+1] = '\0';
+					return s_path;
+				}
+				--size;
+			}
+			return std::string();
+#       else
+			char arg1[20];
+			char exepath[PATH_MAX + 1] = {0};
+
+			sprintf( arg1, "/proc/%d/exe", getpid() );
+			readlink( arg1, exepath, 1024 );
+			return std::string( exepath );
+#       endif
+	}
+
+	int file_reader( route66::request &request, std::ostream &headers, std::ostream &contents ) {
+		std::ifstream ifs( request.uri.c_str(), std::ios::binary );
+		if( ifs.good() ) {
+			headers << route66::mime(request.uri);
+			contents << ifs.rdbuf();
+			return 200;
+		} else {
+			headers << route66::mime(".text");
+			contents << "404: not found" << std::endl;
+			//contents << request.uri << std::endl;
+			return 404;
+		}
+	}
+}
+
+bool fserve( unsigned port, const std::string &mask, const std::string &path ) {
+	return create( port, mask, file_reader, get_app_folder() + path );
+}
+
+#undef INIT
+#undef SOCKET
+#undef ACCEPT
+#undef CONNECT
+#undef CLOSE
+#undef RECV
+#undef READ
+#undef SELECT
+#undef SEND
+#undef WRITE
+#undef GETSOCKOPT
+#undef SETSOCKOPT
+
+#undef BIND
+#undef LISTEN
+#undef SHUTDOWN
+#undef SHUTDOWN_R
+#undef SHUTDOWN_W
+
+/*/ 1XX informational
+/*/ const httpcode SHUTDOWN = { 0, "Shutdown requested" };
+/*/ 1XX informational
+/*/ const httpcode CONTINUE = { 100, "The request can be continued." }; /*/
+/*/ const httpcode SWITCH_PROTOCOLS = { 101, "The server has switched protocols in an upgrade header." };
+/*/ 2XX success
+/*/ const httpcode OK = { 200, "The request completed successfully." }; /*/
+/*/ const httpcode CREATED = { 201, "The request has been fulfilled and resulted in the creation of a new resource." }; /*/
+/*/ const httpcode ACCEPTED = { 202, "The request has been accepted for processing, but the processing has not been completed." }; /*/
+/*/ const httpcode PARTIAL = { 203, "The returned meta information in the entity-header is not the definitive set available from the originating server." }; /*/
+/*/ const httpcode NO_CONTENT = { 204, "The server has fulfilled the request, but there is no new information to send back." }; /*/
+/*/ const httpcode RESET_CONTENT = { 205, "The request has been completed, and the client program should reset the document view that caused the request to be sent to allow the user to easily initiate another input action." }; /*/
+/*/ const httpcode PARTIAL_CONTENT = { 206, "The server has fulfilled the partial GET request for the resource." }; /*/
+/*/ const httpcode WEBDAV_MULTI_STATUS = { 207, "During a World Wide Web Distributed Authoring and Versioning (WebDAV) operation, this indicates multiple status const httpcodes for a single response. The response body contains Extensible Markup Language (XML) that describes the status const httpcodes. For more information, see HTTP Extensions for Distributed Authoring." };
+/*/ 3XX redirection
+/*/ const httpcode AMBIGUOUS = { 300, "The requested resource is available at one or more locations." }; /*/
+/*/ const httpcode MOVED = { 301, "The requested resource has been assigned to a new permanent Uniform Resource Identifier (URI), and any future references to this resource should be done using one of the returned URIs." }; /*/
+/*/ const httpcode REDIRECT = { 302, "The requested resource resides temporarily under a different URI." }; /*/
+/*/ const httpcode REDIRECT_METHOD = { 303, "The response to the request can be found under a different URI and should be retrieved using a GET HTTP verb on that resource." }; /*/
+/*/ const httpcode NOT_MODIFIED = { 304, "The requested resource has not been modified." }; /*/
+/*/ const httpcode USE_PROXY = { 305, "The requested resource must be accessed through the proxy given by the location field." }; /*/
+/*/ const httpcode REDIRECT_KEEP_VERB = { 307, "The redirected request keeps the same HTTP verb. HTTP/1.1 behavior." };
+/*/ 4XX client's fault
+/*/ const httpcode BAD_REQUEST = { 400, "The request could not be processed by the server due to invalid syntax." }; /*/
+/*/ const httpcode DENIED = { 401, "The requested resource requires user authentication." }; /*/
+/*/ const httpcode PAYMENT_REQ = { 402, "Not implemented in the HTTP protocol." }; /*/
+/*/ const httpcode FORBIDDEN = { 403, "The server understood the request, but cannot fulfill it." }; /*/
+/*/ const httpcode NOT_FOUND = { 404, "The server has not found anything that matches the requested URI." }; /*/
+/*/ const httpcode BAD_METHOD = { 405, "The HTTP verb used is not allowed." }; /*/
+/*/ const httpcode NONE_ACCEPTABLE = { 406, "No responses acceptable to the client were found." }; /*/
+/*/ const httpcode PROXY_AUTH_REQ = { 407, "Proxy authentication required." }; /*/
+/*/ const httpcode REQUEST_TIMEOUT = { 408, "The server timed out waiting for the request." }; /*/
+/*/ const httpcode CONFLICT = { 409, "The request could not be completed due to a conflict with the current state of the resource. The user should resubmit with more information." }; /*/
+/*/ const httpcode GONE = { 410, "The requested resource is no longer available at the server, and no forwarding address is known." }; /*/
+/*/ const httpcode LENGTH_REQUIRED = { 411, "The server cannot accept the request without a defined content length." }; /*/
+/*/ const httpcode PRECOND_FAILED = { 412, "The precondition given in one or more of the request header fields evaluated to false when it was tested on the server." }; /*/
+/*/ const httpcode REQUEST_TOO_LARGE = { 413, "The server cannot process the request because the request entity is larger than the server is able to process." }; /*/
+/*/ const httpcode URI_TOO_LONG = { 414, "The server cannot service the request because the request URI is longer than the server can interpret." }; /*/
+/*/ const httpcode UNSUPPORTED_MEDIA = { 415, "The server cannot service the request because the entity of the request is in a format not supported by the requested resource for the requested method." }; /*/
+/*/ const httpcode RETRY_WITH = { 449, "The request should be retried after doing the appropriate action." };
+/*/ 5XX server's fault
+/*/ const httpcode SERVER_ERROR = { 500, "The server encountered an unexpected condition that prevented it from fulfilling the request." }; /*/
+/*/ const httpcode NOT_SUPPORTED = { 501, "The server does not support the functionality required to fulfill the request." }; /*/
+/*/ const httpcode BAD_GATEWAY = { 502, "The server, while acting as a gateway or proxy, received an invalid response from the upstream server it accessed in attempting to fulfill the request." }; /*/
+/*/ const httpcode SERVICE_UNAVAIL = { 503, "The service is temporarily overloaded." }; /*/
+/*/ const httpcode GATEWAY_TIMEOUT = { 504, "The request was timed out waiting for a gateway." }; /*/
+/*/ const httpcode VERSION_NOT_SUP = { 505, "The server does not support the HTTP protocol version that was used in the request message." };
+
+}
+
+
+#endif
+
+// checks: todo
+// if /MD or /MDd and kTraceyReportWildPointers warn user "not a good idea"
+#if kTraceyHookLegacyCRT && !$on($linux)
+	$warning( "<tracey/tracey.cpp> says: kTraceyHookLegacyCRT option ignored. CRT hooking not supported on this platform.")
+#   undef  kTraceyHookLegacyCRT
+#   define kTraceyHookLegacyCRT 0
+#endif
+
+#if kTraceyHookMmap && !$on($linux)
+	$warning( "<tracey/tracey.cpp> says: kTraceyHookMmap option ignored. mmap hooking not supported on this platform.")
+#   undef  kTraceyHookMmap
+#   define kTraceyHookMmap 0
+#endif
+
+// inline headers are written by the allocating thread, so they cannot wait for the aggregator
+#if kTraceyHeaders && kTraceyAsync
+	$warning( "<tracey/tracey.cpp> says: kTraceyAsync option ignored. Not compatible with kTraceyHeaders.")
+#   undef  kTraceyAsync
+#   define kTraceyAsync 0
+#endif
+
+// forked children restart the async aggregator, see container::after_fork()
+#if !$on($windows)
+#include <pthread.h>
+#endif
+
+// C allocator is interposed at the end of this file, so tracey reaches the real one through crt::realloc
+#if kTraceyHookLegacyCRT
+#include <dlfcn.h>
+namespace tracey { namespace crt { void *realloc( void *ptr, size_t size ); void *calloc( size_t num, size_t size ); void *memalign( size_t alignment, size_t size ); void free( void *ptr ); } }
+#   undef  kTraceyRealloc
+#   define kTraceyRealloc tracey::crt::realloc
+#   undef  kTraceyCalloc
+#   define kTraceyCalloc tracey::crt::calloc
+#   undef  kTraceyFree
+#   define kTraceyFree tracey::crt::free
+#endif
+
+// mmap and friends are interposed at the end of this file too, so tracey maps its own memory through vm::
+#if kTraceyHookMmap
+#include <dlfcn.h>
+namespace tracey { namespace vm { void *mmap( void *addr, size_t length, int prot, int flags, int fd, off_t offset ); int madvise( void *addr, size_t length, int advice ); } }
+#   define kTraceyMmap    tracey::vm::mmap
+#   define kTraceyMadvise tracey::vm::madvise
+#else
+#   define kTraceyMmap    mmap
+#   define kTraceyMadvise madvise
+#endif
+
+namespace tracey
+{
+	static void webmain( void * );
+	static void hotkeymain( void * );
+	static void on_report_signal( int );
+
+	typedef heal::sfstring string;
+	typedef heal::sfstrings strings;
+
+	std::string human( size_t bytes ) {
+		/**/ if( bytes >= 1024 * 1024 * 1024 ) return tracey::string("\1 GB", bytes / (1024 * 1024 * 1024));
+		else if( bytes >=   16 * 1024 * 1024 ) return tracey::string("\1 MB", bytes / (       1024 * 1024));
+		else if( bytes >=          16 * 1024 ) return tracey::string("\1 KB", bytes / (              1024));
+		else                                   return tracey::string("\1 bytes", bytes );
+	}
+
+	struct branch {
+		size_t hits;
+		size_t size;
+		branch() : hits(0), size(0) {
+		}
+		branch( const branch &other ) {
+			operator=( other );
+		}
+		branch &operator =( const branch &other ) {
+			if( this != &other ) {
+				hits = other.hits;
+				size = other.size;
+			}
+			return *this;
+		}
+		branch &operator +=( const branch &other ) {
+			this->size += /*(other.hits ? other.hits : 1) **/ other.size;
+			return *this;
+		}
+		bool operator<( const double t ) const {
+			return size < t;
+		}
+
+		std::string str( double total ) const {
+			tracey::string os;
+			int pct = int((size * 100.0) / total);
+			/**/ if( pct >= 100 ) os << tracey::string(   "\1%", pct ) << " .. " << tracey::human( size );
+			else if( pct >=  10 ) os << tracey::string(  "0\1%", pct ) << " .. " << tracey::human( size );
+			else                  os << tracey::string( "00\1%", pct ) << " .. " << tracey::human( size );
+
+			if( hits > 1 ) os << " ; " << hits << " hits";
+			return os;
+		}
+	};
+}
+
+namespace tracey {
+
+	//#include <map>
+	//#include <iostream>
+
+	// tree class
+	// [] is read-only
+	// () is read-writeable (so is <<)
+	typedef void *K;
+	typedef branch V;
+	typedef oak::tree<K,V> tree;
+
+	// for tree walking
+	struct chopper {
+		bool operator()( tracey::tree &tree, tracey::tree::iterator &it ) const {
+			if( it->second.get() < kTraceyTruncateBranchesSmallerThan ) {
+				tree.erase( it->first );
+				return false;
+			} else {
+				return true;
+			}
+		}
+	};
+
+	template<typename U>
+	std::string print( const tree &self, double total, const tracey::string &fmt1234, const tracey::string &sorted_by, bool reversed, const std::map<K,U> &tmap, unsigned depth ) {
+		std::map<std::string,tracey::strings> list;
+		std::string tabs( depth, kTraceyCharTab[0] );
+		if( !tmap.empty() ) {
+			for( tree::const_iterator it = self.begin(), end = self.end(); it != end; ++it  ) {
+				tracey::string key( sorted_by, tmap.find( it->first )->second, it->second.get().str(total), tabs, self.size() );
+				tracey::string value( fmt1234, tmap.find( it->first )->second, it->second.get().str(total), tabs, self.size() );
+				list[ key ].push_back( value );
+				list[ key ].push_back( print( it->second, total, fmt1234, sorted_by, reversed, tmap, depth + 1 ) );
+			}
+		} else {
+			for( tree::const_iterator it = self.begin(), end = self.end(); it != end; ++it  ) {
+				tracey::string key( sorted_by, it->first, it->second.get().str(total), tabs, self.size() );
+				tracey::string value( fmt1234, it->first, it->second.get().str(total), tabs, self.size() );
+				list[ key ].push_back( value );
+				list[ key ].push_back( print( it->second, total, fmt1234, sorted_by, reversed, tmap, depth + 1 ) );
+			}
+		}
+		std::string out;
+		if( !reversed ) {
+			for( std::map<std::string,tracey::strings>::const_iterator it = list.begin(), end = list.end(); it != end; ++it ) {
+				out += it->second.flat();
+			}
+		} else {
+			for( std::map<std::string,tracey::strings>::const_reverse_iterator it = list.rbegin(), end = list.rend(); it != end; ++it ) {
+				out += it->second.flat();
+			}
+		}
+		return out;
+	}
+
+	template<typename U>
+	std::string print( const tree &self, double total, const std::map<K,U> &tmap, const tracey::string &format = "{tabs}[{size}] {key} ({value})\n", const tracey::string &sorted_by = "{key}", bool reversed = false ) {
+		tracey::string fmt = format
+		.replace("{key}",   "\1")
+		.replace("{value}", "\2")
+		.replace("{tabs}",  "\3")
+		.replace("{size}",  "\4");
+		tracey::string sort = sorted_by
+		.replace("{key}",   "\1")
+		.replace("{value}", "\2")
+		.replace("{tabs}",  "\3")
+		.replace("{size}",  "\4");
+		return print( self, total, fmt, sort, reversed, tmap, 0 );
+	}
+
+	std::string print( const tree &self, double total, const tracey::string &format = "{tabs}[{size}] {key} ({value})\n", const tracey::string &sorted_by = "{key}", bool reversed = false ) {
+		std::map<K, K> dummy;
+		return print( self, total, dummy, format, sorted_by, reversed );
+	}
+
+	// calling-context tree with the same contents as tracey::tree, for reports over many leaks.
+	// nodes live in one array and refer to each other by 32-bit index (0 is the root); while the
+	// tree grows, children are found through one open-addressing table keyed by (parent, frame).
+	// refresh() lays every node's children out as a sorted run of one shared index array.
+	class calltree {
+		public:
+
+			struct node {
+				K frame;
+				uint32_t parent, first, count;  // children: kids[first .. first+count)
+				V value;
+			};
+
+			std::vector<node> nodes;
+			std::vector<uint32_t> kids;
+
+			calltree() {
+				node root = { 0, 0, 0, 0, V() };
+				nodes.push_back( root );
+			}
+
+			// child of parent for frame, added if missing
+			uint32_t insert( uint32_t parent, K frame ) {
+				if( ( nodes.size() + 1 ) * 2 > slots.size() ) {
+					grow();
+				}
+				for( size_t i = hash( parent, frame ) & ( slots.size() - 1 ); ; i = ( i + 1 ) & ( slots.size() - 1 ) ) {
+					uint32_t at = slots[i];
+					if( !at ) {
+						node child = { frame, parent, 0, 0, V() };
+						nodes.push_back( child );
+						return slots[i] = uint32_t( nodes.size() - 1 );
+					}
+					if( nodes[at].frame == frame && nodes[at].parent == parent ) {
+						return at;
+					}
+				}
+			}
+
+			// as oak::tree::refresh(): leaves keep their value; inner nodes get the sum of their
+			// children's sizes. children are created after their parent, so one backwards pass does
+			void refresh() {
+				std::vector<uint32_t>().swap( slots );
+				for( size_t i = 0; i < nodes.size(); ++i ) {
+					nodes[i].first = nodes[i].count = 0;
+				}
+				for( size_t i = 1; i < nodes.size(); ++i ) {
+					nodes[ nodes[i].parent ].count++;
+				}
+				uint32_t first = 0;
+				for( size_t i = 0; i < nodes.size(); ++i ) {
+					nodes[i].first = first;
+					first += nodes[i].count;
+					nodes[i].count = 0;
+				}
+				kids.resize( first );
+				for( size_t i = 1; i < nodes.size(); ++i ) {
+					node &up = nodes[ nodes[i].parent ];
+					kids[ up.first + up.count++ ] = uint32_t( i );
+				}
+				std::vector<V> sums( nodes.size() );
+				for( size_t i = nodes.size(); i-- > 0; ) {
+					node &n = nodes[i];
+					std::sort( kids.begin() + n.first, kids.begin() + n.first + n.count, by_frame( nodes ) );
+					if( n.count ) {
+						n.value = sums[i];
+					}
+					if( i ) {
+						sums[ n.parent ] += n.value;
+					}
+				}
+			}
+
+			// as tracey::chopper: drops branches (and everything below them) smaller than threshold
+			void chop( double threshold ) {
+				for( size_t i = 0; i < nodes.size(); ++i ) {
+					node &n = nodes[i];
+					uint32_t kept = 0;
+					for( uint32_t k = 0; k < n.count; ++k ) {
+						if( !( nodes[ kids[ n.first + k ] ].value < threshold ) ) {
+							kids[ n.first + kept++ ] = kids[ n.first + k ];
+						}
+					}
+					n.count = kept;
+				}
+			}
+
+		private:
+
+			std::vector<uint32_t> slots; // node indices; 0 (the root, never a child) marks a free slot
+
+			static size_t hash( uint32_t parent, K frame ) {
+				uint64_t h = uint64_t( uintptr_t( frame ) ) * 0x9E3779B97F4A7C15ull ^ uint64_t( parent ) * 0xC2B2AE3D27D4EB4Full;
+				return size_t( h ^ ( h >> 29 ) );
+			}
+
+			void grow() {
+				std::vector<uint32_t>( std::max<size_t>( 1024, slots.size() * 2 ), 0 ).swap( slots );
+				for( uint32_t at = 1; at < nodes.size(); ++at ) {
+					size_t i = hash( nodes[at].parent, nodes[at].frame ) & ( slots.size() - 1 );
+					while( slots[i] ) i = ( i + 1 ) & ( slots.size() - 1 );
+					slots[i] = at;
+				}
+			}
+
+			struct by_frame {
+				const std::vector<node> &nodes;
+				by_frame( const std::vector<node> &nodes ) : nodes( nodes ) {
+				}
+				bool operator()( uint32_t a, uint32_t b ) const {
+					return nodes[a].frame < nodes[b].frame;
+				}
+			};
+	};
+
+	// same output as print( const tree & ... ): siblings ordered by their sort key, ties by frame
+	struct sibling {
+		std::string key, line;
+		uint32_t at;
+	};
+
+	struct by_key {
+		bool reversed;
+		bool operator()( const sibling &a, const sibling &b ) const {
+			return reversed ? b.key < a.key : a.key < b.key;
+		}
+	};
+
+	template<typename U>
+	void print( const calltree &self, uint32_t at, double total, const tracey::string &fmt1234, const tracey::string &sorted_by, bool reversed, const std::map<K,U> &tmap, unsigned depth, std::string &out ) {
+		const calltree::node &n = self.nodes[ at ];
+		std::string tabs( depth, kTraceyCharTab[0] );
+		std::vector<sibling> list( n.count );
+		for( uint32_t k = 0; k < n.count; ++k ) {
+			const calltree::node &child = self.nodes[ self.kids[ n.first + k ] ];
+			std::string value = child.value.str(total);
+			if( !tmap.empty() ) {
+				const U &name = tmap.find( child.frame )->second;
+				list[k].key = tracey::string( sorted_by, name, value, tabs, n.count );
+				list[k].line = tracey::string( fmt1234, name, value, tabs, n.count );
+			} else {
+				list[k].key = tracey::string( sorted_by, child.frame, value, tabs, n.count );
+				list[k].line = tracey::string( fmt1234, child.frame, value, tabs, n.count );
+			}
+			list[k].at = self.kids[ n.first + k ];
+		}
+		by_key order = { reversed };
+		std::stable_sort( list.begin(), list.end(), order );
+		for( size_t i = 0; i < list.size(); ++i ) {
+			out += list[i].line;
+			print( self, list[i].at, total, fmt1234, sorted_by, reversed, tmap, depth + 1, out );
+		}
+	}
+
+	template<typename U>
+	std::string print( const calltree &self, double total, const std::map<K,U> &tmap, const tracey::string &format = "{tabs}[{size}] {key} ({value})\n", const tracey::string &sorted_by = "{key}", bool reversed = false ) {
+		tracey::string fmt = format
+		.replace("{key}",   "\1")
+		.replace("{value}", "\2")
+		.replace("{tabs}",  "\3")
+		.replace("{size}",  "\4");
+		tracey::string sort = sorted_by
+		.replace("{key}",   "\1")
+		.replace("{value}", "\2")
+		.replace("{tabs}",  "\3")
+		.replace("{size}",  "\4");
+		std::string out;
+		print( self, 0, total, fmt, sort, reversed, tmap, 0, out );
+		return out;
+	}
+
+	// callstack, demangle, lookup
+	using namespace heal;
+}
+
+namespace tracey
+{
+	// compile-time choice of what the allocation hot path does. the kTracey* options only build
+	// tracey::defaults; the code below reads these features through policy_t (kTraceyPolicy), so
+	// whatever a policy leaves out is compiled out instead of being tested on every allocation.
+	//   DEPTH     frames captured per allocation
+	//   UNWINDER  callstack::UNWIND_* used always; -1 follows callstack::unwinder (TRACEY_UNWINDER)
+	//   FILL      byte new blocks are filled with; -1 leaves them as the backend returns them
+	//   OVERHEAD  extra bytes allocated per block, in hundredths of a percent
+	//   WILD      reports wild pointers and sized deallocations that disagree
+	//   SAMPLING  allows sampling (kTraceySampleRate, TRACEY_SAMPLE_RATE); false tracks every allocation
+	//   HEADERS   inline allocation headers instead of hashing on deallocations
+	//   ASYNC     per-thread event buffers instead of locking the registry; ignored along with HEADERS
+	template< unsigned DEPTH_, int UNWINDER_, int FILL_, unsigned OVERHEAD_, bool WILD_, bool SAMPLING_, bool HEADERS_, bool ASYNC_ >
+	struct policy {
+		enum { DEPTH = DEPTH_, UNWINDER = UNWINDER_, FILL = FILL_ };
+		enum { OVERHEAD = OVERHEAD_ };
+		enum { WILD = WILD_, SAMPLING = SAMPLING_, HEADERS = HEADERS_, ASYNC = ASYNC_ && !HEADERS_ };
+
+		// bytes requested for a block of given size. integer math, split so it cannot overflow
+		static size_t budget( size_t size ) {
+			return OVERHEAD != 0 ? size + ( size / 10000 ) * OVERHEAD + ( size % 10000 ) * OVERHEAD / 10000 : size;
+		}
+		static void *fill( void *ptr, size_t size ) {
+			return FILL >= 0 ? kTraceyMemset( ptr, FILL, size ) : ptr;
+		}
+	};
+
+	typedef policy< kTraceyMaxStacktraces, -1,
+		kTraceyMemsetAllocations ? int( (unsigned char)kTraceyMemsetChar ) : -1,
+		unsigned( kTraceyBudgetOverhead * 100 ),
+		!!kTraceyReportWildPointers, true, !!kTraceyHeaders, !!kTraceyAsync > defaults;
+
+	typedef kTraceyPolicy policy_t;
+}
+
+namespace tracey
+{
+	namespace
+	{
+		volatile size_t timestamp_id = 0;
+
+		// inline allocation header (kTraceyHeaders). it sits right before every block handed out by
+		// tracey::malloc() and doubles as the registry record of that block, so a deallocation reaches
+		// its record at a fixed offset. live records are chained per shard for reporting. the cookie
+		// binds the header to its block address, which tells tracey blocks apart from foreign pointers.
+		struct header {
+			header *prev, *next;   // live records of the shard; unused while not tracked
+			size_t size, id;
+			uint32_t stack;
+			uint32_t offset;       // from underlying allocation to block; larger than header_size when aligned
+			uintptr_t cookie;      // block address ^ BLOCK or LIVE
+			float weight;          // allocations this record stands for, as sampled when tracked
+
+			enum { BLOCK = 0x7ACEB10C, LIVE = 0x7ACE11FE };
+
+			bool is( const void *ptr, uintptr_t state ) const {
+				return cookie == ( (uintptr_t)ptr ^ state );
+			}
+			void mark( const void *ptr, uintptr_t state ) {
+				cookie = (uintptr_t)ptr ^ state;
+			}
+		};
+
+		enum { header_size = ( sizeof(header) + 15 ) & ~15 }; // keeps blocks 16-byte aligned
+
+		header *header_of( const void *ptr ) {
+			return (header *)( (char *)ptr - header_size );
+		}
+
+		struct stats_t {
+			size_t usage, usage_peak, num_leaks, leak_peak, overhead;
+			size_t buffer_peak, buffer_stalls; // async mode only
+			size_t sample_rate; // sampling mode only
+			size_t arena_used, arena_footprint; // tracey metadata
+			size_t slab_used, slab_footprint; // slab backend only
+			size_t headers; // header mode only
+			size_t filter_rejects, filter_passes, filter_false_positives; // frees, as seen by the free filter
+			size_t resized, moved, copied; // reallocations of watched blocks (in place, moved) and bytes moved
+			size_t regions, mapped, mapped_anonymous, mapped_discarded, mapped_peak; // mmap hooks only
+			size_t symbol_hits, symbol_misses; // symbol cache, over all reports so far
+			stats_t() : usage(0), usage_peak(0), num_leaks(0), leak_peak(0), overhead(0), buffer_peak(0), buffer_stalls(0), sample_rate(0), arena_used(0), arena_footprint(0), slab_used(0), slab_footprint(0), headers(0),
+				filter_rejects(0), filter_passes(0), filter_false_positives(0), resized(0), moved(0), copied(0),
+				regions(0), mapped(0), mapped_anonymous(0), mapped_discarded(0), mapped_peak(0), symbol_hits(0), symbol_misses(0) {}
+			stats_t &operator +=( const stats_t &other ) {
+				num_leaks += other.num_leaks;
+				leak_peak = std::max( leak_peak, other.leak_peak );
+				overhead += other.overhead;
+				buffer_peak = std::max( buffer_peak, other.buffer_peak );
+				buffer_stalls += other.buffer_stalls;
+				headers += other.headers;
+				resized += other.resized;
+				moved += other.moved;
+				copied += other.copied;
+				return *this;
+			}
+			std::string str() const {
+				std::string out = tracey::string("highest peak: \1 total, \2 greatest peak // \3 allocs in use: \4 + overhead: \5 = total: \6",
+									human(usage_peak), human(leak_peak), num_leaks, human(usage), human(overhead), human( usage + overhead ) );
+				out += tracey::string(" // metadata arena: \1 in use, \2 mapped", human(arena_used), human(arena_footprint) );
+				if( slab_footprint ) {
+					out += tracey::string(" // slab backend: \1 in use, \2 mapped", human(slab_used), human(slab_footprint) );
+				}
+				if( sample_rate ) {
+					out += tracey::string(" // sampled every ~\1 (estimated)", human(sample_rate) );
+				}
+				if( kTraceyHookMmap ) {
+					out += tracey::string(" // mappings: \1 regions, \2 mapped (\3 anonymous), \4 discarded, \5 peak in use",
+									regions, human(mapped), human(mapped_anonymous), human(mapped_discarded), human(mapped_peak) );
+				}
+				if( resized || moved ) {
+					out += tracey::string(" // reallocs: \1 in place, \2 moved, \3 copied", resized, moved, human(copied) );
+				}
+				if( symbol_hits || symbol_misses ) {
+					out += tracey::string(" // symbol cache: \1 hits, \2 misses", symbol_hits, symbol_misses );
+				}
+				if( kTraceyFreeFilterKB ) {
+					out += tracey::string(" // free filter: \1 rejected, \2 passed, \3 false positives", filter_rejects, filter_passes, filter_false_positives );
+				}
+				if( policy_t::HEADERS ) {
+					out += tracey::string(" // inline headers: \1 in use, \2 per allocation", human(headers), human(header_size) );
+				}
+				if( policy_t::ASYNC ) {
+					out += tracey::string(" // event buffers: \1/\2 events high-water, \3 stalls", buffer_peak, int(kTraceyAsyncBufferSize), buffer_stalls );
+				}
+				return out;
+			}
+		};
+
+		size_t create_id() {
+			static std::atomic<size_t> id( 0 );
+			return ++id;
+		}
+
+		bool view_report( const std::string &html ) {
+			$windows( return std::system( tracey::string("start \1", html).c_str() ), true );
+			$apple( return std::system( tracey::string("open \1", html).c_str() ), true );
+			$linux( return std::system( tracey::string("xdg-open \1", html).c_str() ), true );
+			return false;
+		}
+
+		std::string get_temp_pathfile() {
+			$windows(
+				std::string path = std::string( std::getenv("TEMP") ? std::getenv("TEMP") : "." ) + std::tmpnam(0);
+				while( path.size() && path.at( path.size() - 1 ) == '.' ) path.resize( path.size() - 1 );
+				return path;
+			)
+			$welse(
+				return std::string() + std::tmpnam(0);
+			)
+		}
+	}
+
+	namespace detail
+	{
+		struct leak {
+			size_t id, size;
+			const void *addr;
+			uint32_t stack; // interned callstack id, 0 if none
+			float weight;   // allocations this record stands for, as sampled when tracked
+
+			leak() : size(0), id(0), addr(0), stack(0), weight(1)
+			{}
+
+			void wipe() {
+				id = create_id();
+				stack = 0;
+				size = 0;
+				addr = 0;
+				weight = 1;
+			}
+
+			void swap( leak &other ) {
+				std::swap( id, other.id );
+				std::swap( size, other.size );
+				std::swap( addr, other.addr );
+				std::swap( stack, other.stack );
+				std::swap( weight, other.weight );
+			}
+		};
+
+		inline void swap( leak &a, leak &b ) {
+			a.swap( b );
+		}
+	}
+
+	namespace
+	{
+		using namespace tracey::detail;
+
+		typedef std::vector< leak > leaks;
+
+		// private memory for tracey's own data structures, off the application heap. one big address
+		// range is reserved up front and carved into 64 KB spans. small blocks come from per size-class
+		// free lists (16 bytes .. 32 KB, one class per span); bigger ones take whole runs of spans, which
+		// are given back to the kernel when freed. ownership is a range check, so any thread may free.
+		// blocks are aligned to their class size, runs to a span. the slab backend is an arena too.
+		// if the range cannot be reserved, requests fall back to kTraceyRealloc.
+		class arena
+		{
+			public:
+
+			enum { SPAN_BITS = 16, SPAN = 1 << SPAN_BITS, MIN_BITS = 4, CLASSES = SPAN_BITS - MIN_BITS, SMALL = SPAN / 2 };
+
+			static unsigned size_class( size_t size ) {
+				unsigned c = 0;
+				while( (size_t(1) << (c + MIN_BITS)) < size ) ++c;
+				return c;
+			}
+
+			private:
+
+			enum { RUN = 0xFF, TAIL = 0xFE };
+
+			struct node {
+				node *next;
+				size_t spans; // free runs only
+			};
+
+			char *base;
+			size_t reserved, bumped;     // in spans
+			unsigned char *kinds;        // size class of every span; RUN heads a run, TAIL continues it
+			uint32_t *lengths;           // spans of every run, by head span
+			node *lists[ CLASSES ];
+			node *runs;
+			size_t in_use, mapped;       // bytes
+			std::mutex mutex;
+
+			arena( const arena & );
+			arena &operator=( const arena & );
+
+			void *reserve( size_t bytes ) {
+				$windows(
+					return VirtualAlloc( 0, bytes, MEM_RESERVE, PAGE_READWRITE );
+				)
+				$welse(
+					void *ptr = kTraceyMmap( 0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0 );
+					return ptr == MAP_FAILED ? 0 : ptr;
+				)
+			}
+
+			char *span( size_t n ) const {
+				return base + (n << SPAN_BITS);
+			}
+
+			// takes a run of spans, reusing freed ones first
+			char *take( size_t spans ) {
+				for( node **it = &runs; *it; it = &(*it)->next ) {
+					node *run = *it;
+					if( run->spans >= spans ) {
+						if( run->spans > spans ) {
+							node *rest = (node *)( (char *)run + spans * SPAN );
+							rest->next = run->next;
+							rest->spans = run->spans - spans;
+							*it = rest;
+						} else {
+							*it = run->next;
+						}
+						return (char *)run;
+					}
+				}
+				if( bumped + spans > reserved ) {
+					return 0;
+				}
+				char *ptr = span( bumped );
+				$windows(
+					if( !VirtualAlloc( ptr, spans * SPAN, MEM_COMMIT, PAGE_READWRITE ) ) return 0;
+				)
+				bumped += spans;
+				mapped += spans * SPAN;
+				return ptr;
+			}
+
+			// returns a run of spans, releasing its pages
+			void give( char *ptr, size_t spans ) {
+				$windows( VirtualAlloc( ptr, spans * SPAN, MEM_RESET, PAGE_READWRITE ); )
+				$welse( kTraceyMadvise( ptr, spans * SPAN, MADV_DONTNEED ); )
+				node *run = (node *)ptr;
+				run->spans = spans;
+				run->next = runs;
+				runs = run;
+			}
+
+			// pops a block of class c, carving a fresh span if its list is empty. mutex must be held
+			void *pop( unsigned c ) {
+				size_t bytes = size_t(1) << (c + MIN_BITS);
+				if( !lists[c] ) {
+					if( char *fresh = take( 1 ) ) {
+						kinds[ size_t( fresh - base ) >> SPAN_BITS ] = (unsigned char)c;
+						for( size_t at = SPAN; at >= bytes; at -= bytes ) {
+							node *n = (node *)( fresh + at - bytes );
+							n->next = lists[c];
+							lists[c] = n;
+						}
+					}
+				}
+				node *n = lists[c];
+				if( n ) {
+					lists[c] = n->next;
+					in_use += bytes;
+				}
+				return n;
+			}
+
+			// pushes a block of class c back. mutex must be held
+			void push( void *ptr, unsigned c ) {
+				node *n = (node *)ptr;
+				n->next = lists[c];
+				lists[c] = n;
+				in_use -= size_t(1) << (c + MIN_BITS);
+			}
+
+			public:
+
+			// reserves up to 2^bits bytes of address range, less if the system refuses
+			explicit arena( unsigned bits ) : base(0), reserved(0), bumped(0), kinds(0), lengths(0), runs(0), in_use(0), mapped(0) {
+				for( unsigned c = 0; c < CLASSES; ++c ) {
+					lists[c] = 0;
+				}
+				for( size_t bytes = size_t(1) << bits; bytes >= (size_t(1) << 26) && !base; bytes /= 4 ) {
+					char *range = (char *)reserve( bytes );
+					if( range ) {
+						// first span starts on a span boundary, so class alignment holds for every block
+						base = (char *)( ( (uintptr_t)range + SPAN - 1 ) & ~uintptr_t(SPAN - 1) );
+						reserved = ( bytes - size_t( base - range ) ) >> SPAN_BITS;
+					}
+				}
+				if( base ) {
+					// span tables live at the start of the range itself
+					size_t table = reserved * ( sizeof(unsigned char) + sizeof(uint32_t) );
+					size_t spans = ( table + SPAN - 1 ) >> SPAN_BITS;
+					char *ptr = take( spans );
+					lengths = (uint32_t *)ptr;
+					kinds = (unsigned char *)( ptr + reserved * sizeof(uint32_t) );
+					for( size_t n = 0; n < spans; ++n ) {
+						kinds[n] = n ? TAIL : RUN;
+					}
+					lengths[0] = uint32_t( spans );
+					mapped = 0; // tables are touched lazily; not worth accounting
+				}
+			}
+
+			bool owns( const void *ptr ) const {
+				return (const char *)ptr >= base && (const char *)ptr < base + (reserved << SPAN_BITS);
+			}
+
+			// zeroed: block is returned zero-filled. runs come from the kernel (fresh or given back) and
+			// are zero already, but for the free-run node written at their start
+			void *alloc( size_t size, bool zeroed = false ) {
+				if( !base ) {
+					return zeroed ? kTraceyCalloc( 1, size ) : kTraceyRealloc( 0, size );
+				}
+				if( !size ) size = 1;
+				void *ptr = 0;
+				mutex.lock();
+				if( size <= SMALL ) {
+					ptr = pop( size_class( size ) );
+					mutex.unlock();
+					if( ptr && zeroed ) std::memset( ptr, 0, size );
+				} else {
+					size_t spans = ( size + SPAN - 1 ) >> SPAN_BITS;
+					if( char *run = take( spans ) ) {
+						size_t head = size_t( run - base ) >> SPAN_BITS;
+						kinds[ head ] = RUN;
+						for( size_t n = 1; n < spans; ++n ) {
+							kinds[ head + n ] = TAIL;
+						}
+						lengths[ head ] = uint32_t( spans );
+						in_use += spans * SPAN;
+						ptr = run;
+					}
+					mutex.unlock();
+					if( ptr && zeroed ) std::memset( ptr, 0, $windows( size ) $welse( sizeof(node) ) ); // MEM_RESET pages keep their data
+				}
+				if( !ptr ) { // range exhausted
+					return zeroed ? kTraceyCalloc( 1, size ) : kTraceyRealloc( 0, size );
+				}
+				return ptr;
+			}
+
+			// moves up to n blocks of class c into a chain linked through their first word, under one lock
+			void *alloc_chain( unsigned c, unsigned n, unsigned *got ) {
+				void *chain = 0;
+				*got = 0;
+				if( !base ) return 0;
+				mutex.lock();
+				while( *got < n ) {
+					void *ptr = pop( c );
+					if( !ptr ) break;
+					*(void **)ptr = chain;
+					chain = ptr;
+					++*got;
+				}
+				mutex.unlock();
+				return chain;
+			}
+
+			// gives n chained blocks of class c back, under one lock
+			void free_chain( void *chain, unsigned c, unsigned n ) {
+				mutex.lock();
+				while( n-- ) {
+					void *next = *(void **)chain;
+					push( chain, c );
+					chain = next;
+				}
+				mutex.unlock();
+			}
+
+			void free( void *ptr ) {
+				if( !owns( ptr ) ) {
+					if( ptr ) kTraceyFree( ptr );
+					return;
+				}
+				size_t head = size_t( (char *)ptr - base ) >> SPAN_BITS;
+				mutex.lock();
+				unsigned kind = kinds[ head ];
+				if( kind == RUN ) {
+					in_use -= lengths[ head ] * size_t(SPAN);
+					give( (char *)ptr, lengths[ head ] );
+				} else {
+					push( ptr, kind );
+				}
+				mutex.unlock();
+			}
+
+			size_t usable( const void *ptr ) const {
+				size_t head = size_t( (const char *)ptr - base ) >> SPAN_BITS;
+				return kinds[ head ] == RUN ? lengths[ head ] * size_t(SPAN) : size_t(1) << (kinds[ head ] + MIN_BITS);
+			}
+
+			void *realloc( void *ptr, size_t size ) {
+				if( !ptr ) return alloc( size );
+				if( !size ) return free( ptr ), (void *)0;
+				if( !owns( ptr ) ) return kTraceyRealloc( ptr, size );
+				size_t have = usable( ptr );
+				if( size <= have && size > have / 2 ) return ptr;
+				void *fresh = alloc( size );
+				if( fresh ) {
+					std::memcpy( fresh, ptr, have < size ? have : size );
+					free( ptr );
+				}
+				return fresh;
+			}
+
+			// bytes handed out, and bytes of address range touched so far
+			size_t used() const {
+				return in_use;
+			}
+			size_t footprint() const {
+				return mapped;
+			}
+		};
+
+		arena &metadata() {
+			static char placement[ sizeof(arena) ];
+			static arena *self = new (placement) arena( sizeof(void *) > 4 ? 36 : 28 );
+			return *self;
+		}
+
+		// allocation backends. blocks handed out by tracey::malloc() come from the selected one
+		// (kTraceyBackend, TRACEY_BACKEND) and are given back to the one that owns them, so both can
+		// hold blocks at once and the selection can change at any time.
+		struct backend {
+			const char *name;
+			void *(*allocate)( size_t size, bool zeroed );
+			void *(*reallocate)( void *ptr, size_t size );   // ptr is never null, size never 0
+			void  (*deallocate)( void *ptr );
+			void *(*align)( size_t alignment, size_t size ); // power-of-two alignment; null if unsupported
+			size_t (*usable_size)( const void *ptr );        // 0 if unknown
+			bool  (*owns)( const void *ptr );
+
+			enum { SYSTEM = 0, SLAB = 1 };
+			static volatile int selected;
+		};
+
+		volatile int backend::selected = kTraceyBackend;
+
+		// kTraceyRealloc, kTraceyCalloc and kTraceyFree
+		struct system_heap {
+			static void *allocate( size_t size, bool zeroed ) {
+				return zeroed ? kTraceyCalloc( 1, size ) : kTraceyRealloc( 0, size );
+			}
+			static void *reallocate( void *ptr, size_t size ) {
+				return kTraceyRealloc( ptr, size );
+			}
+			static void deallocate( void *ptr ) {
+				kTraceyFree( ptr );
+			}
+			static void *align( size_t alignment, size_t size ) {
+#if $on($windows)
+				return 0; // _aligned_malloc blocks cannot go through kTraceyRealloc
+#elif kTraceyHookLegacyCRT
+				return tracey::crt::memalign( alignment, size );
+#else
+				void *ptr;
+				return posix_memalign( &ptr, alignment, size ) ? 0 : ptr;
+#endif
+			}
+			static size_t usable_size( const void * ) {
+				return 0; // kTraceyRealloc may be any allocator
+			}
+			static bool owns( const void * ) {
+				return true;
+			}
+		};
+
+		// power-of-two size classes (16 bytes .. 32 KB) carved from an arena of their own, with a cache
+		// of free blocks per thread and class in front of it, so most allocations and frees take no lock.
+		// blocks move between the caches and the arena in batches. bigger blocks go to the system heap.
+		class slab
+		{
+			enum { BATCH = 32, LIMIT = 2 * BATCH };
+			enum { FRESH, CACHING, GONE };
+
+			struct cache {
+				void *heads[ arena::CLASSES ];   // free blocks, chained through their first word
+				unsigned counts[ arena::CLASSES ];
+				int state;
+			};
+
+			static cache &mine() {
+				static $tls(cache) mine;
+				return mine;
 			}
-		}
-		*dst++ = '\0';
-		return dst - 1;
-	}
 
-	std::string &urldecode2( std::string &url ) {
-		char *begin = &url[0], *end = urldecode2( begin, begin );
-		url.resize( end - begin );
-		return url;
-	}
+			// gives the cached blocks of an exiting thread back; later frees go to the arena directly
+			struct flush {
+				~flush() {
+					cache &c = mine();
+					c.state = GONE;
+					for( unsigned k = 0; k < arena::CLASSES; ++k ) {
+						if( c.counts[k] ) {
+							heap().free_chain( c.heads[k], k, c.counts[k] );
+						}
+						c.heads[k] = 0;
+						c.counts[k] = 0;
+					}
+				}
+			};
 
-	// taken from https://github.com/r-lyeh/wire
-	std::string replace( std::string s, const std::string &target, const std::string &repl ) {
-		for( size_t it = 0, tlen = target.length(), rlen = repl.length(); ( it = s.find( target, it ) ) != std::string::npos; it += rlen ) {
-			s.replace( it, tlen, repl );
-		}
-		return s;
-	};
-	std::vector< std::string > tokenize( const std::string &self, const std::string &delimiters ) {
-		std::string map( 256, '\0' );
-		for( std::string::const_iterator it = delimiters.begin(), end = delimiters.end(); it != end; ++it ) {
-			unsigned char ch( *it );
-			map[ ch ] = '\1';
-		}
-		std::vector< std::string > tokens(1);
-		for( std::string::const_iterator it = self.begin(), end = self.end(); it != end; ++it ) {
-			unsigned char ch( *it );
-			/**/ if( !map.at(ch)          ) tokens.back().push_back( char(ch) );
-			else if( tokens.back().size() ) tokens.push_back( std::string() );
-		}
-		while( tokens.size() && !tokens.back().size() ) tokens.pop_back();
-		return tokens;
-	}
-	bool match( const char *pattern, const char *str ) {
-		if( *pattern=='\0' ) return !*str;
-		if( *pattern=='*' )  return match(pattern+1, str) || (*str && match(pattern, str+1));
-		if( *pattern=='?' )  return *str && (*str != '.') && match(pattern+1, str+1);
-		return (*str == *pattern) && match(pattern+1, str+1);
-	}
-	bool matches( const std::string &self, const std::string &pattern ) {
-		return match( pattern.c_str(), self.c_str() );
-	}
-	bool endswith( const std::string &self, const std::string &eof ) {
-		return eof.size() < self.size() && self.substr( self.size() - eof.size() ) == eof;
-	}
-}
+			static cache *local() {
+				cache &c = mine();
+				if( c.state != FRESH ) {
+					return c.state == CACHING ? &c : 0;
+				}
+				c.state = GONE; // registering the flush may allocate
+				static thread_local flush on_exit;
+				(void)on_exit;
+				c.state = CACHING;
+				return &c;
+			}
 
-namespace route66 {
+			static arena &heap() {
+				static char placement[ sizeof(arena) ];
+				static arena *self = instance() = new (placement) arena( sizeof(void *) > 4 ? 38 : 29 );
+				return *self;
+			}
 
-std::string tag( const std::string &pathfile ) {
-	static std::map< std::string, std::string> mimes;
-	if( mimes.empty() ) {
-		// [ref] taken from http://en.wikipedia.org/wiki/Internet_media_type
+			public:
 
-		mimes[".avi"] = "video/avi";                  // Covers most Windows-compatible formats including .avi and .divx[16]
-		mimes[".mpg"] = "video/mpeg";                 // MPEG-1 video with multiplexed audio; Defined in RFC 2045 and RFC 2046
-		mimes[".mpeg"] = "video/mpeg";                // MPEG-1 video with multiplexed audio; Defined in RFC 2045 and RFC 2046
-		mimes[".mp4"] = "video/mp4";                  // MP4 video; Defined in RFC 4337
-		mimes[".mov"] = "video/quicktime";            // QuickTime video; Registered[17]
-		mimes[".webm"] = "video/webm";                // WebM Matroska-based open media format
-		mimes[".mkv"] = "video/x-matroska";           // Matroska open media format
-		mimes[".wmv"] = "video/x-ms-wmv";             // Windows Media Video; Documented in Microsoft KB 288102
-		mimes[".flv"] = "video/x-flv";                // Flash video (FLV files)
+			// null until the slab is first used
+			static arena *&instance() {
+				static arena *self = 0;
+				return self;
+			}
 
-		mimes[".css"] = "text/css";                   // Cascading Style Sheets; Defined in RFC 2318
-		mimes[".csv"] = "text/csv";                   // Comma-separated values; Defined in RFC 4180
-		mimes[".htm"] = "text/html";                  // HTML; Defined in RFC 2854
-		mimes[".html"] = "text/html";                 // HTML; Defined in RFC 2854
-		mimes[".txt"] = "text/plain";                 // Textual data; Defined in RFC 2046 and RFC 3676
-		mimes[".text"] = "text/plain";                // Textual data; Defined in RFC 2046 and RFC 3676
-		mimes[".rtf"] = "text/rtf";                   // RTF; Defined by Paul Lindner
-		mimes[".xml"] = "text/xml";                   // Extensible Markup Language; Defined in RFC 3023
-		mimes[".tsv"] = "text/tab-separated-values";
+			static void *allocate( size_t size, bool zeroed ) {
+				if( size > arena::SMALL ) {
+					return system_heap::allocate( size, zeroed );
+				}
+				unsigned k = arena::size_class( size );
+				void *ptr = 0;
+				if( cache *c = local() ) {
+					if( !c->heads[k] ) {
+						c->heads[k] = heap().alloc_chain( k, BATCH, &c->counts[k] );
+					}
+					if( ( ptr = c->heads[k] ) != 0 ) {
+						c->heads[k] = *(void **)ptr;
+						c->counts[k]--;
+					}
+				}
+				if( !ptr ) {
+					ptr = heap().alloc( size ); // falls back to kTraceyRealloc when the range is exhausted
+				}
+				return ptr && zeroed ? std::memset( ptr, 0, size ) : ptr;
+			}
+			static void deallocate( void *ptr ) {
+				size_t bytes = heap().usable( ptr );
+				cache *c = bytes <= arena::SMALL ? local() : 0;
+				if( !c ) {
+					heap().free( ptr );
+					return;
+				}
+				unsigned k = arena::size_class( bytes );
+				*(void **)ptr = c->heads[k];
+				c->heads[k] = ptr;
+				if( ++c->counts[k] > LIMIT ) {
+					// keeps the most recent blocks, which are the likeliest to be warm
+					void *last = ptr;
+					for( unsigned n = 1; n < BATCH; ++n ) {
+						last = *(void **)last;
+					}
+					heap().free_chain( *(void **)last, k, c->counts[k] - BATCH );
+					*(void **)last = 0;
+					c->counts[k] = BATCH;
+				}
+			}
+			static void *reallocate( void *ptr, size_t size ) {
+				size_t have = heap().usable( ptr );
+				void *fresh = allocate( size, false );
+				if( fresh ) {
+					std::memcpy( fresh, ptr, have < size ? have : size );
+					deallocate( ptr );
+				}
+				return fresh;
+			}
+			static void *align( size_t alignment, size_t size ) {
+				// blocks are aligned to their class size
+				size_t bytes = size > alignment ? size : alignment;
+				return bytes > arena::SMALL ? system_heap::align( alignment, size ) : allocate( bytes, false );
+			}
+			static size_t usable_size( const void *ptr ) {
+				return heap().usable( ptr );
+			}
+			static bool owns( const void *ptr ) {
+				arena *self = instance();
+				return self && self->owns( ptr );
+			}
+		};
 
-		mimes[".gif"] = "image/gif";                  // GIF image; Defined in RFC 2045 and RFC 2046
-		mimes[".jpg"] = "image/jpeg";                 // JPEG JFIF image; Defined in RFC 2045 and RFC 2046
-		mimes[".jpeg"] = "image/jpeg";                // JPEG JFIF image; Defined in RFC 2045 and RFC 2046
-		mimes[".pjpg"] = "image/pjpeg";               // JPEG JFIF image; Associated with Internet Explorer; Listed in ms775147(v=vs.85) - Progressive JPEG, initiated before global browser support for progressive JPEGs (Microsoft and Firefox).
-		mimes[".pjpeg"] = "image/pjpeg";              // JPEG JFIF image; Associated with Internet Explorer; Listed in ms775147(v=vs.85) - Progressive JPEG, initiated before global browser support for progressive JPEGs (Microsoft and Firefox).
-		mimes[".png"] = "image/png";                  // Portable Network Graphics; Registered,[13] Defined in RFC 2083
-		mimes[".svg"] = "image/svg+xml";              // SVG vector image; Defined in SVG Tiny 1.2 Specification Appendix M
-		mimes[".psd"] = "image/vnd.adobe.photoshop";
+		const backend backends[] = {
+			{ "system", system_heap::allocate, system_heap::reallocate, system_heap::deallocate, system_heap::align, system_heap::usable_size, system_heap::owns },
+			{ "slab", slab::allocate, slab::reallocate, slab::deallocate, slab::align, slab::usable_size, slab::owns },
+		};
 
-		mimes[".aif"] = "audio/x-aiff";
-		mimes[".s3m"] = "audio/s3m";
-		mimes[".xm"] = "audio/xm";
-		mimes[".snd"] = "audio/x-adpcm";
-		mimes[".mp3"] = "audio/mpeg3";
-		mimes[".ogg"] = "audio/ogg";                  // Ogg Vorbis, Speex, Flac and other audio; Defined in RFC 5334
-		mimes[".opus"] = "audio/opus";                // Opus audio
-		mimes[".vorbis"] = "audio/vorbis";            // Vorbis encoded audio; Defined in RFC 5215
-		mimes[".wav"] = "audio/x-wav";
+		// backend for new blocks
+		const backend &chosen() {
+			return backends[ backend::selected == backend::SLAB ? backend::SLAB : backend::SYSTEM ];
+		}
 
-		mimes[".atom"] = "application/atom+xml";      // Atom feeds
-		mimes[".dart"] = "application/dart";          // Dart files [8]
-		mimes[".ejs"] = "application/ecmascript";     // ECMAScript/JavaScript; Defined in RFC 4329 (equivalent to application/javascript but with stricter processing rules)
-		mimes[".json"] = "application/json";          // JavaScript Object Notation JSON; Defined in RFC 4627
-		mimes[".js"] = "application/javascript";      // ECMAScript/JavaScript; Defined in RFC 4329 (equivalent to application/ecmascript but with looser processing rules) It is not accepted in IE 8 or earlier - text/javascript is accepted but it is defined as obsolete in RFC 4329. The "type" attribute of the <script> tag in HTML5 is optional. In practice, omitting the media type of JavaScript programs is the most interoperable solution, since all browsers have always assumed the correct default even before HTML5.
-		mimes[".bin"] = "application/octet-stream";   // Arbitrary binary data.[9] Generally speaking this type identifies files that are not associated with a specific application. Contrary to past assumptions by software packages such as Apache this is not a type that should be applied to unknown files. In such a case, a server or application should not indicate a content type, as it may be incorrect, but rather, should omit the type in order to allow the recipient to guess the type.[10]
-		mimes[".pdf"] = "application/pdf";            // Portable Document Format, PDF has been in use for document exchange on the Internet since 1993; Defined in RFC 3778
-		mimes[".ps"] = "application/postscript";      // PostScript; Defined in RFC 2046
-		mimes[".rdf"] = "application/rdf+xml";        // Resource Description Framework; Defined by RFC 3870
-		mimes[".rss"] = "application/rss+xml";        // RSS feeds
-		mimes[".soap"] = "application/soap+xml";      // SOAP; Defined by RFC 3902
-		mimes[".font"] = "application/font-woff";     // Web Open Font Format; (candidate recommendation; use application/x-font-woff until standard is official)
-		mimes[".xhtml"] = "application/xhtml+xml";    // XHTML; Defined by RFC 3236
-		mimes[".xml"] = "application/xml";            // XML files; Defined by RFC 3023
-		mimes[".zip"] = "application/zip";            // ZIP archive files; Registered[11]
-		mimes[".gz"] = "application/gzip";            // Gzip, Defined in RFC 6713
-		mimes[".nacl"] = "application/x-nacl";        // Native Client web module (supplied via Google Web Store only)
-		mimes[".pnacl"] = "application/x-pnacl";      // Portable Native Client web module (may supplied by any website as it is safer than x-nacl)
-	};
+		// backend holding ptr
+		const backend &owner( const void *ptr ) {
+			return backends[ slab::owns( ptr ) ? backend::SLAB : backend::SYSTEM ];
+		}
 
-	size_t ext = pathfile.find_last_of(".");
-	if( ext != std::string::npos ) {
-		std::map<std::string, std::string>::const_iterator found = mimes.find( &pathfile[ext] );
-		if( found != mimes.end() ) {
-			return found->second;
+		// header of ptr if ptr is a tracey block, or null. a header crossing into the previous page is
+		// never peeked at, so foreign pointers cannot fault here; such blocks are tracked by the table.
+		// slab blocks are always peeked at, as their header is slab memory too.
+		header *headed( const void *ptr ) {
+			if( !policy_t::HEADERS || ( ( (uintptr_t)ptr & 4095 ) < header_size && !( slab::owns( ptr ) && slab::owns( header_of( ptr ) ) ) ) ) {
+				return 0;
+			}
+			header *h = header_of( ptr );
+			return h->is( ptr, header::BLOCK ) || h->is( ptr, header::LIVE ) ? h : 0;
 		}
-	}
-	return mimes[".txt"];
-}
 
-std::string mime( const std::string &filename_ext ) {
-	return std::string("Content-Type: ") + tag(filename_ext) + "; charset=utf-8\r\n";
-};
+		// writes an untracked header at the end of the first offset bytes of base; returns the block
+		void *stamp( void *base, size_t offset, size_t size ) {
+			char *ptr = (char *)base + offset;
+			header *h = header_of( ptr );
+			h->prev = h->next = 0;
+			h->size = size;
+			h->id = 0;
+			h->stack = 0;
+			h->weight = 1;
+			h->offset = uint32_t( offset );
+			h->mark( ptr, header::BLOCK );
+			return ptr;
+		}
 
-std::string interval_from_headers( const std::string &header, const std::string &text1, const std::string &text2 ) {
-	size_t pos = header.find(text1);
-	if( pos == std::string::npos ) {
-		return std::string();
-	}
-	pos += text1.size();
-	size_t pos2 = header.find(text2, pos);
-	if( pos2 == std::string::npos ) {
-		return header.substr(pos);
-	} else {
-		return header.substr(pos, pos2-pos);
-	}
-}
+		// open addressing hash table (robin hood), keyed by the address of its records.
+		// records are stored inline and a null address marks an empty slot. erasing shifts
+		// following records backwards, so there are no tombstones and probes stay short.
+		// slots are requested to the metadata arena directly, so the table never tracks itself.
+		template<typename V>
+		class table
+		{
+			V *slots;
+			size_t mask, count;
+			unsigned shift;
 
-std::string extract_from_headers( const std::string &header, const std::string &text ) {
-	size_t pos = header.find(text);
-	if( pos == std::string::npos ) {
-		return std::string();
-	}
-	pos += text.size();
-	size_t pos2 = header.find( "\r\n", pos );
-	if( pos2 == std::string::npos ) {
-		return header.substr(pos);
-	} else {
-		return header.substr(pos, pos2-pos);
-	}
-}
+			table( const table & );
+			table &operator=( const table & );
 
-struct daemon {
-	int socket;
-	const std::map< std::string /*path*/, route66::callback /*fn*/ > *routers;
-	std::string base;
+			size_t home( const void *key ) const {
+				return size_t( ( uint64_t( (uintptr_t)key >> 4 ) * 0xFF51AFD7ED558CCDULL ) >> shift );
+			}
+			size_t distance( size_t pos ) const {
+				return ( pos - home( slots[pos].addr ) ) & mask;
+			}
 
-	daemon() : socket(-1), routers(0)
-	{}
+			void rehash( size_t capacity, unsigned bits ) {
+				V *old = slots;
+				size_t old_capacity = this->capacity();
 
-	void operator()() {
-		bool shutdown = false;
-		while( !shutdown ) {
-			enum { buflen = 1024 * 1024, SPACES = 2 /*>=2*/ };
+				slots = (V *)metadata().alloc( capacity * sizeof(V) );
+				if( !slots ) tracey::badalloc();
+				for( size_t i = 0; i < capacity; ++i ) {
+					new (&slots[i]) V();
+				}
+				mask = capacity - 1;
+				shift = 64 - bits;
+				count = 0;
+
+				for( size_t i = 0; i < old_capacity; ++i ) {
+					if( old[i].addr ) {
+						using std::swap;
+						swap( insert( old[i].addr ), old[i] );
+					}
+					old[i].~V();
+				}
+				if( old ) metadata().free( old );
+			}
 
-			int child = ACCEPT(socket,0,0), o = 0, h[SPACES] = {}, hi = 0;
-			if( child < 0 ) continue;
+			public:
 
-			std::string buf( buflen, '\0' );
-			char *b = &buf[0];
+			table() : slots(0), mask(0), count(0), shift(64)
+			{}
 
-			while(hi<SPACES&&o<buflen) {
-				int n = READ(child,b+o,buflen-o);
-				if(n<=0) { break; }
-				else {
-					int i = o;
-					o+=n;
-					for(;i<n&&hi<SPACES;i++) {
-					if((hi < SPACES) && b[i] == ' ') { h[hi++] = i; }
-					}
+			~table() {
+				clear();
+			}
+
+			size_t size() const {
+				return count;
+			}
+			size_t capacity() const {
+				return slots ? mask + 1 : 0;
+			}
+			size_t space() const {
+				return capacity() * sizeof(V);
+			}
+
+			V &at( size_t pos ) {
+				return slots[pos];
+			}
+			const V &at( size_t pos ) const {
+				return slots[pos];
+			}
+
+			V *find( const void *key ) {
+				if( !count ) return 0;
+				for( size_t pos = home( key ), dist = 0; slots[pos].addr && distance( pos ) >= dist; pos = (pos + 1) & mask, ++dist ) {
+					if( slots[pos].addr == key ) return &slots[pos];
 				}
+				return 0;
 			}
 
-			if(hi >= SPACES) {
-				b[ o ] = '\0';
-				buf.resize( o );
+			// returns the record of given key, which is created (empty but keyed) if missing
+			V &insert( const void *key ) {
+				if( V *found = find( key ) ) return *found;
+				if( (count + 1) * 8 > capacity() * 7 ) {
+					rehash( capacity() ? capacity() * 2 : 64, capacity() ? 64 - shift + 1 : 6 );
+				}
 
-				const char *logmask = std::getenv("R66LOG");
-				if( logmask ) {
-					if( matches(b, logmask) ) {
-						//__asm int 3;
-						//fprintf(stdout, "%s,%s\n", multipart.c_str(), boundary.c_str());
+				using std::swap;
+				V entry;
+				entry.addr = key;
+				V *inserted = 0;
+				for( size_t pos = home( key ), dist = 0; ; pos = (pos + 1) & mask, ++dist ) {
+					if( !slots[pos].addr ) {
+						swap( slots[pos], entry );
+						if( !inserted ) inserted = &slots[pos];
+						break;
+					}
+					size_t other = distance( pos );
+					if( other < dist ) {
+						// rich record found; steal its slot and keep on probing for the poor one
+						swap( slots[pos], entry );
+						if( !inserted ) inserted = &slots[pos];
+						dist = other;
 					}
 				}
+				++count;
+				return *inserted;
+			}
 
-				typedef std::map< std::string, std::string > filemap;
-				static std::map< std::string /*boundary*/, filemap > boundaries;
+			void erase( V *record ) {
+				using std::swap;
+				size_t pos = record - slots;
+				V empty;
+				swap( slots[pos], empty );
+				for( size_t next = (pos + 1) & mask; slots[next].addr && distance( next ); pos = next, next = (next + 1) & mask ) {
+					swap( slots[pos], slots[next] );
+				}
+				--count;
+			}
 
-				unsigned curlen = 0;
+			void clear() {
+				for( size_t i = 0, end = capacity(); i < end; ++i ) {
+					slots[i].~V();
+				}
+				if( slots ) metadata().free( slots );
+				slots = 0;
+				mask = count = 0;
+				shift = 64;
+			}
+		};
 
-				std::string boundary = std::string("--") + extract_from_headers( buf, "Content-Type: multipart/form-data; boundary=");
-				std::string eof = boundary + "--\r\n";
-				std::string headers = buf.substr( 0, buf.find("\r\n\r\n") + 4 );
-				std::string payload = buf.substr( headers.size() );
+		// registry is alive (constructed and not yet destroyed)
+		std::atomic<bool> ready( false );
 
-				while( boundary.size() > 2 && !endswith( payload, eof ) ) {
-					std::stringstream head1, head2;
-					head1 << "HTTP/1.1 100 Continue\r\n";
-					WRITE( child, head1.str().c_str(), head1.str().size() );
+		// hard on/off switch
+		static const    bool kTraceyEnabledHard = kTraceyEnabled;
+		// soft on/off switch
+		static volatile bool kTraceyEnabledSoft = true;
 
-					o = 0;
-					buf.clear();
-					buf.resize( buflen, '\0' );
+		// interning table of callstacks. identical stacks are stored once and are referred by a
+		// 32-bit id (low bits pick the stripe, high bits the entry within it; 0 means no stack).
+		// entries and frames never move once written, so they can be read by id without locking:
+		// entry chunks double in size and hang from a fixed directory published with release stores.
+		class stacktable
+		{
+			enum { SHARD_BITS = 6, SHARDS = 1 << SHARD_BITS, ENTRIES_PER_CHUNK = 512, FRAMES_PER_CHUNK = 4096 };
+			enum { DIRECTORY = 32 - SHARD_BITS, MAX_ENTRIES = ( 1u << (32 - SHARD_BITS) ) - 1 };
+
+			struct entry {
+				uint64_t hash;
+				void **frames;
+				unsigned depth;
+				size_t regrows, copied;          // reallocations of blocks allocated here, and bytes they moved
+			};
 
-					int n;
-					n = READ(child,b+o,buflen-o);
-					if(n<=0) { break; }
+			struct shard {
+				mutable std::mutex mutex;
+				std::atomic< entry * > entries[ DIRECTORY ];  // chunk k holds ENTRIES_PER_CHUNK << k entries
+				void **frames;                   // last chunk of FRAMES_PER_CHUNK frames; older ones are owned by their entries
+				size_t chunks, count, used;      // frame chunks allocated, entries in use, frames in use within last chunk
+				uint32_t *index;                 // open addressing index of entry numbers (+1), 0 is empty
+				size_t mask;
+				shard() : frames(0), chunks(0), count(0), used(FRAMES_PER_CHUNK), index(0), mask(0) {
+					for( unsigned k = 0; k < DIRECTORY; ++k ) entries[k].store( 0, std::memory_order_relaxed );
+				}
+			} shards[ SHARDS ];
 
-					buf.resize( n );
+			stacktable( const stacktable & );
+			stacktable &operator=( const stacktable & );
 
-					payload += buf;
+			static uint64_t hash( void *const *frames, unsigned depth ) {
+				uint64_t h = 0xCBF29CE484222325ULL ^ depth;
+				for( unsigned i = 0; i < depth; ++i ) {
+					h = ( h ^ uint64_t( (uintptr_t)frames[i] ) ) * 0x100000001B3ULL;
+					h ^= h >> 29;
 				}
+				return h;
+			}
 
-				route66::request rq;
+			static void *alloc( size_t bytes ) {
+				void *ptr = metadata().alloc( bytes );
+				if( !ptr ) tracey::badalloc();
+				return ptr;
+			}
 
-				if( boundary.size() > 2 ) {
-					payload = interval_from_headers( payload, boundary + "\r\n", boundary );
+			// chunk holding entry number n, and its offset within it
+			static unsigned chunk( size_t n, size_t *offset ) {
+				unsigned k = 0;
+				for( size_t q = n / ENTRIES_PER_CHUNK + 1; q >>= 1; ) ++k;
+				*offset = n - ENTRIES_PER_CHUNK * ( ( size_t(1) << k ) - 1 );
+				return k;
+			}
 
-					{
-						std::string headers = payload.substr( 0, payload.find("\r\n\r\n") + 4 );
-						std::string file = extract_from_headers( headers, "Content-Disposition: form-data; name=");
-						file = file.substr( 1, file.size() - 2 ); // remove ""
+			static entry &at( const shard &sh, size_t n ) {
+				size_t offset;
+				unsigned k = chunk( n, &offset );
+				return sh.entries[k].load( std::memory_order_acquire )[ offset ];
+			}
 
-						payload = payload.substr( headers.size() );
-						rq.multipart[ file ] = payload;
+			static void reindex( shard &sh, size_t capacity ) {
+				if( sh.index ) metadata().free( sh.index );
+				sh.index = (uint32_t *)alloc( capacity * sizeof(uint32_t) );
+				std::memset( sh.index, 0, capacity * sizeof(uint32_t) );
+				sh.mask = capacity - 1;
+				for( size_t n = 0; n < sh.count; ++n ) {
+					size_t pos = size_t( at( sh, n ).hash >> SHARD_BITS ) & sh.mask;
+					while( sh.index[pos] ) pos = (pos + 1) & sh.mask;
+					sh.index[pos] = uint32_t( n + 1 );
+				}
+			}
+
+			public:
+
+			stacktable()
+			{}
+
+			// returns the id of given stack, which is stored first time it is seen
+			uint32_t intern( void *const *frames, unsigned depth ) {
+				if( !depth ) return 0;
+
+				uint64_t h = hash( frames, depth );
+				unsigned s = unsigned( h & (SHARDS - 1) );
+				shard &sh = shards[s];
+
+				sh.mutex.lock();
+				size_t pos = sh.index ? size_t( h >> SHARD_BITS ) & sh.mask : 0;
+				for( ; sh.index && sh.index[pos]; pos = (pos + 1) & sh.mask ) {
+					const entry &e = at( sh, sh.index[pos] - 1 );
+					if( e.hash == h && e.depth == depth && !std::memcmp( e.frames, frames, depth * sizeof(void *) ) ) {
+						uint32_t id = uint32_t( ( sh.index[pos] << SHARD_BITS ) | s );
+						sh.mutex.unlock();
+						return id;
 					}
+				}
 
-					buf = headers;
+				// not found; copy frames and entry into their chunks, then index them
+				if( sh.count >= MAX_ENTRIES ) {
+					sh.mutex.unlock();
+					tracey::fail( "<tracey/tracey.cpp> says: error! too many callstacks for 32-bit ids" );
+					return 0;
+				}
+				if( sh.used + depth > FRAMES_PER_CHUNK ) {
+					sh.frames = (void **)alloc( FRAMES_PER_CHUNK * sizeof(void *) );
+					sh.chunks++;
+					sh.used = 0;
+				}
+				size_t offset;
+				unsigned k = chunk( sh.count, &offset );
+				if( !offset ) {
+					sh.entries[k].store( (entry *)alloc( ( size_t( ENTRIES_PER_CHUNK ) << k ) * sizeof(entry) ), std::memory_order_release );
+				}
+				entry &e = at( sh, sh.count );
+				e.hash = h;
+				e.depth = depth;
+				e.regrows = e.copied = 0;
+				e.frames = sh.frames + sh.used;
+				std::memcpy( e.frames, frames, depth * sizeof(void *) );
+				sh.used += depth;
+				sh.count++;
+
+				if( !sh.index || sh.count * 4 > (sh.mask + 1) * 3 ) {
+					reindex( sh, sh.index ? (sh.mask + 1) * 2 : 256 );
+				} else {
+					while( sh.index[pos] ) pos = (pos + 1) & sh.mask;
+					sh.index[pos] = uint32_t( sh.count );
 				}
 
-				rq.data = buf;
+				uint32_t id = uint32_t( ( sh.count << SHARD_BITS ) | s );
+				sh.mutex.unlock();
+				return id;
+			}
 
-				char org = b[h[1]];
-				b[h[1]] = '\0';
+			void *const *frames( uint32_t id, unsigned *depth ) const {
+				if( !id ) return *depth = 0, (void *const *)0;
+				const entry &e = at( shards[ id & (SHARDS - 1) ], (id >> SHARD_BITS) - 1 );
+				return *depth = e.depth, e.frames;
+			}
 
-#if 1
-				socklen_t len;
-				struct sockaddr_storage addr;
-				char ipstr[INET_ADDRSTRLEN];
-				len = sizeof addr;
-				getpeername(child, (struct sockaddr*) &addr, &len);
-				struct sockaddr_in *s = (struct sockaddr_in *) &addr;
-				inet_ntop(AF_INET, &s->sin_addr, ipstr, sizeof ipstr);
-				if( std::strcmp("127.0.0.1", ipstr) == 0 ) rq.ip = "localhost";
-				else rq.ip = ipstr;
+			// realloc chains, per allocation site {
 
-				struct sockaddr_in l;
-				len = sizeof(l);
-				if (getsockname(child, (struct sockaddr *)&l, &len) != -1) {
-					rq.port = ntohs(l.sin_port);
-				} else {
-					rq.port = 0;
+			struct chain {
+				uint32_t stack;
+				size_t regrows, copied;
+				bool operator<( const chain &other ) const {
+					return copied != other.copied ? copied > other.copied : regrows > other.regrows;
 				}
-#endif
+			};
 
-				std::string method( b, h[0] );
-				std::string url( &b[h[0]+1] ); //skip "GET "
-				b[h[1]] = org;
+			// counts a reallocation of a block allocated at given stack; copied is 0 if done in place
+			void regrew( uint32_t id, size_t copied ) {
+				if( !id ) return;
+				shard &sh = shards[ id & (SHARDS - 1) ];
+				sh.mutex.lock();
+				entry &e = at( sh, (id >> SHARD_BITS) - 1 );
+				e.regrows++;
+				e.copied += copied;
+				sh.mutex.unlock();
+			}
 
-				std::string path, options;
+			// sites that reallocated their blocks, most bytes copied first
+			std::vector< chain > chains() const {
+				std::vector< chain > list;
+				for( unsigned s = 0; s < SHARDS; ++s ) {
+					const shard &sh = shards[s];
+					sh.mutex.lock();
+					for( size_t n = 0; n < sh.count; ++n ) {
+						const entry &e = at( sh, n );
+						if( e.regrows ) {
+							chain c = { uint32_t( ( (n + 1) << SHARD_BITS ) | s ), e.regrows, e.copied };
+							list.push_back( c );
+						}
+					}
+					sh.mutex.unlock();
+				}
+				std::sort( list.begin(), list.end() );
+				return list;
+			}
 
-				size_t mark = url.find_first_of('?');
-				if( mark == std::string::npos ) {
-					path = url;
-				} else {
-					path = url.substr( 0, mark );
-					options = url.substr( mark + 1 );
+			void clear_chains() {
+				for( unsigned s = 0; s < SHARDS; ++s ) {
+					shard &sh = shards[s];
+					sh.mutex.lock();
+					for( size_t n = 0; n < sh.count; ++n ) {
+						at( sh, n ).regrows = at( sh, n ).copied = 0;
+					}
+					sh.mutex.unlock();
 				}
+			}
 
-				if( method == "PUT" || method == "POST" )  {
-					options = &b[ std::string(b).find("\r\n\r\n") + 4 ];
+			// }
+
+			size_t size() const {
+				size_t total = 0;
+				for( unsigned s = 0; s < SHARDS; ++s ) {
+					shards[s].mutex.lock();
+					total += shards[s].count;
+					shards[s].mutex.unlock();
 				}
+				return total;
+			}
 
-				std::string route = method + " " + path;
-				std::map< std::string, route66::callback >::const_iterator found = routers->find( route );
-				if( found == routers->end() ) {
-					// bad route, try index wildcard matching
-					for( found = routers->begin(); found != routers->end(); ++found ) {
-						if( matches( route, found->first ) ) {
-							break;
-						}
+			size_t space() const {
+				size_t total = 0;
+				for( unsigned s = 0; s < SHARDS; ++s ) {
+					const shard &sh = shards[s];
+					sh.mutex.lock();
+					for( unsigned k = 0; k < DIRECTORY && sh.entries[k].load(); ++k ) {
+						total += ( size_t( ENTRIES_PER_CHUNK ) << k ) * sizeof(entry);
 					}
+					total += sh.chunks * FRAMES_PER_CHUNK * sizeof(void *);
+					total += sh.index ? (sh.mask + 1) * sizeof(uint32_t) : 0;
+					sh.mutex.unlock();
 				}
-				if( found == routers->end() ) {
-					// bad route, try index fallback
-					found = routers->find("GET /");
+				return total;
+			}
+		};
+
+		// byte-based poisson sampling, as in tcmalloc heap profiler. every thread counts down the bytes
+		// it allocates and samples the allocation that crosses zero; distances between samples are
+		// exponentially distributed with mean `rate` bytes. an allocation of size s is then sampled with
+		// probability p = 1 - exp(-s/rate), so each record stands for 1/p allocations and s/p bytes.
+		// unsampled pointers are never marked in the free filter below, so their frees return early.
+		class sampler
+		{
+			// next distance between samples, in bytes
+			static size_t draw() {
+				static $tls(uint64_t) seed = 0;
+				if( !seed ) {
+					seed = uint64_t( (uintptr_t)&seed ) ^ uint64_t( std::time(0) ) ^ 0x9E3779B97F4A7C15ULL;
 				}
+				seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; // xorshift64
+				double u = double( (seed >> 11) + 1 ) / 9007199254740992.0; // (0..1]
+				double bytes = -std::log( u ) * double( rate );
+				return bytes < 1.0 ? 1 : size_t( bytes );
+			}
 
-				if( found != routers->end() ) {
+			public:
 
-					rq.method = method;
-					rq.url = url;
-					rq.uri = path;
-					rq.options = options;
+			// mean bytes between samples; 0 tracks every allocation. defaults to kTraceySampleRate
+			static volatile size_t rate;
 
-					urldecode2( rq.uri );
+			// whether allocations are being sampled. never, when the policy compiles sampling out
+			static bool on() {
+				return policy_t::SAMPLING && rate;
+			}
 
-					// arguments
-					std::vector< std::string > split = tokenize( options, "&" );
-					for( std::vector< std::string >::const_iterator it = split.begin(), end = split.end(); it != end; ++it ) {
-						const std::string &glued = *it;
-						std::vector< std::string > pair = tokenize( glued, "=" );
-						if( 2 == pair.size() ) {
-							rq.arguments[ urldecode2(pair[0]) ] = urldecode2(pair[1]);
-						} else {
-							rq.arguments[ urldecode2(pair[0]) ] = std::string();
-						}
-					}
+			// decides whether calling thread samples this allocation
+			static bool pick( size_t size ) {
+				static $tls(size_t) left = 0;
+				if( !left ) {
+					left = draw();
+				}
+				if( left > size ) {
+					left -= size;
+					return false;
+				}
+				left = draw();
+				return true;
+			}
 
-					// normalize & rebase (if needed)
-					if( rq.uri == "" || rq.uri == "/" ) rq.uri = "index.html";
-					rq.uri = base + rq.uri;
+			// allocations that an allocation of given size stands for, if sampled now. records keep it,
+			// so their estimates are added and taken back alike even if the rate changes meanwhile
+			static float weight( size_t size ) {
+				return on() && size ? float( 1.0 / ( 1.0 - std::exp( -double( size ) / double( rate ) ) ) ) : 1.0f;
+			}
 
-					if( logmask ) {
-						char addr[64]; sprintf(addr, "%s:%d", rq.ip.c_str(), rq.port );
-						if( matches(addr, logmask) || matches(rq.uri, logmask) || matches(rq.data, logmask) ) {
-							fprintf(stdout, "%s - %s\n%s\n", addr, rq.uri.c_str(), rq.str().c_str());
-						}
-					}
+			// number of allocations and bytes that a record of given size and weight stands for
+			static size_t count( float weight ) {
+				return size_t( weight + 0.5 );
+			}
+			static size_t bytes( size_t size, float weight ) {
+				return size_t( size * double( weight ) + 0.5 );
+			}
+		};
 
-					{
-						const route66::callback &fn = found->second;
-						std::stringstream headers, contents;
-						int httpcode = fn( rq, headers, contents );
+		volatile size_t sampler::rate = policy_t::SAMPLING ? kTraceySampleRate : 0;
 
-						std::string datas = contents.str();
-						shutdown = ( 0 == httpcode ? true : false );
+		// counting blocked bloom filter of tracked addresses, so frees of pointers that were never tracked
+		// (allocated while disabled, unsampled, foreign...) skip the registry and its locks altogether.
+		// both probes of an address fall in the same 64-byte block (one cache line). counters saturate
+		// and stay, so maybe() never lies about a tracked address; it just grows less selective.
+		// tallies are split in per-thread stripes, so counting does not bounce a shared cache line.
+		class bloomfilter
+		{
+			enum { BLOCK = 64, BLOCKS = kTraceyFreeFilterKB * 1024 / BLOCK, STICKY = 255, STRIPES = 64 };
 
-						if( !shutdown && datas.size() ) {
-							std::stringstream head1, head2;
-							head1 << "HTTP/1.1 " << httpcode << " OK\r\n";
-							head2 << headers.str() << "Content-Length: " << datas.size() << "\r\n\r\n";
+			struct tally {
+				std::atomic<size_t> rejected, passed, confused;
+				char pad[ 64 - 3 * sizeof(std::atomic<size_t>) ];
+			};
 
-							WRITE( child, head1.str().c_str(), head1.str().size() );
-							WRITE( child, head2.str().c_str(), head2.str().size() );
-							if( method != "HEAD" )
-							WRITE( child, datas.c_str(), datas.size() );
-						}
-					}
+			std::atomic<unsigned char> counters[ BLOCKS != 0 ? BLOCKS * BLOCK : 1 ];
+			tally tallies[ STRIPES ];
+
+			static uint64_t hash( const void *ptr ) {
+				return uint64_t( (uintptr_t)ptr >> 4 ) * 0x9E3779B97F4A7C15ULL;
+			}
+			std::atomic<unsigned char> &probe( uint64_t h, unsigned which ) {
+				return counters[ size_t( (h >> 32) & (BLOCKS - 1) ) * BLOCK + size_t( (h >> (20 + 6 * which)) & (BLOCK - 1) ) ];
+			}
+			static void up( std::atomic<unsigned char> &c ) {
+				unsigned char n = c.load( std::memory_order_relaxed );
+				while( n != STICKY && !c.compare_exchange_weak( n, n + 1 ) );
+			}
+			static void down( std::atomic<unsigned char> &c ) {
+				unsigned char n = c.load( std::memory_order_relaxed );
+				while( n != STICKY && n && !c.compare_exchange_weak( n, n - 1 ) );
+			}
+			tally &local() {
+				static std::atomic<unsigned> threads( 0 );
+				static $tls(unsigned) stripe = 0;
+				if( !stripe ) stripe = ++threads;
+				return tallies[ stripe & (STRIPES - 1) ];
+			}
+
+			public:
 
+			bloomfilter() {
+				for( size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); ++i ) {
+					counters[i] = 0;
+				}
+				for( unsigned i = 0; i < STRIPES; ++i ) {
+					tallies[i].rejected = tallies[i].passed = tallies[i].confused = 0;
 				}
+			}
 
-				SHUTDOWN(child);
-				CLOSE(child);
+			void mark( const void *ptr ) {
+				if( BLOCKS == 0 ) return;
+				uint64_t h = hash( ptr );
+				up( probe( h, 0 ) );
+				up( probe( h, 1 ) );
+			}
+			void unmark( const void *ptr ) {
+				if( BLOCKS == 0 ) return;
+				uint64_t h = hash( ptr );
+				down( probe( h, 0 ) );
+				down( probe( h, 1 ) );
 			}
-		}
-	}
-};
 
-namespace {
+			// false if ptr is not tracked for sure; true if it may be
+			bool maybe( const void *ptr ) {
+				if( BLOCKS == 0 ) return true;
+				uint64_t h = hash( ptr );
+				bool hit = probe( h, 0 ).load( std::memory_order_relaxed ) && probe( h, 1 ).load( std::memory_order_relaxed );
+				( hit ? local().passed : local().rejected ).fetch_add( 1, std::memory_order_relaxed );
+				return hit;
+			}
+			// maybe() said yes but there was no record
+			void false_positive() {
+				local().confused.fetch_add( 1, std::memory_order_relaxed );
+			}
 
-	typedef std::map< std::string /*path*/, route66::callback /*fn */> routers;
+			void totals( size_t *rejected, size_t *passed, size_t *confused ) const {
+				*rejected = *passed = *confused = 0;
+				for( unsigned i = 0; i < STRIPES; ++i ) {
+					*rejected += tallies[i].rejected.load( std::memory_order_relaxed );
+					*passed += tallies[i].passed.load( std::memory_order_relaxed );
+					*confused += tallies[i].confused.load( std::memory_order_relaxed );
+				}
+			}
+		};
 
-	bool create( unsigned port, const std::string &mask, const route66::callback &fn, std::string base ) {
-		static std::map< unsigned, routers > daemons;
+		// address space mapped by the application itself (kTraceyHookMmap). mappings are ranges, not
+		// points: one munmap() or madvise(MADV_DONTNEED) may cover several of them or just the middle of
+		// one, which splits it in two. regions are kept sorted by start address; every piece keeps the
+		// callstack and id of the mmap() it comes from. discarded pages are still mapped, but not in use.
+		class mappings
+		{
+			public:
 
-		if( daemons.find(port) == daemons.end() ) {
-			INIT();
-			int socket = SOCKET(PF_INET, SOCK_STREAM, IPPROTO_IP);
-			if( socket < 0 ) {
-				return "cannot init socket", false;
-			}
+			struct region {
+				uintptr_t end;
+				size_t id;
+				uint32_t stack;
+				bool anonymous, discarded;
+			};
 
-			struct sockaddr_in l;
-			std::memset( &l, 0, sizeof(sockaddr_in) );
-			l.sin_family = AF_INET;
-			l.sin_port = htons(port);
-			l.sin_addr.s_addr = INADDR_ANY;
-	#       if !defined(_WIN32)
-			int r = 1; setsockopt(socket,SOL_SOCKET,SO_REUSEADDR,&r,sizeof(r));
-	#       endif
-			BIND(socket,(struct sockaddr *)&l,sizeof(l));
-			LISTEN(socket,5);
+			private:
 
-			route66::daemon dm;
-			dm.socket = socket;
-			dm.routers = &daemons[ port ];
-			dm.base = base;
-			std::thread( dm ).detach();
-		}
+			typedef std::map< uintptr_t, region > regions;
 
-		daemons[ port ][ mask ] = fn;
+			mutable std::mutex mutex;
+			regions live;
+			size_t in_use, peak;
 
-		return "ok", true;
-	}
-}
+			static uintptr_t page_up( uintptr_t at ) {
+				static const uintptr_t page = $windows( 4096 ) $welse( uintptr_t( sysconf( _SC_PAGESIZE ) ) );
+				return ( at + page - 1 ) & ~( page - 1 );
+			}
 
-bool create( unsigned port, const std::string &mask, const route66::callback &fn ) {
-	return create( port, mask, fn, std::string() );
-}
+			// makes `at` a region boundary, if some region spans across it. mutex must be held
+			void split( uintptr_t at ) {
+				regions::iterator it = live.upper_bound( at );
+				if( it == live.begin() ) return;
+				--it;
+				if( it->first < at && at < it->second.end ) {
+					region tail = it->second;
+					it->second.end = at;
+					live.insert( std::make_pair( at, tail ) );
+				}
+			}
 
-namespace {
+			// removes [lo, hi) from every region; mutex must be held
+			void cut( uintptr_t lo, uintptr_t hi ) {
+				split( lo );
+				split( hi );
+				regions::iterator it = live.lower_bound( lo );
+				while( it != live.end() && it->first < hi ) {
+					if( !it->second.discarded ) in_use -= it->second.end - it->first;
+					live.erase( it++ );
+				}
+			}
 
-	std::string get_app_folder() {
-#       ifdef _WIN32
-			char s_path[MAX_PATH] = {0};
-			const size_t len = MAX_PATH;
+			public:
 
-			HMODULE mod = 0;
-			::GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (LPCSTR)&get_app_folder, &mod);
-			DWORD size = ::GetModuleFileNameA(mod, s_path, (DWORD)len);
+			mappings() : in_use(0), peak(0)
+			{}
 
-			while( size > 0 ) {
-				if( s_path[size] == '\\' ) {
-					s_path[size+1] = '\0';
-					return s_path;
+			void map( const void *addr, size_t length, const region &props ) {
+				uintptr_t lo = (uintptr_t)addr, hi = page_up( lo + length );
+				mutex.lock();
+				cut( lo, hi ); // MAP_FIXED replaces whatever was there
+				region r = props;
+				r.end = hi;
+				r.discarded = false;
+				live.insert( std::make_pair( lo, r ) );
+				in_use += hi - lo;
+				if( in_use > peak ) peak = in_use;
+				mutex.unlock();
+			}
+
+			// *found receives the region holding addr, if any, so a remap can carry it over
+			bool unmap( const void *addr, size_t length, region *found = 0 ) {
+				uintptr_t lo = (uintptr_t)addr, hi = page_up( lo + length );
+				mutex.lock();
+				bool hit = false;
+				if( found ) {
+					regions::iterator it = live.upper_bound( lo );
+					if( it != live.begin() && (--it)->second.end > lo ) {
+						*found = it->second;
+						hit = true;
+					}
 				}
-				--size;
+				cut( lo, hi );
+				mutex.unlock();
+				return hit;
 			}
-			return std::string();
-#       else
-			char arg1[20];
-			char exepath[PATH_MAX + 1] = {0};
 
-			sprintf( arg1, "/proc/%d/exe", getpid() );
-			readlink( arg1, exepath, 1024 );
-			return std::string( exepath );
-#       endif
-	}
+			void discard( const void *addr, size_t length ) {
+				uintptr_t lo = (uintptr_t)addr, hi = page_up( lo + length );
+				mutex.lock();
+				split( lo );
+				split( hi );
+				for( regions::iterator it = live.lower_bound( lo ); it != live.end() && it->first < hi; ++it ) {
+					if( !it->second.discarded ) in_use -= it->second.end - it->first;
+					it->second.discarded = true;
+				}
+				mutex.unlock();
+			}
 
-	int file_reader( route66::request &request, std::ostream &headers, std::ostream &contents ) {
-		std::ifstream ifs( request.uri.c_str(), std::ios::binary );
-		if( ifs.good() ) {
-			headers << route66::mime(request.uri);
-			contents << ifs.rdbuf();
-			return 200;
-		} else {
-			headers << route66::mime(".text");
-			contents << "404: not found" << std::endl;
-			//contents << request.uri << std::endl;
-			return 404;
-		}
-	}
-}
+			void clear() {
+				mutex.lock();
+				live.clear();
+				in_use = 0;
+				mutex.unlock();
+			}
 
-bool fserve( unsigned port, const std::string &mask, const std::string &path ) {
-	return create( port, mask, file_reader, get_app_folder() + path );
-}
+			// regions, mapped and discarded bytes (anonymous ones included in *anonymous), and peak in use
+			void totals( size_t *count, size_t *mapped, size_t *anonymous, size_t *discarded, size_t *high ) const {
+				mutex.lock();
+				*count = live.size();
+				*mapped = *anonymous = *discarded = 0;
+				for( regions::const_iterator it = live.begin(), end = live.end(); it != end; ++it ) {
+					size_t bytes = it->second.end - it->first;
+					*mapped += bytes;
+					if( it->second.anonymous ) *anonymous += bytes;
+					if( it->second.discarded ) *discarded += bytes;
+				}
+				*high = peak;
+				mutex.unlock();
+			}
 
-#undef INIT
-#undef SOCKET
-#undef ACCEPT
-#undef CONNECT
-#undef CLOSE
-#undef RECV
-#undef READ
-#undef SELECT
-#undef SEND
-#undef WRITE
-#undef GETSOCKOPT
-#undef SETSOCKOPT
+			// bytes in use (discarded pages excluded) and regions, per callstack; most bytes first
+			struct site {
+				uint32_t stack;
+				size_t bytes, count;
+				bool operator<( const site &other ) const {
+					return bytes > other.bytes;
+				}
+			};
+			std::vector< site > sites() const {
+				std::map< uint32_t, site > by_stack;
+				mutex.lock();
+				for( regions::const_iterator it = live.begin(), end = live.end(); it != end; ++it ) {
+					if( it->second.discarded || it->second.id < timestamp_id ) continue;
+					site &s = by_stack[ it->second.stack ];
+					s.stack = it->second.stack;
+					s.bytes += it->second.end - it->first;
+					s.count++;
+				}
+				mutex.unlock();
+				std::vector< site > list;
+				for( std::map< uint32_t, site >::const_iterator it = by_stack.begin(), end = by_stack.end(); it != end; ++it ) {
+					list.push_back( it->second );
+				}
+				std::sort( list.begin(), list.end() );
+				return list;
+			}
+		};
 
-#undef BIND
-#undef LISTEN
-#undef SHUTDOWN
-#undef SHUTDOWN_R
-#undef SHUTDOWN_W
+		// set while a thread runs tracey code, so tracey's own allocations are not tracked
+		$tls(bool) acquired = false;
 
-/*/ 1XX informational
-/*/ const httpcode SHUTDOWN = { 0, "Shutdown requested" };
-/*/ 1XX informational
-/*/ const httpcode CONTINUE = { 100, "The request can be continued." }; /*/
-/*/ const httpcode SWITCH_PROTOCOLS = { 101, "The server has switched protocols in an upgrade header." };
-/*/ 2XX success
-/*/ const httpcode OK = { 200, "The request completed successfully." }; /*/
-/*/ const httpcode CREATED = { 201, "The request has been fulfilled and resulted in the creation of a new resource." }; /*/
-/*/ const httpcode ACCEPTED = { 202, "The request has been accepted for processing, but the processing has not been completed." }; /*/
-/*/ const httpcode PARTIAL = { 203, "The returned meta information in the entity-header is not the definitive set available from the originating server." }; /*/
-/*/ const httpcode NO_CONTENT = { 204, "The server has fulfilled the request, but there is no new information to send back." }; /*/
-/*/ const httpcode RESET_CONTENT = { 205, "The request has been completed, and the client program should reset the document view that caused the request to be sent to allow the user to easily initiate another input action." }; /*/
-/*/ const httpcode PARTIAL_CONTENT = { 206, "The server has fulfilled the partial GET request for the resource." }; /*/
-/*/ const httpcode WEBDAV_MULTI_STATUS = { 207, "During a World Wide Web Distributed Authoring and Versioning (WebDAV) operation, this indicates multiple status const httpcodes for a single response. The response body contains Extensible Markup Language (XML) that describes the status const httpcodes. For more information, see HTTP Extensions for Distributed Authoring." };
-/*/ 3XX redirection
-/*/ const httpcode AMBIGUOUS = { 300, "The requested resource is available at one or more locations." }; /*/
-/*/ const httpcode MOVED = { 301, "The requested resource has been assigned to a new permanent Uniform Resource Identifier (URI), and any future references to this resource should be done using one of the returned URIs." }; /*/
-/*/ const httpcode REDIRECT = { 302, "The requested resource resides temporarily under a different URI." }; /*/
-/*/ const httpcode REDIRECT_METHOD = { 303, "The response to the request can be found under a different URI and should be retrieved using a GET HTTP verb on that resource." }; /*/
-/*/ const httpcode NOT_MODIFIED = { 304, "The requested resource has not been modified." }; /*/
-/*/ const httpcode USE_PROXY = { 305, "The requested resource must be accessed through the proxy given by the location field." }; /*/
-/*/ const httpcode REDIRECT_KEEP_VERB = { 307, "The redirected request keeps the same HTTP verb. HTTP/1.1 behavior." };
-/*/ 4XX client's fault
-/*/ const httpcode BAD_REQUEST = { 400, "The request could not be processed by the server due to invalid syntax." }; /*/
-/*/ const httpcode DENIED = { 401, "The requested resource requires user authentication." }; /*/
-/*/ const httpcode PAYMENT_REQ = { 402, "Not implemented in the HTTP protocol." }; /*/
-/*/ const httpcode FORBIDDEN = { 403, "The server understood the request, but cannot fulfill it." }; /*/
-/*/ const httpcode NOT_FOUND = { 404, "The server has not found anything that matches the requested URI." }; /*/
-/*/ const httpcode BAD_METHOD = { 405, "The HTTP verb used is not allowed." }; /*/
-/*/ const httpcode NONE_ACCEPTABLE = { 406, "No responses acceptable to the client were found." }; /*/
-/*/ const httpcode PROXY_AUTH_REQ = { 407, "Proxy authentication required." }; /*/
-/*/ const httpcode REQUEST_TIMEOUT = { 408, "The server timed out waiting for the request." }; /*/
-/*/ const httpcode CONFLICT = { 409, "The request could not be completed due to a conflict with the current state of the resource. The user should resubmit with more information." }; /*/
-/*/ const httpcode GONE = { 410, "The requested resource is no longer available at the server, and no forwarding address is known." }; /*/
-/*/ const httpcode LENGTH_REQUIRED = { 411, "The server cannot accept the request without a defined content length." }; /*/
-/*/ const httpcode PRECOND_FAILED = { 412, "The precondition given in one or more of the request header fields evaluated to false when it was tested on the server." }; /*/
-/*/ const httpcode REQUEST_TOO_LARGE = { 413, "The server cannot process the request because the request entity is larger than the server is able to process." }; /*/
-/*/ const httpcode URI_TOO_LONG = { 414, "The server cannot service the request because the request URI is longer than the server can interpret." }; /*/
-/*/ const httpcode UNSUPPORTED_MEDIA = { 415, "The server cannot service the request because the entity of the request is in a format not supported by the requested resource for the requested method." }; /*/
-/*/ const httpcode RETRY_WITH = { 449, "The request should be retried after doing the appropriate action." };
-/*/ 5XX server's fault
-/*/ const httpcode SERVER_ERROR = { 500, "The server encountered an unexpected condition that prevented it from fulfilling the request." }; /*/
-/*/ const httpcode NOT_SUPPORTED = { 501, "The server does not support the functionality required to fulfill the request." }; /*/
-/*/ const httpcode BAD_GATEWAY = { 502, "The server, while acting as a gateway or proxy, received an invalid response from the upstream server it accessed in attempting to fulfill the request." }; /*/
-/*/ const httpcode SERVICE_UNAVAIL = { 503, "The service is temporarily overloaded." }; /*/
-/*/ const httpcode GATEWAY_TIMEOUT = { 504, "The request was timed out waiting for a gateway." }; /*/
-/*/ const httpcode VERSION_NOT_SUP = { 505, "The server does not support the HTTP protocol version that was used in the request message." };
+		// asynchronous bookkeeping. every thread appends compact events to its own ring buffer
+		// (single producer, single consumer) and one aggregator thread drains all rings into the
+		// registry, each ring in the order it was written. across rings, only events on the same
+		// address need an order (a free() before the allocation recycling it), so addresses are hashed
+		// into lanes and every event takes the next sequence number of its lane. the aggregator applies
+		// a lane strictly in that order; a ring whose next event is early waits for the other rings.
+		struct event {
+			const void *addr;
+			size_t size;        // 0 on deallocations
+			uint32_t stack;
+			uint32_t seq;       // within the lane of addr
+		};
 
-}
+		class eventlog
+		{
+			enum { CAPACITY = kTraceyAsyncBufferSize, MAX_RINGS = 1024, LANE_BITS = 12, LANES = 1 << LANE_BITS };
+
+			struct ring {
+				std::atomic<size_t> tail;   // owner thread only
+				char pad0[ 64 - sizeof(std::atomic<size_t>) ];
+				std::atomic<size_t> head;   // aggregator only
+				char pad1[ 64 - sizeof(std::atomic<size_t>) ];
+				std::atomic<bool> retired;  // no owner thread; adopted by the next thread once drained
+				event events[ CAPACITY ];
+
+				ring() : tail(0), head(0), retired(false)
+				{}
+			};
 
+			std::atomic<ring *> rings[ MAX_RINGS ]; // never freed, so they can be read at any time
+			std::atomic<unsigned> used;         // rings[] high-water mark
+			std::atomic<unsigned> allocated;
+			std::atomic<bool> closed;           // no aggregator anymore; events are tracked synchronously
+			std::atomic<size_t> peak, stalls;
+			std::atomic<uint32_t> issued[ LANES ];  // next sequence number of every lane
+			uint32_t applied[ LANES ];              // next one the aggregator applies; aggregator only
 
-#endif
+			static unsigned lane( const void *addr ) {
+				return unsigned( ( uint64_t( (uintptr_t)addr >> 4 ) * 0x9E3779B97F4A7C15ULL ) >> (64 - LANE_BITS) );
+			}
 
-// checks: todo
-// if /MD or /MDd and kTraceyReportWildPointers warn user "not a good idea"
-#if kTraceyHookLegacyCRT
-	$warning( "<tracey/tracey.cpp> says: kTraceyHookLegacyCRT option ignored. CRT hooking not supported on this platform.")
-#   undef  kTraceyHookLegacyCRT
-#   define kTraceyHookLegacyCRT 0
-#endif
+			static bool &gone() {
+				static $tls(bool) gone = false;
+				return gone;
+			}
+			static ring *&mine() {
+				static $tls(ring *) mine = 0;
+				return mine;
+			}
 
-namespace tracey
-{
-	static void webmain( void * );
-	static void hotkeymain( void * );
+			// hands the ring of an exiting thread back, to be adopted by another thread once drained
+			struct retire {
+				~retire() {
+					gone() = true;
+					if( ring *r = mine() ) {
+						mine() = 0;
+						r->retired.store( true, std::memory_order_release );
+					}
+				}
+			};
 
-	typedef heal::sfstring string;
-	typedef heal::sfstrings strings;
+			ring *claim( ring *r ) {
+				static thread_local retire on_exit;
+				(void)on_exit;
+				return mine() = r;
+			}
 
-	std::string human( size_t bytes ) {
-		/**/ if( bytes >= 1024 * 1024 * 1024 ) return tracey::string("\1 GB", bytes / (1024 * 1024 * 1024));
-		else if( bytes >=   16 * 1024 * 1024 ) return tracey::string("\1 MB", bytes / (       1024 * 1024));
-		else if( bytes >=          16 * 1024 ) return tracey::string("\1 KB", bytes / (              1024));
-		else                                   return tracey::string("\1 bytes", bytes );
-	}
+			ring *local() {
+				ring *r = mine();
+				if( r || gone() ) {
+					return r;
+				}
+				for( unsigned i = 0, end = used.load(); i < end; ++i ) {
+					bool retired = true;
+					r = rings[i].load( std::memory_order_acquire );
+					if( r && r->retired.load() && r->head.load( std::memory_order_acquire ) == r->tail.load() &&
+						r->retired.compare_exchange_strong( retired, false ) ) {
+						return claim( r );
+					}
+				}
+				void *mem = metadata().alloc( sizeof(ring) );
+				if( !mem ) {
+					return 0;
+				}
+				r = new (mem) ring();
+				for( unsigned i = 0; i < MAX_RINGS; ++i ) {
+					ring *empty = 0;
+					if( rings[i].compare_exchange_strong( empty, r ) ) {
+						unsigned n = used.load();
+						while( n < i + 1 && !used.compare_exchange_weak( n, i + 1 ) );
+						allocated++;
+						return claim( r );
+					}
+				}
+				r->~ring();
+				metadata().free( r );
+				gone() = true; // too many threads; this one stays synchronous
+				return 0;
+			}
 
-	struct branch {
-		size_t hits;
-		size_t size;
-		branch() : hits(0), size(0) {
-		}
-		branch( const branch &other ) {
-			operator=( other );
-		}
-		branch &operator =( const branch &other ) {
-			if( this != &other ) {
-				hits = other.hits;
-				size = other.size;
+			public:
+
+			eventlog() : used(0), allocated(0), closed(false), peak(0), stalls(0) {
+				for( unsigned i = 0; i < MAX_RINGS; ++i ) {
+					rings[i] = 0;
+				}
+				for( unsigned i = 0; i < LANES; ++i ) {
+					issued[i] = applied[i] = 0;
+				}
 			}
-			return *this;
-		}
-		branch &operator +=( const branch &other ) {
-			this->size += /*(other.hits ? other.hits : 1) **/ other.size;
-			return *this;
-		}
-		bool operator<( const double t ) const {
-			return size < t;
-		}
 
-		std::string str( double total ) const {
-			tracey::string os;
-			int pct = int((size * 100.0) / total);
-			/**/ if( pct >= 100 ) os << tracey::string(   "\1%", pct ) << " .. " << tracey::human( size );
-			else if( pct >=  10 ) os << tracey::string(  "0\1%", pct ) << " .. " << tracey::human( size );
-			else                  os << tracey::string( "00\1%", pct ) << " .. " << tracey::human( size );
+			// producer side; returns false if calling thread has no ring (caller falls back to sync path)
+			bool push( const void *addr, size_t size, uint32_t stack ) {
+				ring *r = closed.load( std::memory_order_relaxed ) ? 0 : local();
+				if( !r ) {
+					return false;
+				}
+				size_t t = r->tail.load( std::memory_order_relaxed );
+				size_t h = r->head.load( std::memory_order_acquire );
+				if( t - h == CAPACITY ) {
+					// backpressure: aggregator is behind, so wait for room
+					stalls++;
+					do {
+						std::this_thread::yield();
+						h = r->head.load( std::memory_order_acquire );
+					} while( t - h == CAPACITY && !closed.load() );
+					if( t - h == CAPACITY ) {
+						return false;
+					}
+				}
+				// room is reserved before taking a sequence number, so published numbers have no gaps
+				event &e = r->events[ t & (CAPACITY - 1) ];
+				e.addr = addr;
+				e.size = size;
+				e.stack = stack;
+				e.seq = issued[ lane( addr ) ]++;
+				r->tail.store( t + 1, std::memory_order_release );
+
+				size_t level = t + 1 - h, top = peak.load( std::memory_order_relaxed );
+				while( level > top && !peak.compare_exchange_weak( top, level ) );
+				return true;
+			}
 
-			if( hits > 1 ) os << " ; " << hits << " hits";
-			return os;
-		}
-	};
-}
+			// consumer side; applies every event that is next in its lane. returns false when idle.
+			// force applies whatever is queued regardless, as the last drain does
+			template<typename SINK>
+			bool drain( SINK &sink, bool force = false ) {
+				bool any = false;
+				for( bool progress = true; progress; any |= progress ) {
+					progress = false;
+					for( unsigned i = 0, end = used.load(); i < end; ++i ) {
+						ring *r = rings[i].load( std::memory_order_acquire );
+						if( !r ) {
+							continue;
+						}
+						size_t h = r->head.load( std::memory_order_relaxed );
+						size_t t = r->tail.load( std::memory_order_acquire );
+						while( h != t ) {
+							const event &e = r->events[ h & (CAPACITY - 1) ];
+							uint32_t &next = applied[ lane( e.addr ) ];
+							if( e.seq != next && !force ) {
+								break; // an earlier event on this lane is in another ring
+							}
+							next = e.seq + 1;
+							sink.apply( e );
+							r->head.store( ++h, std::memory_order_release );
+							progress = true;
+						}
+					}
+				}
+				return any;
+			}
 
-namespace tracey {
+			// blocks until every event pushed so far has been applied, or nobody is left to apply it
+			void flush() const {
+				for( unsigned i = 0, end = used.load(); i < end; ++i ) {
+					ring *r = rings[i].load( std::memory_order_acquire );
+					size_t t = r ? r->tail.load( std::memory_order_acquire ) : 0;
+					while( r && r->head.load( std::memory_order_acquire ) < t && !closed.load() ) {
+						std::this_thread::yield();
+					}
+				}
+			}
 
-	//#include <map>
-	//#include <iostream>
+			// no more events are queued; producers fall back to the synchronous path from now on
+			void close() {
+				closed = true;
+			}
+			bool done() const {
+				return closed.load();
+			}
 
-	// tree class
-	// [] is read-only
-	// () is read-writeable (so is <<)
-	typedef void *K;
-	typedef branch V;
-	typedef oak::tree<K,V> tree;
+			// forked child: the threads that owned rings are gone, and so is whatever they queued.
+			// calling thread gets a ring again on its next event
+			void reset() {
+				for( unsigned i = 0, end = used.load(); i < end; ++i ) {
+					if( ring *r = rings[i].load() ) {
+						r->head.store( r->tail.load() );
+						r->retired = true;
+					}
+				}
+				for( unsigned i = 0; i < LANES; ++i ) {
+					applied[i] = issued[i].load();
+				}
+				mine() = 0;
+			}
 
-	// for tree walking
-	struct chopper {
-		bool operator()( tracey::tree &tree, tracey::tree::iterator &it ) const {
-			if( it->second.get() < kTraceyTruncateBranchesSmallerThan ) {
-				tree.erase( it->first );
-				return false;
-			} else {
-				return true;
+			size_t high_water() const {
+				return peak.load();
 			}
-		}
-	};
+			size_t backpressure() const {
+				return stalls.load();
+			}
+			size_t space() const {
+				return allocated.load() * sizeof(ring);
+			}
+		};
 
-	template<typename U>
-	std::string print( const tree &self, double total, const tracey::string &fmt1234, const tracey::string &sorted_by, bool reversed, const std::map<K,U> &tmap, unsigned depth ) {
-		std::map<std::string,tracey::strings> list;
-		std::string tabs( depth, kTraceyCharTab[0] );
-		if( !tmap.empty() ) {
-			for( tree::const_iterator it = self.begin(), end = self.end(); it != end; ++it  ) {
-				tracey::string key( sorted_by, tmap.find( it->first )->second, it->second.get().str(total), tabs, self.size() );
-				tracey::string value( fmt1234, tmap.find( it->first )->second, it->second.get().str(total), tabs, self.size() );
-				list[ key ].push_back( value );
-				list[ key ].push_back( print( it->second, total, fmt1234, sorted_by, reversed, tmap, depth + 1 ) );
+		// runtime settings. they default to kTracey* macros and are overridden by TRACEY_* environment
+		// variables, so a preloaded build can be configured without rebuilding it:
+		//   TRACEY_ENABLED, TRACEY_REPORT_ON_EXIT, TRACEY_VIEW, TRACEY_REPORT (report file; %p is pid),
+		//   TRACEY_REPORT_SIGNAL (signal that writes a report on demand), TRACEY_WEBSERVER_PORT,
+		//   TRACEY_SAMPLE_RATE, TRACEY_UNWINDER, TRACEY_BACKEND, TRACEY_INHERIT (keep LD_PRELOAD for child processes),
+		//   TRACEY_SYMBOLIZER (addr2line-compatible command for modules without line tables; empty disables it),
+		//   TRACEY_SYMBOL_CACHE (symbol cache directory, even with kTraceySymbolCache off; empty disables it).
+		struct options_t {
+			bool report_on_exit, view, inherit;
+			unsigned port;
+			int signal;
+			const char *report, *symbol_cache;
+
+			static long env( const char *name, long fallback ) {
+				const char *value = std::getenv( name );
+				return value && *value ? std::strtol( value, 0, 0 ) : fallback;
 			}
-		} else {
-			for( tree::const_iterator it = self.begin(), end = self.end(); it != end; ++it  ) {
-				tracey::string key( sorted_by, it->first, it->second.get().str(total), tabs, self.size() );
-				tracey::string value( fmt1234, it->first, it->second.get().str(total), tabs, self.size() );
-				list[ key ].push_back( value );
-				list[ key ].push_back( print( it->second, total, fmt1234, sorted_by, reversed, tmap, depth + 1 ) );
+
+			options_t() {
+				bool preload = false;
+#ifdef TRACEY_PRELOAD
+				preload = true;
+#endif
+				kTraceyEnabledSoft = env( "TRACEY_ENABLED", kTraceyEnabledSoft ) != 0;
+				report_on_exit = env( "TRACEY_REPORT_ON_EXIT", kTraceyReportOnExit ) != 0;
+				view = env( "TRACEY_VIEW", !preload ) != 0;
+				inherit = env( "TRACEY_INHERIT", 0 ) != 0;
+#ifdef TRACEY_PRELOAD
+				if( !inherit ) {
+					uninherit(); // child processes must not report themselves
+				}
+#endif
+				port = unsigned( env( "TRACEY_WEBSERVER_PORT", kTraceyWebserverPort ) );
+				signal = int( env( "TRACEY_REPORT_SIGNAL", 0 ) );
+				report = std::getenv( "TRACEY_REPORT" );
+				symbol_cache = std::getenv( "TRACEY_SYMBOL_CACHE" );
+				if( policy_t::SAMPLING ) {
+					sampler::rate = size_t( env( "TRACEY_SAMPLE_RATE", long( sampler::rate ) ) );
+				}
+				tracey::callstack::unwinder = int( env( "TRACEY_UNWINDER", tracey::callstack::unwinder ) );
+				backend::selected = int( env( "TRACEY_BACKEND", backend::selected ) );
+#if HEAL_HAS_ELF
+				if( const char *symbolizer = std::getenv( "TRACEY_SYMBOLIZER" ) ) {
+					tracey::elf::fallback = symbolizer;
+				}
+#endif
 			}
-		}
-		std::string out;
-		if( !reversed ) {
-			for( std::map<std::string,tracey::strings>::const_iterator it = list.begin(), end = list.end(); it != end; ++it ) {
-				out += it->second.flat();
+
+#ifdef TRACEY_PRELOAD
+			// drops this library from LD_PRELOAD, keeping any other library preloaded along with it.
+			// runs while options are read, before tracey starts its own thread.
+			static void uninherit() {
+				Dl_info info;
+				const char *preload = std::getenv( "LD_PRELOAD" );
+				if( !preload || !dladdr( (void *)&uninherit, &info ) || !info.dli_fname ) {
+					return;
+				}
+				std::string self = info.dli_fname, kept;
+				self = self.substr( self.find_last_of( '/' ) + 1 );
+				for( const char *it = preload; *it; ) {
+					size_t len = std::strcspn( it, ": " );
+					std::string lib( it, len );
+					if( len && lib.substr( lib.find_last_of( '/' ) + 1 ) != self ) {
+						kept += ( kept.empty() ? "" : ":" ) + lib;
+					}
+					it += len + ( it[len] ? 1 : 0 );
+				}
+				if( kept.empty() ) unsetenv( "LD_PRELOAD" );
+				else setenv( "LD_PRELOAD", kept.c_str(), 1 );
 			}
-		} else {
-			for( std::map<std::string,tracey::strings>::const_reverse_iterator it = list.rbegin(), end = list.rend(); it != end; ++it ) {
-				out += it->second.flat();
+#endif
+
+			std::string report_path() const {
+				if( !report || !*report ) {
+					return get_temp_pathfile() + "xxx-tracey.html";
+				}
+				unsigned pid = $windows( GetCurrentProcessId() ) $welse( getpid() );
+				return tracey::string( report ).replace( "%p", tracey::string( "\1", pid ) );
 			}
+		};
+
+		const options_t &options() {
+			static const options_t opts;
+			return opts;
 		}
-		return out;
-	}
 
-	template<typename U>
-	std::string print( const tree &self, double total, const std::map<K,U> &tmap, const tracey::string &format = "{tabs}[{size}] {key} ({value})\n", const tracey::string &sorted_by = "{key}", bool reversed = false ) {
-		tracey::string fmt = format
-		.replace("{key}",   "\1")
-		.replace("{value}", "\2")
-		.replace("{tabs}",  "\3")
-		.replace("{size}",  "\4");
-		tracey::string sort = sorted_by
-		.replace("{key}",   "\1")
-		.replace("{value}", "\2")
-		.replace("{tabs}",  "\3")
-		.replace("{size}",  "\4");
-		return print( self, total, fmt, sort, reversed, tmap, 0 );
-	}
+#if HEAL_HAS_ELF
+		// persistent symbol cache. frames resolved to a line are kept on disk, in one file per module
+		// named after its GNU build-id, so reports on an unchanged binary start warm across reports and
+		// restarts. file layout: header, entries sorted by offset into the module, then their text.
+		namespace symbol_cache {
+			struct header {
+				char magic[8];          // "tracey1"
+				uint64_t count;
+			};
+
+			struct entry {
+				uint64_t offset;        // address minus load bias
+				uint32_t text, size;    // into the text that follows the entries
+			};
+
+			std::atomic< size_t > hits( 0 ), misses( 0 );
+
+			// TRACEY_SYMBOL_CACHE, else $XDG_CACHE_HOME/tracey or ~/.cache/tracey when kTraceySymbolCache is on
+			// and that cache home is writable; empty if disabled. never destroyed, since reports are also made
+			// from atexit() handlers
+			std::string *locate() {
+				const char *env = options().symbol_cache, *xdg = std::getenv( "XDG_CACHE_HOME" ), *home = std::getenv( "HOME" );
+				if( env ) return new std::string( env );
+				if( !kTraceySymbolCache ) return new std::string();
+				std::string base = xdg && *xdg ? std::string( xdg ) : home && *home ? std::string( home ) + "/.cache" : std::string();
+				if( base.empty() || access( base.c_str(), W_OK ) != 0 ) return new std::string();
+				return new std::string( base + "/tracey" );
+			}
+			const std::string &directory() {
+				static const std::string *dir = locate();
+				return *dir;
+			}
 
-	std::string print( const tree &self, double total, const tracey::string &format = "{tabs}[{size}] {key} ({value})\n", const tracey::string &sorted_by = "{key}", bool reversed = false ) {
-		std::map<K, K> dummy;
-		return print( self, total, dummy, format, sorted_by, reversed );
-	}
+			// a mapped cache file. a missing or malformed file is just empty
+			struct file {
+				const uint8_t *data;
+				size_t size;
+				const entry *entries;
+				uint64_t count;
+				const char *text;
+				size_t text_size;
+
+				void open( const std::string &path ) {
+					data = 0, size = 0, entries = 0, count = 0, text = 0, text_size = 0;
+					int fd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+					if( fd < 0 )
+						return;
+					struct stat st;
+					if( fstat( fd, &st ) == 0 && size_t( st.st_size ) >= sizeof(header) ) {
+						void *map = mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+						if( map != MAP_FAILED ) data = (const uint8_t *)map, size = st.st_size;
+					}
+					::close( fd );
+					if( !data )
+						return;
+					const header &h = *(const header *)data;
+					if( std::memcmp( h.magic, "tracey1", 8 ) || h.count > ( size - sizeof(header) ) / sizeof(entry) ) {
+						close();
+						return;
+					}
+					entries = (const entry *)( data + sizeof(header) );
+					count = h.count;
+					text = (const char *)( entries + count );
+					text_size = size - sizeof(header) - count * sizeof(entry);
+				}
+				void close() {
+					if( data ) munmap( (void *)data, size );
+					data = 0, size = 0, entries = 0, count = 0, text = 0, text_size = 0;
+				}
 
-	// callstack, demangle, lookup
-	using namespace heal;
-}
+				bool find( uint64_t offset, std::string &out ) const {
+					size_t lo = 0, hi = count;
+					while( lo < hi ) {
+						size_t mid = lo + ( hi - lo ) / 2;
+						if( entries[mid].offset < offset ) lo = mid + 1; else hi = mid;
+					}
+					if( lo == count || entries[lo].offset != offset || uint64_t( entries[lo].text ) + entries[lo].size > text_size )
+						return false;
+					out.assign( text + entries[lo].text, entries[lo].size );
+					return true;
+				}
+			};
 
-namespace tracey
-{
-	namespace
-	{
-		volatile size_t timestamp_id = 0;
-		struct stats_t {
-			size_t usage, usage_peak, num_leaks, leak_peak, overhead;
-			stats_t() : usage(0), usage_peak(0), num_leaks(0), leak_peak(0), overhead(0) {}
-			std::string str() const {
-				return tracey::string("highest peak: \1 total, \2 greatest peak // \3 allocs in use: \4 + overhead: \5 = total: \6",
-									human(usage_peak), human(leak_peak), num_leaks, human(usage), human(overhead), human( usage + overhead ) );
+			std::string path( const tracey::elf::image &im ) {
+				return directory() + "/" + im.build_id + ".symbols";
 			}
-		} stats;
 
-		size_t create_id() {
-			static size_t id = 0;
-			return ++id;
-		}
+			// just the cache directory itself; its parent must exist. failing that is told once
+			bool make_directory( const std::string &dir ) {
+				static std::atomic< bool > told( false );
+				struct stat st;
+				if( mkdir( dir.c_str(), 0700 ) == 0 || ( stat( dir.c_str(), &st ) == 0 && S_ISDIR( st.st_mode ) ) )
+					return true;
+				if( !told.exchange( true ) ) {
+					kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: Warning, cannot create symbol cache directory \1; symbols are not cached." kTraceyCharLinefeed, dir ).c_str() );
+				}
+				return false;
+			}
 
-		bool view_report( const std::string &html ) {
-			$windows( return std::system( tracey::string("start \1", html).c_str() ), true );
-			$apple( return std::system( tracey::string("open \1", html).c_str() ), true );
-			$linux( return std::system( tracey::string("xdg-open \1", html).c_str() ), true );
-			return false;
+			// merges fresh symbols with the current file and swaps the result in, so concurrent readers
+			// see either file whole. concurrent writers may drop each other's additions, which is harmless
+			void store( const std::string &name, const file &current, std::map< uint64_t, std::string > &fresh ) {
+				for( uint64_t i = 0; i < current.count; ++i ) {
+					std::string text;
+					if( current.find( current.entries[i].offset, text ) ) {
+						fresh.insert( std::make_pair( current.entries[i].offset, text ) );
+					}
+				}
+				if( !make_directory( directory() ) )
+					return;
+				static std::atomic< unsigned > serial( 0 );
+				std::string temp = tracey::string( "\1.\2.\3", name, unsigned( getpid() ), serial++ ); // unique among concurrent reports
+				kTraceyfFile *fp = kTraceyfOpen( temp.c_str(), "wb" );
+				if( !fp )
+					return;
+				header h;
+				std::memcpy( h.magic, "tracey1", 8 );
+				h.count = fresh.size();
+				bool ok = std::fwrite( &h, sizeof(h), 1, fp ) == 1;
+				uint64_t at = 0;
+				for( std::map< uint64_t, std::string >::const_iterator it = fresh.begin(); ok && it != fresh.end(); ++it ) {
+					entry e = { it->first, uint32_t( at ), uint32_t( it->second.size() ) };
+					ok = std::fwrite( &e, sizeof(e), 1, fp ) == 1;
+					at += it->second.size();
+				}
+				for( std::map< uint64_t, std::string >::const_iterator it = fresh.begin(); ok && it != fresh.end(); ++it ) {
+					ok = std::fwrite( it->second.data(), 1, it->second.size(), fp ) == it->second.size();
+				}
+				ok = kTraceyfClose( fp ) == 0 && ok && at <= ~uint32_t(0);
+				if( !ok || std::rename( temp.c_str(), name.c_str() ) ) {
+					std::remove( temp.c_str() );
+				}
+			}
 		}
 
-		std::string get_temp_pathfile() {
-			$windows(
-				std::string path = std::string( std::getenv("TEMP") ? std::getenv("TEMP") : "." ) + std::tmpnam(0);
-				while( path.size() && path.at( path.size() - 1 ) == '.' ) path.resize( path.size() - 1 );
-				return path;
-			)
-			$welse(
-				return std::string() + std::tmpnam(0);
-			)
-		}
-	}
+		// symbols for the unique frames of a report. frames are grouped by module and cut into chunks,
+		// which a few threads resolve against the cache and the in-process tables. modules whose line
+		// tables live elsewhere are handed to one external symbolizer process each, also in parallel.
+		namespace batch {
+			struct task {
+				tracey::elf::image *im;
+				size_t begin, end;    // into frames
+				const symbol_cache::file *cache;
+			};
 
-	namespace detail
-	{
-		struct leak {
-			size_t id, size;
-			const void *addr;
-			tracey::callstack cs;
+			struct job {
+				const std::vector< void * > *frames;
+				std::vector< std::string > *symbols;
+				std::vector< char > *resolved;
+				const std::vector< task > *tasks;
+				bool external;
+				std::atomic< size_t > next;
+			};
 
-			leak() : size(0), id(0), addr(0)
-			{}
+			enum { UNRESOLVED, LINE, CACHED };
 
-			void wipe() {
-				id = create_id();
-				cs = tracey::callstack();
-				size = 0;
-				addr = 0;
+			void worker( job *j ) {
+				bool was = acquired;
+				acquired = true;
+				size_t hits = 0, misses = 0;
+				for( size_t t; ( t = j->next++ ) < j->tasks->size(); ) {
+					const task &k = (*j->tasks)[ t ];
+					if( !j->external ) {
+						bool prepared = false;
+						for( size_t i = k.begin; i < k.end; ++i ) {
+							if( k.cache ) {
+								if( k.cache->find( uintptr_t( (*j->frames)[ i ] ) - k.im->bias, (*j->symbols)[ i ] ) ) {
+									(*j->resolved)[ i ] = CACHED;
+									++hits;
+									continue;
+								}
+								++misses;
+							}
+							if( !prepared ) {
+								tracey::elf::prepare( *k.im );
+								prepared = true;
+							}
+							(*j->resolved)[ i ] = tracey::elf::lookup( *k.im, (*j->frames)[ i ], (*j->symbols)[ i ] ) ? LINE : UNRESOLVED;
+						}
+					} else {
+						std::vector< void * > pending;
+						std::vector< std::string * > outputs;
+						std::vector< size_t > at;
+						for( size_t i = k.begin; i < k.end; ++i ) {
+							if( (*j->resolved)[ i ] == UNRESOLVED ) {
+								pending.push_back( (*j->frames)[ i ] );
+								outputs.push_back( &(*j->symbols)[ i ] );
+								at.push_back( i );
+							}
+						}
+						std::vector< char > found( pending.size(), 0 );
+						tracey::elf::external( *k.im, pending, outputs, &found );
+						for( size_t i = 0; i < found.size(); ++i ) {
+							if( found[ i ] ) (*j->resolved)[ at[ i ] ] = LINE;
+						}
+					}
+				}
+				symbol_cache::hits += hits;
+				symbol_cache::misses += misses;
+				acquired = was;
 			}
 
-			~leak() {
-				wipe();
+			// calling thread takes part
+			void run( job &j, const std::vector< task > &tasks, bool external ) {
+				j.tasks = &tasks;
+				j.external = external;
+				j.next = 0;
+				size_t threads = std::min< size_t >( std::max( 1u, std::thread::hardware_concurrency() ), tasks.size() );
+				// thread state and its TLS belong to tracey, as does the pool itself
+				bool was_acquired = acquired;
+				acquired = true;
+				std::vector< std::thread > pool;
+				for( size_t t = 1; t < threads; ++t ) {
+					pool.push_back( std::thread( worker, &j ) );
+				}
+				acquired = was_acquired;
+				worker( &j );
+				acquired = true;
+				for( size_t t = 0; t < pool.size(); ++t ) {
+					pool[ t ].join();
+				}
+				pool = std::vector< std::thread >();
+				acquired = was_acquired;
 			}
-		};
-	}
-
-	namespace
-	{
-		using namespace tracey::detail;
+		}
 
-		typedef std::vector< const leak * > leaks;
+		std::vector< std::string > symbolize( const std::vector< void * > &frames ) {
+			enum { CHUNK = 4096 };
+			std::vector< std::string > symbols( frames.size() );
+			std::vector< char > resolved( frames.size(), batch::UNRESOLVED );
+			std::vector< batch::task > chunks, external;
+			std::vector< symbol_cache::file > caches;
+			std::vector< void * > strays;
+			std::vector< size_t > stray_at;
+			// sorted frames make each module a single run
+			for( size_t i = 0, end; i < frames.size(); i = end ) {
+				end = i + 1;
+				tracey::elf::image *im = tracey::elf::locate( frames[ i ] );
+				if( !im ) {
+					strays.push_back( frames[ i ] );
+					stray_at.push_back( i );
+					continue;
+				}
+				while( end < frames.size() && uintptr_t( frames[ end ] ) >= im->lo && uintptr_t( frames[ end ] ) < im->hi ) {
+					++end;
+				}
+				batch::task m = { im, i, end, 0 };
+				external.push_back( m );
+			}
+			// mapped after grouping, so tasks can point into a vector that no longer grows
+			caches.resize( external.size() );
+			for( size_t m = 0; m < external.size(); ++m ) {
+				batch::task &k = external[ m ];
+				if( !symbol_cache::directory().empty() && !k.im->build_id.empty() ) {
+					caches[ m ].open( symbol_cache::path( *k.im ) );
+					k.cache = &caches[ m ];
+				}
+				for( size_t c = k.begin; c < k.end; c += CHUNK ) {
+					batch::task chunk = { k.im, c, std::min< size_t >( c + CHUNK, k.end ), k.cache };
+					chunks.push_back( chunk );
+				}
+			}
 
-		// recursive mutex
-		std::recursive_mutex *mutex = 0;
+			batch::job j;
+			j.frames = &frames;
+			j.symbols = &symbols;
+			j.resolved = &resolved;
+			batch::run( j, chunks, false );
+
+			// lookups are done, so whether a module has line tables of its own is known now
+			std::vector< batch::task > missing;
+			for( size_t m = 0; m < external.size(); ++m ) {
+				const batch::task &k = external[ m ];
+				if( !k.im->lines && std::find( resolved.begin() + k.begin, resolved.begin() + k.end, char( batch::UNRESOLVED ) ) != resolved.begin() + k.end ) {
+					missing.push_back( k );
+				}
+			}
+			batch::run( j, missing, true );
+
+			for( size_t m = 0; m < external.size(); ++m ) {
+				const batch::task &k = external[ m ];
+				std::map< uint64_t, std::string > fresh;
+				for( size_t i = k.begin; k.cache && i < k.end; ++i ) {
+					if( resolved[ i ] == batch::LINE ) {
+						fresh[ uintptr_t( frames[ i ] ) - k.im->bias ] = symbols[ i ];
+					}
+				}
+				if( !fresh.empty() ) {
+					symbol_cache::store( symbol_cache::path( *k.im ), caches[ m ], fresh );
+				}
+				caches[ m ].close();
+			}
 
-		// hard on/off switch
-		static const    bool kTraceyEnabledHard = kTraceyEnabled;
-		// soft on/off switch
-		static volatile bool kTraceyEnabledSoft = true;
+			if( strays.size() ) {
+				tracey::callstack cs;
+				cs.frames = strays;
+				std::vector< std::string > unwound = cs.unwind();
+				for( size_t i = 0; i < unwound.size() && i < stray_at.size(); ++i ) {
+					symbols[ stray_at[ i ] ] = unwound[ i ];
+				}
+			}
+			return symbols;
+		}
+#else
+		std::vector< std::string > symbolize( const std::vector< void * > &frames ) {
+			tracey::callstack cs;
+			cs.frames = frames;
+			return cs.unwind();
+		}
+#endif
 
-		class container : public std::map< const void *, leak, std::less< const void * > > //, tracey::malloc_allocator< std::pair< const void *, leak * > > >
+		class container
 		{
 			public:
 
-			container()
+			// registry is split by pointer hash into independently locked stripes, each one
+			// with its own map and counters. alloc/free from different threads rarely contend.
+			struct shard {
+				mutable std::mutex mutex;
+				table< leak > map;
+				stats_t stats;
+				header *live;      // header mode: tracked blocks with an inline record
+				size_t linked;
+
+				shard() : live(0), linked(0)
+				{}
+
+				void link( header *h ) {
+					h->prev = 0;
+					h->next = live;
+					if( live ) live->prev = h;
+					live = h;
+					linked++;
+					stats.headers += h->offset;
+				}
+				void unlink( header *h ) {
+					if( h->prev ) h->prev->next = h->next; else live = h->next;
+					if( h->next ) h->next->prev = h->prev;
+					linked--;
+					stats.headers -= h->offset;
+				}
+			};
+
+			shard shards[ kTraceyRegistryShards ];
+			stacktable stacks;
+			bloomfilter filter;
+			eventlog events;
+			mappings maps;
+			std::atomic<bool> aggregating;
+			std::thread worker;                 // the aggregator, once started
+			std::atomic<size_t> usage, usage_peak; // registry-wide, so the peak is a real high-water mark
+
+			shard &find_shard( const void *ptr ) {
+				// skip alignment bits, then fibonacci hashing spreads neighbour blocks across stripes
+				uint64_t hash = uint64_t( (uintptr_t)ptr >> 4 ) * 0x9E3779B97F4A7C15ULL;
+				return shards[ (hash >> 32) & (kTraceyRegistryShards - 1) ];
+			}
+
+			container() : aggregating(false), usage(0), usage_peak(0)
 			{
-				 mutex = new std::recursive_mutex();
+				ready = true;
 			}
 
 			~container() {
-				mutex = 0;
+				ready = false;
+				acquired = true; // report below allocates from the metadata arena
+				stop();
 
-				if( kTraceyReportOnExit && kTraceyEnabledSoft ) {
-					view_report( _report() );
+				if( options().report_on_exit && kTraceyEnabledSoft ) {
+					std::string logfile = _report();
+					if( options().view ) view_report( logfile );
 				}
 
+#ifdef TRACEY_PRELOAD
+				// preloaded into someone else's program: its exit status and its remaining atexit handlers and
+				// static destructors are left alone. the arena is never freed, and later frees see ready=false
+				return;
+#endif
+
 				// We should clear the memory involved in all allocations but after all, we are a memory tracker and we should be the very
 				// last thing to deallocate in any program. So we don't do it and we save some time for developing when exiting the app.
 				// Silent & quick exit. Not a requirement in all architectures but who knows.
@@ -3237,29 +6617,341 @@ namespace tracey
 
 			void _clear() {
 
-				for( iterator it = this->begin(), end = this->end(); it != end; ++it ) {
-					it->second.wipe();
+				for( unsigned s = 0; s < kTraceyRegistryShards; ++s ) {
+					shard &sh = shards[s];
+					sh.mutex.lock();
+					sh.map.clear();
+					for( header *h = sh.live; h; h = h->next ) {
+						h->mark( (char *)h + header_size, header::BLOCK );
+					}
+					sh.live = 0;
+					sh.linked = 0;
+					sh.stats = stats_t();
+					sh.mutex.unlock();
+				}
+				usage = usage_peak = 0;
+				stacks.clear_chains();
+				maps.clear();
+			}
+
+			size_t size() const {
+				size_t total = 0;
+				for( unsigned s = 0; s < kTraceyRegistryShards; ++s ) {
+					shards[s].mutex.lock();
+					total += shards[s].map.size() + shards[s].linked;
+					shards[s].mutex.unlock();
+				}
+				return total;
+			}
+
+			stats_t stats() const {
+				stats_t total;
+				for( unsigned s = 0; s < kTraceyRegistryShards; ++s ) {
+					shards[s].mutex.lock();
+					total += shards[s].stats;
+					total.overhead += shards[s].map.space();
+					shards[s].mutex.unlock();
+				}
+				total.usage = usage.load();
+				total.usage_peak = usage_peak.load();
+				total.overhead += total.headers;
+				total.overhead += stacks.space();
+				total.overhead += sizeof(filter);
+				total.overhead += events.space();
+				total.buffer_peak = events.high_water();
+				total.buffer_stalls = events.backpressure();
+				total.sample_rate = sampler::rate;
+				total.arena_used = metadata().used();
+				total.arena_footprint = metadata().footprint();
+				if( const arena *slabs = slab::instance() ) {
+					total.slab_used = slabs->used();
+					total.slab_footprint = slabs->footprint();
+				}
+				filter.totals( &total.filter_rejects, &total.filter_passes, &total.filter_false_positives );
+				maps.totals( &total.regions, &total.mapped, &total.mapped_anonymous, &total.mapped_discarded, &total.mapped_peak );
+#if HEAL_HAS_ELF
+				total.symbol_hits = symbol_cache::hits.load();
+				total.symbol_misses = symbol_cache::misses.load();
+#endif
+				return total;
+			}
+
+			// registry bookkeeping, shared by synchronous tracer and async aggregator {
+
+			// adds bytes in use and raises the peak if exceeded
+			void account( size_t delta ) {
+				size_t now = usage.fetch_add( delta ) + delta, top = usage_peak.load( std::memory_order_relaxed );
+				while( now > top && !usage_peak.compare_exchange_weak( top, now ) );
+			}
+
+			// returns false if ptr was not being watched (wild pointer)
+			// *mismatch is set to the recorded size if it differs from a non-zero expected size
+			// *detached receives the record, so a reallocation can carry it over to the new block
+			bool untrack( const void *ptr, size_t expected = 0, size_t *mismatch = 0, leak *detached = 0 ) {
+				shard &sh = find_shard( ptr );
+				sh.mutex.lock();
+				size_t size = 0;
+				float weight = 1;
+				bool found;
+				if( header *h = headed( ptr ) ) {
+					// header mode: the record is right before ptr, no lookup
+					found = h->is( ptr, header::LIVE );
+					if( found ) {
+						size = h->size;
+						weight = h->weight;
+						if( detached ) {
+							detached->id = h->id;
+							detached->size = h->size;
+							detached->addr = ptr;
+							detached->stack = h->stack;
+							detached->weight = h->weight;
+						}
+						sh.unlink( h );
+						h->mark( ptr, header::BLOCK );
+					}
+				} else {
+					leak *L = sh.map.find( ptr );
+					found = ( L != 0 );
+					if( found ) {
+						size = L->size;
+						weight = L->weight;
+						if( detached ) *detached = *L;
+						sh.map.erase( L );
+					}
+				}
+				if( found )
+				{
+					if( expected && mismatch && size != expected ) *mismatch = size;
+					usage -= sampler::bytes( size, weight );
+					sh.stats.num_leaks -= sampler::count( weight );
+				}
+				sh.mutex.unlock();
+				if( found ) {
+					filter.unmark( ptr );
+				} else {
+					filter.false_positive(); // every caller asked the filter first
+				}
+				return found;
+			}
+
+			// returns true if ptr was already being watched (double allocation)
+			// previous: record detached from the block ptr was reallocated from; its id and stack are kept
+			bool track( const void *ptr, size_t size, uint32_t stack, const leak *previous = 0 ) {
+				size_t id = previous ? previous->id : create_id();
+				float weight = sampler::weight( size );
+				shard &sh = find_shard( ptr );
+				sh.mutex.lock();
+				header *h = headed( ptr );
+				leak *L = h ? 0 : sh.map.find( ptr );
+				bool found = h ? h->is( ptr, header::LIVE ) : ( L != 0 );
+
+				if( found ) {
+					// forget previous record before reusing it
+					size_t previous = h ? h->size : L->size;
+					float previous_weight = h ? h->weight : L->weight;
+					usage -= sampler::bytes( previous, previous_weight );
+					sh.stats.num_leaks -= sampler::count( previous_weight );
+				}
+
+				if( h ) {
+					// header mode: fill the inline record and chain it
+					if( !found ) {
+						sh.link( h );
+						h->mark( ptr, header::LIVE );
+					}
+					h->id = id;
+					h->stack = stack;
+					h->size = size;
+					h->weight = weight;
+				} else {
+					// create a leak and (re)insert it into map
+					tracey::detail::leak &leak = found ? *L : sh.map.insert( ptr );
+					leak.id = id;
+					leak.stack = stack;
+					leak.size = size;
+					leak.weight = weight;
+				}
+
+				// realloc chain of the allocation site; failed reallocations give the record back unchanged
+				size_t copied = 0;
+				bool resized = previous && ( previous->addr != ptr || previous->size != size );
+				if( resized ) {
+					if( previous->addr == ptr ) {
+						sh.stats.resized++;
+					} else {
+						copied = std::min( previous->size, size );
+						sh.stats.moved++;
+						sh.stats.copied += copied;
+					}
+				}
+
+				// update stats (scaled back up when sampling)
+				sh.stats.num_leaks += sampler::count( weight );
+				account( sampler::bytes( size, weight ) );
+
+				// and peaks
+				if( size > sh.stats.leak_peak ) sh.stats.leak_peak = size;
+
+				sh.mutex.unlock();
+				if( resized ) {
+					stacks.regrew( stack, copied );
 				}
+				return found;
+			}
+
+			// }
+
+			// async mode {
+
+			// queues an event for the aggregator. returns false if caller must track synchronously,
+			// which waits for queued events first so they cannot land after the synchronous update
+			bool defer( const void *ptr, size_t size, uint32_t stack ) {
+				if( !aggregating.load( std::memory_order_relaxed ) && !aggregating.exchange( true ) ) {
+					$welse(
+						if( !forking() ) {
+							forking() = this;
+							pthread_atfork( before_fork, 0, after_fork );
+						}
+					)
+					worker = std::thread( aggregator, this );
+				}
+				if( events.push( ptr, size, stack ) ) {
+					return true;
+				}
+				events.flush();
+				return false;
+			}
+
+			void flush() const {
+				if( policy_t::ASYNC && aggregating.load() ) {
+					events.flush();
+				}
+			}
+
+			// joins the aggregator and applies whatever it left behind
+			void stop() {
+				if( policy_t::ASYNC && aggregating.load() ) {
+					events.close();
+					if( worker.joinable() ) {
+						worker.join();
+					}
+					events.drain( *this, true );
+				}
+			}
+
+			// forked child has no aggregator: queued events are applied before forking, and the
+			// child starts a new aggregator (with fresh rings) on its first event
+			static container *&forking() {
+				static container *self = 0;
+				return self;
+			}
+			static void before_fork() {
+				forking()->flush();
+			}
+			static void after_fork() {
+				container *self = forking();
+				self->events.reset();
+				new (&self->worker) std::thread(); // parent's handle means nothing here
+				self->aggregating = false;
+			}
+
+			void apply( const event &e ) {
+				if( !e.size ) {
+					if( !untrack( e.addr ) && policy_t::WILD && !sampler::on() ) {
+						kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: Error, wild pointer deallocation (\1)." kTraceyCharLinefeed, e.addr ).c_str() );
+					}
+				} else {
+					if( track( e.addr, e.size, e.stack ) && kTraceyReportDoubleAllocations ) {
+						kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: Error, double pointer allocation (\1). This should never happen" kTraceyCharLinefeed, e.addr ).c_str() );
+					}
+				}
+			}
 
-				this->clear();
+			static void aggregator( container *self ) {
+				acquired = true; // aggregator allocations are never tracked
+				for( unsigned idle = 0; !self->events.done(); ) {
+					if( self->events.drain( *self ) ) {
+						idle = 0;
+					} else if( ++idle < 64 ) {
+						std::this_thread::yield();
+					} else {
+						std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+					}
+				}
 			}
 
+			// }
+
+			// leaks of one callstack, folded together; a table<> record keyed by the interned stack id
+			struct stack_total {
+				const void *addr;     // stack id << 4, so that table<> hashes consecutive ids apart
+				size_t count, bytes;  // as sampler::count() and sampler::bytes() estimate them
+				stack_total() : addr(0), count(0), bytes(0)
+				{}
+				uint32_t stack() const {
+					return uint32_t( uintptr_t( addr ) >> 4 );
+				}
+			};
+
+			// leaks are copied out shard by shard, so no stripe stays locked while the report is built
 			leaks collect_leaks( size_t *wasted ) const {
 				leaks list;
 				*wasted = 0;
-				for( const_iterator it = this->begin(), end = this->end(); it != end; ++it ) {
-					const tracey::detail::leak &L = it->second;
-					if( L.addr && L.size && L.id >= timestamp_id ) {
-						*wasted += L.size;
-						list.push_back( &L );
+				for( unsigned s = 0; s < kTraceyRegistryShards; ++s ) {
+					const shard &sh = shards[s];
+					sh.mutex.lock();
+					for( size_t i = 0, end = sh.map.capacity(); i < end; ++i ) {
+						const tracey::detail::leak &L = sh.map.at( i );
+						if( L.addr && L.size && L.id >= timestamp_id ) {
+							*wasted += sampler::bytes( L.size, L.weight );
+							list.push_back( L );
+						}
+					}
+					for( const header *h = sh.live; h; h = h->next ) {
+						if( h->size && h->id >= timestamp_id ) {
+							leak L;
+							L.id = h->id;
+							L.size = h->size;
+							L.addr = (const char *)h + header_size;
+							L.stack = h->stack;
+							L.weight = h->weight;
+							*wasted += sampler::bytes( L.size, L.weight );
+							list.push_back( L );
+						}
 					}
+					sh.mutex.unlock();
 				}
 				return list;
 			}
 
+			// sites listed apart from the tree (realloc chains, mappings) show their innermost frames only {
+
+			enum { SITES = 20, SITE_FRAMES = 4 };
+
+			void site_frames( uint32_t stack, std::set< void * > &set ) const {
+				unsigned depth;
+				void *const *frames = stacks.frames( stack, &depth );
+				for( unsigned i = kTraceyStacktraceSkipBegin; i < depth && i < kTraceyStacktraceSkipBegin + SITE_FRAMES; ++i ) {
+					set.insert( frames[i] );
+				}
+			}
+
+			std::string site_symbols( uint32_t stack, std::map< void *, std::string > &translate ) const {
+				unsigned depth;
+				void *const *frames = stacks.frames( stack, &depth );
+				std::string site;
+				for( unsigned i = kTraceyStacktraceSkipBegin; i < depth && i < kTraceyStacktraceSkipBegin + SITE_FRAMES; ++i ) {
+					site += ( site.empty() ? "" : " <- " ) + translate[ frames[i] ];
+				}
+				return site;
+			}
+
+			// }
+
 			std::string _report() const {
 
-				std::string logfile = get_temp_pathfile() + "xxx-tracey.html";
+				std::string logfile = options().report_path();
+				stats_t stats = this->stats();
 
 				kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: summary: \1" kTraceyCharLinefeed, stats.str() ).c_str() );
 				kTraceyPrintf( "%s", tracey::string( "<tracey/tracey.cpp> says: creating report: \1" kTraceyCharLinefeed, logfile).c_str() );
@@ -3274,10 +6966,13 @@ namespace tracey
 
 				// Find leaks
 				kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: filtering leaks..." kTraceyCharLinefeed).c_str() );
-				size_t wasted, n_leak;
+				size_t wasted, n_leak, n_estimated = 0;
 				leaks filtered = collect_leaks( &wasted );
 				n_leak = filtered.size();
-				kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: found \1 leaks wasting \2" kTraceyCharLinefeed, n_leak, human(wasted)).c_str() );
+				for( leaks::const_iterator it = filtered.begin(), end = filtered.end(); it != end; ++it ) {
+					n_estimated += sampler::count( it->weight );
+				}
+				kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: found \1 leaks wasting \2" kTraceyCharLinefeed, n_estimated, human(wasted)).c_str() );
 
 				// Calc score
 				double leaks_pct = this->size() ? n_leak * 100.0 / this->size() : 0.0;
@@ -3294,46 +6989,106 @@ namespace tracey
 				if( tracey::lookup(url) == "????" )
 				kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: failed to decode symbols!! Is debug information available?" $msvc(" Are .PDB files available?") kTraceyCharLinefeed ).c_str() );
 				kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: best viewed on foldable text editor (like SublimeText2) with tabs=2sp and no word-wrap" kTraceyCharLinefeed ).c_str() );
-				kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: \1, \2 leaks found; \3 wasted ('\4' score)" kTraceyCharLinefeed, !n_leak ? "ok" : "error", n_leak, human(wasted), score ).c_str() );
+				kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: \1, \2 leaks found; \3 wasted ('\4' score)" kTraceyCharLinefeed, !n_leak ? "ok" : "error", n_estimated, human(wasted), score ).c_str() );
+				if( sampler::rate )
+				kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: sampled one allocation every ~\1; \2 samples, figures below are estimates" kTraceyCharLinefeed, human(sampler::rate), n_leak ).c_str() );
 				kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: summary: \1" kTraceyCharLinefeed, stats.str() ).c_str() );
 				kTraceyfPrintf( fp, "%s", tracey::string( "<tracey/tracey.cpp> says: report filename: \1" kTraceyCharLinefeed, logfile).c_str() );
 
+				// Leaks from the same callstack are folded first, so the trees cost one walk per distinct
+				// stack instead of one per leaked block
+				table< stack_total > folded;
+				for( leaks::const_iterator it = filtered.begin(), end = filtered.end(); it != end; ++it ) {
+					if( it->stack ) {
+						stack_total &S = folded.insert( (const void *)( uintptr_t( it->stack ) << 4 ) );
+						S.count += sampler::count( it->weight );
+						S.bytes += sampler::bytes( it->size, it->weight );
+					}
+				}
+				kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: folded \1 leaks into \2 unique callstacks" kTraceyCharLinefeed, n_leak, folded.size()).c_str() );
+
+				// Some apps are low on memory in here, so we free memory as soon as possible
+				filtered = leaks();
+
 				// Body
 				// Get all frame addresses involved in all leaks
 				// Also, create a tree of frames; so we will take decisions from above by examining node weights (@todo)
 				kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: creating trees of frames..."  kTraceyCharLinefeed).c_str() );
 				std::set< void * > set;
 				tracey::tree tree;
-				tree[ (void *)((~0)-0) ]; // bottom-top branch
-				tree[ (void *)((~0)-1) ]; // top-bottom branch
-				for( leaks::const_iterator it = filtered.begin(), end = filtered.end(); it != end; ++it ) {
-					const leak &L = **it;
-					const tracey::callstack &callstack = L.cs;
+				tracey::calltree flat;
+				const uint32_t flat_top = flat.insert( 0, (void *)((~0)-0) ); // bottom-top branch
+				const uint32_t flat_inv = flat.insert( 0, (void *)((~0)-1) ); // top-bottom branch
+				if( !kTraceyFlatTree ) {
+					tree[ (void *)((~0)-0) ]; // bottom-top branch
+					tree[ (void *)((~0)-1) ]; // top-bottom branch
+				}
+				for( size_t s = 0, capacity = folded.capacity(); s < capacity; ++s ) {
+					const stack_total &S = folded.at( s );
+					if( !S.addr ) continue;
+					unsigned depth;
+					void *const *frames = stacks.frames( S.stack(), &depth );
+					if( !depth ) continue;
+
+					if( kTraceyFlatTree ) {
+						uint32_t _top = flat_top, _inv = flat_inv;
+						for( unsigned i = 0, start = kTraceyStacktraceSkipBegin, end = depth - 1 - kTraceyStacktraceSkipEnd; start+i <= end; ++i ) {
+							double size;
+							size = (start+i == end ? S.bytes : 0);
+							_top = flat.insert( _top, frames[start + i] );
+							flat.nodes[ _top ].value.size += size;
+							flat.nodes[ _top ].value.hits += S.count;
+							set.insert( frames[start + i] );
+
+							size = (end - i == start ? S.bytes : 0);
+							_inv = flat.insert( _inv, frames[end - i] );
+							flat.nodes[ _inv ].value.size += size;
+							flat.nodes[ _inv ].value.hits += S.count;
+							set.insert( frames[end - i] );
+						}
+						continue;
+					}
+
 					tracey::tree *_tree = &tree[(void *)((~0)-0)];
 					tracey::tree *_tree_inv = &tree[(void *)((~0)-1)];
-					if( !callstack.frames.size() ) continue;
-
-					for( unsigned i = 0, start = kTraceyStacktraceSkipBegin, end = callstack.frames.size() - 1 - kTraceyStacktraceSkipEnd; start+i <= end; ++i ) {
+					for( unsigned i = 0, start = kTraceyStacktraceSkipBegin, end = depth - 1 - kTraceyStacktraceSkipEnd; start+i <= end; ++i ) {
 
 						double size;
-						size = (start+i == end ? L.size : 0);
-						(*_tree)[ callstack.frames[start + i] ].get().size += size;
-						(*_tree)[ callstack.frames[start + i] ].get().hits ++;
-						//(*_tree)[ callstack.frames[start + i] ].get().total = 100.0 * size / wasted;
-						_tree = &(*_tree)[ callstack.frames[start + i] ];
-						set.insert( callstack.frames[start + i] );
-
-						size = (end - i == start ? L.size : 0);
-						(*_tree_inv)[ callstack.frames[end - i] ].get().size += size;
-						(*_tree_inv)[ callstack.frames[end - i] ].get().hits ++;
-						//(*_tree_inv)[ callstack.frames[end - i] ].get().total = 100.0 * size / wasted;
-						_tree_inv = &(*_tree_inv)[ callstack.frames[end - i] ];
-						set.insert( callstack.frames[end - i] );
+						size = (start+i == end ? S.bytes : 0);
+						(*_tree)[ frames[start + i] ].get().size += size;
+						(*_tree)[ frames[start + i] ].get().hits += S.count;
+						//(*_tree)[ frames[start + i] ].get().total = 100.0 * size / wasted;
+						_tree = &(*_tree)[ frames[start + i] ];
+						set.insert( frames[start + i] );
+
+						size = (end - i == start ? S.bytes : 0);
+						(*_tree_inv)[ frames[end - i] ].get().size += size;
+						(*_tree_inv)[ frames[end - i] ].get().hits += S.count;
+						//(*_tree_inv)[ frames[end - i] ].get().total = 100.0 * size / wasted;
+						_tree_inv = &(*_tree_inv)[ frames[end - i] ];
+						set.insert( frames[end - i] );
 					}
 				}
 
-				// Some apps are low on memory in here, so we free memory as soon as possible
-				filtered = leaks();
+				folded.clear();
+
+				// Realloc chains: sites whose blocks kept growing (or shrinking)
+				std::vector< stacktable::chain > chains = stacks.chains();
+				if( chains.size() > SITES ) {
+					chains.resize( SITES );
+				}
+				for( size_t c = 0; c < chains.size(); ++c ) {
+					site_frames( chains[c].stack, set );
+				}
+
+				// Mappings: address space mapped by the application itself, which is not part of the tree
+				std::vector< mappings::site > mapped = maps.sites();
+				if( mapped.size() > SITES ) {
+					mapped.resize( SITES );
+				}
+				for( size_t m = 0; m < mapped.size(); ++m ) {
+					site_frames( mapped[m].stack, set );
+				}
 
 				if( !set.size() ) {
 					if( n_leak ) {
@@ -3348,7 +7103,15 @@ namespace tracey
 					for( std::set< void * >::iterator it = set.begin(), end = set.end(); it != end; ++it ) {
 						frames.push_back( *it );
 					}
-					tracey::strings symbols = cs.unwind();
+#if HEAL_HAS_ELF
+					size_t hits = symbol_cache::hits.load(), misses = symbol_cache::misses.load();
+#endif
+					tracey::strings symbols = symbolize( frames );
+#if HEAL_HAS_ELF
+					if( !symbol_cache::directory().empty() ) {
+						kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: symbol cache: \1 hits, \2 misses" kTraceyCharLinefeed, symbol_cache::hits.load() - hits, symbol_cache::misses.load() - misses).c_str() );
+					}
+#endif
 					std::map< void *, std::string > translate;
 					{
 						if( frames.size() != symbols.size() ) {
@@ -3366,7 +7129,11 @@ namespace tracey
 						kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: converting tree of frames into tree of symbols..." kTraceyCharLinefeed).c_str() );
 						translate[ (void *)((~0)-1) ] = "begin";
 						translate[ (void *)((~0)-0) ] = "end";
-						tree.refresh();
+						if( kTraceyFlatTree ) {
+							flat.refresh();
+						} else {
+							tree.refresh();
+						}
 						//std::cout << tree << std::endl;
 
 						// truncate branches lower than user-defined percentage (it helps reducing log size)
@@ -3374,11 +7141,35 @@ namespace tracey
 
 						kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: flattering tree of symbols..." kTraceyCharLinefeed).c_str() );
 						if( kTraceyTruncateBranchesSmallerThan > 0 ) {
-							tree.walk<tracey::chopper>();
+							if( kTraceyFlatTree ) {
+								flat.chop( kTraceyTruncateBranchesSmallerThan );
+							} else {
+								tree.walk<tracey::chopper>();
+							}
 						}
 
 						kTraceyPrintf( "%s", tracey::string("<tracey/tracey.cpp> says: dumping tree log..." kTraceyCharLinefeed).c_str() );
-						kTraceyfPrintf( fp, "%s", tracey::print(tree, wasted, translate, "{tabs}[{size}] ({value}) {key}\n", "{value}", true).c_str() );
+						if( kTraceyFlatTree ) {
+							kTraceyfPrintf( fp, "%s", tracey::print(flat, wasted, translate, "{tabs}[{size}] ({value}) {key}\n", "{value}", true).c_str() );
+						} else {
+							kTraceyfPrintf( fp, "%s", tracey::print(tree, wasted, translate, "{tabs}[{size}] ({value}) {key}\n", "{value}", true).c_str() );
+						}
+
+						if( !chains.empty() ) {
+							kTraceyfPrintf( fp, "%s", tracey::string( kTraceyCharLinefeed "<tracey/tracey.cpp> says: realloc chains (\1 busiest sites)" kTraceyCharLinefeed, chains.size() ).c_str() );
+						}
+						for( size_t c = 0; c < chains.size(); ++c ) {
+							kTraceyfPrintf( fp, "%s", tracey::string( kTraceyCharTab "[\1 regrows, \2 copied] \3" kTraceyCharLinefeed,
+								chains[c].regrows, human( chains[c].copied ), site_symbols( chains[c].stack, translate ) ).c_str() );
+						}
+
+						if( !mapped.empty() ) {
+							kTraceyfPrintf( fp, "%s", tracey::string( kTraceyCharLinefeed "<tracey/tracey.cpp> says: mappings (\1 biggest sites, discarded pages excluded)" kTraceyCharLinefeed, mapped.size() ).c_str() );
+						}
+						for( size_t m = 0; m < mapped.size(); ++m ) {
+							kTraceyfPrintf( fp, "%s", tracey::string( kTraceyCharTab "[\1 in \2 regions] \3" kTraceyCharLinefeed,
+								human( mapped[m].bytes ), mapped[m].count, site_symbols( mapped[m].stack, translate ) ).c_str() );
+						}
 					}
 				}
 
@@ -3390,34 +7181,97 @@ namespace tracey
 			}
 		};
 
-		void *tracer( void *ptr, size_t &size );
+		void *tracer( void *ptr, size_t &size, size_t expected = 0 );
 
-		container &init() {
-			//static unsigned char buy[ sizeof( container ) ];
-			//static container *map = new (buy) container();
-			static $cpp11(std::unique_ptr) $cpp03(std::auto_ptr)<container> map( new container() );
+		// a record on its way across a reallocation, handed to tracer() twice: once to detach it from
+		// the old block before that block is released, and once to attach it to the new block.
+		struct moving {
+			void *from, *to;
+			size_t size;
+			leak record;
+			bool detached;
+		};
 
-			static bool once = false; if(! once ) { once = true;
-				kTraceyPrintf( "%s", tracey::settings().c_str() );
-				if( 1 ) {
-					webmain( 0 );
-				}
-				if( 1 ) {
-					volatile bool sitdown = false;
-					std::thread(tracey::hotkeymain, (void *) &sitdown).detach();
-					while( !sitdown ) {
-					$windows( Sleep( 1000 ) );
-					$welse( sleep( 1 ) );
-					}
+		// tracer() size that hands it a moving record
+		const size_t moving_fn = size_t(~0) - 5;
+
+		// a change to the address space, handed to tracer() by the mmap hooks. a remap is handed twice,
+		// like a reallocation: the old range is released first, and the new one is mapped afterwards.
+		struct mapping {
+			enum kind { MAP, UNMAP, REMAP, DISCARD } op;
+			const void *addr;
+			size_t length;
+			mappings::region props;
+			bool detached;
+		};
+
+		// tracer() size that hands it a mapping event
+		const size_t mapping_fn = size_t(~0) - 6;
+
+		// one-time initialization is a lock-free state machine. first thread to flip the state builds
+		// the registry in the metadata arena and publishes it; threads racing with it spin until then.
+		// banner, webserver and hotkeys are left to start_services(), which only spawns their thread.
+		enum { UNINITIALIZED, INITIALIZING, INITIALIZED };
+		std::atomic<int> init_state( UNINITIALIZED );
+		std::atomic<container *> registry( 0 );
+
+		void start_services();
+
+		void shutdown() {
+			registry.load()->~container();
+		}
+
+		container &init() {
+			container *map = registry.load( std::memory_order_acquire );
+			if( map ) {
+				return *map;
+			}
+			int state = UNINITIALIZED;
+			if( init_state.compare_exchange_strong( state, INITIALIZING ) ) {
+				bool was_acquired = acquired;
+				acquired = true; // anything allocated meanwhile belongs to tracey
+				options(); // settings are read once, before anything is tracked
+				map = new ( metadata().alloc( sizeof(container) ) ) container();
+				std::atexit( shutdown );
+				registry.store( map, std::memory_order_release );
+				init_state = INITIALIZED;
+				if( kTraceyEnabled ) {
+					start_services();
 				}
-				// Construct internals of tracer (static initializers)
-				// size_t dummy = 0;
-				// tracer( 0, dummy );
+				acquired = was_acquired;
+				return *map;
+			}
+			while( !(map = registry.load( std::memory_order_acquire )) ) {
+				std::this_thread::yield();
 			}
 			return *map;
 		}
 
-		void *tracer( void *ptr, size_t &size )
+		// banner, webserver and hotkeys run on their own thread, which is spawned once by the first
+		// tracked allocation; no allocation ever waits for them.
+		void services() {
+			acquired = true;
+			kTraceyPrintf( "%s", tracey::settings().c_str() );
+			webmain( 0 );
+			acquired = false;
+			hotkeymain( 0 );
+		}
+
+		void start_services() {
+			$welse(
+				if( options().signal ) {
+					signal( options().signal, on_report_signal ); // before anyone can send it
+				}
+			)
+			// thread state and its TLS are allocated by this thread, and belong to tracey
+			bool was_acquired = acquired;
+			acquired = true;
+			std::thread( services ).detach();
+			acquired = was_acquired;
+		}
+
+		// expected: size told by a sized deallocation, if any
+		void *tracer( void *ptr, size_t &size, size_t expected )
 		{
 			if( !ptr )
 				return size = 0, ptr;
@@ -3425,80 +7279,128 @@ namespace tracey
 			if( !kTraceyEnabledHard )                       // hard on/off switch
 				return size = 0, ptr;
 
-			if( !kTraceyEnabledSoft && (size < (~0) - 4) )  // soft on/off switch; only for mallocs & frees
-				return size = 0, ptr;
+			if( !kTraceyEnabledSoft && (size < (~0) - 4) && size != moving_fn && size != mapping_fn )  // soft on/off switch; only for mallocs & frees
+				return size = 0, ptr;                          // (records keep moving, and mappings check it themselves, as unmaps go on)
 
-#if         kTraceyHookLegacyCRT
-			// do nothing
-#else
-			static bool initialized = true;
-			if( !initialized )
+			if( metadata().owns( ptr ) )                    // tracey metadata is never tracked
 				return size = 0, ptr;
-			static container *init = 0;
-			static const bool reinit = (initialized = false, init = &tracey::init(), initialized = true);
-			static container &map = *init;
-#endif
 
-			if ( !mutex )
+			// threads will return on recursive calls (tracey allocating for itself).
+			// threads will lock the shard owning ptr; special functions visit every shard.
+			// in async mode threads just queue an event, and special functions flush the queues first.
+			// when sampling, unsampled allocations and frees of never sampled pointers return early.
+
+			if( acquired )
 				return size = 0, ptr;
 
-			// threads will lock here till the slot is free.
-			// threads will return on recursive locks.
+			container &map = tracey::init();                // one acquire load once initialized
 
-			static $tls(bool) acquired = false;
-			mutex->lock();
-			if( acquired ) {
-				mutex->unlock();
+			if ( !ready )
 				return size = 0, ptr;
-			} else {
-				acquired = true;
-			}
 
-			// ready
-			container::iterator it = map.find( ptr );
-			bool found = ( it != map.end() );
+			acquired = true;
 
 			if( size == ~0 || size == 0 )
 			{
-				if( found )
-				{
-					leak &L = it->second;
-					stats.overhead -= L.cs.space();
-					stats.usage -= L.size;
-					stats.num_leaks--;
-					L.wipe();
-				}
+				size_t mismatch = 0;
+
+				// filter: ptr was surely never tracked, so there is no record to look for (and no locking)
+				bool candidate = map.filter.maybe( ptr );
+
+				// async: ptr cannot be validated here, so it is always released
+				if( candidate && policy_t::ASYNC && map.defer( ptr, 0, 0 ) )
+					(void)0;
 				else
+				// sampling: a missing record means an unsampled pointer rather than a wild one
+				if( !( candidate && map.untrack( ptr, expected, &mismatch ) ) && !sampler::on() )
 				{
 					// 1st) wild pointer deallocation found; warn user
-					if( kTraceyReportWildPointers )
+					if( policy_t::WILD )
 						kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, wild pointer deallocation." kTraceyCharLinefeed ) +
 							tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
 
 					// 2nd) normalize ptr for further deallocation (deallocating null pointers is ok)
 					ptr = 0;
 				}
+				else
+				if( mismatch && policy_t::WILD )
+				{
+					// sized deallocation disagrees with the size that was allocated
+					kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, sized deallocation of \1 bytes on a block of \2 bytes." kTraceyCharLinefeed, expected, mismatch ) +
+						tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
+				}
 			}
 			else
 			if( size == (~0) - 1 )
 			{
-				int code = *((int*)ptr);
+				int code;
+				std::memcpy( &code, ptr, sizeof(code) );
 				//ptr = 0;
+				map.flush();
 				if( code == 1 ) {
 					map._clear();
-					stats = stats_t();
 					timestamp_id = create_id();
 				}
 
-				if( code == 2 ) { *((stats_t*)ptr) = stats; };
+				if( code == 2 ) { *((stats_t*)ptr) = map.stats(); };
 				if( code == 3 ) (void)0;
 				if( code == 4 ) (void)0;
 			}
 			else
+			if( size == moving_fn )
+			{
+				moving &m = *((moving *)ptr);
+
+				// async: records of m.from may still be queued, so caller falls back to forget+watch
+				if( policy_t::ASYNC || metadata().owns( m.from ) )
+					size = 0;
+				else
+				if( !m.detached )
+				{
+					m.detached = map.filter.maybe( m.from ) && map.untrack( m.from, 0, 0, &m.record );
+
+					if( !m.detached && !sampler::on() && policy_t::WILD )
+						kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, wild pointer reallocation." kTraceyCharLinefeed ) +
+							tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
+				}
+				else
+				{
+					// same callstack as the original allocation, so there is nothing to unwind
+					map.filter.mark( m.to );
+					map.track( m.to, m.size, m.record.stack, &m.record );
+				}
+			}
+			else
+			if( size == mapping_fn )
+			{
+				mapping &m = *((mapping *)ptr);
+
+				if( m.op == mapping::UNMAP )
+					map.maps.unmap( m.addr, m.length );
+				else
+				if( m.op == mapping::DISCARD )
+					map.maps.discard( m.addr, m.length );
+				else
+				if( m.op == mapping::REMAP && !m.detached )
+					m.detached = map.maps.unmap( m.addr, m.length, &m.props );
+				else
+				if( kTraceyEnabledSoft )
+				{
+					// new mappings, and remaps of ranges mapped before tracey was watching, get their own callstack
+					if( !m.detached ) {
+						tracey::stackframes< policy_t::DEPTH, policy_t::UNWINDER > cs( true );
+						m.props.stack = map.stacks.intern( cs.frames, cs.size );
+						m.props.id = create_id();
+					}
+					map.maps.map( m.addr, m.length, m.props );
+				}
+			}
+			else
 			if( size == (~0) - 2 )
 			{
 				static char placement[ sizeof(std::string) ];
 				static std::string *log = new ((std::string *)placement) std::string();
+				map.flush();
 				*log = map._report();
 				ptr = (void *)log;
 			}
@@ -3513,40 +7415,36 @@ namespace tracey
 			{
 				static char placement[ sizeof(std::string) ];
 				static std::string *log = new ((std::string *)placement) std::string();
-				*log = stats.str();
+				map.flush();
+				*log = map.stats().str();
 				ptr = (void *)log;
 			}
 			else
+			if( sampler::on() && !sampler::pick( size ) )
+			{
+				// not sampled; neither callstack nor record is kept
+			}
+			else
 			{
-				if( found ) {
-					if( kTraceyReportDoubleAllocations ) {
-						kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, double pointer allocation. This should never happen" kTraceyCharLinefeed ) +
-							tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
-					}
-					// kTraceyAssert( !map[ptr].first );
-					// kTraceyAssert( !map[ptr].second );
-				}
 				kTraceyAssert( size > 0 );
 
-				// create a leak and (re)insert it into map
-				tracey::detail::leak &leak = (map[ptr] = map[ptr]);
-				leak.wipe();
-				leak.cs.save();
-				leak.addr = ptr;
-				leak.size = size;
+				map.filter.mark( ptr ); // before the record exists, so a racing free cannot miss it
 
-				// update stats
-				stats.num_leaks++;
-				stats.usage += size;
-				stats.overhead += leak.cs.space();
+				// unwind and intern before locking, so the stripe is held just for the map update
+				// frames are captured on the stack and copied once into the interning table (no mallocs)
+				tracey::stackframes< policy_t::DEPTH, policy_t::UNWINDER > cs( true );
+				uint32_t stack = map.stacks.intern( cs.frames, cs.size );
 
-				// and peaks
-				if( leak.size   > stats.leak_peak  ) stats.leak_peak = leak.size;
-				if( stats.usage > stats.usage_peak ) stats.usage_peak = stats.usage;
+				if( policy_t::ASYNC && map.defer( ptr, size, stack ) )
+					(void)0;
+				else
+				if( map.track( ptr, size, stack ) && kTraceyReportDoubleAllocations ) {
+					kTraceyPrintf( "%s", (tracey::string( "<tracey/tracey.cpp> says: Error, double pointer allocation. This should never happen" kTraceyCharLinefeed ) +
+						tracey::callstack( true ).flat( kTraceyCharTab "\1) \2" kTraceyCharLinefeed, kTraceyStacktraceSkipBegin) ).c_str() );
+				}
 			}
 
 			acquired = false;
-			mutex->unlock();
 
 			return ptr;
 		}
@@ -3564,6 +7462,39 @@ namespace tracey
 		tracer( (void *)ptr, forget );
 		return (void *)ptr;
 	}
+	void *forget( const void *ptr, size_t size ) {
+		size_t forget = (~0);
+		tracer( (void *)ptr, forget, size );
+		return (void *)ptr;
+	}
+	// reallocates a watched block; its record moves along, so the original callstack is kept
+	void *rewatch( void *ptr, size_t resize, void *(*realloc)( void *, size_t ) ) {
+		if( !ptr || !resize ) {
+			return ptr ? realloc( tracey::forget( ptr ), 0 ) : tracey::watch( realloc( 0, resize ), resize );
+		}
+		moving m;
+		m.from = ptr;
+		m.to = 0;
+		m.size = resize;
+		m.detached = false;
+		size_t special_fn = moving_fn;
+		tracer( &m, special_fn );
+		if( !special_fn ) {
+			return tracey::watch( realloc( tracey::forget( ptr ), resize ), resize ); // not tracing right now
+		}
+		void *fresh = realloc( ptr, resize );
+		if( !m.detached ) {
+			return tracey::watch( fresh, resize ); // never watched: a brand new allocation as far as tracey knows
+		}
+		// old block is still valid if reallocation failed, and keeps its record then
+		m.to = fresh ? fresh : ptr;
+		m.size = fresh ? resize : m.record.size;
+		tracer( &m, special_fn );
+		return fresh;
+	}
+	void *rewatch( void *ptr, size_t resize ) {
+		return tracey::rewatch( ptr, resize, tracey::realloc );
+	}
 	void enable() {
 		kTraceyEnabledSoft = true;
 	}
@@ -3574,6 +7505,14 @@ namespace tracey
 		size_t opcode = 1, special_fn = (~0) - 1;
 		tracer( &opcode, special_fn );
 	}
+	static stats_t snapshot() {
+		stats_t stats;
+		int opcode = 2; // overwritten by the aggregated stats of all shards
+		std::memcpy( (void *)&stats, &opcode, sizeof(opcode) ); // stats_t is plain counters
+		size_t special_fn = (~0) - 1;
+		tracer( &stats, special_fn );
+		return stats;
+	}
 	std::string report() {
 		size_t special_fn = (~0) - 2;
 		return *((std::string *)tracey::tracer( (void*)&report, special_fn ));
@@ -3620,6 +7559,7 @@ namespace tracey
 			out += tracey::string( "\1failed to decode symbols!! Is debug information available?" $msvc(" Are .PDB files available?") kTraceyCharLinefeed, prefix );
 		}
 		out += tracey::string( "\1using \2 as realloc" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyRealloc) );
+		out += tracey::string( "\1using \2 as calloc" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyCalloc) );
 		out += tracey::string( "\1using \2 as memset" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyMemset) );
 		out += tracey::string( "\1using \2 as printf" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyPrintf) );
 		out += tracey::string( "\1using \2 as exit" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyDie) );
@@ -3627,19 +7567,38 @@ namespace tracey
 		out += tracey::string( "\1using \2 as fclose" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyfClose) );
 		out += tracey::string( "\1using \2 as fprintf" kTraceyCharLinefeed, prefix, tracey::lookup(kTraceyfPrintf) );
 		out += tracey::string( "\1with C++ exceptions=\2" kTraceyCharLinefeed, prefix, $throw("enabled") $telse("disabled") );
-		out += tracey::string( "\1with kTraceyBudgetOverhead=\2%" kTraceyCharLinefeed, prefix, (100 + kTraceyBudgetOverhead) );
-		out += tracey::string( "\1with kTraceyMaxStacktraces=\2 range[\3..\4]" kTraceyCharLinefeed, prefix, int(kTraceyMaxStacktraces), int(kTraceyStacktraceSkipBegin), int(kTraceyStacktraceSkipEnd) );
+		const int unwinder = policy_t::UNWINDER < 0 ? int( tracey::callstack::unwinder ) : int( policy_t::UNWINDER );
+		out += tracey::string( "\1with kTraceyPolicy=\2" kTraceyCharLinefeed, prefix, std::is_same< policy_t, defaults >::value ? "defaults" : "custom" );
+		out += tracey::string( "\1with kTraceyBudgetOverhead=\2%" kTraceyCharLinefeed, prefix, (100 + policy_t::OVERHEAD / 100.0) );
+		out += tracey::string( "\1with kTraceyMaxStacktraces=\2 range[\3..\4]" kTraceyCharLinefeed, prefix, int(policy_t::DEPTH), int(kTraceyStacktraceSkipBegin), int(kTraceyStacktraceSkipEnd) );
+		out += tracey::string( "\1with kTraceyUnwinder=\2" kTraceyCharLinefeed, prefix,
+			unwinder == tracey::callstack::UNWIND_FRAME_POINTERS ? "frame pointers" :
+			unwinder == tracey::callstack::UNWIND_DWARF ? "dwarf cfi" : "platform" );
 		// kTraceyCharLinefeed
 		// kTraceyCharTab
-		out += tracey::string( "\1with kTraceyReportWildPointers=\2" kTraceyCharLinefeed, prefix, kTraceyReportWildPointers ? "yes" : "no" );
+		out += tracey::string( "\1with kTraceyReportWildPointers=\2" kTraceyCharLinefeed, prefix, policy_t::WILD ? "yes" : "no" );
 		out += tracey::string( "\1with kTraceyDefineMemoryOperators=\2" kTraceyCharLinefeed, prefix, kTraceyDefineMemoryOperators ? "yes" : "no" );
-		out += tracey::string( "\1with kTraceyMemsetAllocations=\2" kTraceyCharLinefeed, prefix, kTraceyMemsetAllocations ? "yes" : "no" );
+		out += tracey::string( "\1with kTraceyMemsetAllocations=\2" kTraceyCharLinefeed, prefix, policy_t::FILL >= 0 ? "yes" : "no" );
 		out += tracey::string( "\1with kTraceyStacktraceSkipBegin=\2" kTraceyCharLinefeed, prefix, int(kTraceyStacktraceSkipBegin) );
 		out += tracey::string( "\1with kTraceyStacktraceSkipEnd=\2" kTraceyCharLinefeed, prefix, int(kTraceyStacktraceSkipEnd) );
-		out += tracey::string( "\1with kTraceyReportOnExit=\2" kTraceyCharLinefeed, prefix, kTraceyReportOnExit ? "yes" : "no" );
-		out += tracey::string( "\1with kTraceyWebserverPort=\2" kTraceyCharLinefeed, prefix, int(kTraceyWebserverPort) );
+		out += tracey::string( "\1with kTraceyReportOnExit=\2" kTraceyCharLinefeed, prefix, options().report_on_exit ? "yes" : "no" );
+		out += tracey::string( "\1with kTraceyWebserverPort=\2" kTraceyCharLinefeed, prefix, int(options().port) );
+		out += tracey::string( "\1with TRACEY_REPORT=\2" kTraceyCharLinefeed, prefix, options().report ? options().report : "(temp file)" );
+		out += tracey::string( "\1with TRACEY_REPORT_SIGNAL=\2" kTraceyCharLinefeed, prefix, options().signal );
 		out += tracey::string( "\1with kTraceyHookLegacyCRT=\2" kTraceyCharLinefeed, prefix, int(kTraceyHookLegacyCRT) );
+		out += tracey::string( "\1with kTraceyHookMmap=\2" kTraceyCharLinefeed, prefix, int(kTraceyHookMmap) );
 		out += tracey::string( "\1with kTraceyEnabled=\2" kTraceyCharLinefeed, prefix, int(kTraceyEnabled) );
+		out += tracey::string( "\1with kTraceyRegistryShards=\2" kTraceyCharLinefeed, prefix, int(kTraceyRegistryShards) );
+		out += tracey::string( "\1with kTraceyAsync=\2 (\3 events per thread)" kTraceyCharLinefeed, prefix, policy_t::ASYNC ? "yes" : "no", int(kTraceyAsyncBufferSize) );
+		out += tracey::string( "\1with kTraceySampleRate=\2" kTraceyCharLinefeed, prefix, sampler::rate ? tracey::human( sampler::rate ) : std::string("off (every allocation)") );
+		out += tracey::string( "\1with kTraceyFreeFilterKB=\2" kTraceyCharLinefeed, prefix, int(kTraceyFreeFilterKB) );
+		out += tracey::string( "\1with kTraceyBackend=\2" kTraceyCharLinefeed, prefix, chosen().name );
+		out += tracey::string( "\1with kTraceyFlatTree=\2" kTraceyCharLinefeed, prefix, kTraceyFlatTree ? "yes" : "no (oak::tree)" );
+#if HEAL_HAS_ELF
+		out += tracey::string( "\1with kTraceySymbolCache=\2 (\3 hits, \4 misses)" kTraceyCharLinefeed, prefix,
+			symbol_cache::directory().empty() ? std::string("off") : symbol_cache::directory(), symbol_cache::hits.load(), symbol_cache::misses.load() );
+#endif
+		out += tracey::string( "\1with kTraceyHeaders=\2 (\3 bytes per allocation)" kTraceyCharLinefeed, prefix, policy_t::HEADERS ? "yes" : "no", policy_t::HEADERS ? int(header_size) : 0 );
 		return out;
 	}
 	std::string settings() {
@@ -3653,32 +7612,118 @@ namespace tracey
 		return true;
 	}
 	bool install_c_hooks() {
-		return false;
+		return kTraceyHookLegacyCRT != 0; // symbols are interposed at link time, nothing to install
 	}
 
-	void *realloc( void *ptr, size_t resize ) {
+	// resizes a block through the backend owning it. blocks that still fit are left in place
+	static void *regrow( void *ptr, size_t bytes ) {
+		const backend &from = owner( ptr );
+		size_t have = from.usable_size( ptr );
+		return bytes <= have && bytes > have / 2 ? ptr : from.reallocate( ptr, bytes );
+	}
+
+	// zeroed: new block is requested zero-filled to the backend
+	static void *reallocate( void *ptr, size_t resize, bool zeroed ) {
 		static const bool init = install_c_hooks();
 
-		ptr = kTraceyRealloc( ptr, (size_t)( resize + (kTraceyBudgetOverhead * resize) / 100.0 ) );
+		// allocations made by tracey itself (while tracing) and their frees go to the metadata arena
+		if( ptr ? metadata().owns( ptr ) : acquired ) {
+			ptr = metadata().realloc( ptr, resize );
+			if( !ptr && resize )
+				tracey::badalloc();
+			return zeroed ? kTraceyMemset( ptr, 0, resize ) : ptr;
+		}
+
+		size_t budget = policy_t::budget( resize );
+
+		if( policy_t::HEADERS ) {
+			// header mode: the header is part of the underlying allocation and moves along with the block
+			size_t offset = header_size;
+			char *base = 0;
+			if( ptr ) {
+				header *h = header_of( ptr );
+				if( h->is( ptr, header::LIVE ) ) {
+					registry.load()->untrack( ptr ); // chained record must not outlive its block
+				}
+				offset = h->offset;
+				h->cookie = 0;
+				base = (char *)ptr - offset;
+				if( !resize ) {
+					return owner( base ).deallocate( base ), (void *)0;
+				}
+			}
+			base = (char *)( base ? regrow( base, offset + budget ) : chosen().allocate( offset + budget, zeroed ) );
+			if( !base )
+				tracey::badalloc();
+			return stamp( base, offset, resize );
+		}
+
+		if( !ptr ) {
+			ptr = chosen().allocate( budget, zeroed );
+		} else if( !resize ) {
+			return owner( ptr ).deallocate( ptr ), (void *)0;
+		} else {
+			ptr = regrow( ptr, budget );
+		}
 
 		if( !ptr && resize )
 			tracey::badalloc();
 
 		return ptr;
 	}
+
+	// zero-filled blocks. big ones are requested zeroed to the allocator, which knows what memory is fresh
+	// from the kernel (and zero already) and only clears recycled memory; small ones are cheaper to clear here.
+	static void *zalloc( size_t size ) {
+		if( size < ( 128 << 10 ) ) {
+			return kTraceyMemset( reallocate( 0, size, false ), 0, size );
+		}
+		return reallocate( 0, size, true );
+	}
+
+	void *realloc( void *ptr, size_t resize ) {
+		return reallocate( ptr, resize, false );
+	}
 	void *malloc( size_t size ) {
-		void *ptr = tracey::realloc( 0, size );
-		return kTraceyMemsetAllocations ? kTraceyMemset( ptr, kTraceyMemsetChar, size ) : ptr;
+		if( policy_t::FILL == 0 ) {
+			return zalloc( size );
+		}
+		return policy_t::fill( tracey::realloc( 0, size ), size );
 	}
 	void *calloc( size_t num, size_t size ) {
-		return kTraceyMemsetAllocations ? tracey::malloc( num * size ) : memset( tracey::malloc( num * size ), kTraceyMemsetChar, num * size );
+		if( size && num > size_t(~0) / size )
+			tracey::badalloc();
+		return zalloc( num * size );
 	}
 	void *free( void *ptr ) {
 		return tracey::realloc( ptr, 0 ), ptr;
 	}
 
 	void *amalloc( size_t size, size_t alignment ) {
-		// kids, dont do this at home. this is horrible.
+		// real aligned allocation, releasable by tracey::free() like any other block
+		$welse(
+			if( alignment <= sizeof(void *) * 2 ) {
+				return tracey::malloc( size );
+			}
+			void *ptr;
+			size_t resize = policy_t::budget( size );
+			// header mode: header goes in front, padded so the block keeps its alignment
+			size_t offset = policy_t::HEADERS ? ( header_size + alignment - 1 ) & ~( alignment - 1 ) : 0;
+			if( acquired ) {
+				// arena blocks are aligned to their size class
+				ptr = metadata().alloc( resize > alignment ? resize : alignment );
+				offset = 0;
+			} else {
+				ptr = chosen().align( alignment, offset + resize );
+			}
+			if( !ptr )
+				tracey::badalloc();
+			if( offset )
+				ptr = stamp( ptr, offset, size );
+			return policy_t::fill( ptr, size );
+		)
+
+		// kids, dont do this at home. this is horrible. (_aligned_malloc blocks cannot go through kTraceyRealloc)
 		std::vector<void *> invalids( 1, tracey::malloc(size) );
 		if( alignment ) {
 #          define is_aligned(POINTER, BYTE_COUNT) \
@@ -3718,11 +7763,17 @@ void operator delete[]( void *ptr, const std::nothrow_t &t ) throw() {
 
 //* Custom memory operators (with exceptions)
 
-void *operator new( size_t size ) throw(std::bad_alloc) {
+#if __cplusplus >= 201103L
+#define kTraceyThrowBadAlloc noexcept(false) // dynamic exception specifications are gone in C++17
+#else
+#define kTraceyThrowBadAlloc throw(std::bad_alloc)
+#endif
+
+void *operator new( size_t size ) kTraceyThrowBadAlloc {
 	return tracey::watch( tracey::malloc( size ), size );
 }
 
-void *operator new[]( size_t size ) throw(std::bad_alloc) {
+void *operator new[]( size_t size ) kTraceyThrowBadAlloc {
 	return tracey::watch( tracey::malloc( size ), size );
 }
 
@@ -3734,6 +7785,411 @@ void operator delete[]( void *ptr ) throw() {
 	tracey::free( tracey::forget( ptr ) );
 }
 
+//* Sized deallocation (C++14). Size is checked against the record
+
+#if defined(__cpp_sized_deallocation) || ( defined(_MSC_VER) && _MSC_VER >= 1900 )
+
+void operator delete( void *ptr, size_t size ) throw() {
+	tracey::free( tracey::forget( ptr, size ) );
+}
+
+void operator delete[]( void *ptr, size_t size ) throw() {
+	tracey::free( tracey::forget( ptr, size ) ); // same size new[] was given, array cookie included
+}
+
+#endif
+
+//* Aligned memory operators (C++17)
+
+#if defined(__cpp_aligned_new)
+
+void *operator new( size_t size, std::align_val_t al ) {
+	return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+}
+
+void *operator new[]( size_t size, std::align_val_t al ) {
+	return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+}
+
+// amalloc() throws on failure, which must not leave a noexcept operator
+void *operator new( size_t size, std::align_val_t al, const std::nothrow_t & ) noexcept {
+	$throw(
+		try {
+			return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+		} catch( const std::bad_alloc & ) {
+			return nullptr;
+		}
+	)
+	$telse(
+		return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+	)
+}
+
+void *operator new[]( size_t size, std::align_val_t al, const std::nothrow_t & ) noexcept {
+	$throw(
+		try {
+			return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+		} catch( const std::bad_alloc & ) {
+			return nullptr;
+		}
+	)
+	$telse(
+		return tracey::watch( tracey::amalloc( size, size_t(al) ), size );
+	)
+}
+
+void operator delete( void *ptr, std::align_val_t ) noexcept {
+	tracey::free( tracey::forget( ptr ) );
+}
+
+void operator delete[]( void *ptr, std::align_val_t ) noexcept {
+	tracey::free( tracey::forget( ptr ) );
+}
+
+void operator delete( void *ptr, std::align_val_t, const std::nothrow_t & ) noexcept {
+	tracey::free( tracey::forget( ptr ) );
+}
+
+void operator delete[]( void *ptr, std::align_val_t, const std::nothrow_t & ) noexcept {
+	tracey::free( tracey::forget( ptr ) );
+}
+
+void operator delete( void *ptr, size_t size, std::align_val_t ) noexcept {
+	tracey::free( tracey::forget( ptr, size ) );
+}
+
+void operator delete[]( void *ptr, size_t size, std::align_val_t ) noexcept {
+	tracey::free( tracey::forget( ptr, size ) );
+}
+
+#endif
+
+#endif
+
+#if kTraceyHookLegacyCRT
+
+//* C allocator hooks (linux). Every symbol forwards to the next definition in lookup order (glibc)
+//* and is watched like operator new. dlsym() may allocate while the real functions are looked up,
+//* so those early requests are served from a static bootstrap buffer that is never released.
+
+namespace tracey {
+namespace crt {
+
+	struct api {
+		void *(*malloc)( size_t );
+		void *(*calloc)( size_t, size_t );
+		void *(*realloc)( void *, size_t );
+		void  (*free)( void * );
+		int   (*posix_memalign)( void **, size_t, size_t );
+		void *(*aligned_alloc)( size_t, size_t );
+		void *(*memalign)( size_t, size_t );
+		void *(*valloc)( size_t );
+		void *(*pvalloc)( size_t );
+		size_t (*usable)( void * );
+	} next;
+
+	enum { UNRESOLVED, RESOLVING, RESOLVED };
+	std::atomic<int> state( UNRESOLVED );
+	$tls(bool) resolving = false;
+
+	template<typename FN>
+	void bind( FN &fn, const char *name ) {
+		fn = reinterpret_cast<FN>( dlsym( RTLD_NEXT, name ) );
+	}
+
+	// true once next.* can be used; false while calling thread is looking them up
+	bool resolved() {
+		if( state.load( std::memory_order_acquire ) == RESOLVED ) {
+			return true;
+		}
+		if( resolving ) {
+			return false;
+		}
+		int expected = UNRESOLVED;
+		if( state.compare_exchange_strong( expected, RESOLVING ) ) {
+			resolving = true;
+			bind( next.malloc, "malloc" );
+			bind( next.calloc, "calloc" );
+			bind( next.realloc, "realloc" );
+			bind( next.free, "free" );
+			bind( next.posix_memalign, "posix_memalign" );
+			bind( next.aligned_alloc, "aligned_alloc" );
+			bind( next.memalign, "memalign" );
+			bind( next.valloc, "valloc" );
+			bind( next.pvalloc, "pvalloc" );
+			bind( next.usable, "malloc_usable_size" );
+			resolving = false;
+			state.store( RESOLVED, std::memory_order_release );
+			return true;
+		}
+		while( state.load( std::memory_order_acquire ) != RESOLVED ) {
+			std::this_thread::yield();
+		}
+		return true;
+	}
+
+	// bootstrap buffer. every block is preceded by its size; blocks are zeroed and never reused
+	enum { BOOTSTRAP = 64 * 1024, HEADER = 16 };
+	union { char bytes[ BOOTSTRAP ]; double align; } bootstrap;
+	std::atomic<size_t> bootstrapped( 0 );
+
+	bool early( const void *ptr ) {
+		return (const char *)ptr >= bootstrap.bytes && (const char *)ptr < bootstrap.bytes + BOOTSTRAP;
+	}
+	void *early_alloc( size_t size, size_t alignment = HEADER ) {
+		if( alignment < HEADER ) alignment = HEADER;
+		size_t at, from = bootstrapped.load();
+		do {
+			at = ( from + HEADER + alignment - 1 ) & ~( alignment - 1 );
+			if( at + size > BOOTSTRAP ) return 0;
+		} while( !bootstrapped.compare_exchange_weak( from, at + size ) );
+		std::memcpy( bootstrap.bytes + at - sizeof(size_t), &size, sizeof(size_t) );
+		return bootstrap.bytes + at;
+	}
+	size_t early_size( const void *ptr ) {
+		size_t size;
+		std::memcpy( &size, (const char *)ptr - sizeof(size_t), sizeof(size_t) );
+		return size;
+	}
+
+	// kTraceyRealloc while hooked: untracked, realloc(ptr, 0) frees
+	void *realloc( void *ptr, size_t size ) {
+		if( !resolved() ) {
+			return ptr ? 0 : early_alloc( size );
+		}
+		if( early( ptr ) ) {
+			void *fresh = size ? next.malloc( size ) : 0;
+			if( fresh ) std::memcpy( fresh, ptr, std::min( size, early_size( ptr ) ) );
+			return fresh;
+		}
+		if( ptr && !size ) {
+			return next.free( ptr ), (void *)0;
+		}
+		return next.realloc( ptr, size );
+	}
+
+	// kTraceyFree while hooked: untracked. bootstrap blocks are never released
+	void free( void *ptr ) {
+		if( ptr && !early( ptr ) && resolved() ) {
+			next.free( ptr );
+		}
+	}
+
+	// zeroed counterpart of crt::realloc, untracked. bootstrap blocks are zeroed already
+	void *calloc( size_t num, size_t size ) {
+		return resolved() ? next.calloc( num, size ) : early_alloc( num * size );
+	}
+
+	// aligned counterpart of crt::realloc, untracked
+	void *memalign( size_t alignment, size_t size ) {
+		if( !resolved() ) {
+			return early_alloc( size, alignment );
+		}
+		void *ptr;
+		return next.posix_memalign( &ptr, alignment, size ) ? 0 : ptr;
+	}
+
+	void *watched( void *ptr, size_t size ) {
+		return ptr ? tracey::watch( ptr, size ? size : 1 ) : ptr;
+	}
+}
+}
+
+extern "C" {
+
+void *malloc( size_t size ) throw() {
+	using namespace tracey::crt;
+	return resolved() ? watched( next.malloc( size ), size ) : early_alloc( size );
+}
+
+void *calloc( size_t num, size_t size ) throw() {
+	using namespace tracey::crt;
+	if( size && num > size_t(~0) / size ) return 0;
+	return resolved() ? watched( next.calloc( num, size ), num * size ) : early_alloc( num * size );
+}
+
+void *realloc( void *ptr, size_t size ) throw() {
+	using namespace tracey::crt;
+	if( !ptr ) return malloc( size );
+	if( !size ) return ::free( ptr ), (void *)0;
+	if( !resolved() || early( ptr ) ) return watched( tracey::crt::realloc( ptr, size ), size );
+	return tracey::rewatch( ptr, size, next.realloc );
+}
+
+void free( void *ptr ) throw() {
+	using namespace tracey::crt;
+	if( !ptr || early( ptr ) ) return;
+	tracey::forget( ptr );
+	if( resolved() ) next.free( ptr );
+}
+
+int posix_memalign( void **ptr, size_t alignment, size_t size ) throw() {
+	using namespace tracey::crt;
+	if( !resolved() ) return ( *ptr = early_alloc( size, alignment ) ) ? 0 : 12 /*ENOMEM*/;
+	int error = next.posix_memalign( ptr, alignment, size );
+	if( !error ) watched( *ptr, size );
+	return error;
+}
+
+void *aligned_alloc( size_t alignment, size_t size ) throw() {
+	using namespace tracey::crt;
+	return resolved() ? watched( next.aligned_alloc( alignment, size ), size ) : early_alloc( size, alignment );
+}
+
+void *memalign( size_t alignment, size_t size ) throw() {
+	using namespace tracey::crt;
+	return resolved() ? watched( next.memalign( alignment, size ), size ) : early_alloc( size, alignment );
+}
+
+void *valloc( size_t size ) throw() {
+	using namespace tracey::crt;
+	return resolved() ? watched( next.valloc( size ), size ) : early_alloc( size, 4096 );
+}
+
+void *pvalloc( size_t size ) throw() {
+	using namespace tracey::crt;
+	return resolved() ? watched( next.pvalloc( size ), size ) : early_alloc( ( size + 4095 ) & ~size_t(4095), 4096 );
+}
+
+size_t malloc_usable_size( void *ptr ) throw() {
+	using namespace tracey::crt;
+	if( !ptr ) return 0;
+	return early( ptr ) ? early_size( ptr ) : resolved() ? next.usable( ptr ) : 0;
+}
+
+}
+
+#endif
+
+#if kTraceyHookMmap
+
+//* Address space hooks (linux). mmap, munmap, mremap and madvise forward to the next definition in
+//* lookup order and report mapped ranges to tracer(). Tracey maps its own arenas through vm::mmap, which
+//* is never tracked. Calls made while the real functions are being looked up go straight to the kernel.
+
+#include <stdarg.h>
+#include <sys/syscall.h>
+
+namespace tracey {
+namespace vm {
+
+	struct api {
+		void *(*mmap)( void *, size_t, int, int, int, off_t );
+		int   (*munmap)( void *, size_t );
+		void *(*mremap)( void *, size_t, size_t, int, ... );
+		int   (*madvise)( void *, size_t, int );
+	} next;
+
+	enum { UNBOUND, BINDING, BOUND };
+	std::atomic<int> state( UNBOUND );
+
+	template<typename FN>
+	void bind( FN &fn, const char *name ) {
+		fn = reinterpret_cast<FN>( dlsym( RTLD_NEXT, name ) );
+	}
+
+	// true once next.* can be used
+	bool bound() {
+		int current = state.load( std::memory_order_acquire );
+		if( current == BOUND ) {
+			return true;
+		}
+		if( current == UNBOUND && state.compare_exchange_strong( current, BINDING ) ) {
+			bind( next.mmap, "mmap" );
+			bind( next.munmap, "munmap" );
+			bind( next.mremap, "mremap" );
+			bind( next.madvise, "madvise" );
+			state.store( BOUND, std::memory_order_release );
+			return true;
+		}
+		return false;
+	}
+
+	// untracked mmap and madvise, for tracey's own memory
+	void *mmap( void *addr, size_t length, int prot, int flags, int fd, off_t offset ) {
+		if( bound() ) {
+			return next.mmap( addr, length, prot, flags, fd, offset );
+		}
+#ifdef SYS_mmap2
+		return (void *)syscall( SYS_mmap2, addr, length, prot, flags, fd, offset / 4096 );
+#else
+		return (void *)syscall( SYS_mmap, addr, length, prot, flags, fd, offset );
+#endif
+	}
+	int madvise( void *addr, size_t length, int advice ) {
+		return bound() ? next.madvise( addr, length, advice ) : int( syscall( SYS_madvise, addr, length, advice ) );
+	}
+
+	void report( int op, const void *addr, size_t length, mappings::region *props = 0, bool *detached = 0 ) {
+		mapping m;
+		m.op = (mapping::kind)op;
+		m.addr = addr;
+		m.length = length;
+		m.detached = detached ? *detached : false;
+		if( props ) m.props = *props;
+		else m.props.anonymous = true;
+		size_t special_fn = mapping_fn;
+		tracer( &m, special_fn );
+		if( props ) *props = m.props;
+		if( detached ) *detached = special_fn && m.detached;
+	}
+}
+}
+
+extern "C" {
+
+void *mmap( void *addr, size_t length, int prot, int flags, int fd, off_t offset ) throw() {
+	using namespace tracey::vm;
+	void *ptr = tracey::vm::mmap( addr, length, prot, flags, fd, offset );
+	if( ptr != MAP_FAILED ) {
+		tracey::mappings::region props;
+		props.anonymous = ( flags & MAP_ANONYMOUS ) != 0;
+		report( tracey::mapping::MAP, ptr, length, &props );
+	}
+	return ptr;
+}
+
+int munmap( void *addr, size_t length ) throw() {
+	using namespace tracey::vm;
+	report( tracey::mapping::UNMAP, addr, length ); // before the range can be mapped again by someone else
+	return bound() ? next.munmap( addr, length ) : int( syscall( SYS_munmap, addr, length ) );
+}
+
+void *mremap( void *old_address, size_t old_size, size_t new_size, int flags, ... ) throw() {
+	using namespace tracey::vm;
+	void *new_address = 0;
+	if( flags & MREMAP_FIXED ) {
+		va_list args;
+		va_start( args, flags );
+		new_address = va_arg( args, void * );
+		va_end( args );
+	}
+	// old range is released first and its callstack moves to the new range, as with reallocations
+	tracey::mappings::region props;
+	props.anonymous = true;
+	bool detached = false;
+	report( tracey::mapping::REMAP, old_address, old_size, &props, &detached );
+	void *ptr = bound() ? next.mremap( old_address, old_size, new_size, flags, new_address ) :
+		(void *)syscall( SYS_mremap, old_address, old_size, new_size, flags, new_address );
+	if( ptr != MAP_FAILED ) {
+		report( tracey::mapping::MAP, ptr, new_size, &props, &detached );
+	} else if( detached ) {
+		report( tracey::mapping::MAP, old_address, old_size, &props, &detached ); // old range is still there
+	}
+	return ptr;
+}
+
+int madvise( void *addr, size_t length, int advice ) throw() {
+	using namespace tracey::vm;
+	int error = tracey::vm::madvise( addr, length, advice );
+	if( !error && advice == MADV_DONTNEED ) {
+		report( tracey::mapping::DISCARD, addr, length );
+	}
+	return error;
+}
+
+}
+
 #endif
 
 namespace tracey {
@@ -3772,8 +8228,8 @@ static tracey::string get_html_template() {
 	);
 }
 
-static void webmain( void *arg ) {
-	if( kTraceyWebserverPort ) {
+static void webmain( void * ) {
+	if( unsigned port = options().port ) {
 
 		struct local {
 			static
@@ -3795,14 +8251,14 @@ static void webmain( void *arg ) {
 			}
 		};
 
-		route66::create( kTraceyWebserverPort, "GET /", local::GET_root );
-		route66::create( kTraceyWebserverPort, "GET /report", local::GET_report );
+		route66::create( port, "GET /", local::GET_root );
+		route66::create( port, "GET /report", local::GET_report );
 	}
 }
 
 #else
 
-static void webmain( void *arg )
+static void webmain( void * )
 {}
 
 #endif
@@ -3811,10 +8267,11 @@ static void webmain( void *arg )
 
 namespace tracey {
 	#pragma comment(lib, "user32.lib")
-	static void hotkeymain( void *arg ) {
-		volatile bool &sitdown = *(volatile bool *)arg;
-		sitdown = true;
-
+	static volatile sig_atomic_t report_requested = 0;
+	static void on_report_signal( int ) {
+		report_requested = 1;
+	}
+	static void hotkeymain( void * ) {
 		$windows(
 			for(;;) {
 				if( GetAsyncKeyState(VK_NUMLOCK) ) {
@@ -3823,6 +8280,19 @@ namespace tracey {
 				Sleep( 1000/60 );
 			}
 		)
+		$welse(
+			// reports on demand: kill -<TRACEY_REPORT_SIGNAL> <pid>
+			if( options().signal ) {
+				for(;;) {
+					if( report_requested ) {
+						report_requested = 0;
+						std::string logfile = tracey::report();
+						if( options().view ) tracey::view( logfile );
+					}
+					usleep( 100 * 1000 );
+				}
+			}
+		)
 	}
 }
 
@@ -3846,7 +8316,7 @@ namespace tracey {
 	}
 	scope::~scope() {
 		tracey::disable();
-		if( tracey::stats.num_leaks > 0 ) tracey::view( tracey::report() );
+		if( tracey::snapshot().num_leaks > 0 ) tracey::view( tracey::report() );
 	}
 }
 
@@ -3922,7 +8392,7 @@ extern "C" {
 			return tracey::watch( tracey::malloc( size ), size );
 		}
 		void *tracey_checked_realloc( void *ptr, size_t resize ) {
-			return tracey::watch( tracey::realloc( tracey::forget( ptr ), resize ), resize );
+			return tracey::rewatch( ptr, resize );
 		}
 		void  tracey_checked_free( void *ptr ) {
 			tracey::free( tracey::forget( ptr ) );